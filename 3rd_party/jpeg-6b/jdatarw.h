@@ -15,5 +15,7 @@ struct jpeg_datarw_struct{
 
 EXTERN(void) jpeg_writer_dest JPP((j_compress_ptr cinfo, struct jpeg_datarw_struct *rw));
 EXTERN(void) jpeg_reader_src JPP((j_decompress_ptr cinfo, struct jpeg_datarw_struct *rw));
+/* decodes the bytes in place, they must live until jpeg_finish_decompress */
+EXTERN(void) jpeg_memory_src JPP((j_decompress_ptr cinfo, const JOCTET *data, size_t size));
 
 #endif /* __JDATARW_H__ */
\ No newline at end of file
@@ -11,6 +11,7 @@
 #define JPEG_INTERNALS
 #include "jinclude.h"
 #include "jpeglib.h"
+#include "jsimd.h"
 
 
 /* Private subobject */
@@ -23,6 +24,11 @@ typedef struct {
   int * Cb_b_tab;		/* => table for Cb to B conversion */
   INT32 * Cr_g_tab;		/* => table for Cr to G conversion */
   INT32 * Cb_g_tab;		/* => table for Cb to G conversion */
+
+  /* Pixel layout of the JCS_EXT_xxx output spaces */
+  int ext_red;			/* offset of red in the pixel */
+  int ext_blue;			/* offset of blue in the pixel */
+  int ext_pixelsize;		/* 3, or 4 with opaque alpha at offset 3 */
 } my_color_deconverter;
 
 typedef my_color_deconverter * my_cconvert_ptr;
@@ -157,6 +163,57 @@ ycc_rgb_convert (j_decompress_ptr cinfo,
 }
 
 
+/*
+ * Convert some rows of samples to one of the JCS_EXT_xxx layouts: RGBA,
+ * BGR or BGRA, the alpha samples are opaque.  This is ycc_rgb_convert with
+ * the layout of the application textures, they need no other pass.
+ */
+
+METHODDEF(void)
+ycc_ext_convert (j_decompress_ptr cinfo,
+		 JSAMPIMAGE input_buf, JDIMENSION input_row,
+		 JSAMPARRAY output_buf, int num_rows)
+{
+  my_cconvert_ptr cconvert = (my_cconvert_ptr) cinfo->cconvert;
+  register int y, cb, cr;
+  register JSAMPROW outptr;
+  register JSAMPROW inptr0, inptr1, inptr2;
+  register JDIMENSION col;
+  JDIMENSION num_cols = cinfo->output_width;
+  /* copy these pointers into registers if possible */
+  register JSAMPLE * range_limit = cinfo->sample_range_limit;
+  register int * Crrtab = cconvert->Cr_r_tab;
+  register int * Cbbtab = cconvert->Cb_b_tab;
+  register INT32 * Crgtab = cconvert->Cr_g_tab;
+  register INT32 * Cbgtab = cconvert->Cb_g_tab;
+  int red = cconvert->ext_red;
+  int blue = cconvert->ext_blue;
+  int pixelsize = cconvert->ext_pixelsize;
+  SHIFT_TEMPS
+
+  while (--num_rows >= 0) {
+    inptr0 = input_buf[0][input_row];
+    inptr1 = input_buf[1][input_row];
+    inptr2 = input_buf[2][input_row];
+    input_row++;
+    outptr = *output_buf++;
+    for (col = 0; col < num_cols; col++) {
+      y  = GETJSAMPLE(inptr0[col]);
+      cb = GETJSAMPLE(inptr1[col]);
+      cr = GETJSAMPLE(inptr2[col]);
+      outptr[red] =   range_limit[y + Crrtab[cr]];
+      outptr[1] =     range_limit[y +
+			      ((int) RIGHT_SHIFT(Cbgtab[cb] + Crgtab[cr],
+						 SCALEBITS))];
+      outptr[blue] =  range_limit[y + Cbbtab[cb]];
+      if (pixelsize == 4)
+	outptr[3] = MAXJSAMPLE;
+      outptr += pixelsize;
+    }
+  }
+}
+
+
 /**************** Cases other than YCbCr -> RGB **************/
 
 
@@ -234,6 +291,65 @@ gray_rgb_convert (j_decompress_ptr cinfo,
 }
 
 
+/*
+ * Convert grayscale or RGB to the JCS_EXT_xxx layouts: the color samples
+ * are copied, the alpha samples are opaque.
+ */
+
+METHODDEF(void)
+gray_ext_convert (j_decompress_ptr cinfo,
+		  JSAMPIMAGE input_buf, JDIMENSION input_row,
+		  JSAMPARRAY output_buf, int num_rows)
+{
+  my_cconvert_ptr cconvert = (my_cconvert_ptr) cinfo->cconvert;
+  register JSAMPROW inptr, outptr;
+  register JDIMENSION col;
+  JDIMENSION num_cols = cinfo->output_width;
+  int pixelsize = cconvert->ext_pixelsize;
+
+  while (--num_rows >= 0) {
+    inptr = input_buf[0][input_row++];
+    outptr = *output_buf++;
+    for (col = 0; col < num_cols; col++) {
+      outptr[0] = outptr[1] = outptr[2] = inptr[col];
+      if (pixelsize == 4)
+	outptr[3] = MAXJSAMPLE;
+      outptr += pixelsize;
+    }
+  }
+}
+
+METHODDEF(void)
+rgb_ext_convert (j_decompress_ptr cinfo,
+		 JSAMPIMAGE input_buf, JDIMENSION input_row,
+		 JSAMPARRAY output_buf, int num_rows)
+{
+  my_cconvert_ptr cconvert = (my_cconvert_ptr) cinfo->cconvert;
+  register JSAMPROW inptr0, inptr1, inptr2, outptr;
+  register JDIMENSION col;
+  JDIMENSION num_cols = cinfo->output_width;
+  int red = cconvert->ext_red;
+  int blue = cconvert->ext_blue;
+  int pixelsize = cconvert->ext_pixelsize;
+
+  while (--num_rows >= 0) {
+    inptr0 = input_buf[0][input_row];
+    inptr1 = input_buf[1][input_row];
+    inptr2 = input_buf[2][input_row];
+    input_row++;
+    outptr = *output_buf++;
+    for (col = 0; col < num_cols; col++) {
+      outptr[red] = inptr0[col];
+      outptr[1] = inptr1[col];
+      outptr[blue] = inptr2[col];
+      if (pixelsize == 4)
+	outptr[3] = MAXJSAMPLE;
+      outptr += pixelsize;
+    }
+  }
+}
+
+
 /*
  * Adobe-style YCCK->CMYK conversion.
  * We convert YCbCr to R=1-C, G=1-M, and B=1-Y using the same
@@ -305,6 +421,9 @@ jinit_color_deconverter (j_decompress_ptr cinfo)
 {
   my_cconvert_ptr cconvert;
   int ci;
+#ifdef JSIMD_SUPPORTED
+  int simd;
+#endif
 
   cconvert = (my_cconvert_ptr)
     (*cinfo->mem->alloc_small) ((j_common_ptr) cinfo, JPOOL_IMAGE,
@@ -360,6 +479,13 @@ jinit_color_deconverter (j_decompress_ptr cinfo)
     if (cinfo->jpeg_color_space == JCS_YCbCr) {
       cconvert->pub.color_convert = ycc_rgb_convert;
       build_ycc_rgb_table(cinfo);
+#ifdef JSIMD_SUPPORTED
+      simd = jsimd_support();
+      if (simd & JSIMD_AVX2)
+	cconvert->pub.color_convert = jsimd_ycc_rgb_convert_avx2;
+      else if (simd & JSIMD_SSE41)
+	cconvert->pub.color_convert = jsimd_ycc_rgb_convert_sse41;
+#endif
     } else if (cinfo->jpeg_color_space == JCS_GRAYSCALE) {
       cconvert->pub.color_convert = gray_rgb_convert;
     } else if (cinfo->jpeg_color_space == JCS_RGB && RGB_PIXELSIZE == 3) {
@@ -368,6 +494,38 @@ jinit_color_deconverter (j_decompress_ptr cinfo)
       ERREXIT(cinfo, JERR_CONVERSION_NOTIMPL);
     break;
 
+  case JCS_EXT_RGBA:
+  case JCS_EXT_BGR:
+  case JCS_EXT_BGRA:
+    cconvert->ext_red = cinfo->out_color_space == JCS_EXT_RGBA ? 0 : 2;
+    cconvert->ext_blue = 2 - cconvert->ext_red;
+    cconvert->ext_pixelsize = cinfo->out_color_space == JCS_EXT_BGR ? 3 : 4;
+    cinfo->out_color_components = cconvert->ext_pixelsize;
+    if (cinfo->jpeg_color_space == JCS_YCbCr) {
+      cconvert->pub.color_convert = ycc_ext_convert;
+      build_ycc_rgb_table(cinfo);
+#ifdef JSIMD_SUPPORTED
+      simd = jsimd_support();
+      if (cconvert->ext_pixelsize == 3) {
+	if (simd & JSIMD_AVX2)
+	  cconvert->pub.color_convert = jsimd_ycc_rgb_convert_avx2;
+	else if (simd & JSIMD_SSE41)
+	  cconvert->pub.color_convert = jsimd_ycc_rgb_convert_sse41;
+      } else {
+	if (simd & JSIMD_AVX2)
+	  cconvert->pub.color_convert = jsimd_ycc_rgba_convert_avx2;
+	else if (simd & JSIMD_SSE41)
+	  cconvert->pub.color_convert = jsimd_ycc_rgba_convert_sse41;
+      }
+#endif
+    } else if (cinfo->jpeg_color_space == JCS_GRAYSCALE) {
+      cconvert->pub.color_convert = gray_ext_convert;
+    } else if (cinfo->jpeg_color_space == JCS_RGB) {
+      cconvert->pub.color_convert = rgb_ext_convert;
+    } else
+      ERREXIT(cinfo, JERR_CONVERSION_NOTIMPL);
+    break;
+
   case JCS_CMYK:
     cinfo->out_color_components = 4;
     if (cinfo->jpeg_color_space == JCS_YCCK) {
@@ -19,6 +19,7 @@
 #include "jinclude.h"
 #include "jpeglib.h"
 #include "jdct.h"		/* Private declarations for DCT subsystem */
+#include "jsimd.h"
 
 
 /*
@@ -94,6 +95,9 @@ start_pass (j_decompress_ptr cinfo)
   int method = 0;
   inverse_DCT_method_ptr method_ptr = NULL;
   JQUANT_TBL * qtbl;
+#ifdef JSIMD_SUPPORTED
+  int simd = jsimd_support();
+#endif
 
   for (ci = 0, compptr = cinfo->comp_info; ci < cinfo->num_components;
        ci++, compptr++) {
@@ -118,12 +122,24 @@ start_pass (j_decompress_ptr cinfo)
 #ifdef DCT_ISLOW_SUPPORTED
       case JDCT_ISLOW:
 	method_ptr = jpeg_idct_islow;
+#ifdef JSIMD_SUPPORTED
+	if (simd & JSIMD_AVX2)
+	  method_ptr = jsimd_idct_islow_avx2;
+	else if (simd & JSIMD_SSE41)
+	  method_ptr = jsimd_idct_islow_sse41;
+#endif
 	method = JDCT_ISLOW;
 	break;
 #endif
 #ifdef DCT_IFAST_SUPPORTED
       case JDCT_IFAST:
 	method_ptr = jpeg_idct_ifast;
+#ifdef JSIMD_SUPPORTED
+	if (simd & JSIMD_AVX2)
+	  method_ptr = jsimd_idct_ifast_avx2;
+	else if (simd & JSIMD_SSE41)
+	  method_ptr = jsimd_idct_ifast_sse41;
+#endif
 	method = JDCT_IFAST;
 	break;
 #endif
@@ -180,10 +180,13 @@ jpeg_calc_output_dimensions (j_decompress_ptr cinfo)
     break;
 #endif /* else share code with YCbCr */
   case JCS_YCbCr:
+  case JCS_EXT_BGR:
     cinfo->out_color_components = 3;
     break;
   case JCS_CMYK:
   case JCS_YCCK:
+  case JCS_EXT_RGBA:
+  case JCS_EXT_BGRA:
     cinfo->out_color_components = 4;
     break;
   default:			/* else must be same colorspace as in file */
@@ -21,6 +21,7 @@
 #define JPEG_INTERNALS
 #include "jinclude.h"
 #include "jpeglib.h"
+#include "jsimd.h"
 
 
 /* Pointer to routine to upsample a single component */
@@ -403,6 +404,9 @@ jinit_upsampler (j_decompress_ptr cinfo)
   jpeg_component_info * compptr;
   boolean need_buffer, do_fancy;
   int h_in_group, v_in_group, h_out_group, v_out_group;
+#ifdef JSIMD_SUPPORTED
+  int simd = jsimd_support();
+#endif
 
   upsample = (my_upsample_ptr)
     (*cinfo->mem->alloc_small) ((j_common_ptr) cinfo, JPOOL_IMAGE,
@@ -447,15 +451,23 @@ jinit_upsampler (j_decompress_ptr cinfo)
     } else if (h_in_group * 2 == h_out_group &&
 	       v_in_group == v_out_group) {
       /* Special cases for 2h1v upsampling */
-      if (do_fancy && compptr->downsampled_width > 2)
+      if (do_fancy && compptr->downsampled_width > 2) {
 	upsample->methods[ci] = h2v1_fancy_upsample;
-      else
+#ifdef JSIMD_SUPPORTED
+	if (simd & JSIMD_SSE2)
+	  upsample->methods[ci] = jsimd_h2v1_fancy_upsample_sse2;
+#endif
+      } else
 	upsample->methods[ci] = h2v1_upsample;
     } else if (h_in_group * 2 == h_out_group &&
 	       v_in_group * 2 == v_out_group) {
       /* Special cases for 2h2v upsampling */
       if (do_fancy && compptr->downsampled_width > 2) {
 	upsample->methods[ci] = h2v2_fancy_upsample;
+#ifdef JSIMD_SUPPORTED
+	if (simd & JSIMD_SSE2)
+	  upsample->methods[ci] = jsimd_h2v2_fancy_upsample_sse2;
+#endif
 	upsample->pub.need_context_rows = TRUE;
       } else
 	upsample->methods[ci] = h2v2_upsample;
@@ -19,7 +19,9 @@
  * JPEG standard, and the IJG code does not support anything else!
  * We do not support run-time selection of data precision, sorry.
  */
-#include <Windows.h>
+#ifdef _WIN32
+#include <Windows.h>		/* defines boolean, see HAVE_BOOLEAN below */
+#endif
 
 #define BITS_IN_JSAMPLE  8	/* use 8 or 12 */
 
@@ -159,7 +161,9 @@ typedef short INT16;
 /* INT32 must hold at least signed 32-bit values. */
 
 #ifndef XMD_H			/* X11/xmd.h correctly defines INT32 */
-//typedef long INT32;
+#ifndef _WIN32			/* Windows.h defines INT32 as int */
+typedef int INT32;
+#endif
 #endif
 
 /* Datatype used for image dimensions.  The JPEG standard only supports
@@ -225,7 +229,9 @@ typedef unsigned int JDIMENSION;
  */
 
 #ifndef HAVE_BOOLEAN
-//typedef int boolean;
+#ifndef _WIN32
+typedef int boolean;
+#endif
 #endif
 #ifndef FALSE			/* in case these macros already exist */
 #define FALSE	0		/* values of boolean */
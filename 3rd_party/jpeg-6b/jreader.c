@@ -114,3 +114,74 @@ jpeg_reader_src (j_decompress_ptr cinfo, struct jpeg_datarw_struct *rw)
   src->pub.bytes_in_buffer = 0; /* forces fill_input_buffer on first read */
   src->pub.next_input_byte = NULL; /* until buffer loaded */
 }
+
+
+/* Data source object for the memory, the whole input is the buffer */
+
+METHODDEF(void)
+init_source_m (j_decompress_ptr cinfo)
+{
+  /* no work necessary here */
+}
+
+
+METHODDEF(boolean)
+fill_input_buffer_m (j_decompress_ptr cinfo)
+{
+  static const JOCTET eoi[2] = { (JOCTET) 0xFF, (JOCTET) JPEG_EOI };
+
+  /* all data has been consumed, insert a fake EOI marker */
+  WARNMS(cinfo, JWRN_JPEG_EOF);
+  cinfo->src->next_input_byte = eoi;
+  cinfo->src->bytes_in_buffer = 2;
+
+  return TRUE;
+}
+
+
+METHODDEF(void)
+skip_input_data_m (j_decompress_ptr cinfo, long num_bytes)
+{
+  struct jpeg_source_mgr * src = cinfo->src;
+
+  if (num_bytes > 0) {
+    while (num_bytes > (long) src->bytes_in_buffer) {
+      num_bytes -= (long) src->bytes_in_buffer;
+      (void) fill_input_buffer_m(cinfo);
+    }
+    src->next_input_byte += (size_t) num_bytes;
+    src->bytes_in_buffer -= (size_t) num_bytes;
+  }
+}
+
+
+METHODDEF(void)
+term_source_m (j_decompress_ptr cinfo)
+{
+  /* no work necessary here */
+}
+
+
+GLOBAL(void)
+jpeg_memory_src (j_decompress_ptr cinfo, const JOCTET *data, size_t size)
+{
+  struct jpeg_source_mgr * src;
+
+  if (size == 0)                /* Treat empty input as fatal error */
+    ERREXIT(cinfo, JERR_INPUT_EMPTY);
+
+  if (cinfo->src == NULL) {     /* first time for this JPEG object? */
+    cinfo->src = (struct jpeg_source_mgr *)
+      (*cinfo->mem->alloc_small) ((j_common_ptr) cinfo, JPOOL_PERMANENT,
+                  SIZEOF(struct jpeg_source_mgr));
+  }
+
+  src = cinfo->src;
+  src->init_source = init_source_m;
+  src->fill_input_buffer = fill_input_buffer_m;
+  src->skip_input_data = skip_input_data_m;
+  src->resync_to_restart = jpeg_resync_to_restart; /* use default method */
+  src->term_source = term_source_m;
+  src->bytes_in_buffer = size;
+  src->next_input_byte = data;
+}
@@ -0,0 +1,53 @@
+/*
+ * jsimd.c
+ *
+ * This file is part of the Independent JPEG Group's software.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This file contains the run-time check of the instruction sets used by
+ * the SIMD routines (jsimdidct.c, jsimdsamp.c, jsimdcolor.c).
+ */
+
+#define JPEG_INTERNALS
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jsimd.h"
+
+#ifdef JSIMD_SUPPORTED
+
+
+/*
+ * Report the instruction sets of the CPU as JSIMD_xxx flags.
+ * __builtin_cpu_supports() reads the flags filled by the runtime at startup,
+ * the call is cheap enough for the module initialization routines.
+ *
+ * The environment variable JSIMD_FORCENONE=1 selects the portable code and
+ * JSIMD_FORCESSE41=1 turns AVX2 off, so the SIMD routines can be compared
+ * with the portable ones in one program.  Define NO_GETENV to disable this.
+ */
+
+GLOBAL(int)
+jsimd_support (void)
+{
+  int flags = 0;
+#ifndef NO_GETENV
+  char * env;
+
+  if ((env = getenv("JSIMD_FORCENONE")) != NULL && env[0] == '1')
+    return 0;
+#endif
+
+  if (__builtin_cpu_supports("sse2"))
+    flags |= JSIMD_SSE2;
+  if (__builtin_cpu_supports("sse4.1"))
+    flags |= JSIMD_SSE41;
+  if (__builtin_cpu_supports("avx2"))
+    flags |= JSIMD_AVX2;
+#ifndef NO_GETENV
+  if ((env = getenv("JSIMD_FORCESSE41")) != NULL && env[0] == '1')
+    flags &= ~JSIMD_AVX2;
+#endif
+  return flags;
+}
+
+#endif /* JSIMD_SUPPORTED */
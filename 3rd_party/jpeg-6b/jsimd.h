@@ -0,0 +1,79 @@
+/*
+ * jsimd.h
+ *
+ * This file is part of the Independent JPEG Group's software.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This include file declares the SIMD versions of the decompressor inner
+ * loops: the islow and ifast IDCTs, the h2v1 and h2v2 fancy upsampling and
+ * the YCbCr->RGB/RGBA color conversion.  These declarations are private to
+ * the modules that select them (jddctmgr.c, jdsample.c, jdcolor.c).
+ *
+ * The SIMD code is compiled with the target attributes of GCC and clang,
+ * so the library is built without the -m flags and runs on any x86 CPU.
+ * The module initialization routines call jsimd_support() and store the
+ * method pointers, nothing is tested per row or per block.  Every routine
+ * computes exactly the same samples as the portable one it replaces.
+ * Define NO_SIMD to build the portable code only, or set JSIMD_FORCENONE=1
+ * (JSIMD_FORCESSE41=1 for no AVX2) in the environment to select it at run
+ * time.
+ */
+
+#if !defined(NO_SIMD) && defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(__i386__)) && \
+    BITS_IN_JSAMPLE == 8 && DCTSIZE == 8 && \
+    RGB_RED == 0 && RGB_GREEN == 1 && RGB_BLUE == 2 && RGB_PIXELSIZE == 3
+#define JSIMD_SUPPORTED
+#endif
+
+#ifdef JSIMD_SUPPORTED
+
+/* Instruction sets reported by jsimd_support() */
+
+#define JSIMD_SSE2	0x01
+#define JSIMD_SSE41	0x02
+#define JSIMD_AVX2	0x04
+
+EXTERN(int) jsimd_support JPP((void));
+
+/* Inverse DCT routines, see jdct.h */
+
+EXTERN(void) jsimd_idct_islow_sse41
+    JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	 JCOEFPTR coef_block, JSAMPARRAY output_buf, JDIMENSION output_col));
+EXTERN(void) jsimd_idct_islow_avx2
+    JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	 JCOEFPTR coef_block, JSAMPARRAY output_buf, JDIMENSION output_col));
+EXTERN(void) jsimd_idct_ifast_sse41
+    JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	 JCOEFPTR coef_block, JSAMPARRAY output_buf, JDIMENSION output_col));
+EXTERN(void) jsimd_idct_ifast_avx2
+    JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	 JCOEFPTR coef_block, JSAMPARRAY output_buf, JDIMENSION output_col));
+
+/* Upsampling routines, see jdsample.c */
+
+EXTERN(void) jsimd_h2v1_fancy_upsample_sse2
+    JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	 JSAMPARRAY input_data, JSAMPARRAY * output_data_ptr));
+EXTERN(void) jsimd_h2v2_fancy_upsample_sse2
+    JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	 JSAMPARRAY input_data, JSAMPARRAY * output_data_ptr));
+
+/* Color conversion routines, see jdcolor.c.  The rgb routines also do
+ * JCS_EXT_BGR, the rgba routines JCS_EXT_RGBA and JCS_EXT_BGRA. */
+
+EXTERN(void) jsimd_ycc_rgb_convert_sse41
+    JPP((j_decompress_ptr cinfo, JSAMPIMAGE input_buf, JDIMENSION input_row,
+	 JSAMPARRAY output_buf, int num_rows));
+EXTERN(void) jsimd_ycc_rgb_convert_avx2
+    JPP((j_decompress_ptr cinfo, JSAMPIMAGE input_buf, JDIMENSION input_row,
+	 JSAMPARRAY output_buf, int num_rows));
+EXTERN(void) jsimd_ycc_rgba_convert_sse41
+    JPP((j_decompress_ptr cinfo, JSAMPIMAGE input_buf, JDIMENSION input_row,
+	 JSAMPARRAY output_buf, int num_rows));
+EXTERN(void) jsimd_ycc_rgba_convert_avx2
+    JPP((j_decompress_ptr cinfo, JSAMPIMAGE input_buf, JDIMENSION input_row,
+	 JSAMPARRAY output_buf, int num_rows));
+
+#endif /* JSIMD_SUPPORTED */
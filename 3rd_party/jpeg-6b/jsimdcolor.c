@@ -0,0 +1,327 @@
+/*
+ * jsimdcolor.c
+ *
+ * This file is part of the Independent JPEG Group's software.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This file contains SSE4.1 and AVX2 versions of the YCbCr->RGB and
+ * YCbCr->RGBA conversion of jdcolor.c.  The same routines write BGR and
+ * BGRA, the red and the blue vectors are swapped before the stores.
+ *
+ * The tables of jdcolor.c hold FIX(c) * x scaled by 2**16 with the constants
+ * 1.40200, 1.77200, 0.71414 and 0.34414.  The constants do not fit 16 bits,
+ * so they are split in a multiple of 2**16 and a remainder that does:
+ *	R = Y + Cr + ((26345*Cr + 32768) >> 16)
+ *	B = Y + 2*Cb + ((-14942*Cb + 32768) >> 16)
+ *	G = Y - Cr + ((-22554*Cb + 18734*Cr + 32768) >> 16)
+ * where Cb and Cr are centered on 0.  The sums in the parentheses are done
+ * by pmaddwd on pairs of 16-bit lanes, the other terms drop out of the
+ * shifts exactly, so the samples are bit-exact.  The range limiting is the
+ * saturation of the final pack.  SSSE3 (pshufb) interleaves the RGB samples,
+ * the least instruction set of these routines is SSE4.1 as for the IDCT.
+ */
+
+#define JPEG_INTERNALS
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jsimd.h"
+
+#ifdef JSIMD_SUPPORTED
+
+#include <immintrin.h>
+
+#define SCALEBITS	16
+#define ONE_HALF	((INT32) 1 << (SCALEBITS-1))
+#define FIX(x)		((INT32) ((x) * (1L<<SCALEBITS) + 0.5))
+
+/* pmaddwd multipliers: (Cr, 2) for R, (Cb, 2) for B, (Cb, Cr) for G */
+#define MADD_PAIR(lo, hi)  ((int) (((unsigned int) (hi) << 16) | ((lo) & 0xFFFF)))
+#define MADD_R	MADD_PAIR(26345, ONE_HALF/2)
+#define MADD_B	MADD_PAIR(-14942, ONE_HALF/2)
+#define MADD_G	MADD_PAIR(-22554, 18734)
+
+
+/*
+ * Convert the lo or hi halves (unpack is unpacklo or unpackhi) of the
+ * bytes y, cb, cr to R, G, B on 16-bit lanes.  P is the prefix of the
+ * intrinsics, _mm_ or _mm256_; the AVX2 unpacks and packs work within
+ * the 128-bit lanes and leave the samples in order.
+ */
+
+#define YCC_RGB_HALF(P, V, unpack, y, cb, cr, r, g, b) \
+  { \
+    V yw = P##unpack##_epi8(y, zero); \
+    V cbw = P##sub_epi16(P##unpack##_epi8(cb, zero), center); \
+    V crw = P##sub_epi16(P##unpack##_epi8(cr, zero), center); \
+    V lo, hi; \
+    lo = P##srai_epi32(P##madd_epi16(P##unpacklo_epi16(crw, two), madd_r), SCALEBITS); \
+    hi = P##srai_epi32(P##madd_epi16(P##unpackhi_epi16(crw, two), madd_r), SCALEBITS); \
+    r = P##add_epi16(P##add_epi16(yw, crw), P##packs_epi32(lo, hi)); \
+    lo = P##srai_epi32(P##madd_epi16(P##unpacklo_epi16(cbw, two), madd_b), SCALEBITS); \
+    hi = P##srai_epi32(P##madd_epi16(P##unpackhi_epi16(cbw, two), madd_b), SCALEBITS); \
+    b = P##add_epi16(P##add_epi16(yw, P##add_epi16(cbw, cbw)), P##packs_epi32(lo, hi)); \
+    lo = P##srai_epi32(P##add_epi32(P##madd_epi16(P##unpacklo_epi16(cbw, crw), madd_g), \
+				    one_half), SCALEBITS); \
+    hi = P##srai_epi32(P##add_epi32(P##madd_epi16(P##unpackhi_epi16(cbw, crw), madd_g), \
+				    one_half), SCALEBITS); \
+    g = P##sub_epi16(P##add_epi16(yw, P##packs_epi32(lo, hi)), crw); \
+  }
+
+/* Convert the vectors y, cb, cr of bytes to the vectors r, g, b of bytes */
+
+#define YCC_RGB(P, V, y, cb, cr, r, g, b) \
+  { \
+    V rl, gl, bl, rh, gh, bh; \
+    YCC_RGB_HALF(P, V, unpacklo, y, cb, cr, rl, gl, bl); \
+    YCC_RGB_HALF(P, V, unpackhi, y, cb, cr, rh, gh, bh); \
+    r = P##packus_epi16(rl, rh); \
+    g = P##packus_epi16(gl, gh); \
+    b = P##packus_epi16(bl, bh); \
+  }
+
+#define YCC_CONSTANTS(P, V, SI) \
+  const V zero = P##setzero_##SI(); \
+  const V center = P##set1_epi16(CENTERJSAMPLE); \
+  const V two = P##set1_epi16(2); \
+  const V one_half = P##set1_epi32(ONE_HALF); \
+  const V madd_r = P##set1_epi32(MADD_R); \
+  const V madd_b = P##set1_epi32(MADD_B); \
+  const V madd_g = P##set1_epi32(MADD_G)
+
+
+/* pshufb masks of 16 pixels in three planes to 48 bytes of RGB */
+
+#define Z 0x80
+static const unsigned char rgb_shuffle[3][3][16] __attribute__((aligned(16))) = {
+  {
+    { 0, Z, Z, 1, Z, Z, 2, Z, Z, 3, Z, Z, 4, Z, Z, 5 },
+    { Z, Z, 6, Z, Z, 7, Z, Z, 8, Z, Z, 9, Z, Z, 10, Z },
+    { Z, 11, Z, Z, 12, Z, Z, 13, Z, Z, 14, Z, Z, 15, Z, Z }
+  },
+  {
+    { Z, 0, Z, Z, 1, Z, Z, 2, Z, Z, 3, Z, Z, 4, Z, Z },
+    { 5, Z, Z, 6, Z, Z, 7, Z, Z, 8, Z, Z, 9, Z, Z, 10 },
+    { Z, Z, 11, Z, Z, 12, Z, Z, 13, Z, Z, 14, Z, Z, 15, Z }
+  },
+  {
+    { Z, Z, 0, Z, Z, 1, Z, Z, 2, Z, Z, 3, Z, Z, 4, Z },
+    { Z, 5, Z, Z, 6, Z, Z, 7, Z, Z, 8, Z, Z, 9, Z, Z },
+    { 10, Z, Z, 11, Z, Z, 12, Z, Z, 13, Z, Z, 14, Z, Z, 15 }
+  }
+};
+#undef Z
+
+
+/* TRUE if the output space stores blue first */
+
+#define IS_BGR(cinfo)  ((cinfo)->out_color_space == JCS_EXT_BGR || \
+			(cinfo)->out_color_space == JCS_EXT_BGRA)
+
+#define SWAP_RB(V, r, b, bgr) \
+  if (bgr) { \
+    V t = r; r = b; b = t; \
+  }
+
+
+/*
+ * The pixels left over at the end of the row, as ycc_rgb_convert does.
+ */
+
+LOCAL(void)
+ycc_convert_tail (j_decompress_ptr cinfo, JSAMPROW inptr0, JSAMPROW inptr1,
+		  JSAMPROW inptr2, JSAMPROW outptr, JDIMENSION col,
+		  JDIMENSION num_cols, int pixelsize)
+{
+  register int y, cb, cr;
+  register JSAMPLE * range_limit = cinfo->sample_range_limit;
+  int red = IS_BGR(cinfo) ? 2 : 0;
+  int blue = 2 - red;
+  SHIFT_TEMPS
+
+  outptr += col * pixelsize;
+  for (; col < num_cols; col++) {
+    y  = GETJSAMPLE(inptr0[col]);
+    cb = GETJSAMPLE(inptr1[col]) - CENTERJSAMPLE;
+    cr = GETJSAMPLE(inptr2[col]) - CENTERJSAMPLE;
+    outptr[red] = range_limit[y +
+		(int) RIGHT_SHIFT(FIX(1.40200) * cr + ONE_HALF, SCALEBITS)];
+    outptr[1] = range_limit[y +
+		(int) RIGHT_SHIFT(- FIX(0.34414) * cb - FIX(0.71414) * cr +
+				  ONE_HALF, SCALEBITS)];
+    outptr[blue] = range_limit[y +
+		(int) RIGHT_SHIFT(FIX(1.77200) * cb + ONE_HALF, SCALEBITS)];
+    if (pixelsize == 4)
+      outptr[3] = MAXJSAMPLE;
+    outptr += pixelsize;
+  }
+}
+
+
+/************************ SSE4.1, 16 pixels ************************/
+
+#define SSE41 __attribute__((target("sse4.1")))
+
+#define LOADU(ptr)  _mm_loadu_si128((const __m128i *) (ptr))
+#define STOREU(ptr, v)  _mm_storeu_si128((__m128i *) (ptr), v)
+
+GLOBAL(void) SSE41
+jsimd_ycc_rgb_convert_sse41 (j_decompress_ptr cinfo,
+			     JSAMPIMAGE input_buf, JDIMENSION input_row,
+			     JSAMPARRAY output_buf, int num_rows)
+{
+  YCC_CONSTANTS(_mm_, __m128i, si128);
+  const __m128i * shuffle = (const __m128i *) rgb_shuffle;
+  JDIMENSION num_cols = cinfo->output_width;
+  JSAMPROW inptr0, inptr1, inptr2, outptr;
+  JDIMENSION col;
+  int bgr = IS_BGR(cinfo);
+  int k;
+
+  while (--num_rows >= 0) {
+    inptr0 = input_buf[0][input_row];
+    inptr1 = input_buf[1][input_row];
+    inptr2 = input_buf[2][input_row];
+    input_row++;
+    outptr = *output_buf++;
+    for (col = 0; col + 16 <= num_cols; col += 16) {
+      __m128i r, g, b;
+      YCC_RGB(_mm_, __m128i, LOADU(inptr0 + col), LOADU(inptr1 + col),
+	      LOADU(inptr2 + col), r, g, b);
+      SWAP_RB(__m128i, r, b, bgr);
+      for (k = 0; k < 3; k++)
+	STOREU(outptr + 3*col + 16*k,
+	       _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, shuffle[k]),
+					 _mm_shuffle_epi8(g, shuffle[3+k])),
+			    _mm_shuffle_epi8(b, shuffle[6+k])));
+    }
+    ycc_convert_tail(cinfo, inptr0, inptr1, inptr2, outptr, col, num_cols, 3);
+  }
+}
+
+GLOBAL(void) SSE41
+jsimd_ycc_rgba_convert_sse41 (j_decompress_ptr cinfo,
+			      JSAMPIMAGE input_buf, JDIMENSION input_row,
+			      JSAMPARRAY output_buf, int num_rows)
+{
+  YCC_CONSTANTS(_mm_, __m128i, si128);
+  const __m128i alpha = _mm_set1_epi8((char) MAXJSAMPLE);
+  JDIMENSION num_cols = cinfo->output_width;
+  JSAMPROW inptr0, inptr1, inptr2, outptr;
+  JDIMENSION col;
+  int bgr = IS_BGR(cinfo);
+
+  while (--num_rows >= 0) {
+    inptr0 = input_buf[0][input_row];
+    inptr1 = input_buf[1][input_row];
+    inptr2 = input_buf[2][input_row];
+    input_row++;
+    outptr = *output_buf++;
+    for (col = 0; col + 16 <= num_cols; col += 16) {
+      __m128i r, g, b, rg, ba;
+      YCC_RGB(_mm_, __m128i, LOADU(inptr0 + col), LOADU(inptr1 + col),
+	      LOADU(inptr2 + col), r, g, b);
+      SWAP_RB(__m128i, r, b, bgr);
+      rg = _mm_unpacklo_epi8(r, g);
+      ba = _mm_unpacklo_epi8(b, alpha);
+      STOREU(outptr + 4*col, _mm_unpacklo_epi16(rg, ba));
+      STOREU(outptr + 4*col + 16, _mm_unpackhi_epi16(rg, ba));
+      rg = _mm_unpackhi_epi8(r, g);
+      ba = _mm_unpackhi_epi8(b, alpha);
+      STOREU(outptr + 4*col + 32, _mm_unpacklo_epi16(rg, ba));
+      STOREU(outptr + 4*col + 48, _mm_unpackhi_epi16(rg, ba));
+    }
+    ycc_convert_tail(cinfo, inptr0, inptr1, inptr2, outptr, col, num_cols, 4);
+  }
+}
+
+
+/************************ AVX2, 32 pixels ************************/
+
+#define AVX2 __attribute__((target("avx2")))
+
+#define LOADU8(ptr)  _mm256_loadu_si256((const __m256i *) (ptr))
+#define STOREU8(ptr, v)  _mm256_storeu_si256((__m256i *) (ptr), v)
+
+GLOBAL(void) AVX2
+jsimd_ycc_rgb_convert_avx2 (j_decompress_ptr cinfo,
+			    JSAMPIMAGE input_buf, JDIMENSION input_row,
+			    JSAMPARRAY output_buf, int num_rows)
+{
+  YCC_CONSTANTS(_mm256_, __m256i, si256);
+  __m256i shuffle[9];
+  JDIMENSION num_cols = cinfo->output_width;
+  JSAMPROW inptr0, inptr1, inptr2, outptr;
+  JDIMENSION col;
+  int bgr = IS_BGR(cinfo);
+  int k;
+
+  for (k = 0; k < 9; k++)
+    shuffle[k] = _mm256_broadcastsi128_si256(
+		   _mm_load_si128((const __m128i *) rgb_shuffle + k));
+
+  while (--num_rows >= 0) {
+    inptr0 = input_buf[0][input_row];
+    inptr1 = input_buf[1][input_row];
+    inptr2 = input_buf[2][input_row];
+    input_row++;
+    outptr = *output_buf++;
+    for (col = 0; col + 32 <= num_cols; col += 32) {
+      __m256i r, g, b, c[3];
+      YCC_RGB(_mm256_, __m256i, LOADU8(inptr0 + col), LOADU8(inptr1 + col),
+	      LOADU8(inptr2 + col), r, g, b);
+      SWAP_RB(__m256i, r, b, bgr);
+      /* the 128-bit lanes are pixels 0..15 and 16..31 */
+      for (k = 0; k < 3; k++)
+	c[k] = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(r, shuffle[k]),
+					       _mm256_shuffle_epi8(g, shuffle[3+k])),
+			       _mm256_shuffle_epi8(b, shuffle[6+k]));
+      STOREU8(outptr + 3*col, _mm256_permute2x128_si256(c[0], c[1], 0x20));
+      STOREU8(outptr + 3*col + 32, _mm256_permute2x128_si256(c[2], c[0], 0x30));
+      STOREU8(outptr + 3*col + 64, _mm256_permute2x128_si256(c[1], c[2], 0x31));
+    }
+    ycc_convert_tail(cinfo, inptr0, inptr1, inptr2, outptr, col, num_cols, 3);
+  }
+}
+
+GLOBAL(void) AVX2
+jsimd_ycc_rgba_convert_avx2 (j_decompress_ptr cinfo,
+			     JSAMPIMAGE input_buf, JDIMENSION input_row,
+			     JSAMPARRAY output_buf, int num_rows)
+{
+  YCC_CONSTANTS(_mm256_, __m256i, si256);
+  const __m256i alpha = _mm256_set1_epi8((char) MAXJSAMPLE);
+  JDIMENSION num_cols = cinfo->output_width;
+  JSAMPROW inptr0, inptr1, inptr2, outptr;
+  JDIMENSION col;
+  int bgr = IS_BGR(cinfo);
+
+  while (--num_rows >= 0) {
+    inptr0 = input_buf[0][input_row];
+    inptr1 = input_buf[1][input_row];
+    inptr2 = input_buf[2][input_row];
+    input_row++;
+    outptr = *output_buf++;
+    for (col = 0; col + 32 <= num_cols; col += 32) {
+      __m256i r, g, b, rg, ba, p0, p1, p2, p3;
+      YCC_RGB(_mm256_, __m256i, LOADU8(inptr0 + col), LOADU8(inptr1 + col),
+	      LOADU8(inptr2 + col), r, g, b);
+      SWAP_RB(__m256i, r, b, bgr);
+      /* pixels 0..3|16..19, 4..7|20..23, 8..11|24..27, 12..15|28..31 */
+      rg = _mm256_unpacklo_epi8(r, g);
+      ba = _mm256_unpacklo_epi8(b, alpha);
+      p0 = _mm256_unpacklo_epi16(rg, ba);
+      p1 = _mm256_unpackhi_epi16(rg, ba);
+      rg = _mm256_unpackhi_epi8(r, g);
+      ba = _mm256_unpackhi_epi8(b, alpha);
+      p2 = _mm256_unpacklo_epi16(rg, ba);
+      p3 = _mm256_unpackhi_epi16(rg, ba);
+      STOREU8(outptr + 4*col, _mm256_permute2x128_si256(p0, p1, 0x20));
+      STOREU8(outptr + 4*col + 32, _mm256_permute2x128_si256(p2, p3, 0x20));
+      STOREU8(outptr + 4*col + 64, _mm256_permute2x128_si256(p0, p1, 0x31));
+      STOREU8(outptr + 4*col + 96, _mm256_permute2x128_si256(p2, p3, 0x31));
+    }
+    ycc_convert_tail(cinfo, inptr0, inptr1, inptr2, outptr, col, num_cols, 4);
+  }
+}
+
+#endif /* JSIMD_SUPPORTED */
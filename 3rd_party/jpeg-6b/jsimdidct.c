@@ -0,0 +1,448 @@
+/*
+ * jsimdidct.c
+ *
+ * This file is part of the Independent JPEG Group's software.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This file contains SSE4.1 and AVX2 versions of the inverse DCTs of
+ * jidctint.c (islow) and jidctfst.c (ifast).
+ *
+ * The arithmetic is the one of the portable routines on 32-bit lanes: the
+ * multiplications, the shifts and the wraparound are those of INT32, so the
+ * samples are bit-exact, also for corrupt data.  A vector holds 4 (SSE4.1)
+ * or 8 (AVX2) columns in pass 1; the work array is transposed in registers
+ * and a vector holds 4 or 8 rows in pass 2.  SSE2 has no 32-bit multiply
+ * (pmulld), so SSE4.1 is the least instruction set of these routines.
+ *
+ * The portable routines skip the columns and the rows whose AC terms are
+ * all zero.  Where the shortcut gives other values than the full
+ * calculation (the shifts of islow overflow), the lanes of such columns
+ * and rows are replaced with the shortcut values.
+ */
+
+#define JPEG_INTERNALS
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jdct.h"		/* Private declarations for DCT subsystem */
+#include "jsimd.h"
+
+#ifdef JSIMD_SUPPORTED
+
+#include <immintrin.h>
+
+/* The quantization tables are loaded as vectors of 32-bit multipliers */
+typedef char jsimd_mult_check[(SIZEOF(ISLOW_MULT_TYPE) == 4 &&
+			       SIZEOF(IFAST_MULT_TYPE) == 4 &&
+			       SIZEOF(JCOEF) == 2) ? 1 : -1];
+
+typedef int jvec4 __attribute__((vector_size(16)));
+typedef int jvec8 __attribute__((vector_size(32)));
+
+
+/*
+ * Range limiting of the outputs: range_limit[x & RANGE_MASK] of the
+ * portable routines is x sign extended from 10 bits plus CENTERJSAMPLE,
+ * clamped to 0..MAXJSAMPLE.  The clamp is done by the saturating packs.
+ */
+
+#define RANGE_CENTER(x) \
+  ((((x) & RANGE_MASK) ^ ((MAXJSAMPLE+1)*2)) - ((MAXJSAMPLE+1)*2 - CENTERJSAMPLE))
+
+
+/*
+ * One-dimensional islow IDCT of 8 vectors, see jidctint.c.
+ * T is the vector type, n the descale bits of the pass.
+ */
+
+#define ISLOW_CONST_BITS  13
+#define ISLOW_PASS1_BITS  2
+
+#define ISLOW_1D(T, in, out, n) \
+  { \
+    T tmp0, tmp1, tmp2, tmp3; \
+    T tmp10, tmp11, tmp12, tmp13; \
+    T z1, z2, z3, z4, z5; \
+    z2 = in[2]; \
+    z3 = in[6]; \
+    z1 = (z2 + z3) * 4433;		/* FIX_0_541196100 */ \
+    tmp2 = z1 + z3 * (-15137);		/* FIX_1_847759065 */ \
+    tmp3 = z1 + z2 * 6270;		/* FIX_0_765366865 */ \
+    tmp0 = (in[0] + in[4]) << ISLOW_CONST_BITS; \
+    tmp1 = (in[0] - in[4]) << ISLOW_CONST_BITS; \
+    tmp10 = tmp0 + tmp3; \
+    tmp13 = tmp0 - tmp3; \
+    tmp11 = tmp1 + tmp2; \
+    tmp12 = tmp1 - tmp2; \
+    tmp0 = in[7]; \
+    tmp1 = in[5]; \
+    tmp2 = in[3]; \
+    tmp3 = in[1]; \
+    z1 = tmp0 + tmp3; \
+    z2 = tmp1 + tmp2; \
+    z3 = tmp0 + tmp2; \
+    z4 = tmp1 + tmp3; \
+    z5 = (z3 + z4) * 9633;		/* FIX_1_175875602 */ \
+    tmp0 = tmp0 * 2446;			/* FIX_0_298631336 */ \
+    tmp1 = tmp1 * 16819;		/* FIX_2_053119869 */ \
+    tmp2 = tmp2 * 25172;		/* FIX_3_072711026 */ \
+    tmp3 = tmp3 * 12299;		/* FIX_1_501321110 */ \
+    z1 = z1 * (-7373);			/* FIX_0_899976223 */ \
+    z2 = z2 * (-20995);			/* FIX_2_562915447 */ \
+    z3 = z3 * (-16069);			/* FIX_1_961570560 */ \
+    z4 = z4 * (-3196);			/* FIX_0_390180644 */ \
+    z3 += z5; \
+    z4 += z5; \
+    tmp0 += z1 + z3; \
+    tmp1 += z2 + z4; \
+    tmp2 += z2 + z3; \
+    tmp3 += z1 + z4; \
+    out[0] = (tmp10 + tmp3 + (1 << ((n)-1))) >> (n); \
+    out[7] = (tmp10 - tmp3 + (1 << ((n)-1))) >> (n); \
+    out[1] = (tmp11 + tmp2 + (1 << ((n)-1))) >> (n); \
+    out[6] = (tmp11 - tmp2 + (1 << ((n)-1))) >> (n); \
+    out[2] = (tmp12 + tmp1 + (1 << ((n)-1))) >> (n); \
+    out[5] = (tmp12 - tmp1 + (1 << ((n)-1))) >> (n); \
+    out[3] = (tmp13 + tmp0 + (1 << ((n)-1))) >> (n); \
+    out[4] = (tmp13 - tmp0 + (1 << ((n)-1))) >> (n); \
+  }
+
+/* The lanes of zero, where all AC terms are zero, get the shortcut dc */
+
+#define ISLOW_SHORTCUT(T, out, zero, dc) \
+  { \
+    int i; \
+    for (i = 0; i < DCTSIZE; i++) \
+      out[i] = (out[i] & ~(zero)) | ((dc) & (zero)); \
+  }
+
+
+/*
+ * One-dimensional ifast IDCT of 8 vectors, see jidctfst.c.
+ * MULTIPLY does not round (USE_ACCURATE_ROUNDING is not defined).
+ * The shortcut of the portable routine gives the same values here.
+ */
+
+#define IFAST_MULTIPLY(var, c)  (((var) * (c)) >> 8)
+
+#define IFAST_1D(T, in, out) \
+  { \
+    T tmp0, tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, tmp7; \
+    T tmp10, tmp11, tmp12, tmp13; \
+    T z5, z10, z11, z12, z13; \
+    tmp10 = in[0] + in[4]; \
+    tmp11 = in[0] - in[4]; \
+    tmp13 = in[2] + in[6]; \
+    tmp12 = IFAST_MULTIPLY(in[2] - in[6], 362) - tmp13; /* FIX_1_414213562 */ \
+    tmp0 = tmp10 + tmp13; \
+    tmp3 = tmp10 - tmp13; \
+    tmp1 = tmp11 + tmp12; \
+    tmp2 = tmp11 - tmp12; \
+    z13 = in[5] + in[3]; \
+    z10 = in[5] - in[3]; \
+    z11 = in[1] + in[7]; \
+    z12 = in[1] - in[7]; \
+    tmp7 = z11 + z13; \
+    tmp11 = IFAST_MULTIPLY(z11 - z13, 362);	/* FIX_1_414213562 */ \
+    z5 = IFAST_MULTIPLY(z10 + z12, 473);	/* FIX_1_847759065 */ \
+    tmp10 = IFAST_MULTIPLY(z12, 277) - z5;	/* FIX_1_082392200 */ \
+    tmp12 = IFAST_MULTIPLY(z10, -669) + z5;	/* FIX_2_613125930 */ \
+    tmp6 = tmp12 - tmp7; \
+    tmp5 = tmp11 - tmp6; \
+    tmp4 = tmp10 + tmp5; \
+    out[0] = tmp0 + tmp7; \
+    out[7] = tmp0 - tmp7; \
+    out[1] = tmp1 + tmp6; \
+    out[6] = tmp1 - tmp6; \
+    out[2] = tmp2 + tmp5; \
+    out[5] = tmp2 - tmp5; \
+    out[4] = tmp3 + tmp4; \
+    out[3] = tmp3 - tmp4; \
+  }
+
+
+/************************ SSE4.1, 4 lanes ************************/
+
+#define SSE41 __attribute__((target("sse4.1")))
+
+LOCAL(void) SSE41
+transpose4 (jvec4 * v)
+{
+  __m128i t0 = _mm_unpacklo_epi32((__m128i) v[0], (__m128i) v[1]);
+  __m128i t1 = _mm_unpackhi_epi32((__m128i) v[0], (__m128i) v[1]);
+  __m128i t2 = _mm_unpacklo_epi32((__m128i) v[2], (__m128i) v[3]);
+  __m128i t3 = _mm_unpackhi_epi32((__m128i) v[2], (__m128i) v[3]);
+
+  v[0] = (jvec4) _mm_unpacklo_epi64(t0, t2);
+  v[1] = (jvec4) _mm_unpackhi_epi64(t0, t2);
+  v[2] = (jvec4) _mm_unpacklo_epi64(t1, t3);
+  v[3] = (jvec4) _mm_unpackhi_epi64(t1, t3);
+}
+
+/* The transpose of the 8x8 work array held as lo (columns 0..3) and hi
+ * (columns 4..7): lo gets rows 0..3 and hi rows 4..7 of every column.
+ */
+
+LOCAL(void) SSE41
+transpose8x4 (jvec4 * lo, jvec4 * hi)
+{
+  jvec4 t;
+  int i;
+
+  transpose4(lo);
+  transpose4(lo + 4);
+  transpose4(hi);
+  transpose4(hi + 4);
+  for (i = 0; i < 4; i++) {
+    t = lo[i + 4];
+    lo[i + 4] = hi[i];
+    hi[i] = t;
+  }
+}
+
+/* Range limit and store 4 rows of the lanes of out, columns 0..7 */
+
+LOCAL(void) SSE41
+store_rows4 (jvec4 * out, JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  __m128i r01, r23;
+  int i;
+
+  for (i = 0; i < DCTSIZE; i++)
+    out[i] = RANGE_CENTER(out[i]);
+  transpose4(out);
+  transpose4(out + 4);
+  r01 = _mm_packus_epi16(_mm_packs_epi32((__m128i) out[0], (__m128i) out[4]),
+			 _mm_packs_epi32((__m128i) out[1], (__m128i) out[5]));
+  r23 = _mm_packus_epi16(_mm_packs_epi32((__m128i) out[2], (__m128i) out[6]),
+			 _mm_packs_epi32((__m128i) out[3], (__m128i) out[7]));
+  _mm_storel_epi64((__m128i *) (output_buf[0] + output_col), r01);
+  _mm_storel_epi64((__m128i *) (output_buf[1] + output_col),
+		   _mm_unpackhi_epi64(r01, r01));
+  _mm_storel_epi64((__m128i *) (output_buf[2] + output_col), r23);
+  _mm_storel_epi64((__m128i *) (output_buf[3] + output_col),
+		   _mm_unpackhi_epi64(r23, r23));
+}
+
+LOCAL(jvec4) SSE41
+load_coef4 (JCOEFPTR coef)
+{
+  return (jvec4) _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i *) coef));
+}
+
+LOCAL(jvec4) SSE41
+load_mult4 (const int * mult)
+{
+  return (jvec4) _mm_loadu_si128((const __m128i *) mult);
+}
+
+
+GLOBAL(void) SSE41
+jsimd_idct_islow_sse41 (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+			JCOEFPTR coef_block,
+			JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  ISLOW_MULT_TYPE * quantptr = (ISLOW_MULT_TYPE *) compptr->dct_table;
+  jvec4 in[DCTSIZE], lo[DCTSIZE], hi[DCTSIZE];
+  jvec4 ac, dc, zero;
+  int i, half;
+
+  /* Pass 1: process columns 0..3 and 4..7 from input. */
+  for (half = 0; half < 2; half++) {
+    jvec4 * out = half ? hi : lo;
+    ac = (jvec4) _mm_setzero_si128();
+    for (i = 0; i < DCTSIZE; i++) {
+      in[i] = load_coef4(coef_block + DCTSIZE*i + 4*half);
+      if (i > 0)
+	ac |= in[i];
+      in[i] *= load_mult4(quantptr + DCTSIZE*i + 4*half);
+    }
+    ISLOW_1D(jvec4, in, out, ISLOW_CONST_BITS-ISLOW_PASS1_BITS);
+    zero = ac == 0;
+    dc = in[0] << ISLOW_PASS1_BITS;
+    ISLOW_SHORTCUT(jvec4, out, zero, dc);
+  }
+
+  /* Pass 2: process rows 0..3 and 4..7 from the work array. */
+  transpose8x4(lo, hi);
+  for (half = 0; half < 2; half++) {
+    jvec4 * ws = half ? hi : lo;
+    ac = ws[1] | ws[2] | ws[3] | ws[4] | ws[5] | ws[6] | ws[7];
+    zero = ac == 0;
+    dc = (ws[0] + (1 << (ISLOW_PASS1_BITS+3-1))) >> (ISLOW_PASS1_BITS+3);
+    ISLOW_1D(jvec4, ws, in, ISLOW_CONST_BITS+ISLOW_PASS1_BITS+3);
+    ISLOW_SHORTCUT(jvec4, in, zero, dc);
+    store_rows4(in, output_buf + 4*half, output_col);
+  }
+}
+
+
+GLOBAL(void) SSE41
+jsimd_idct_ifast_sse41 (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+			JCOEFPTR coef_block,
+			JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  IFAST_MULT_TYPE * quantptr = (IFAST_MULT_TYPE *) compptr->dct_table;
+  jvec4 in[DCTSIZE], lo[DCTSIZE], hi[DCTSIZE];
+  int i, half;
+
+  /* Pass 1: process columns 0..3 and 4..7 from input. */
+  for (half = 0; half < 2; half++) {
+    jvec4 * out = half ? hi : lo;
+    for (i = 0; i < DCTSIZE; i++)
+      in[i] = load_coef4(coef_block + DCTSIZE*i + 4*half) *
+	      load_mult4(quantptr + DCTSIZE*i + 4*half);
+    IFAST_1D(jvec4, in, out);
+  }
+
+  /* Pass 2: process rows 0..3 and 4..7, descale by 2**(PASS1_BITS+3). */
+  transpose8x4(lo, hi);
+  for (half = 0; half < 2; half++) {
+    jvec4 * ws = half ? hi : lo;
+    IFAST_1D(jvec4, ws, in);
+    for (i = 0; i < DCTSIZE; i++)
+      in[i] >>= 5;
+    store_rows4(in, output_buf + 4*half, output_col);
+  }
+}
+
+
+/************************ AVX2, 8 lanes ************************/
+
+#define AVX2 __attribute__((target("avx2")))
+
+LOCAL(void) AVX2
+transpose8 (jvec8 * v)
+{
+  __m256i t0 = _mm256_unpacklo_epi32((__m256i) v[0], (__m256i) v[1]);
+  __m256i t1 = _mm256_unpackhi_epi32((__m256i) v[0], (__m256i) v[1]);
+  __m256i t2 = _mm256_unpacklo_epi32((__m256i) v[2], (__m256i) v[3]);
+  __m256i t3 = _mm256_unpackhi_epi32((__m256i) v[2], (__m256i) v[3]);
+  __m256i t4 = _mm256_unpacklo_epi32((__m256i) v[4], (__m256i) v[5]);
+  __m256i t5 = _mm256_unpackhi_epi32((__m256i) v[4], (__m256i) v[5]);
+  __m256i t6 = _mm256_unpacklo_epi32((__m256i) v[6], (__m256i) v[7]);
+  __m256i t7 = _mm256_unpackhi_epi32((__m256i) v[6], (__m256i) v[7]);
+  /* columns i and i+4 of rows 0..3 and 4..7 */
+  __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+  __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+  __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+  __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+  __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+  __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+  __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+  __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+  v[0] = (jvec8) _mm256_permute2x128_si256(u0, u4, 0x20);
+  v[1] = (jvec8) _mm256_permute2x128_si256(u1, u5, 0x20);
+  v[2] = (jvec8) _mm256_permute2x128_si256(u2, u6, 0x20);
+  v[3] = (jvec8) _mm256_permute2x128_si256(u3, u7, 0x20);
+  v[4] = (jvec8) _mm256_permute2x128_si256(u0, u4, 0x31);
+  v[5] = (jvec8) _mm256_permute2x128_si256(u1, u5, 0x31);
+  v[6] = (jvec8) _mm256_permute2x128_si256(u2, u6, 0x31);
+  v[7] = (jvec8) _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+/* Range limit and store the 8 rows of the lanes of out */
+
+LOCAL(void) AVX2
+store_rows8 (jvec8 * out, JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  __m256i r0123, r4567;
+  int i;
+
+  for (i = 0; i < DCTSIZE; i++)
+    out[i] = RANGE_CENTER(out[i]);
+  transpose8(out);
+  /* the packs work in 128-bit lanes: columns 0..3 of the rows are in
+   * the low lane and columns 4..7 in the high one */
+  r0123 = _mm256_packus_epi16(_mm256_packs_epi32((__m256i) out[0], (__m256i) out[1]),
+			      _mm256_packs_epi32((__m256i) out[2], (__m256i) out[3]));
+  r4567 = _mm256_packus_epi16(_mm256_packs_epi32((__m256i) out[4], (__m256i) out[5]),
+			      _mm256_packs_epi32((__m256i) out[6], (__m256i) out[7]));
+  r0123 = _mm256_permutevar8x32_epi32(r0123, order);
+  r4567 = _mm256_permutevar8x32_epi32(r4567, order);
+  for (i = 0; i < 2; i++) {
+    __m256i rows = i ? r4567 : r0123;
+    __m128i r01 = _mm256_castsi256_si128(rows);
+    __m128i r23 = _mm256_extracti128_si256(rows, 1);
+    JSAMPARRAY buf = output_buf + 4*i;
+    _mm_storel_epi64((__m128i *) (buf[0] + output_col), r01);
+    _mm_storel_epi64((__m128i *) (buf[1] + output_col),
+		     _mm_unpackhi_epi64(r01, r01));
+    _mm_storel_epi64((__m128i *) (buf[2] + output_col), r23);
+    _mm_storel_epi64((__m128i *) (buf[3] + output_col),
+		     _mm_unpackhi_epi64(r23, r23));
+  }
+}
+
+LOCAL(jvec8) AVX2
+load_coef8 (JCOEFPTR coef)
+{
+  return (jvec8) _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) coef));
+}
+
+LOCAL(jvec8) AVX2
+load_mult8 (const int * mult)
+{
+  return (jvec8) _mm256_loadu_si256((const __m256i *) mult);
+}
+
+
+GLOBAL(void) AVX2
+jsimd_idct_islow_avx2 (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+		       JCOEFPTR coef_block,
+		       JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  ISLOW_MULT_TYPE * quantptr = (ISLOW_MULT_TYPE *) compptr->dct_table;
+  jvec8 in[DCTSIZE], ws[DCTSIZE];
+  jvec8 ac, dc, zero;
+  int i;
+
+  /* Pass 1: process the columns from input. */
+  ac = (jvec8) _mm256_setzero_si256();
+  for (i = 0; i < DCTSIZE; i++) {
+    in[i] = load_coef8(coef_block + DCTSIZE*i);
+    if (i > 0)
+      ac |= in[i];
+    in[i] *= load_mult8(quantptr + DCTSIZE*i);
+  }
+  ISLOW_1D(jvec8, in, ws, ISLOW_CONST_BITS-ISLOW_PASS1_BITS);
+  zero = ac == 0;
+  dc = in[0] << ISLOW_PASS1_BITS;
+  ISLOW_SHORTCUT(jvec8, ws, zero, dc);
+
+  /* Pass 2: process the rows from the work array. */
+  transpose8(ws);
+  ac = ws[1] | ws[2] | ws[3] | ws[4] | ws[5] | ws[6] | ws[7];
+  zero = ac == 0;
+  dc = (ws[0] + (1 << (ISLOW_PASS1_BITS+3-1))) >> (ISLOW_PASS1_BITS+3);
+  ISLOW_1D(jvec8, ws, in, ISLOW_CONST_BITS+ISLOW_PASS1_BITS+3);
+  ISLOW_SHORTCUT(jvec8, in, zero, dc);
+  store_rows8(in, output_buf, output_col);
+}
+
+
+GLOBAL(void) AVX2
+jsimd_idct_ifast_avx2 (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+		       JCOEFPTR coef_block,
+		       JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  IFAST_MULT_TYPE * quantptr = (IFAST_MULT_TYPE *) compptr->dct_table;
+  jvec8 in[DCTSIZE], ws[DCTSIZE];
+  int i;
+
+  /* Pass 1: process the columns from input. */
+  for (i = 0; i < DCTSIZE; i++)
+    in[i] = load_coef8(coef_block + DCTSIZE*i) *
+	    load_mult8(quantptr + DCTSIZE*i);
+  IFAST_1D(jvec8, in, ws);
+
+  /* Pass 2: process the rows, descale by 2**(PASS1_BITS+3). */
+  transpose8(ws);
+  IFAST_1D(jvec8, ws, in);
+  for (i = 0; i < DCTSIZE; i++)
+    in[i] >>= 5;
+  store_rows8(in, output_buf, output_col);
+}
+
+#endif /* JSIMD_SUPPORTED */
@@ -0,0 +1,187 @@
+/*
+ * jsimdsamp.c
+ *
+ * This file is part of the Independent JPEG Group's software.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This file contains SSE2 versions of the h2v1 and h2v2 fancy upsampling
+ * of jdsample.c.  16 input samples are done at once on 16-bit lanes, the
+ * first and the last columns and the samples left over at the end of the
+ * row are done as in jdsample.c.  The outputs are bit-exact.
+ */
+
+#define JPEG_INTERNALS
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jsimd.h"
+
+#ifdef JSIMD_SUPPORTED
+
+#include <immintrin.h>
+
+#define SSE2 __attribute__((target("sse2")))
+
+/* Interleave the even and the odd outputs of 16 input samples */
+
+#define STORE_PAIRS(outptr, even, odd) \
+  { \
+    _mm_storeu_si128((__m128i *) (outptr), _mm_unpacklo_epi8(even, odd)); \
+    _mm_storeu_si128((__m128i *) ((outptr) + 16), _mm_unpackhi_epi8(even, odd)); \
+  }
+
+#define LOADU(ptr)  _mm_loadu_si128((const __m128i *) (ptr))
+
+
+/*
+ * Fancy processing for 2:1 horizontal and 1:1 vertical,
+ * see h2v1_fancy_upsample in jdsample.c.
+ */
+
+GLOBAL(void) SSE2
+jsimd_h2v1_fancy_upsample_sse2 (j_decompress_ptr cinfo,
+				jpeg_component_info * compptr,
+				JSAMPARRAY input_data,
+				JSAMPARRAY * output_data_ptr)
+{
+  JSAMPARRAY output_data = *output_data_ptr;
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one = _mm_set1_epi16(1);
+  const __m128i two = _mm_set1_epi16(2);
+  JSAMPROW inptr, outptr;
+  JDIMENSION width = compptr->downsampled_width;
+  JDIMENSION col;
+  int invalue, inrow, h;
+
+  for (inrow = 0; inrow < cinfo->max_v_samp_factor; inrow++) {
+    inptr = input_data[inrow];
+    outptr = output_data[inrow];
+    /* Special case for first column */
+    invalue = GETJSAMPLE(inptr[0]);
+    outptr[0] = (JSAMPLE) invalue;
+    outptr[1] = (JSAMPLE) ((invalue * 3 + GETJSAMPLE(inptr[1]) + 2) >> 2);
+
+    /* General case, the loads read up to the last column */
+    for (col = 1; col + 16 < width; col += 16) {
+      __m128i prev = LOADU(inptr + col - 1);
+      __m128i cur = LOADU(inptr + col);
+      __m128i next = LOADU(inptr + col + 1);
+      __m128i even[2], odd[2];
+      for (h = 0; h < 2; h++) {
+	__m128i p = h ? _mm_unpackhi_epi8(prev, zero) : _mm_unpacklo_epi8(prev, zero);
+	__m128i c = h ? _mm_unpackhi_epi8(cur, zero) : _mm_unpacklo_epi8(cur, zero);
+	__m128i n = h ? _mm_unpackhi_epi8(next, zero) : _mm_unpacklo_epi8(next, zero);
+	c = _mm_add_epi16(c, _mm_add_epi16(c, c));
+	even[h] = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(c, p), one), 2);
+	odd[h] = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(c, n), two), 2);
+      }
+      STORE_PAIRS(outptr + 2*col, _mm_packus_epi16(even[0], even[1]),
+		  _mm_packus_epi16(odd[0], odd[1]));
+    }
+    for (; col < width - 1; col++) {
+      invalue = GETJSAMPLE(inptr[col]) * 3;
+      outptr[2*col] = (JSAMPLE) ((invalue + GETJSAMPLE(inptr[col-1]) + 1) >> 2);
+      outptr[2*col+1] = (JSAMPLE) ((invalue + GETJSAMPLE(inptr[col+1]) + 2) >> 2);
+    }
+
+    /* Special case for last column */
+    invalue = GETJSAMPLE(inptr[col]);
+    outptr[2*col] = (JSAMPLE) ((invalue * 3 + GETJSAMPLE(inptr[col-1]) + 1) >> 2);
+    outptr[2*col+1] = (JSAMPLE) invalue;
+  }
+}
+
+
+/*
+ * Fancy processing for 2:1 horizontal and 2:1 vertical,
+ * see h2v2_fancy_upsample in jdsample.c.
+ * The column sums 3 * nearer + further row are at most 1020, the sums of
+ * the outputs fit the 16-bit lanes.
+ */
+
+GLOBAL(void) SSE2
+jsimd_h2v2_fancy_upsample_sse2 (j_decompress_ptr cinfo,
+				jpeg_component_info * compptr,
+				JSAMPARRAY input_data,
+				JSAMPARRAY * output_data_ptr)
+{
+  JSAMPARRAY output_data = *output_data_ptr;
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i seven = _mm_set1_epi16(7);
+  const __m128i eight = _mm_set1_epi16(8);
+  JSAMPROW inptr0, inptr1, outptr;
+  JDIMENSION width = compptr->downsampled_width;
+  JDIMENSION col;
+  int thiscolsum, lastcolsum, nextcolsum;
+  int inrow, outrow, v, h;
+
+  inrow = outrow = 0;
+  while (outrow < cinfo->max_v_samp_factor) {
+    for (v = 0; v < 2; v++) {
+      /* inptr0 points to nearest input row, inptr1 points to next nearest */
+      inptr0 = input_data[inrow];
+      if (v == 0)		/* next nearest is row above */
+	inptr1 = input_data[inrow-1];
+      else			/* next nearest is row below */
+	inptr1 = input_data[inrow+1];
+      outptr = output_data[outrow++];
+
+      /* Special case for first column */
+      thiscolsum = GETJSAMPLE(inptr0[0]) * 3 + GETJSAMPLE(inptr1[0]);
+      nextcolsum = GETJSAMPLE(inptr0[1]) * 3 + GETJSAMPLE(inptr1[1]);
+      outptr[0] = (JSAMPLE) ((thiscolsum * 4 + 8) >> 4);
+      outptr[1] = (JSAMPLE) ((thiscolsum * 3 + nextcolsum + 7) >> 4);
+
+      /* General case, the loads read up to the last column */
+      for (col = 1; col + 16 < width; col += 16) {
+	__m128i prev0 = LOADU(inptr0 + col - 1), prev1 = LOADU(inptr1 + col - 1);
+	__m128i cur0 = LOADU(inptr0 + col), cur1 = LOADU(inptr1 + col);
+	__m128i next0 = LOADU(inptr0 + col + 1), next1 = LOADU(inptr1 + col + 1);
+	__m128i even[2], odd[2];
+	for (h = 0; h < 2; h++) {
+	  __m128i p, c, n;
+	  if (h) {
+	    p = _mm_unpackhi_epi8(prev0, zero);
+	    c = _mm_unpackhi_epi8(cur0, zero);
+	    n = _mm_unpackhi_epi8(next0, zero);
+	    p = _mm_add_epi16(_mm_add_epi16(p, _mm_add_epi16(p, p)),
+			      _mm_unpackhi_epi8(prev1, zero));
+	    c = _mm_add_epi16(_mm_add_epi16(c, _mm_add_epi16(c, c)),
+			      _mm_unpackhi_epi8(cur1, zero));
+	    n = _mm_add_epi16(_mm_add_epi16(n, _mm_add_epi16(n, n)),
+			      _mm_unpackhi_epi8(next1, zero));
+	  } else {
+	    p = _mm_unpacklo_epi8(prev0, zero);
+	    c = _mm_unpacklo_epi8(cur0, zero);
+	    n = _mm_unpacklo_epi8(next0, zero);
+	    p = _mm_add_epi16(_mm_add_epi16(p, _mm_add_epi16(p, p)),
+			      _mm_unpacklo_epi8(prev1, zero));
+	    c = _mm_add_epi16(_mm_add_epi16(c, _mm_add_epi16(c, c)),
+			      _mm_unpacklo_epi8(cur1, zero));
+	    n = _mm_add_epi16(_mm_add_epi16(n, _mm_add_epi16(n, n)),
+			      _mm_unpacklo_epi8(next1, zero));
+	  }
+	  c = _mm_add_epi16(c, _mm_add_epi16(c, c));
+	  even[h] = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(c, p), eight), 4);
+	  odd[h] = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(c, n), seven), 4);
+	}
+	STORE_PAIRS(outptr + 2*col, _mm_packus_epi16(even[0], even[1]),
+		    _mm_packus_epi16(odd[0], odd[1]));
+      }
+      lastcolsum = GETJSAMPLE(inptr0[col-1]) * 3 + GETJSAMPLE(inptr1[col-1]);
+      thiscolsum = GETJSAMPLE(inptr0[col]) * 3 + GETJSAMPLE(inptr1[col]);
+      for (; col < width - 1; col++) {
+	nextcolsum = GETJSAMPLE(inptr0[col+1]) * 3 + GETJSAMPLE(inptr1[col+1]);
+	outptr[2*col] = (JSAMPLE) ((thiscolsum * 3 + lastcolsum + 8) >> 4);
+	outptr[2*col+1] = (JSAMPLE) ((thiscolsum * 3 + nextcolsum + 7) >> 4);
+	lastcolsum = thiscolsum; thiscolsum = nextcolsum;
+      }
+
+      /* Special case for last column */
+      outptr[2*col] = (JSAMPLE) ((thiscolsum * 3 + lastcolsum + 8) >> 4);
+      outptr[2*col+1] = (JSAMPLE) ((thiscolsum * 4 + 7) >> 4);
+    }
+    inrow++;
+  }
+}
+
+#endif /* JSIMD_SUPPORTED */
@@ -0,0 +1,92 @@
+/* filter_paeth_intrinsics.h - Paeth filter functions for one instruction set
+ *
+ * Derived from intel/filter_sse2_intrinsics.c
+ *
+ * This code is released under the libpng license.
+ * For conditions of distribution and use, see the disclaimer
+ * and license in png.h
+ */
+
+/* This file is included by filter_ssse3_intrinsics.c once per instruction
+ * set, it defines png_read_filter_row_paeth3/4 with the suffix.  The includer
+ * defines:
+ *    PNG_PAETH_TARGET       the target attribute of the functions
+ *    PNG_PAETH_NAME(name)   the name with the suffix of the instruction set
+ *    PNG_PAETH_ABS(x)       the absolute values of 16 bit lanes
+ *    PNG_PAETH_SELECT(c,t,e) the lanes of t where c is set, e elsewhere
+ * The algorithm is the one of the SSE2 functions, see the comments there.
+ */
+
+static PNG_PAETH_TARGET __m128i
+PNG_PAETH_NAME(paeth_nearest)(__m128i a, __m128i b, __m128i c)
+{
+   __m128i pa, pb, pc, smallest;
+
+   pa = _mm_sub_epi16(b, c);     /* p-a */
+   pb = _mm_sub_epi16(a, c);     /* p-b */
+   pc = _mm_add_epi16(pa, pb);   /* p-c */
+
+   pa = PNG_PAETH_ABS(pa);
+   pb = PNG_PAETH_ABS(pb);
+   pc = PNG_PAETH_ABS(pc);
+
+   smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+   /* Paeth breaks ties favoring a over b over c. */
+   return PNG_PAETH_SELECT(_mm_cmpeq_epi16(smallest, pa), a,
+          PNG_PAETH_SELECT(_mm_cmpeq_epi16(smallest, pb), b, c));
+}
+
+PNG_PAETH_TARGET void
+PNG_PAETH_NAME(png_read_filter_row_paeth3)(png_row_infop row_info, png_bytep row,
+   png_const_bytep prev)
+{
+   size_t rb;
+   const __m128i zero = _mm_setzero_si128();
+   __m128i c, b = zero,
+           a, d = zero;
+
+   rb = row_info->rowbytes;
+   while (rb >= 4) {
+      c = b; b = _mm_unpacklo_epi8(load4(prev), zero);
+      a = d; d = _mm_unpacklo_epi8(load4(row ), zero);
+
+      /* Note `_epi8`: we need addition to wrap modulo 255. */
+      d = _mm_add_epi8(d, PNG_PAETH_NAME(paeth_nearest)(a, b, c));
+      store3(row, _mm_packus_epi16(d,d));
+
+      prev += 3;
+      row  += 3;
+      rb   -= 3;
+   }
+   if (rb > 0) {
+      c = b; b = _mm_unpacklo_epi8(load3(prev), zero);
+      a = d; d = _mm_unpacklo_epi8(load3(row ), zero);
+
+      d = _mm_add_epi8(d, PNG_PAETH_NAME(paeth_nearest)(a, b, c));
+      store3(row, _mm_packus_epi16(d,d));
+   }
+}
+
+PNG_PAETH_TARGET void
+PNG_PAETH_NAME(png_read_filter_row_paeth4)(png_row_infop row_info, png_bytep row,
+   png_const_bytep prev)
+{
+   size_t rb;
+   const __m128i zero = _mm_setzero_si128();
+   __m128i c, b = zero,
+           a, d = zero;
+
+   rb = row_info->rowbytes+4;
+   while (rb > 4) {
+      c = b; b = _mm_unpacklo_epi8(load4(prev), zero);
+      a = d; d = _mm_unpacklo_epi8(load4(row ), zero);
+
+      d = _mm_add_epi8(d, PNG_PAETH_NAME(paeth_nearest)(a, b, c));
+      store4(row, _mm_packus_epi16(d,d));
+
+      prev += 4;
+      row  += 4;
+      rb   -= 4;
+   }
+}
@@ -0,0 +1,95 @@
+/* filter_ssse3_intrinsics.c - SSSE3, SSE4.1 and AVX2 filter functions
+ *
+ * Derived from intel/filter_sse2_intrinsics.c
+ *
+ * This code is released under the libpng license.
+ * For conditions of distribution and use, see the disclaimer
+ * and license in png.h
+ */
+
+#include "../pngpriv.h"
+
+#ifdef PNG_READ_SUPPORTED
+
+#if PNG_INTEL_SSE_DISPATCH > 0
+
+#include <immintrin.h>
+
+/* The functions are compiled with the target attributes, the library is
+ * built for SSE2 and png_init_filter_functions_sse2 selects them when the
+ * CPU supports the instruction set.
+ */
+
+static __m128i load4(const void* p) {
+   int tmp;
+   memcpy(&tmp, p, sizeof(tmp));
+   return _mm_cvtsi32_si128(tmp);
+}
+
+static void store4(void* p, __m128i v) {
+   int tmp = _mm_cvtsi128_si32(v);
+   memcpy(p, &tmp, sizeof(int));
+}
+
+static __m128i load3(const void* p) {
+   png_uint_32 tmp = 0;
+   memcpy(&tmp, p, 3);
+   return _mm_cvtsi32_si128(tmp);
+}
+
+static void store3(void* p, __m128i v) {
+   int tmp = _mm_cvtsi128_si32(v);
+   memcpy(p, &tmp, 3);
+}
+
+/* SSSE3 has the absolute value */
+#define PNG_PAETH_TARGET __attribute__((target("ssse3")))
+#define PNG_PAETH_NAME(name) name##_ssse3
+#define PNG_PAETH_ABS(x) _mm_abs_epi16(x)
+#define PNG_PAETH_SELECT(c,t,e) \
+   _mm_or_si128(_mm_and_si128(c, t), _mm_andnot_si128(c, e))
+#include "filter_paeth_intrinsics.h"
+#undef PNG_PAETH_TARGET
+#undef PNG_PAETH_NAME
+#undef PNG_PAETH_SELECT
+
+/* SSE4.1 adds the blend */
+#define PNG_PAETH_TARGET __attribute__((target("sse4.1")))
+#define PNG_PAETH_NAME(name) name##_sse41
+#define PNG_PAETH_SELECT(c,t,e) _mm_blendv_epi8(e, t, c)
+#include "filter_paeth_intrinsics.h"
+#undef PNG_PAETH_TARGET
+#undef PNG_PAETH_NAME
+#undef PNG_PAETH_ABS
+#undef PNG_PAETH_SELECT
+
+/* The Up filter has no dependency between the bytes of the row, it is done
+ * by 32 bytes with AVX2.  The other filters depend on the pixel to the left
+ * and gain nothing from the wider registers.
+ */
+__attribute__((target("avx2"))) void
+png_read_filter_row_up_avx2(png_row_infop row_info, png_bytep row,
+   png_const_bytep prev)
+{
+   size_t rb = row_info->rowbytes;
+
+   png_debug(1, "in png_read_filter_row_up_avx2");
+
+   while (rb >= 32) {
+      __m256i r = _mm256_loadu_si256((const __m256i*)row);
+      __m256i p = _mm256_loadu_si256((const __m256i*)prev);
+      _mm256_storeu_si256((__m256i*)row, _mm256_add_epi8(r, p));
+      prev += 32;
+      row  += 32;
+      rb   -= 32;
+   }
+   while (rb > 0) {
+      *row = (png_byte)(*row + *prev);
+      prev++;
+      row++;
+      rb--;
+   }
+}
+
+#endif /* PNG_INTEL_SSE_DISPATCH > 0 */
+#endif /* READ */
@@ -16,6 +16,24 @@
 #ifdef PNG_READ_SUPPORTED
 #if PNG_INTEL_SSE_IMPLEMENTATION > 0
 
+#ifndef NO_GETENV
+/* The environment variable PNG_SIMD_FORCENONE=1 keeps the portable filters,
+ * PNG_SIMD_FORCESSE2=1 selects the SSE2 ones only and PNG_SIMD_FORCESSSE3=1
+ * turns SSE4.1 and AVX2 off, as JSIMD_FORCENONE of jpeg-6b.  The filters are
+ * selected for every image, so the paths are compared in one program.
+ * Define NO_GETENV to disable this.
+ */
+static int
+png_simd_forced(const char *name)
+{
+   const char *env = getenv(name);
+
+   return env != NULL && env[0] == '1';
+}
+#else
+#  define png_simd_forced(name) 0
+#endif
+
 void
 png_init_filter_functions_sse2(png_structp pp, unsigned int bpp)
 {
@@ -28,6 +46,9 @@ png_init_filter_functions_sse2(png_structp pp, unsigned int bpp)
     * but they end up a bit slower than using the equally-ubiquitous SSE2.
    */
    png_debug(1, "in png_init_filter_functions_sse2");
+   if (png_simd_forced("PNG_SIMD_FORCENONE"))
+      return;
+
    if (bpp == 3)
    {
       pp->read_filter[PNG_FILTER_VALUE_SUB-1] = png_read_filter_row_sub3_sse2;
@@ -46,6 +67,28 @@ png_init_filter_functions_sse2(png_structp pp, unsigned int bpp)
    /* No need optimize PNG_FILTER_VALUE_UP.  The compiler should
     * autovectorize.
     */
+
+#if PNG_INTEL_SSE_DISPATCH > 0
+   /* The library is built for SSE2, the newer instruction sets are checked
+    * at run time.  The flags are filled by the compiler runtime at startup.
+    */
+   if (png_simd_forced("PNG_SIMD_FORCESSE2"))
+      return;
+
+   if (bpp == 3 || bpp == 4)
+   {
+      if (__builtin_cpu_supports("sse4.1") &&
+          !png_simd_forced("PNG_SIMD_FORCESSSE3"))
+         pp->read_filter[PNG_FILTER_VALUE_PAETH-1] = bpp == 3 ?
+             png_read_filter_row_paeth3_sse41 : png_read_filter_row_paeth4_sse41;
+      else if (__builtin_cpu_supports("ssse3"))
+         pp->read_filter[PNG_FILTER_VALUE_PAETH-1] = bpp == 3 ?
+             png_read_filter_row_paeth3_ssse3 : png_read_filter_row_paeth4_ssse3;
+   }
+   if (__builtin_cpu_supports("avx2") &&
+       !png_simd_forced("PNG_SIMD_FORCESSSE3"))
+      pp->read_filter[PNG_FILTER_VALUE_UP-1] = png_read_filter_row_up_avx2;
+#endif
 }
 
 #endif /* PNG_INTEL_SSE_IMPLEMENTATION > 0 */
@@ -245,6 +245,17 @@
 #   define PNG_INTEL_SSE_IMPLEMENTATION 0
 #endif
 
+/* The SSSE3, SSE4.1 and AVX2 filters are compiled with the target attributes
+ * of GCC and clang and selected at run time by png_init_filter_functions_sse2,
+ * see intel/filter_ssse3_intrinsics.c
+ */
+#if PNG_INTEL_SSE_IMPLEMENTATION > 0 && defined(__GNUC__) && \
+   (defined(__x86_64__) || defined(__i386__))
+#   define PNG_INTEL_SSE_DISPATCH 1
+#else
+#   define PNG_INTEL_SSE_DISPATCH 0
+#endif
+
 #if PNG_MIPS_MSA_OPT > 0
 #  define PNG_FILTER_OPTIMIZATIONS png_init_filter_functions_msa
 #  ifndef PNG_MIPS_MSA_IMPLEMENTATION
@@ -1364,6 +1375,19 @@ PNG_INTERNAL_FUNCTION(void,png_read_filter_row_paeth4_sse2,(png_row_infop
     row_info, png_bytep row, png_const_bytep prev_row),PNG_EMPTY);
 #endif
 
+#if PNG_INTEL_SSE_DISPATCH > 0
+PNG_INTERNAL_FUNCTION(void,png_read_filter_row_paeth3_ssse3,(png_row_infop
+    row_info, png_bytep row, png_const_bytep prev_row),PNG_EMPTY);
+PNG_INTERNAL_FUNCTION(void,png_read_filter_row_paeth4_ssse3,(png_row_infop
+    row_info, png_bytep row, png_const_bytep prev_row),PNG_EMPTY);
+PNG_INTERNAL_FUNCTION(void,png_read_filter_row_paeth3_sse41,(png_row_infop
+    row_info, png_bytep row, png_const_bytep prev_row),PNG_EMPTY);
+PNG_INTERNAL_FUNCTION(void,png_read_filter_row_paeth4_sse41,(png_row_infop
+    row_info, png_bytep row, png_const_bytep prev_row),PNG_EMPTY);
+PNG_INTERNAL_FUNCTION(void,png_read_filter_row_up_avx2,(png_row_infop
+    row_info, png_bytep row, png_const_bytep prev_row),PNG_EMPTY);
+#endif
+
 /* Choose the best filter to use and filter the row data */
 PNG_INTERNAL_FUNCTION(void,png_write_find_filter,(png_structrp png_ptr,
     png_row_infop row_info),PNG_EMPTY);
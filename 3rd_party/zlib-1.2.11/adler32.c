@@ -6,6 +6,7 @@
 /* @(#) $Id$ */
 
 #include "zutil.h"
+#include "simd.h"
 
 local uLong adler32_combine_ OF((uLong adler1, uLong adler2, z_off64_t len2));
 
@@ -87,6 +88,15 @@ uLong ZEXPORT adler32_z(adler, buf, len)
     if (buf == Z_NULL)
         return 1L;
 
+#ifdef X86_SIMD
+    if (len >= ADLER32_SIMD_MIN_LENGTH) {
+        if (x86_cpu_has_avx2())
+            return adler32_avx2_((uint32_t)(adler | (sum2 << 16)), buf, len);
+        if (x86_cpu_has_ssse3())
+            return adler32_ssse3_((uint32_t)(adler | (sum2 << 16)), buf, len);
+    }
+#endif /* X86_SIMD */
+
     /* in case short lengths are provided, keep it somewhat fast */
     if (len < 16) {
         while (len--) {
@@ -0,0 +1,159 @@
+/* adler32_simd.c -- compute the Adler-32 checksum with SSSE3 or AVX2
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ *
+ * The input is processed in blocks of 32 bytes. For each block s1 gets the
+ * sum of the bytes and s2 gets the bytes multiplied by 32, 31, ..., 1 plus
+ * 32 times the s1 of the preceding blocks (v_ps). At most NMAX bytes are
+ * summed before the reduction modulo BASE, as in adler32.c.
+ */
+
+#include "simd.h"
+
+#ifdef X86_SIMD
+
+#include <immintrin.h>
+
+#define BASE 65521U     /* largest prime smaller than 65536 */
+#define NMAX 5552
+
+#define BLOCK_SIZE 32
+
+/* ========================================================================= */
+local uint32_t adler32_tail(s1, s2, buf, len)
+    uint32_t s1;
+    uint32_t s2;
+    const unsigned char FAR *buf;
+    z_size_t len;
+{
+    while (len--) {
+        s1 += *buf++;
+        s2 += s1;
+    }
+    s1 %= BASE;
+    s2 %= BASE;
+    return s1 | (s2 << 16);
+}
+
+/* ========================================================================= */
+uint32_t ZLIB_INTERNAL __attribute__((target("ssse3")))
+adler32_ssse3_(adler, buf, len)
+    uint32_t adler;
+    const unsigned char FAR *buf;
+    z_size_t len;
+{
+    uint32_t s1 = adler & 0xffff;
+    uint32_t s2 = adler >> 16;
+    z_size_t blocks = len / BLOCK_SIZE;
+    const __m128i tap1 =
+        _mm_setr_epi8(32,31,30,29,28,27,26,25,24,23,22,21,20,19,18,17);
+    const __m128i tap2 =
+        _mm_setr_epi8(16,15,14,13,12,11,10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+
+    len -= blocks * BLOCK_SIZE;
+    while (blocks) {
+        unsigned n = NMAX / BLOCK_SIZE;
+        __m128i v_ps, v_s1, v_s2;
+
+        if (n > blocks)
+            n = (unsigned)blocks;
+        blocks -= n;
+
+        v_ps = _mm_setr_epi32((int)(s1 * n), 0, 0, 0);
+        v_s2 = _mm_setr_epi32((int)s2, 0, 0, 0);
+        v_s1 = _mm_setzero_si128();
+        do {
+            const __m128i bytes1 = _mm_loadu_si128((const __m128i *)buf);
+            const __m128i bytes2 = _mm_loadu_si128((const __m128i *)(buf + 16));
+
+            /* s1 of the preceding blocks of this run */
+            v_ps = _mm_add_epi32(v_ps, v_s1);
+
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes1, zero));
+            v_s2 = _mm_add_epi32(v_s2,
+                _mm_madd_epi16(_mm_maddubs_epi16(bytes1, tap1), ones));
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes2, zero));
+            v_s2 = _mm_add_epi32(v_s2,
+                _mm_madd_epi16(_mm_maddubs_epi16(bytes2, tap2), ones));
+
+            buf += BLOCK_SIZE;
+        } while (--n);
+
+        v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_ps, 5));
+
+        /* horizontal sums */
+        v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(1,0,3,2)));
+        s1 += (uint32_t)_mm_cvtsi128_si32(v_s1);
+        v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(2,3,0,1)));
+        v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(1,0,3,2)));
+        s2 = (uint32_t)_mm_cvtsi128_si32(v_s2);
+
+        s1 %= BASE;
+        s2 %= BASE;
+    }
+
+    return adler32_tail(s1, s2, buf, len);
+}
+
+/* ========================================================================= */
+uint32_t ZLIB_INTERNAL __attribute__((target("avx2")))
+adler32_avx2_(adler, buf, len)
+    uint32_t adler;
+    const unsigned char FAR *buf;
+    z_size_t len;
+{
+    uint32_t s1 = adler & 0xffff;
+    uint32_t s2 = adler >> 16;
+    z_size_t blocks = len / BLOCK_SIZE;
+    const __m256i tap = _mm256_setr_epi8(
+        32,31,30,29,28,27,26,25,24,23,22,21,20,19,18,17,
+        16,15,14,13,12,11,10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+
+    len -= blocks * BLOCK_SIZE;
+    while (blocks) {
+        unsigned n = NMAX / BLOCK_SIZE;
+        __m256i v_ps, v_s1, v_s2;
+        __m128i h_s1, h_s2;
+
+        if (n > blocks)
+            n = (unsigned)blocks;
+        blocks -= n;
+
+        v_ps = _mm256_setr_epi32((int)(s1 * n), 0, 0, 0, 0, 0, 0, 0);
+        v_s2 = _mm256_setr_epi32((int)s2, 0, 0, 0, 0, 0, 0, 0);
+        v_s1 = _mm256_setzero_si256();
+        do {
+            const __m256i bytes = _mm256_loadu_si256((const __m256i *)buf);
+
+            v_ps = _mm256_add_epi32(v_ps, v_s1);
+            v_s1 = _mm256_add_epi32(v_s1, _mm256_sad_epu8(bytes, zero));
+            v_s2 = _mm256_add_epi32(v_s2,
+                _mm256_madd_epi16(_mm256_maddubs_epi16(bytes, tap), ones));
+
+            buf += BLOCK_SIZE;
+        } while (--n);
+
+        v_s2 = _mm256_add_epi32(v_s2, _mm256_slli_epi32(v_ps, 5));
+
+        /* horizontal sums */
+        h_s1 = _mm_add_epi32(_mm256_castsi256_si128(v_s1),
+                             _mm256_extracti128_si256(v_s1, 1));
+        h_s1 = _mm_add_epi32(h_s1, _mm_shuffle_epi32(h_s1, _MM_SHUFFLE(1,0,3,2)));
+        s1 += (uint32_t)_mm_cvtsi128_si32(h_s1);
+        h_s2 = _mm_add_epi32(_mm256_castsi256_si128(v_s2),
+                             _mm256_extracti128_si256(v_s2, 1));
+        h_s2 = _mm_add_epi32(h_s2, _mm_shuffle_epi32(h_s2, _MM_SHUFFLE(2,3,0,1)));
+        h_s2 = _mm_add_epi32(h_s2, _mm_shuffle_epi32(h_s2, _MM_SHUFFLE(1,0,3,2)));
+        s2 = (uint32_t)_mm_cvtsi128_si32(h_s2);
+
+        s1 %= BASE;
+        s2 %= BASE;
+    }
+
+    return adler32_tail(s1, s2, buf, len);
+}
+
+#endif /* X86_SIMD */
@@ -29,6 +29,7 @@
 #endif /* MAKECRCH */
 
 #include "zutil.h"      /* for STDC and FAR definitions */
+#include "simd.h"
 
 /* Definitions for doing the crc four data bytes at a time. */
 #if !defined(NOBYFOUR) && defined(Z_U4)
@@ -211,6 +212,20 @@ unsigned long ZEXPORT crc32_z(crc, buf, len)
         make_crc_table();
 #endif /* DYNAMIC_CRC_TABLE */
 
+#ifdef X86_SIMD
+    /* the multiples of 16 bytes by PCLMULQDQ, the rest by the tables */
+    if (len >= CRC32_SIMD_MIN_LENGTH && x86_cpu_has_pclmul()) {
+        z_size_t chunk = len & ~(z_size_t)CRC32_SIMD_CHUNK_MASK;
+
+        crc = crc32_pclmul_(buf, chunk, (uint32_t)crc ^ 0xffffffffUL) ^
+              0xffffffffUL;
+        buf += chunk;
+        len -= chunk;
+        if (len == 0)
+            return crc;
+    }
+#endif /* X86_SIMD */
+
 #ifdef BYFOUR
     if (sizeof(void *) == sizeof(ptrdiff_t)) {
         z_crc_t endian;
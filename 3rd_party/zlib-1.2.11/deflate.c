@@ -198,6 +198,25 @@ local const config configuration_table[10] = {
  * bit values at the expense of memory usage). We slide even when level == 0 to
  * keep the hash table consistent if we switch back to level > 0 later.
  */
+#if defined(__SSE2__) && !defined(NO_SIMD)
+#  include <emmintrin.h>
+
+/* The positions are 16 bits, the subtraction saturated at zero is the same
+   as m >= wsize ? m - wsize : NIL. hash_size and w_size are powers of two
+   not less than 256, so the tables are multiples of 8 entries. */
+local void slide_hash_sse2(table, n, wsize)
+    Posf *table;
+    unsigned n;
+    uInt wsize;
+{
+    const __m128i w = _mm_set1_epi16((short)wsize);
+    __m128i *p = (__m128i *)table;
+
+    for (n /= 8; n; n--, p++)
+        _mm_storeu_si128(p, _mm_subs_epu16(_mm_loadu_si128(p), w));
+}
+#endif
+
 local void slide_hash(s)
     deflate_state *s;
 {
@@ -205,6 +224,13 @@ local void slide_hash(s)
     Posf *p;
     uInt wsize = s->w_size;
 
+#if defined(__SSE2__) && !defined(NO_SIMD)
+    slide_hash_sse2(s->head, s->hash_size, wsize);
+#ifndef FASTEST
+    slide_hash_sse2(s->prev, wsize, wsize);
+#endif
+    return;
+#endif
     n = s->hash_size;
     p = &s->head[n];
     do {
@@ -12,6 +12,53 @@
 #  pragma message("Assembler code may have bugs -- use at your own risk")
 #else
 
+/* bytes copied at once by chunk_copy() */
+#define INFLATE_CHUNK 16
+
+/*
+   Copy the match of len bytes from dist bytes back in the output, the match
+   overlaps itself when dist < len. The bytes are copied in chunks of
+   INFLATE_CHUNK bytes and up to INFLATE_CHUNK - 1 bytes are written past the
+   match, so the caller checks that there is len + INFLATE_CHUNK - 1 bytes of
+   output space. The bytes past the match are not a part of the output yet,
+   they are overwritten by the following codes.
+
+   A distance shorter than a chunk is a repeated pattern: it is copied
+   without overlap from the start of the match, doubling the copied length,
+   until the distance to the start is a multiple of the pattern not shorter
+   than a chunk.
+ */
+local unsigned char FAR *chunk_copy(out, dist, len)
+    unsigned char FAR *out;
+    unsigned dist;
+    unsigned len;
+{
+    unsigned char FAR *from = out - dist;
+    unsigned n;
+
+    if (dist == 1) {
+        memset(out, *from, len);
+        return out + len;
+    }
+    while (dist < INFLATE_CHUNK) {
+        n = dist < len ? dist : len;
+        zmemcpy(out, from, n);
+        out += n;
+        len -= n;
+        if (len == 0)
+            return out;
+        dist += n;
+    }
+    for (;;) {
+        zmemcpy(out, from, INFLATE_CHUNK);
+        if (len <= INFLATE_CHUNK)
+            return out + len;
+        out += INFLATE_CHUNK;
+        from += INFLATE_CHUNK;
+        len -= INFLATE_CHUNK;
+    }
+}
+
 /*
    Decode literal, length, and distance codes and write out the resulting
    literal and match bytes until either not enough input or output is
@@ -57,6 +104,7 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
     unsigned char FAR *out;     /* local strm->next_out */
     unsigned char FAR *beg;     /* inflate()'s initial strm->next_out */
     unsigned char FAR *end;     /* while out < end, enough space available */
+    unsigned char FAR *limit;   /* end of the output space */
 #ifdef INFLATE_STRICT
     unsigned dmax;              /* maximum distance from zlib header */
 #endif
@@ -76,6 +124,7 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
     unsigned len;               /* match length, unused bytes */
     unsigned dist;              /* match distance */
     unsigned char FAR *from;    /* where to copy match from */
+    int direct;                 /* the rest of the match is from output */
 
     /* copy state to local variables */
     state = (struct inflate_state FAR *)strm->state;
@@ -84,6 +133,7 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
     out = strm->next_out;
     beg = out - (start - strm->avail_out);
     end = out + (strm->avail_out - 257);
+    limit = out + strm->avail_out;
 #ifdef INFLATE_STRICT
     dmax = state->dmax;
 #endif
@@ -197,14 +247,15 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
 #endif
                     }
                     from = window;
+                    direct = 0;
                     if (wnext == 0) {           /* very common case */
                         from += wsize - op;
                         if (op < len) {         /* some from window */
                             len -= op;
-                            do {
-                                *out++ = *from++;
-                            } while (--op);
+                            zmemcpy(out, from, op);
+                            out += op;
                             from = out - dist;  /* rest from output */
+                            direct = 1;
                         }
                     }
                     else if (wnext < op) {      /* wrap around window */
@@ -212,17 +263,16 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                         op -= wnext;
                         if (op < len) {         /* some from end of window */
                             len -= op;
-                            do {
-                                *out++ = *from++;
-                            } while (--op);
+                            zmemcpy(out, from, op);
+                            out += op;
                             from = window;
                             if (wnext < len) {  /* some from start of window */
                                 op = wnext;
                                 len -= op;
-                                do {
-                                    *out++ = *from++;
-                                } while (--op);
+                                zmemcpy(out, from, op);
+                                out += op;
                                 from = out - dist;      /* rest from output */
+                                direct = 1;
                             }
                         }
                     }
@@ -230,24 +280,35 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                         from += wnext - op;
                         if (op < len) {         /* some from window */
                             len -= op;
-                            do {
-                                *out++ = *from++;
-                            } while (--op);
+                            zmemcpy(out, from, op);
+                            out += op;
                             from = out - dist;  /* rest from output */
+                            direct = 1;
                         }
                     }
-                    while (len > 2) {
-                        *out++ = *from++;
-                        *out++ = *from++;
-                        *out++ = *from++;
-                        len -= 3;
+                    if (!direct) {
+                        zmemcpy(out, from, len);
+                        out += len;
                     }
-                    if (len) {
-                        *out++ = *from++;
-                        if (len > 1)
+                    else if ((unsigned)(limit - out) >=
+                             len + INFLATE_CHUNK - 1)
+                        out = chunk_copy(out, dist, len);
+                    else {
+                        while (len > 2) {
                             *out++ = *from++;
+                            *out++ = *from++;
+                            *out++ = *from++;
+                            len -= 3;
+                        }
+                        if (len) {
+                            *out++ = *from++;
+                            if (len > 1)
+                                *out++ = *from++;
+                        }
                     }
                 }
+                else if ((unsigned)(limit - out) >= len + INFLATE_CHUNK - 1)
+                    out = chunk_copy(out, dist, len);
                 else {
                     from = out - dist;          /* copy direct from output */
                     do {                        /* minimum length is three */
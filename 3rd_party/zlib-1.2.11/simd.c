@@ -0,0 +1,40 @@
+/* simd.c -- the run-time check of the instruction sets of simd.h
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+#include "simd.h"
+
+#ifdef X86_SIMD
+
+/* the flags plus one, 0 until the first call. The threads racing for the
+   first call store the same value */
+local volatile int simd_flags = 0;
+
+/* ========================================================================= */
+int ZLIB_INTERNAL x86_simd_support()
+{
+    int flags = simd_flags - 1;
+#ifndef NO_GETENV
+    char *env;
+#endif
+
+    if (flags >= 0)
+        return flags;
+    flags = 0;
+    if (__builtin_cpu_supports("ssse3"))
+        flags |= X86_SIMD_SSSE3;
+    if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1"))
+        flags |= X86_SIMD_PCLMUL;
+    if (__builtin_cpu_supports("avx2"))
+        flags |= X86_SIMD_AVX2;
+#ifndef NO_GETENV
+    if ((env = getenv("ZSIMD_FORCENONE")) != NULL && env[0] == '1')
+        flags = 0;
+    if ((env = getenv("ZSIMD_FORCESSSE3")) != NULL && env[0] == '1')
+        flags &= ~X86_SIMD_AVX2;
+#endif
+    simd_flags = flags + 1;
+    return flags;
+}
+
+#endif /* X86_SIMD */
@@ -0,0 +1,62 @@
+/* simd.h -- SIMD versions of the checksums, dispatched at run time
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/* WARNING: this file should *not* be used by applications. It is
+   part of the implementation of the compression library and is
+   subject to change. Applications should only use zlib.h.
+ */
+
+#ifndef SIMD_H
+#define SIMD_H
+
+#include "zutil.h"
+
+/* The SIMD code is compiled with the target attributes of GCC and clang,
+   so the library is built without the -m flags and runs on any x86 CPU.
+   The CPU is checked once by x86_simd_support(), the later calls load the
+   kept flags. Define NO_SIMD to build the portable code only. */
+#if !defined(NO_SIMD) && defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#  define X86_SIMD
+#endif
+
+#ifdef X86_SIMD
+
+#  include <stdint.h>
+
+#  define X86_SIMD_SSSE3  1
+#  define X86_SIMD_PCLMUL 2     /* with SSE4.1 */
+#  define X86_SIMD_AVX2   4
+
+/* the X86_SIMD_xxx flags of the CPU. The environment variable
+   ZSIMD_FORCENONE=1 selects the portable code and ZSIMD_FORCESSSE3=1 turns
+   AVX2 off, as JSIMD_FORCENONE and JSIMD_FORCESSE41 of jpeg-6b. They are
+   read by the first call, define NO_GETENV to disable them */
+int ZLIB_INTERNAL x86_simd_support OF((void));
+
+#  define x86_cpu_has_pclmul() (x86_simd_support() & X86_SIMD_PCLMUL)
+#  define x86_cpu_has_ssse3() (x86_simd_support() & X86_SIMD_SSSE3)
+#  define x86_cpu_has_avx2() (x86_simd_support() & X86_SIMD_AVX2)
+
+/* crc32_pclmul_ needs at least CRC32_SIMD_MIN_LENGTH bytes, a multiple of
+   16 bytes. The crc is pre- and post-conditioned by the caller */
+#  define CRC32_SIMD_MIN_LENGTH 64
+#  define CRC32_SIMD_CHUNK_MASK 15
+
+uint32_t ZLIB_INTERNAL crc32_pclmul_ OF((const unsigned char FAR *buf,
+                                         z_size_t len, uint32_t crc));
+
+/* the whole buffer, any length */
+#  define ADLER32_SIMD_MIN_LENGTH 64
+
+uint32_t ZLIB_INTERNAL adler32_ssse3_ OF((uint32_t adler,
+                                          const unsigned char FAR *buf,
+                                          z_size_t len));
+uint32_t ZLIB_INTERNAL adler32_avx2_ OF((uint32_t adler,
+                                         const unsigned char FAR *buf,
+                                         z_size_t len));
+
+#endif /* X86_SIMD */
+
+#endif /* SIMD_H */
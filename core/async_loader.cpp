@@ -0,0 +1,229 @@
+#include "async_loader.hpp"
+#include <core/filesystem.hpp>
+#include <core/common.hpp>
+#include <core/assert.hpp>
+#include <limits>
+
+namespace engine::core
+{
+
+namespace
+{
+
+/* ticks_to_msec */
+float ticks_to_msec( timer::ticks ticks )
+{
+    return static_cast<float>( static_cast<double>( ticks ) * 1000.0 / timer::get_ticks_per_sec() );
+}
+
+} /* namespace */
+
+/* async_loader::~async_loader */
+async_loader::~async_loader()
+{
+    if( isRunning ) {
+        stop();
+    }
+}
+
+/* async_loader::start */
+void async_loader::start( int threadsNumber )
+{
+    assert( !isRunning );
+    assert( threadsNumber > 0 );
+    isRunning = true;
+    for( int i = 0; i < threadsNumber; i++ ) {
+        threads.emplace_back( [this]() { thread_main(); } );
+    }
+}
+
+/* async_loader::stop */
+void async_loader::stop()
+{
+    assert( isRunning );
+    {
+        std::lock_guard<std::mutex> guard( lock );
+        isRunning = false;
+        for( request *r : queue ) {
+            r->state.store( REQUEST_CANCELED, std::memory_order_relaxed );
+            r->status = LOAD_STATUS_CANCELED;
+            completedNumber.fetch_add( 1, std::memory_order_relaxed );
+            completion.push( r );
+        }
+        queue.clear();
+    }
+    wakeUp.notify_all();
+    for( auto &thread : threads ) {
+        thread.join();
+    }
+    threads.clear();
+    while( !requests.empty() ) {
+        update( std::numeric_limits<float>::max() );
+    }
+}
+
+/* async_loader::load */
+async_loader::request_id async_loader::load( const string &path, load_priority priority, decode_fn decode, finalize_fn finalize )
+{
+    assert( decode != nullptr );
+    if( !isRunning ) {
+        /* no thread would take the request, stop() would wait for it forever */
+        if( finalize ) {
+            finalize( LOAD_STATUS_CANCELED );
+        }
+        totals.canceled++;
+        return 0;
+    }
+    request *r = new request;
+    r->id = ++lastId == 0 ? ++lastId : lastId;
+    r->priority = priority;
+    r->order = lastOrder++;
+    r->path = path;
+    r->decode = std::move( decode );
+    r->finalize = std::move( finalize );
+    r->loadTicks = timer::get_ticks();
+    requests[r->id] = r;
+    {
+        std::lock_guard<std::mutex> guard( lock );
+        queue.insert( r );
+    }
+    wakeUp.notify_one();
+    return r->id;
+}
+
+/* async_loader::cancel */
+bool async_loader::cancel( request_id id )
+{
+    auto found = requests.find( id );
+    if( found == requests.end() ) {
+        return false;
+    }
+    request *r = found->second;
+    std::lock_guard<std::mutex> guard( lock );
+    int state = r->state.load( std::memory_order_relaxed );
+    if( state == REQUEST_QUEUED ) {
+        queue.erase( r );
+        r->state.store( REQUEST_CANCELED, std::memory_order_relaxed );
+        r->status = LOAD_STATUS_CANCELED;
+        completedNumber.fetch_add( 1, std::memory_order_relaxed );
+        completion.push( r );
+        return true;
+    }
+    /* the thread checks the state when the decoding is done */
+    return state == REQUEST_LOADING &&
+            r->state.compare_exchange_strong( state, REQUEST_CANCELED, std::memory_order_acq_rel );
+}
+
+/* async_loader::update */
+int async_loader::update( float budgetMsec )
+{
+    timer tm;
+    tm.start();
+    int finalized = 0;
+    while( request *r = completion.pop() ) {
+        completedNumber.fetch_sub( 1, std::memory_order_relaxed );
+        if( r->finalize ) {
+            r->finalize( r->status );
+        }
+        float latency = ticks_to_msec( timer::get_ticks() - r->loadTicks );
+        latencySum += latency;
+        if( latency > totals.maxLatencyMsec ) {
+            totals.maxLatencyMsec = latency;
+        }
+        switch( r->status ) {
+            case LOAD_STATUS_SUCCEEDED:
+                totals.succeeded++;
+                break;
+            case LOAD_STATUS_FAILED:
+                totals.failed++;
+                break;
+            case LOAD_STATUS_CANCELED:
+                totals.canceled++;
+                break;
+        }
+        if( r->decodeMsec > 0.0f ) {
+            decodeSum += r->decodeMsec;
+            decodedNumber++;
+        }
+        requests.erase( r->id );
+        delete r;
+        finalized++;
+        if( tm.get_elapsed_msec() >= budgetMsec ) {
+            break;
+        }
+    }
+    return finalized;
+}
+
+/* async_loader::wait_all */
+void async_loader::wait_all()
+{
+    while( !requests.empty() ) {
+        if( update( std::numeric_limits<float>::max() ) == 0 ) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+/* async_loader::get_stats */
+async_loader_stats async_loader::get_stats() const
+{
+    async_loader_stats stats( totals );
+    {
+        std::lock_guard<std::mutex> guard( lock );
+        stats.queued = static_cast<int>( queue.size() );
+    }
+    stats.loading = loadingNumber.load( std::memory_order_relaxed );
+    stats.completed = completedNumber.load( std::memory_order_relaxed );
+    int finalized = totals.succeeded + totals.failed + totals.canceled;
+    stats.averageLatencyMsec = finalized > 0 ? static_cast<float>( latencySum / finalized ) : 0.0f;
+    stats.averageDecodeMsec = decodedNumber > 0 ? static_cast<float>( decodeSum / decodedNumber ) : 0.0f;
+    return stats;
+}
+
+/* async_loader::thread_main */
+void async_loader::thread_main()
+{
+    for( ;; ) {
+        request *r;
+        {
+            std::unique_lock<std::mutex> guard( lock );
+            wakeUp.wait( guard, [this]() { return !isRunning || !queue.empty(); } );
+            if( !isRunning ) {
+                return;
+            }
+            r = *queue.begin();
+            queue.erase( queue.begin() );
+            r->state.store( REQUEST_LOADING, std::memory_order_relaxed );
+            loadingNumber.fetch_add( 1, std::memory_order_relaxed );
+        }
+        timer::ticks start = timer::get_ticks();
+        bool succeeded = false;
+        {
+            mapped_file file( filesystem::open_mapped( r->path ) );
+            if( file.is_open() ) {
+                succeeded = r->decode( file );
+            } else {
+                common::error() << "async_loader error: cannot open " << r->path << std::endl;
+            }
+        }
+        r->decodeMsec = ticks_to_msec( timer::get_ticks() - start );
+        complete( r, succeeded );
+    }
+}
+
+/* async_loader::complete */
+void async_loader::complete( request *r, bool succeeded )
+{
+    int state = REQUEST_LOADING;
+    if( r->state.compare_exchange_strong( state, REQUEST_COMPLETED, std::memory_order_acq_rel ) ) {
+        r->status = succeeded ? LOAD_STATUS_SUCCEEDED : LOAD_STATUS_FAILED;
+    } else {
+        r->status = LOAD_STATUS_CANCELED;
+    }
+    loadingNumber.fetch_sub( 1, std::memory_order_relaxed );
+    completedNumber.fetch_add( 1, std::memory_order_relaxed );
+    completion.push( r );
+}
+
+} /* namespace engine::core */
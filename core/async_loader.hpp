@@ -0,0 +1,171 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <set>
+#include <unordered_map>
+#include <core/types.hpp>
+#include <core/string.hpp>
+#include <core/vector.hpp>
+#include <core/timer.hpp>
+#include <core/mapped_file.hpp>
+#include <core/jobs/mpsc_queue.hpp>
+
+namespace engine::core
+{
+
+enum load_priority
+{
+    LOAD_PRIORITY_LOW,
+    LOAD_PRIORITY_NORMAL,
+    LOAD_PRIORITY_HIGH
+};
+
+enum load_status
+{
+    LOAD_STATUS_SUCCEEDED,
+    LOAD_STATUS_FAILED,             /* the file is not opened or decode returned false */
+    LOAD_STATUS_CANCELED
+};
+
+struct async_loader_stats
+{
+    int             queued{0};          /* waiting for a thread */
+    int             loading{0};         /* being read and decoded */
+    int             completed{0};       /* waiting for update() */
+    int             succeeded{0};       /* finalized since start() */
+    int             failed{0};
+    int             canceled{0};
+    float           averageLatencyMsec{0.0f};   /* from load() to the finalization */
+    float           maxLatencyMsec{0.0f};
+    float           averageDecodeMsec{0.0f};
+};
+
+/* async_loader
+* the files are mapped and decoded by the background threads of the
+* loader, the requests with the higher priority go first. The results are
+* returned to the main thread through a lock-free queue and finalized by
+* update() within the budget of the frame (the uploads to the GPU etc).
+* The job system is not used: its worker 0 is the main thread which
+* would execute a long decode while it waits for the frame jobs.
+* load(), cancel(), update() are called by the main thread only */
+class async_loader
+{
+public:
+    typedef unsigned    request_id;         /* 0 is not a request */
+                        /* the background thread, the file may be moved out */
+    typedef std::function<bool( mapped_file &file )>    decode_fn;
+                        /* the main thread, called for every request once */
+    typedef std::function<void( load_status status )>   finalize_fn;
+
+public:
+                    async_loader() {}
+                    async_loader( const async_loader& ) = delete;
+    async_loader &  operator=( const async_loader& ) = delete;
+                    ~async_loader();
+
+    void            start( int threadsNumber = 1 );
+                    /* cancels the queued requests, waits for the loading ones
+                    * and finalizes everything */
+    void            stop();
+    bool            is_started() const;
+
+                    /* the path is opened by filesystem::open_mapped(). If the loader
+                    * is not running (finalize of stop() loads again) then finalize
+                    * gets LOAD_STATUS_CANCELED at once and 0 is returned */
+    request_id      load( const string &path, load_priority priority, decode_fn decode, finalize_fn finalize = nullptr );
+                    /* returns false if the request is already completed. The result
+                    * of the request being decoded is dropped, finalize gets
+                    * LOAD_STATUS_CANCELED */
+    bool            cancel( request_id id );
+    bool            is_pending( request_id id ) const;
+                    /* finalizes the completed requests until budgetMsec is spent,
+                    * at least one. Returns the number of the finalized requests */
+    int             update( float budgetMsec );
+                    /* update() until all requests are finalized */
+    void            wait_all();
+
+    async_loader_stats  get_stats() const;
+
+private:
+    enum request_state
+    {
+        REQUEST_QUEUED,
+        REQUEST_LOADING,
+        REQUEST_CANCELED,
+        REQUEST_COMPLETED
+    };
+
+    struct request : public jobs::mpsc_node
+    {
+        request_id          id;
+        int                 priority;
+        std::uint64_t       order;          /* FIFO of the same priority */
+        string              path;
+        decode_fn           decode;
+        finalize_fn         finalize;
+        std::atomic<int>    state{REQUEST_QUEUED};
+        load_status         status{LOAD_STATUS_FAILED};
+        timer::ticks        loadTicks;
+        float               decodeMsec{0.0f};
+    };
+
+    /* request_order
+    * the higher priority first, then the earlier request */
+    struct request_order
+    {
+        bool        operator()( const request *a, const request *b ) const;
+    };
+
+    void            thread_main();
+    void            complete( request *r, bool succeeded );
+
+    core::vector<std::thread>       threads;
+    bool                            isRunning{false};
+
+    /* the queued requests */
+    mutable std::mutex              lock;
+    std::condition_variable         wakeUp;
+    std::set<request*, request_order>   queue;
+
+    jobs::mpsc_queue<request>       completion;
+    std::atomic<int>                loadingNumber{0};
+    std::atomic<int>                completedNumber{0};
+
+    /* the main thread only */
+    std::unordered_map<request_id, request*>    requests;
+    request_id                      lastId{0};
+    std::uint64_t                   lastOrder{0};
+    async_loader_stats              totals;
+    double                          latencySum{0.0};
+    double                          decodeSum{0.0};
+    int                             decodedNumber{0};
+}; /* class async_loader */
+
+
+
+/* async_loader::is_started */
+inline bool async_loader::is_started() const
+{
+    return isRunning;
+}
+
+/* async_loader::is_pending */
+inline bool async_loader::is_pending( request_id id ) const
+{
+    return requests.find( id ) != requests.end();
+}
+
+/* async_loader::request_order::operator() */
+inline bool async_loader::request_order::operator()( const request *a, const request *b ) const
+{
+    if( a->priority != b->priority ) {
+        return a->priority > b->priority;
+    }
+    return a->order < b->order;
+}
+
+} /* namespace engine::core */
@@ -3,7 +3,16 @@
 #define ENABLED                     1
 #define DISABLED                    0
 
-#define PLATFORM_WIN64_ENABLED      ENABLED
+/* target platform, selected by the compiler */
+#if defined(_WIN32)
+#   define PLATFORM_WIN64_ENABLED   ENABLED
+#   define PLATFORM_LINUX_ENABLED   DISABLED
+#elif defined(__linux__)
+#   define PLATFORM_WIN64_ENABLED   DISABLED
+#   define PLATFORM_LINUX_ENABLED   ENABLED
+#else
+#   error "unsupported platform"
+#endif /* _WIN32 */
 
 #define DEBUG_ENABLED               ENABLED
 #define CORE_DEBUG_ENABLED          DEBUG_ENABLED
@@ -13,3 +22,19 @@
 #define CORE_ASSERT_ENABLED         ASSERT_ENABLED && CORE_DEBUG_ENABLED
 #define MATH_ASSERT_ENABLED         CORE_ASSERT_ENABLED
 #define CONTAINERS_ASSERT_ENABLED   CORE_ASSERT_ENABLED
+
+/* SIMD instruction sets, selected at compile time by the compiler flags
+* (see ENGINE_SIMD in the root CMakeLists.txt) */
+#if defined(__AVX2__)
+#   define SIMD_AVX2_ENABLED        ENABLED
+#else
+#   define SIMD_AVX2_ENABLED        DISABLED
+#endif /* __AVX2__ */
+
+#if defined(__SSE4_1__) || SIMD_AVX2_ENABLED
+#   define SIMD_SSE4_1_ENABLED      ENABLED
+#else
+#   define SIMD_SSE4_1_ENABLED      DISABLED
+#endif /* __SSE4_1__ */
+
+#define MATH_SIMD_ENABLED           SIMD_SSE4_1_ENABLED
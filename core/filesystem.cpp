@@ -1,41 +1,90 @@
 #include "filesystem.hpp"
+#include <core/platform/api.hpp>
 
 namespace engine::core
 {
 
+/* default resources directory, see ENGINE_RESOURCES_DIR in CMakeLists.txt */
+#ifndef ENGINE_RESOURCES_DIR
+#   define ENGINE_RESOURCES_DIR     "resources/"
+#endif /* ENGINE_RESOURCES_DIR */
+
+namespace
+{
+
+/* directory with the trailing separator */
+string make_dir( const string &dir )
+{
+    string result( dir );
+    if( !result.empty() && result.back() != '/' && result.back() != '\\' ) {
+        result += '/';
+    }
+    return result;
+}
+
+/* absolute paths are not relative to the resources */
+bool is_absolute( const string &path )
+{
+    return (!path.empty() && (path[0] == '/' || path[0] == '\\')) ||
+            (path.length() > 1 && path[1] == ':');
+}
+
+string resourcesDir( make_dir( ENGINE_RESOURCES_DIR ) );
+
+/* path of the resource file */
+string get_path( const string &name )
+{
+    if( is_absolute( name ) ) {
+        return name;
+    }
+    string path( resourcesDir );
+    path += name;
+    return path;
+}
+
+} /* namespace */
+
 /* filesystem::file_exists */
 bool filesystem::file_exists( const string &path ) {
-    auto attr = GetFileAttributesA( path.c_str() );
-    if( attr != INVALID_FILE_ATTRIBUTES ) {
-        return static_cast<bool>( !(attr & FILE_ATTRIBUTE_DIRECTORY) );
+    return platform::is_file( path.c_str() );
+}
+
+/* filesystem::get_file_size */
+bool filesystem::get_file_size( const string &path, size_t &size ) {
+    platform::file_size fileSize;
+    if( !platform::get_file_size( path.c_str(), fileSize ) ) {
+        return false;
     }
-    return false;
+    size = static_cast<size_t>( fileSize );
+    return true;
 }
-#define RESUORCES_DIR "C:\\work\\cpp-engine\\resources\\"
+
+/* filesystem::set_resources_dir */
+void filesystem::set_resources_dir( const string &dir ) {
+    resourcesDir = make_dir( dir );
+}
+
+/* filesystem::get_resources_dir */
+const string &filesystem::get_resources_dir() {
+    return resourcesDir;
+}
+
 /* filesystem::read_contents */
 file_contents filesystem::read_contents( const string &path, size_t offset, size_t length ) {
     file_contents result;
-    std::ifstream file(RESUORCES_DIR + path, std::ios::in | std::ios::binary);
+    mapped_file file( open_mapped( path ) );
     result.success = file.is_open();
     if( result.success ) {
-        /* calculate or clamp length of file */
-        file.seekg( 0, std::ios::end );
-        auto fileSize = static_cast<size_t>( file.tellg() );
+        /* clamp length of file */
+        auto fileSize = file.size();
         if( offset > fileSize ) {
             offset = fileSize;
         }
         if( length + offset > fileSize || length == 0 ) {
             length = fileSize - offset;
         }
-        file.seekg( offset, std::ios::beg );
-        /* reserve string size and read contents */
-        if( length + offset == fileSize ) {
-            result.contents.reserve( length );
-            result.contents.assign( std::istreambuf_iterator<char>(file),
-                    std::istreambuf_iterator<char>() );
-        } else {
-            result.contents.resize( length );
-            file.read( static_cast<char*>(result.contents.data()), length );
+        if( length > 0 ) {
+            result.contents.assign( reinterpret_cast<const char*>( file.data() + offset ), length );
         }
     }
     return result;
@@ -43,12 +92,19 @@ file_contents filesystem::read_contents( const string &path, size_t offset, size
 
 /* filesystem::open_read */
 ifstream filesystem::open_read( const string &filename ) {
-    return ifstream(RESUORCES_DIR + filename, std::ios::in | std::ios::binary );
+    return ifstream(get_path( filename ), std::ios::in | std::ios::binary );
+}
+
+/* filesystem::open_mapped */
+mapped_file filesystem::open_mapped( const string &filename ) {
+    mapped_file file;
+    file.open( get_path( filename ) );
+    return file;
 }
 
 /* filesystem::open_write */
 ofstream filesystem::open_write( const string &filename ) {
-    return ofstream(RESUORCES_DIR + filename, std::ios::out | std::ios::binary );
+    return ofstream(get_path( filename ), std::ios::out | std::ios::binary );
 }
 
 } /* namespace engine::core */
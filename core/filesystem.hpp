@@ -2,6 +2,7 @@
 #include <core/types.hpp>
 #include <core/vector.hpp>
 #include <core/string.hpp>
+#include <core/mapped_file.hpp>
 
 namespace engine::core {
 
@@ -10,14 +11,26 @@ struct file_contents {
     string          contents;
 };
 
+/* filesystem
+* files are opened relative to the resources directory unless the
+* path is absolute,
+* file_exists() and get_file_size() take the path as is */
 class filesystem {
 public:
     static bool             file_exists( const string &path );
+                            /* returns false if the file does not exist */
+    static bool             get_file_size( const string &path, size_t &size );
+
+                            /* directory with the trailing separator */
+    static void             set_resources_dir( const string &dir );
+    static const string &   get_resources_dir();
 
                             /* read file */
     static file_contents    read_contents( const string &path, size_t offset = 0, size_t length = 0 );
                             /* open file for reading */
     static ifstream         open_read( const string &filename );
+                            /* map file to the memory, see mapped_file::is_open() */
+    static mapped_file      open_mapped( const string &filename );
                             /* open file for writing */
     static ofstream         open_write( const string &filename );
 };
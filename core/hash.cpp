@@ -0,0 +1,106 @@
+#include "hash.hpp"
+#include <cstring>
+
+namespace engine::core
+{
+
+namespace
+{
+
+const std::uint64_t PRIME1 = 11400714785074694791ull;
+const std::uint64_t PRIME2 = 14029467366897019727ull;
+const std::uint64_t PRIME3 = 1609587929392839161ull;
+const std::uint64_t PRIME4 = 9650029242287828579ull;
+const std::uint64_t PRIME5 = 2870177450012600261ull;
+
+/* rotl */
+inline std::uint64_t rotl( std::uint64_t value, int bits )
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+/* read64 */
+inline std::uint64_t read64( const unsigned char *p )
+{
+    std::uint64_t value;
+    memcpy( &value, p, sizeof( value ) );
+    return value;
+}
+
+/* read32 */
+inline std::uint32_t read32( const unsigned char *p )
+{
+    std::uint32_t value;
+    memcpy( &value, p, sizeof( value ) );
+    return value;
+}
+
+/* round64 */
+inline std::uint64_t round64( std::uint64_t acc, std::uint64_t input )
+{
+    acc += input * PRIME2;
+    return rotl( acc, 31 ) * PRIME1;
+}
+
+/* merge64 */
+inline std::uint64_t merge64( std::uint64_t acc, std::uint64_t value )
+{
+    acc ^= round64( 0, value );
+    return acc * PRIME1 + PRIME4;
+}
+
+} /* namespace */
+
+/* hash64 */
+std::uint64_t hash64( const void *data, size_t size, std::uint64_t seed )
+{
+    auto p = static_cast<const unsigned char*>( data );
+    const unsigned char *end = p + size;
+    std::uint64_t h;
+    if( size >= 32 ) {
+        /* 4 independent lanes of 8 bytes */
+        std::uint64_t v1 = seed + PRIME1 + PRIME2;
+        std::uint64_t v2 = seed + PRIME2;
+        std::uint64_t v3 = seed;
+        std::uint64_t v4 = seed - PRIME1;
+        const unsigned char *limit = end - 32;
+        do {
+            v1 = round64( v1, read64( p ) );
+            v2 = round64( v2, read64( p + 8 ) );
+            v3 = round64( v3, read64( p + 16 ) );
+            v4 = round64( v4, read64( p + 24 ) );
+            p += 32;
+        } while( p <= limit );
+        h = rotl( v1, 1 ) + rotl( v2, 7 ) + rotl( v3, 12 ) + rotl( v4, 18 );
+        h = merge64( h, v1 );
+        h = merge64( h, v2 );
+        h = merge64( h, v3 );
+        h = merge64( h, v4 );
+    } else {
+        h = seed + PRIME5;
+    }
+    h += static_cast<std::uint64_t>( size );
+
+    for( ; p + 8 <= end; p += 8 ) {
+        h ^= round64( 0, read64( p ) );
+        h = rotl( h, 27 ) * PRIME1 + PRIME4;
+    }
+    if( p + 4 <= end ) {
+        h ^= static_cast<std::uint64_t>( read32( p ) ) * PRIME1;
+        h = rotl( h, 23 ) * PRIME2 + PRIME3;
+        p += 4;
+    }
+    for( ; p < end; p++ ) {
+        h ^= *p * PRIME5;
+        h = rotl( h, 11 ) * PRIME1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+} /* namespace engine::core */
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace engine::core
+{
+
+/* hash64
+* 64 bit hash of the bytes (XXH64), the content hash of the resources */
+std::uint64_t       hash64( const void *data, size_t size, std::uint64_t seed = 0 );
+
+} /* namespace engine::core */
@@ -44,6 +44,7 @@ void raw_input::detach_input()
 void raw_input::initialize( whandle_t handle )
 {
     assert( (handle && !isInit) || (!handle && isInit)  );
+#if PLATFORM_WIN64_ENABLED
     static RAWINPUTDEVICE devieMouse;
     static RAWINPUTDEVICE devieKeyboard;
     if( handle && !isInit ) {
@@ -90,8 +91,16 @@ void raw_input::initialize( whandle_t handle )
         }
         isInit = false;
     }
+#else
+    /* no input devices, keys are never pressed */
+    for( int i = 0; i < static_cast<int>(sizeof(keysPressed)); i++ ) {
+        keysPressed[i] = false;
+    }
+    isInit = handle != nullptr;
+#endif /* PLATFORM_WIN64_ENABLED */
 }
 
+#if PLATFORM_WIN64_ENABLED
 /* raw_input::process_input */
 void raw_input::process_input( LPARAM hRawInput )
 {
@@ -191,5 +200,6 @@ void raw_input::process_input( LPARAM hRawInput )
         break;
     }
 }
+#endif /* PLATFORM_WIN64_ENABLED */
 
 } /* namespace engine::core::input */
@@ -22,7 +22,9 @@ public:
 
     static bool         is_key_pressed( key dik );
 
+#if PLATFORM_WIN64_ENABLED
     static void         process_input( LPARAM hRawInput );
+#endif /* PLATFORM_WIN64_ENABLED */
 private:
     static bool         keysPressed[256];
     static bool         isInit;
@@ -1,6 +1,11 @@
 #pragma once
-#include <Windows.h>
-#include <hidusage.h>
+#include <core/config.hpp>
+#if PLATFORM_WIN64_ENABLED
+#   include <Windows.h>
+#   include <hidusage.h>
+#else
+#   include <core/platform/linux/virtual_keys.hpp>
+#endif /* PLATFORM_WIN64_ENABLED */
 
 namespace engine::core::input
 {
@@ -0,0 +1,2 @@
+#pragma once
+#include <core/jobs/job_system.hpp>
@@ -0,0 +1,249 @@
+#include "job_system.hpp"
+#include "work_stealing_deque.hpp"
+#include <core/unique_ptr.hpp>
+
+#include <thread>
+#include <deque>
+#include <condition_variable>
+
+namespace engine::core::jobs
+{
+
+/* job */
+struct job
+{
+    job_system::task    fn;
+    counter *           signal{nullptr};
+};
+
+namespace
+{
+
+typedef work_stealing_deque<job>    job_deque;
+
+/* worker thread state */
+struct worker
+{
+    job_deque           deque;
+    std::thread         thread;
+    unsigned            victim{0};      /* state of the victim selection */
+};
+
+core::vector<core::unique_ptr<worker>>  workers;
+std::atomic<bool>                       isRunning{false};
+
+/* queue for jobs started outside the workers */
+std::mutex                              sharedLock;
+std::deque<job*>                        sharedQueue;
+std::atomic<int>                        sharedCount{0};
+
+/* sleeping of idle workers */
+std::mutex                              sleepLock;
+std::condition_variable                 wakeUp;
+std::atomic<int>                        queued{0};      /* jobs in the queues */
+std::atomic<int>                        sleeping{0};    /* workers in wakeUp.wait */
+
+thread_local int                        threadIndex{-1};
+
+} /* namespace */
+
+/* job_system::initialize */
+void job_system::initialize( int threadsNumber )
+{
+    assert( !is_initialized() );
+    assert( threadsNumber >= 0 );
+    if( threadsNumber == 0 ) {
+        threadsNumber = static_cast<int>( std::thread::hardware_concurrency() );
+        threadsNumber = threadsNumber > 0 ? threadsNumber : 1;
+    }
+    isRunning = true;
+    threadIndex = 0;
+    workers.clear();
+    for( int i = 0; i < threadsNumber; i++ ) {
+        workers.emplace_back( new worker );
+        workers.back()->victim = static_cast<unsigned>( i + 1 );
+    }
+    for( int i = 1; i < threadsNumber; i++ ) {
+        workers[i]->thread = std::thread( worker_main, i );
+    }
+}
+
+/* job_system::shutdown */
+void job_system::shutdown()
+{
+    assert( is_initialized() );
+    assert( threadIndex == 0 );
+    {
+        std::lock_guard<std::mutex> guard( sleepLock );
+        isRunning = false;
+    }
+    wakeUp.notify_all();
+    for( size_t i = 1; i < workers.size(); i++ ) {
+        workers[i]->thread.join();
+    }
+    /* finish everything what was left */
+    for( auto j = find_job(); j; j = find_job() ) {
+        execute( j );
+    }
+    workers.clear();
+    threadIndex = -1;
+}
+
+/* job_system::is_initialized */
+bool job_system::is_initialized()
+{
+    return !workers.empty();
+}
+
+/* job_system::get_threads_number */
+int job_system::get_threads_number()
+{
+    return static_cast<int>( workers.size() );
+}
+
+/* job_system::get_thread_index */
+int job_system::get_thread_index()
+{
+    return threadIndex;
+}
+
+/* job_system::run */
+void job_system::run( task fn, counter *signal, counter *dependency )
+{
+    if( signal ) {
+        signal->value.fetch_add( 1, std::memory_order_relaxed );
+    }
+    auto j = new job{ std::move( fn ), signal };
+    if( dependency ) {
+        std::lock_guard<std::mutex> guard( dependency->lock );
+        if( dependency->value.load( std::memory_order_acquire ) != 0 ) {
+            dependency->waiting.push_back( j );
+            return;
+        }
+    }
+    push( j );
+}
+
+/* job_system::wait */
+void job_system::wait( counter &c )
+{
+    while( !c.is_done() ) {
+        if( auto j = find_job() ) {
+            execute( j );
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+/* job_system::worker_main */
+void job_system::worker_main( int index )
+{
+    threadIndex = index;
+    while( isRunning.load( std::memory_order_relaxed ) ) {
+        if( auto j = find_job() ) {
+            execute( j );
+            continue;
+        }
+        std::unique_lock<std::mutex> guard( sleepLock );
+        sleeping.fetch_add( 1 );
+        wakeUp.wait( guard, []() { return queued.load() > 0 || !isRunning.load(); } );
+        sleeping.fetch_sub( 1 );
+    }
+}
+
+/* job_system::push */
+void job_system::push( job *j )
+{
+    if( !is_initialized() ) {
+        /* no workers, execute now */
+        execute( j );
+        return;
+    }
+    if( threadIndex >= 0 ) {
+        if( !workers[threadIndex]->deque.push( j ) ) {
+            /* the deque is full, the job is executed now */
+            execute( j );
+            return;
+        }
+    } else {
+        std::lock_guard<std::mutex> guard( sharedLock );
+        sharedQueue.push_back( j );
+        sharedCount.fetch_add( 1 );
+    }
+    /* a sleeping worker either sees queued or is notified */
+    queued.fetch_add( 1 );
+    if( sleeping.load() > 0 ) {
+        std::lock_guard<std::mutex> guard( sleepLock );
+        wakeUp.notify_one();
+    }
+}
+
+/* job_system::find_job */
+job *job_system::find_job()
+{
+    job *j = nullptr;
+    int workersNumber = static_cast<int>( workers.size() );
+    if( threadIndex >= 0 ) {
+        /* own jobs first, latest are hot in cache */
+        auto &self = *workers[threadIndex];
+        j = self.deque.pop();
+        if( !j && workersNumber > 1 ) {
+            /* steal from the others starting with a random victim */
+            self.victim = self.victim * 1103515245u + 12345u;
+            int first = static_cast<int>( (self.victim >> 16) % workersNumber );
+            for( int i = 0; i < workersNumber && !j; i++ ) {
+                int victim = (first + i) % workersNumber;
+                if( victim != threadIndex ) {
+                    j = workers[victim]->deque.steal();
+                }
+            }
+        }
+    } else {
+        for( int i = 0; i < workersNumber && !j; i++ ) {
+            j = workers[i]->deque.steal();
+        }
+    }
+    if( !j && sharedCount.load() > 0 ) {
+        std::lock_guard<std::mutex> guard( sharedLock );
+        if( !sharedQueue.empty() ) {
+            j = sharedQueue.front();
+            sharedQueue.pop_front();
+            sharedCount.fetch_sub( 1 );
+        }
+    }
+    if( j ) {
+        queued.fetch_sub( 1 );
+    }
+    return j;
+}
+
+/* job_system::execute */
+void job_system::execute( job *j )
+{
+    j->fn();
+    auto signal = j->signal;
+    delete j;
+    if( signal ) {
+        signal_done( signal );
+    }
+}
+
+/* job_system::signal_done */
+void job_system::signal_done( counter *c )
+{
+    /* the counter may be destroyed by a waiting thread as soon as it
+    * becomes zero, so it is changed under the lock, see ~counter */
+    core::vector<job*> ready;
+    {
+        std::lock_guard<std::mutex> guard( c->lock );
+        if( c->value.fetch_sub( 1, std::memory_order_acq_rel ) == 1 ) {
+            ready.swap( c->waiting );
+        }
+    }
+    for( auto j : ready ) {
+        push( j );
+    }
+}
+
+} /* namespace engine::core::jobs */
@@ -0,0 +1,120 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <core/vector.hpp>
+#include <core/assert.hpp>
+
+namespace engine::core::jobs
+{
+
+struct job;
+
+/* counter
+* number of unfinished jobs. Every job started with a signal counter
+* increments it and decrements it when done. Jobs started with a
+* dependency counter wait in the counter until it becomes zero */
+class counter
+{
+public:
+                    counter() {}
+                    counter( const counter& ) = delete;
+    counter &       operator=( const counter& ) = delete;
+                    ~counter();
+
+    int             get() const;
+    bool            is_done() const;
+
+private:
+    friend class job_system;
+
+    std::atomic<int>    value{0};
+    std::mutex          lock;           /* guards waiting */
+    core::vector<job*>  waiting;        /* jobs started after this counter */
+}; /* class counter */
+
+
+
+/* job_system
+* worker threads with their own work-stealing deques.
+* The thread which calls initialize() is the worker 0: it does
+* not sleep but executes jobs while it waits for a counter.
+* Jobs started from threads which are not workers go to a
+* shared queue. If the system is not initialized jobs are
+* executed immediately by the calling thread */
+class job_system
+{
+public:
+    typedef std::function<void()>   task;
+
+public:
+                    /* threadsNumber = 0 - one thread per hardware core */
+    static void     initialize( int threadsNumber = 0 );
+    static void     shutdown();
+    static bool     is_initialized();
+                    /* number of workers including the main thread */
+    static int      get_threads_number();
+                    /* index of the calling worker or -1 */
+    static int      get_thread_index();
+
+                    /* start task, signal is incremented now and decremented when
+                    * the task is done, the task does not start before dependency
+                    * becomes zero */
+    static void     run( task fn, counter *signal = nullptr, counter *dependency = nullptr );
+                    /* execute other jobs until the counter becomes zero */
+    static void     wait( counter &c );
+
+private:
+    static void     worker_main( int index );
+    static void     push( job *j );
+    static job *    find_job();
+    static void     execute( job *j );
+    static void     signal_done( counter *c );
+}; /* class job_system */
+
+
+
+/* parallel_for
+* call fn( first, last ) for [begin..end) split into ranges of
+* grain elements and wait until all of them are done */
+template <typename Fn>
+void parallel_for( int begin, int end, int grain, const Fn &fn )
+{
+    assert( grain > 0 );
+    if( end - begin <= grain || job_system::get_threads_number() < 2 ) {
+        if( begin < end ) {
+            fn( begin, end );
+        }
+        return;
+    }
+    counter done;
+    for( int first = begin; first < end; first += grain ) {
+        int last = end - first > grain ? first + grain : end;
+        job_system::run( [&fn, first, last]() { fn( first, last ); }, &done );
+    }
+    job_system::wait( done );
+}
+
+
+
+/* counter::~counter */
+inline counter::~counter()
+{
+    /* wait for the thread which has signaled last */
+    std::lock_guard<std::mutex> guard( lock );
+    assert( value.load() == 0 );
+}
+
+/* counter::get */
+inline int counter::get() const
+{
+    return value.load( std::memory_order_acquire );
+}
+
+/* counter::is_done */
+inline bool counter::is_done() const
+{
+    return get() == 0;
+}
+
+} /* namespace engine::core::jobs */
@@ -0,0 +1,99 @@
+#pragma once
+#include <atomic>
+#include <core/assert.hpp>
+
+namespace engine::core::jobs
+{
+
+/* mpsc_node
+* link of the items of mpsc_queue */
+struct mpsc_node
+{
+    std::atomic<mpsc_node*>     next{nullptr};
+};
+
+/* mpsc_queue
+* unbounded intrusive FIFO queue of Vyukov: any thread pushes with one
+* exchange, the only consumer thread pops. The items derive from
+* mpsc_node and are owned by the caller. Only the consumer may call pop() */
+template <typename T>
+class mpsc_queue
+{
+public:
+                    mpsc_queue();
+                    mpsc_queue( const mpsc_queue& ) = delete;
+    mpsc_queue &    operator=( const mpsc_queue& ) = delete;
+
+    void            push( T *item );
+                    /* returns nullptr if the queue is empty or the
+                    * next item is being pushed right now */
+    T *             pop();
+
+private:
+    void            push_node( mpsc_node *node );
+
+    alignas(64) std::atomic<mpsc_node*>     head;   /* the last pushed */
+    alignas(64) mpsc_node *                 tail;   /* the next popped */
+    mpsc_node                               stub;
+}; /* class mpsc_queue */
+
+
+
+/* mpsc_queue::mpsc_queue */
+template <typename T>
+inline mpsc_queue<T>::mpsc_queue() :
+    head{&stub},
+    tail{&stub}
+{
+}
+
+/* mpsc_queue::push */
+template <typename T>
+inline void mpsc_queue<T>::push( T *item )
+{
+    assert( item != nullptr );
+    push_node( static_cast<mpsc_node*>( item ) );
+}
+
+/* mpsc_queue::push_node */
+template <typename T>
+inline void mpsc_queue<T>::push_node( mpsc_node *node )
+{
+    node->next.store( nullptr, std::memory_order_relaxed );
+    mpsc_node *prev = head.exchange( node, std::memory_order_acq_rel );
+    prev->next.store( node, std::memory_order_release );
+}
+
+/* mpsc_queue::pop */
+template <typename T>
+inline T *mpsc_queue<T>::pop()
+{
+    mpsc_node *t = tail;
+    mpsc_node *next = t->next.load( std::memory_order_acquire );
+    if( t == &stub ) {
+        if( !next ) {
+            return nullptr;
+        }
+        tail = next;
+        t = next;
+        next = next->next.load( std::memory_order_acquire );
+    }
+    if( next ) {
+        tail = next;
+        return static_cast<T*>( t );
+    }
+    if( t != head.load( std::memory_order_acquire ) ) {
+        /* a producer has exchanged the head but has not linked the node yet */
+        return nullptr;
+    }
+    /* the last item, the stub keeps the queue not empty */
+    push_node( &stub );
+    next = t->next.load( std::memory_order_acquire );
+    if( next ) {
+        tail = next;
+        return static_cast<T*>( t );
+    }
+    return nullptr;
+}
+
+} /* namespace engine::core::jobs */
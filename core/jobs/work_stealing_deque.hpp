@@ -0,0 +1,114 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <core/assert.hpp>
+
+namespace engine::core::jobs
+{
+
+/* work_stealing_deque
+* fixed size Chase-Lev deque of pointers: the owner thread pushes and
+* pops at the bottom (LIFO), any other thread steals from the top (FIFO).
+* Only the owner may call push() and pop() */
+template <typename T, int CAPACITY = 4096>
+class work_stealing_deque
+{
+    static_assert( (CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two" );
+public:
+                    work_stealing_deque();
+
+                    /* returns false if the deque is full */
+    bool            push( T *item );
+                    /* returns nullptr if the deque is empty */
+    T *             pop();
+                    /* returns nullptr if the deque is empty or
+                    * another thread took the item first */
+    T *             steal();
+
+    bool            is_empty() const;
+private:
+    static const std::int64_t MASK = CAPACITY - 1;
+
+    alignas(64) std::atomic<std::int64_t>   top{0};
+    alignas(64) std::atomic<std::int64_t>   bottom{0};
+    std::atomic<T*>                         items[CAPACITY];
+}; /* class work_stealing_deque */
+
+
+
+/* work_stealing_deque::work_stealing_deque */
+template <typename T, int CAPACITY>
+inline work_stealing_deque<T, CAPACITY>::work_stealing_deque()
+{
+    for( auto &item : items ) {
+        item.store( nullptr, std::memory_order_relaxed );
+    }
+}
+
+/* work_stealing_deque::push */
+template <typename T, int CAPACITY>
+inline bool work_stealing_deque<T, CAPACITY>::push( T *item )
+{
+    assert( item != nullptr );
+    auto b = bottom.load( std::memory_order_relaxed );
+    auto t = top.load( std::memory_order_acquire );
+    if( b - t > MASK ) {
+        return false;
+    }
+    items[b & MASK].store( item, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+    bottom.store( b + 1, std::memory_order_relaxed );
+    return true;
+}
+
+/* work_stealing_deque::pop */
+template <typename T, int CAPACITY>
+inline T *work_stealing_deque<T, CAPACITY>::pop()
+{
+    auto b = bottom.load( std::memory_order_relaxed ) - 1;
+    bottom.store( b, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    auto t = top.load( std::memory_order_relaxed );
+    if( t > b ) {
+        /* empty */
+        bottom.store( b + 1, std::memory_order_relaxed );
+        return nullptr;
+    }
+    T *item = items[b & MASK].load( std::memory_order_relaxed );
+    if( t == b ) {
+        /* the last item, race against the thieves */
+        if( !top.compare_exchange_strong( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) ) {
+            item = nullptr;
+        }
+        bottom.store( b + 1, std::memory_order_relaxed );
+    }
+    return item;
+}
+
+/* work_stealing_deque::steal */
+template <typename T, int CAPACITY>
+inline T *work_stealing_deque<T, CAPACITY>::steal()
+{
+    auto t = top.load( std::memory_order_acquire );
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    auto b = bottom.load( std::memory_order_acquire );
+    if( t >= b ) {
+        return nullptr;
+    }
+    T *item = items[t & MASK].load( std::memory_order_relaxed );
+    if( !top.compare_exchange_strong( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) ) {
+        return nullptr;
+    }
+    return item;
+}
+
+/* work_stealing_deque::is_empty */
+template <typename T, int CAPACITY>
+inline bool work_stealing_deque<T, CAPACITY>::is_empty() const
+{
+    auto t = top.load( std::memory_order_relaxed );
+    auto b = bottom.load( std::memory_order_relaxed );
+    return b <= t;
+}
+
+} /* namespace engine::core::jobs */
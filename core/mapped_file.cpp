@@ -0,0 +1,48 @@
+#include "mapped_file.hpp"
+
+namespace engine::core
+{
+
+/* mapped_file::mapped_file */
+mapped_file::mapped_file( mapped_file &&other )
+{
+    *this = std::move( other );
+}
+
+/* mapped_file::~mapped_file */
+mapped_file::~mapped_file()
+{
+    close();
+}
+
+/* mapped_file::operator= */
+mapped_file &mapped_file::operator=( mapped_file &&other )
+{
+    if( this != &other ) {
+        close();
+        mapping = other.mapping;
+        isOpen = other.isOpen;
+        other.mapping = platform::file_mapping();
+        other.isOpen = false;
+    }
+    return *this;
+}
+
+/* mapped_file::open */
+bool mapped_file::open( const string &path )
+{
+    close();
+    isOpen = platform::map_file( path.c_str(), mapping );
+    return isOpen;
+}
+
+/* mapped_file::close */
+void mapped_file::close()
+{
+    if( isOpen ) {
+        platform::unmap_file( mapping );
+        isOpen = false;
+    }
+}
+
+} /* namespace engine::core */
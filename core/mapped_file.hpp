@@ -0,0 +1,58 @@
+#pragma once
+#include <core/types.hpp>
+#include <core/string.hpp>
+#include <core/platform/api.hpp>
+
+namespace engine::core
+{
+
+/* mapped_file
+* read-only memory view of the whole file, the pages are loaded by the
+* system on the first access, so nothing is copied. The path is taken
+* as is, see filesystem::open_mapped() for the resources */
+class mapped_file
+{
+public:
+                    mapped_file() {}
+                    mapped_file( mapped_file &&other );
+                    mapped_file( const mapped_file & ) = delete;
+                    ~mapped_file();
+
+    mapped_file &   operator=( mapped_file &&other );
+    mapped_file &   operator=( const mapped_file & ) = delete;
+
+                    /* returns false if the file can not be mapped */
+    bool            open( const string &path );
+    void            close();
+
+    bool            is_open() const;
+                    /* nullptr for the empty file */
+    const byte *    data() const;
+    size_t          size() const;
+
+private:
+    platform::file_mapping  mapping;
+    bool            isOpen{false};
+}; /* class mapped_file */
+
+
+
+/* mapped_file::is_open */
+inline bool mapped_file::is_open() const
+{
+    return isOpen;
+}
+
+/* mapped_file::data */
+inline const byte *mapped_file::data() const
+{
+    return static_cast<const byte*>( mapping.data );
+}
+
+/* mapped_file::size */
+inline size_t mapped_file::size() const
+{
+    return static_cast<size_t>( mapping.size );
+}
+
+} /* namespace engine::core */
@@ -6,3 +6,5 @@
 #include <core/math/mat4.hpp>
 #include <core/math/quat.hpp>
 #include <core/math/rectangle.hpp>
+#include <core/math/bounds.hpp>
+#include <core/math/frustum.hpp>
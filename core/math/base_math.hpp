@@ -98,14 +98,11 @@ T squr( T a )
     return a * a;
 }
 
-/* abs */
+/* abs
+* the sign bit is cleared by the compiler, no type punning */
 inline float abs( float a )
 {
-    void *ptr = reinterpret_cast<void*>(&a);
-    unsigned int bits = (*reinterpret_cast<unsigned int*>(ptr));
-    bits &= 0x7fffffff;
-    ptr = reinterpret_cast<void*>(&bits);
-    return *reinterpret_cast<float*>(ptr);
+    return std::fabs( a );
 }
 
 /* abs 
@@ -0,0 +1,74 @@
+#include "bounds.hpp"
+#include "base_math.hpp"
+
+namespace engine::core::math
+{
+
+/* aabb::transform
+* center is transformed, extents are projected to the new axes */
+aabb aabb::transform( const mat4 &m ) const
+{
+    if( is_empty() ) {
+        return aabb();
+    }
+    auto c = center();
+    auto e = extents();
+    vec3 newCenter(
+        m.x.x * c.x + m.x.y * c.y + m.x.z * c.z + m.x.w,
+        m.y.x * c.x + m.y.y * c.y + m.y.z * c.z + m.y.w,
+        m.z.x * c.x + m.z.y * c.y + m.z.z * c.z + m.z.w );
+    vec3 newExtents(
+        std::fabs( m.x.x ) * e.x + std::fabs( m.x.y ) * e.y + std::fabs( m.x.z ) * e.z,
+        std::fabs( m.y.x ) * e.x + std::fabs( m.y.y ) * e.y + std::fabs( m.y.z ) * e.z,
+        std::fabs( m.z.x ) * e.x + std::fabs( m.z.y ) * e.y + std::fabs( m.z.z ) * e.z );
+    return aabb( newCenter - newExtents, newCenter + newExtents );
+}
+
+/* aabb::from_points */
+aabb aabb::from_points( const void *xyz, int stride, int count )
+{
+    assert( xyz != nullptr || count == 0 );
+    assert( stride >= static_cast<int>(3 * sizeof(float)) );
+    aabb box;
+    auto ptr = reinterpret_cast<const char*>(xyz);
+    for( int i = 0; i < count; i++, ptr += stride ) {
+        auto p = reinterpret_cast<const float*>(ptr);
+        box.add_point( vec3( p[0], p[1], p[2] ) );
+    }
+    return box;
+}
+
+/* sphere::transform */
+sphere sphere::transform( const mat4 &m ) const
+{
+    vec3 c(
+        m.x.x * center.x + m.x.y * center.y + m.x.z * center.z + m.x.w,
+        m.y.x * center.x + m.y.y * center.y + m.y.z * center.z + m.y.w,
+        m.z.x * center.x + m.z.y * center.y + m.z.z * center.z + m.z.w );
+    auto sx = m.x.x * m.x.x + m.x.y * m.x.y + m.x.z * m.x.z;
+    auto sy = m.y.x * m.y.x + m.y.y * m.y.y + m.y.z * m.y.z;
+    auto sz = m.z.x * m.z.x + m.z.y * m.z.y + m.z.z * m.z.z;
+    return sphere( c, radius * sqrt( max( sx, sy, sz ) ) );
+}
+
+/* sphere::from_points */
+sphere sphere::from_points( const void *xyz, int stride, int count )
+{
+    auto box = aabb::from_points( xyz, stride, count );
+    if( box.is_empty() ) {
+        return sphere();
+    }
+    sphere s( box.center(), 0.0 );
+    auto ptr = reinterpret_cast<const char*>(xyz);
+    type radius2 = 0.0;
+    for( int i = 0; i < count; i++, ptr += stride ) {
+        auto p = reinterpret_cast<const float*>(ptr);
+        auto d = vec3( p[0], p[1], p[2] ) - s.center;
+        auto dist2 = d * d;
+        radius2 = dist2 > radius2 ? dist2 : radius2;
+    }
+    s.radius = sqrt( radius2 );
+    return s;
+}
+
+} /* namespace engine::core::math */
@@ -0,0 +1,102 @@
+#pragma once
+#include "vec3.hpp"
+#include "mat4.hpp"
+#include <cfloat>
+
+namespace engine::core::math
+{
+
+/* aabb
+* axis aligned bounding box */
+class aabb
+{
+public:
+    typedef float   type;
+
+public:
+                    /* empty box */
+                    aabb() {}
+                    aabb( const vec3 &min, const vec3 &max ) : min{min}, max{max} {}
+
+    void            clear();
+    bool            is_empty() const;
+    void            add_point( const vec3 &p );
+    vec3            center() const;
+                    /* half size of the box */
+    vec3            extents() const;
+                    /* box around the transformed box */
+    aabb            transform( const mat4 &m ) const;
+
+                    /* points are xyz floats stride bytes apart */
+    static aabb     from_points( const void *xyz, int stride, int count );
+
+public:
+    vec3            min{FLT_MAX, FLT_MAX, FLT_MAX};
+    vec3            max{-FLT_MAX, -FLT_MAX, -FLT_MAX};
+}; /* class aabb */
+
+
+
+/* sphere
+* bounding sphere */
+class sphere
+{
+public:
+    typedef float   type;
+
+public:
+                    sphere() {}
+                    sphere( const vec3 &center, type radius ) : center{center}, radius{radius} {}
+
+                    /* m is translation * scale * rotation like object3d_location,
+                    * the radius is scaled by the longest row of the 3x3 part */
+    sphere          transform( const mat4 &m ) const;
+
+                    /* sphere around the box of the points, points are xyz
+                    * floats stride bytes apart */
+    static sphere   from_points( const void *xyz, int stride, int count );
+
+public:
+    vec3            center{0.0, 0.0, 0.0};
+    type            radius{0.0};
+}; /* class sphere */
+
+
+
+/* aabb::clear */
+inline void aabb::clear()
+{
+    min = vec3( FLT_MAX, FLT_MAX, FLT_MAX );
+    max = vec3( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+}
+
+/* aabb::is_empty */
+inline bool aabb::is_empty() const
+{
+    return min.x > max.x || min.y > max.y || min.z > max.z;
+}
+
+/* aabb::add_point */
+inline void aabb::add_point( const vec3 &p )
+{
+    min.x = p.x < min.x ? p.x : min.x;
+    min.y = p.y < min.y ? p.y : min.y;
+    min.z = p.z < min.z ? p.z : min.z;
+    max.x = p.x > max.x ? p.x : max.x;
+    max.y = p.y > max.y ? p.y : max.y;
+    max.z = p.z > max.z ? p.z : max.z;
+}
+
+/* aabb::center */
+inline vec3 aabb::center() const
+{
+    return (min + max) * 0.5f;
+}
+
+/* aabb::extents */
+inline vec3 aabb::extents() const
+{
+    return (max - min) * 0.5f;
+}
+
+} /* namespace engine::core::math */
@@ -0,0 +1,134 @@
+#include "frustum.hpp"
+#include "base_math.hpp"
+#include <core/simd.hpp>
+
+namespace engine::core::math
+{
+
+/* frustum::set
+* clip = m * p, the point is inside if -w <= x, y, z <= w */
+void frustum::set( const mat4 &m )
+{
+    const vec4 &r0 = m.x;
+    const vec4 &r1 = m.y;
+    const vec4 &r2 = m.z;
+    const vec4 &r3 = m.w;
+    planes[PLANE_LEFT]   = vec4( r3.x + r0.x, r3.y + r0.y, r3.z + r0.z, r3.w + r0.w );
+    planes[PLANE_RIGHT]  = vec4( r3.x - r0.x, r3.y - r0.y, r3.z - r0.z, r3.w - r0.w );
+    planes[PLANE_BOTTOM] = vec4( r3.x + r1.x, r3.y + r1.y, r3.z + r1.z, r3.w + r1.w );
+    planes[PLANE_TOP]    = vec4( r3.x - r1.x, r3.y - r1.y, r3.z - r1.z, r3.w - r1.w );
+    planes[PLANE_NEAR]   = vec4( r3.x + r2.x, r3.y + r2.y, r3.z + r2.z, r3.w + r2.w );
+    planes[PLANE_FAR]    = vec4( r3.x - r2.x, r3.y - r2.y, r3.z - r2.z, r3.w - r2.w );
+    /* normalize so the distances are in world units */
+    for( auto &p : planes ) {
+        auto length = sqrt( p.x * p.x + p.y * p.y + p.z * p.z );
+        if( length > 0.0f ) {
+            auto inv = 1.0f / length;
+            p = vec4( p.x * inv, p.y * inv, p.z * inv, p.w * inv );
+        }
+    }
+}
+
+/* frustum::test_point */
+bool frustum::test_point( const vec3 &p ) const
+{
+    for( const auto &pl : planes ) {
+        if( pl.x * p.x + pl.y * p.y + pl.z * p.z + pl.w < 0.0f ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* frustum::test_sphere */
+bool frustum::test_sphere( const sphere &s ) const
+{
+    const auto &c = s.center;
+    for( const auto &pl : planes ) {
+        if( pl.x * c.x + pl.y * c.y + pl.z * c.z + pl.w < -s.radius ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* frustum::test_aabb
+* the corner farthest along the plane normal must be inside */
+bool frustum::test_aabb( const aabb &box ) const
+{
+    for( const auto &pl : planes ) {
+        auto x = pl.x >= 0.0f ? box.max.x : box.min.x;
+        auto y = pl.y >= 0.0f ? box.max.y : box.min.y;
+        auto z = pl.z >= 0.0f ? box.max.z : box.min.z;
+        if( pl.x * x + pl.y * y + pl.z * z + pl.w < 0.0f ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* frustum::classify_aabb
+* the farthest corner along the normal decides outside,
+* the nearest corner decides inside */
+frustum::test_result frustum::classify_aabb( const aabb &box ) const
+{
+    auto result = TEST_INSIDE;
+    for( const auto &pl : planes ) {
+        auto x = pl.x >= 0.0f ? box.max.x : box.min.x;
+        auto y = pl.y >= 0.0f ? box.max.y : box.min.y;
+        auto z = pl.z >= 0.0f ? box.max.z : box.min.z;
+        if( pl.x * x + pl.y * y + pl.z * z + pl.w < 0.0f ) {
+            return TEST_OUTSIDE;
+        }
+        x = pl.x >= 0.0f ? box.min.x : box.max.x;
+        y = pl.y >= 0.0f ? box.min.y : box.max.y;
+        z = pl.z >= 0.0f ? box.min.z : box.max.z;
+        if( pl.x * x + pl.y * y + pl.z * z + pl.w < 0.0f ) {
+            result = TEST_INTERSECTS;
+        }
+    }
+    return result;
+}
+
+/* frustum::test_spheres */
+int frustum::test_spheres( const type *x, const type *y, const type *z, const type *r, 
+        int count, int *visible ) const
+{
+    assert( count >= 0 );
+    int n = 0;
+    int i = 0;
+#if MATH_SIMD_ENABLED
+    /* four spheres per step against every plane */
+    __m128 px[PLANES_NUMBER], py[PLANES_NUMBER], pz[PLANES_NUMBER], pw[PLANES_NUMBER];
+    for( int p = 0; p < PLANES_NUMBER; p++ ) {
+        px[p] = _mm_set1_ps( planes[p].x );
+        py[p] = _mm_set1_ps( planes[p].y );
+        pz[p] = _mm_set1_ps( planes[p].z );
+        pw[p] = _mm_set1_ps( planes[p].w );
+    }
+    const __m128 signMask = _mm_set1_ps( -0.0f );
+    for( ; i + 4 <= count; i += 4 ) {
+        auto sx = _mm_loadu_ps( x + i );
+        auto sy = _mm_loadu_ps( y + i );
+        auto sz = _mm_loadu_ps( z + i );
+        auto negR = _mm_xor_ps( _mm_loadu_ps( r + i ), signMask );
+        auto outside = _mm_setzero_ps();
+        for( int p = 0; p < PLANES_NUMBER; p++ ) {
+            auto d = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( px[p], sx ), 
+                    _mm_mul_ps( py[p], sy ) ), _mm_mul_ps( pz[p], sz ) ), pw[p] );
+            outside = _mm_or_ps( outside, _mm_cmplt_ps( d, negR ) );
+        }
+        for( int mask = ~_mm_movemask_ps( outside ) & 0xf; mask; mask &= mask - 1 ) {
+            visible[n++] = i + __builtin_ctz( mask );
+        }
+    }
+#endif /* MATH_SIMD_ENABLED */
+    for( ; i < count; i++ ) {
+        if( test_sphere( sphere( vec3( x[i], y[i], z[i] ), r[i] ) ) ) {
+            visible[n++] = i;
+        }
+    }
+    return n;
+}
+
+} /* namespace engine::core::math */
@@ -0,0 +1,71 @@
+#pragma once
+#include "vec4.hpp"
+#include "mat4.hpp"
+#include "bounds.hpp"
+
+namespace engine::core::math
+{
+
+/* frustum
+* six planes of the view volume extracted from a view-projection
+* matrix (Gribb, Hartmann). The planes point inside, a point p is
+* inside if dot(plane.xyz, p) + plane.w >= 0 for all of them */
+class frustum
+{
+public:
+    typedef float   type;
+
+    enum test_result {
+        TEST_OUTSIDE,
+        TEST_INTERSECTS,
+        TEST_INSIDE
+    };
+
+    enum plane_index {
+        PLANE_LEFT,
+        PLANE_RIGHT,
+        PLANE_BOTTOM,
+        PLANE_TOP,
+        PLANE_NEAR,
+        PLANE_FAR,
+        PLANES_NUMBER
+    };
+
+public:
+                    frustum() {}
+                    frustum( const mat4 &viewProjection );
+
+    void            set( const mat4 &viewProjection );
+    const vec4 &    get_plane( plane_index i ) const;
+
+    bool            test_point( const vec3 &p ) const;
+    bool            test_sphere( const sphere &s ) const;
+    bool            test_aabb( const aabb &box ) const;
+                    /* tells whether the box is fully inside the frustum */
+    test_result     classify_aabb( const aabb &box ) const;
+                    /* spheres in arrays x[count], y[count], z[count], r[count];
+                    * indices of the visible ones are written to visible,
+                    * returns their number */
+    int             test_spheres( const type *x, const type *y, const type *z, const type *r, 
+                            int count, int *visible ) const;
+
+private:
+    vec4            planes[PLANES_NUMBER];
+}; /* class frustum */
+
+
+
+/* frustum::frustum */
+inline frustum::frustum( const mat4 &viewProjection )
+{
+    set( viewProjection );
+}
+
+/* frustum::get_plane */
+inline const vec4 &frustum::get_plane( plane_index i ) const
+{
+    math_asserta( i >= 0 && i < PLANES_NUMBER, "index: %d", i );
+    return planes[i];
+}
+
+} /* namespace engine::core::math */
@@ -1,5 +1,6 @@
 #include "mat4.hpp"
 #include "base_math.hpp"
+#include <core/simd.hpp>
 
 namespace engine::core::math
 {
@@ -7,6 +8,100 @@ namespace engine::core::math
 const mat4 MAT4_ZERO { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
 const mat4 MAT4_IDENTITY { 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0 };
 
+#if MATH_SIMD_ENABLED
+/* mat4::operator*
+* the rows are transposed to columns, so each lane sums its row products
+* in the same order as the scalar code and the result is bit-exact */
+vec4 mat4::operator*( const vec4 &a ) const
+{
+    __m128 c0 = _mm_load_ps( x.get_ptr() );
+    __m128 c1 = _mm_load_ps( y.get_ptr() );
+    __m128 c2 = _mm_load_ps( z.get_ptr() );
+    __m128 c3 = _mm_load_ps( w.get_ptr() );
+    _MM_TRANSPOSE4_PS( c0, c1, c2, c3 );
+    __m128 r = _mm_mul_ps( c0, _mm_set1_ps( a.x ) );
+    r = _mm_add_ps( r, _mm_mul_ps( c1, _mm_set1_ps( a.y ) ) );
+    r = _mm_add_ps( r, _mm_mul_ps( c2, _mm_set1_ps( a.z ) ) );
+    r = _mm_add_ps( r, _mm_mul_ps( c3, _mm_set1_ps( a.w ) ) );
+    vec4 out;
+    _mm_store_ps( out.get_ptr(), r );
+    return out;
+}
+
+/* mat4::operator* */
+vec3 mat4::operator*( const vec3 &a ) const
+{
+    __m128 c0 = _mm_load_ps( x.get_ptr() );
+    __m128 c1 = _mm_load_ps( y.get_ptr() );
+    __m128 c2 = _mm_load_ps( z.get_ptr() );
+    __m128 c3 = _mm_load_ps( w.get_ptr() );
+    _MM_TRANSPOSE4_PS( c0, c1, c2, c3 );
+    __m128 r = _mm_mul_ps( c0, _mm_set1_ps( a.x ) );
+    r = _mm_add_ps( r, _mm_mul_ps( c1, _mm_set1_ps( a.y ) ) );
+    r = _mm_add_ps( r, _mm_mul_ps( c2, _mm_set1_ps( a.z ) ) );
+    r = _mm_add_ps( r, c3 );
+    alignas(16) type v[4];
+    _mm_store_ps( v, r );
+    auto scale = v[3];
+    if (scale == 1.0) {
+        return vec3( v[0], v[1], v[2] );
+    } else if (scale == 0.0) {
+        return vec3( 0.0, 0.0, 0.0 );
+    } else {
+        auto invScale = 1.0 / scale;
+        return vec3( v[0] * invScale, v[1] * invScale, v[2] * invScale );
+    }
+}
+
+#if SIMD_AVX2_ENABLED
+/* mat4::operator*
+* two rows of the result per iteration: the low lane holds row i,
+* the high lane holds row i + 1 */
+mat4 mat4::operator*( const mat4 &a ) const
+{
+    mat4 mat;
+    auto r0 = _mm256_broadcast_ps( reinterpret_cast<const __m128*>(&a.x) );
+    auto r1 = _mm256_broadcast_ps( reinterpret_cast<const __m128*>(&a.y) );
+    auto r2 = _mm256_broadcast_ps( reinterpret_cast<const __m128*>(&a.z) );
+    auto r3 = _mm256_broadcast_ps( reinterpret_cast<const __m128*>(&a.w) );
+    auto l = get_ptr();
+    auto m = mat.get_ptr();
+    for (auto i = 0; i < 2; i++) {
+        auto rows = _mm256_loadu_ps( l );
+        auto v = _mm256_mul_ps( _mm256_shuffle_ps( rows, rows, 0x00 ), r0 );
+        v = _mm256_add_ps( v, _mm256_mul_ps( _mm256_shuffle_ps( rows, rows, 0x55 ), r1 ) );
+        v = _mm256_add_ps( v, _mm256_mul_ps( _mm256_shuffle_ps( rows, rows, 0xaa ), r2 ) );
+        v = _mm256_add_ps( v, _mm256_mul_ps( _mm256_shuffle_ps( rows, rows, 0xff ), r3 ) );
+        _mm256_storeu_ps( m, v );
+        l += 8;
+        m += 8;
+    }
+    return mat;
+}
+#else
+/* mat4::operator* */
+mat4 mat4::operator*( const mat4 &a ) const
+{
+    mat4 mat;
+    auto r0 = _mm_load_ps( a.x.get_ptr() );
+    auto r1 = _mm_load_ps( a.y.get_ptr() );
+    auto r2 = _mm_load_ps( a.z.get_ptr() );
+    auto r3 = _mm_load_ps( a.w.get_ptr() );
+    auto l = get_ptr();
+    auto m = mat.get_ptr();
+    for (auto i = 0; i < 4; i++) {
+        auto v = _mm_mul_ps( _mm_set1_ps( l[0] ), r0 );
+        v = _mm_add_ps( v, _mm_mul_ps( _mm_set1_ps( l[1] ), r1 ) );
+        v = _mm_add_ps( v, _mm_mul_ps( _mm_set1_ps( l[2] ), r2 ) );
+        v = _mm_add_ps( v, _mm_mul_ps( _mm_set1_ps( l[3] ), r3 ) );
+        _mm_store_ps( m, v );
+        l += 4;
+        m += 4;
+    }
+    return mat;
+}
+#endif /* SIMD_AVX2_ENABLED */
+#else
 /* mat4::operator* */
 vec4 mat4::operator*( const vec4 &a ) const
 {
@@ -56,6 +151,7 @@ mat4 mat4::operator*( const mat4 &a ) const
     }
     return mat;
 }
+#endif /* MATH_SIMD_ENABLED */
 
 /* mat4::operator+ */
 mat4 mat4::operator+( const mat4 &a ) const
@@ -1,10 +1,41 @@
 #include "quat.hpp"
+#include <core/simd.hpp>
 
 namespace engine::core::math
 {
 
 const quat QUAT_ZERO { 0.0, 0.0, 0.0, 1.0 };
 
+#if MATH_SIMD_ENABLED
+/* quat::to_mat4 */
+mat4 quat::to_mat4()
+{
+    auto q = _mm_load_ps( &x );
+    auto q2 = _mm_add_ps( q, q );
+    /* (xx, yy, zz, ww) */
+    auto sq = _mm_mul_ps( q, q2 );
+    /* (1 - (yy + zz), 1 - (xx + zz), 1 - (xx + yy)) */
+    auto diag = _mm_sub_ps( _mm_set1_ps( 1.0 ),
+            _mm_add_ps( _mm_shuffle_ps( sq, sq, _MM_SHUFFLE(3, 0, 0, 1) ),
+                    _mm_shuffle_ps( sq, sq, _MM_SHUFFLE(3, 1, 2, 2) ) ) );
+    /* (xy, xz, yz) */
+    auto p = _mm_mul_ps( _mm_shuffle_ps( q, q, _MM_SHUFFLE(3, 1, 0, 0) ),
+            _mm_shuffle_ps( q2, q2, _MM_SHUFFLE(3, 2, 2, 1) ) );
+    /* (wz, wy, wx) */
+    auto wv = _mm_mul_ps( _mm_shuffle_ps( q, q, _MM_SHUFFLE(3, 3, 3, 3) ),
+            _mm_shuffle_ps( q2, q2, _MM_SHUFFLE(3, 0, 1, 2) ) );
+    alignas(16) type d[4], s[4], m[4];
+    _mm_store_ps( d, diag );
+    _mm_store_ps( s, _mm_add_ps( p, wv ) );
+    _mm_store_ps( m, _mm_sub_ps( p, wv ) );
+    return mat4(
+        d[0], m[0], s[1], 0.0,
+        s[0], d[1], m[2], 0.0,
+        m[1], s[2], d[2], 0.0,
+        0.0, 0.0, 0.0, 1.0
+    );
+}
+#else
 /* quat::to_mat4 */
 mat4 quat::to_mat4()
 {
@@ -27,5 +58,6 @@ mat4 quat::to_mat4()
         0.0, 0.0, 0.0, 1.0
     );
 }
+#endif /* MATH_SIMD_ENABLED */
 
 } /* namespace engine::core::math */
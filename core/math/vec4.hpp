@@ -19,7 +19,7 @@ public:
     type &          operator[]( int index );
 
     void            zero();
-    vec3 &          vec3();
+    math::vec3 &    vec3();
 
     const type *    get_ptr() const;
     type *          get_ptr();
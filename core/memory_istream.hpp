@@ -0,0 +1,108 @@
+#pragma once
+#include <core/types.hpp>
+#include <core/assert.hpp>
+#include <cstring>
+
+namespace engine::core
+{
+
+/* memory_istream
+* sequential reader of the bytes in the memory (a mapped file or
+* a buffer), which the reader does not own. Unlike std::istream there
+* are no buffers and no states: read() copies, get_ptr() returns the
+* bytes in place and fails without moving if there are not enough */
+class memory_istream
+{
+public:
+                    memory_istream( const byte *data, size_t size );
+
+                    /* returns false and reads nothing if less than size bytes left */
+    bool            read( void *to, size_t size );
+                    /* returns size bytes in place or nullptr */
+    const byte *    get_ptr( size_t size );
+    bool            skip( size_t size );
+    bool            seek( size_t pos );
+
+    size_t          tell() const;
+    size_t          size() const;
+    size_t          remaining() const;
+    const byte *    data() const;
+
+private:
+    const byte *    begin;
+    size_t          length;
+    size_t          pos{0};
+}; /* class memory_istream */
+
+
+
+/* memory_istream::memory_istream */
+inline memory_istream::memory_istream( const byte *data, size_t size ) :
+        begin{data}, length{size}
+{
+    core_assert( data != nullptr || size == 0 );
+}
+
+/* memory_istream::read */
+inline bool memory_istream::read( void *to, size_t size )
+{
+    const byte *from = get_ptr( size );
+    if( from == nullptr ) {
+        return false;
+    }
+    memcpy( to, from, size );
+    return true;
+}
+
+/* memory_istream::get_ptr */
+inline const byte *memory_istream::get_ptr( size_t size )
+{
+    if( size > length - pos ) {
+        return nullptr;
+    }
+    const byte *ptr = begin + pos;
+    pos += size;
+    return ptr;
+}
+
+/* memory_istream::skip */
+inline bool memory_istream::skip( size_t size )
+{
+    return get_ptr( size ) != nullptr;
+}
+
+/* memory_istream::seek */
+inline bool memory_istream::seek( size_t pos )
+{
+    if( pos > length ) {
+        return false;
+    }
+    this->pos = pos;
+    return true;
+}
+
+/* memory_istream::tell */
+inline size_t memory_istream::tell() const
+{
+    return pos;
+}
+
+/* memory_istream::size */
+inline size_t memory_istream::size() const
+{
+    return length;
+}
+
+/* memory_istream::remaining */
+inline size_t memory_istream::remaining() const
+{
+    return length - pos;
+}
+
+/* memory_istream::data */
+inline const byte *memory_istream::data() const
+{
+    return begin;
+}
+
+} /* namespace engine::core */
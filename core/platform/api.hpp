@@ -8,4 +8,13 @@ namespace engine::core::platform
 timer_ticks get_ticks_per_sec();
 timer_ticks get_current_ticks();
 
+/* true if the path is a regular file */
+bool        is_file( const char *path );
+/* returns false if the file does not exist */
+bool        get_file_size( const char *path, file_size &size );
+/* maps the file to the memory for reading, the data of the empty file
+* is nullptr. Returns false if the file can not be opened or mapped */
+bool        map_file( const char *path, file_mapping &mapping );
+void        unmap_file( file_mapping &mapping );
+
 } /* namespace engine::core::platform */
@@ -0,0 +1,68 @@
+#include <core/platform/api.hpp>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace engine::core::platform
+{
+
+/* is_file */
+bool is_file( const char *path )
+{
+    struct stat st;
+    return stat( path, &st ) == 0 && S_ISREG( st.st_mode );
+}
+
+/* get_file_size */
+bool get_file_size( const char *path, file_size &size )
+{
+    struct stat st;
+    if( stat( path, &st ) != 0 || !S_ISREG( st.st_mode ) ) {
+        return false;
+    }
+    size = static_cast<file_size>( st.st_size );
+    return true;
+}
+
+/* map_file */
+bool map_file( const char *path, file_mapping &mapping )
+{
+    int fd = open( path, O_RDONLY );
+    if( fd < 0 ) {
+        return false;
+    }
+    struct stat st;
+    if( fstat( fd, &st ) != 0 || !S_ISREG( st.st_mode ) ) {
+        close( fd );
+        return false;
+    }
+    mapping.data = nullptr;
+    mapping.size = static_cast<file_size>( st.st_size );
+    if( mapping.size > 0 ) {
+        void *data = mmap( nullptr, static_cast<size_t>( mapping.size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+        if( data == MAP_FAILED ) {
+            close( fd );
+            mapping.size = 0;
+            return false;
+        }
+        /* the files are mostly decoded from the beginning to the end */
+        madvise( data, static_cast<size_t>( mapping.size ), MADV_SEQUENTIAL );
+        mapping.data = data;
+    }
+    /* the mapping keeps the file */
+    close( fd );
+    return true;
+}
+
+/* unmap_file */
+void unmap_file( file_mapping &mapping )
+{
+    if( mapping.data != nullptr ) {
+        munmap( const_cast<void*>( mapping.data ), static_cast<size_t>( mapping.size ) );
+    }
+    mapping.data = nullptr;
+    mapping.size = 0;
+}
+
+} /* namespace engine::core::platform */
@@ -0,0 +1,22 @@
+#include <core/platform/api.hpp>
+#include <time.h>
+
+namespace engine::core::platform
+{
+
+/* get_ticks_per_sec
+* ticks are nanoseconds */
+timer_ticks get_ticks_per_sec()
+{
+    return 1000000000ll;
+}
+
+/* get_current_ticks */
+timer_ticks get_current_ticks()
+{
+    timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return static_cast<timer_ticks>( ts.tv_sec ) * 1000000000ll + ts.tv_nsec;
+}
+
+} /* namespace engine::core::platform */
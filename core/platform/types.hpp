@@ -4,5 +4,13 @@ namespace engine::core::platform
 {
 
 typedef long long int   timer_ticks;
+typedef long long int   file_size;
+
+/* read-only view of the whole file, see map_file() */
+struct file_mapping
+{
+    const void *        data{nullptr};
+    file_size           size{0};
+};
 
 } /* namespace engine::core::platform */
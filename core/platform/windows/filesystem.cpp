@@ -0,0 +1,69 @@
+#include <core/platform/api.hpp>
+#include <windows.h>
+
+namespace engine::core::platform
+{
+
+/* is_file */
+bool is_file( const char *path )
+{
+    auto attr = GetFileAttributesA( path );
+    return attr != INVALID_FILE_ATTRIBUTES && !(attr & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+/* get_file_size */
+bool get_file_size( const char *path, file_size &size )
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if( !GetFileAttributesExA( path, GetFileExInfoStandard, &data ) ||
+            (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ) {
+        return false;
+    }
+    size = (static_cast<file_size>( data.nFileSizeHigh ) << 32) | data.nFileSizeLow;
+    return true;
+}
+
+/* map_file */
+bool map_file( const char *path, file_mapping &mapping )
+{
+    HANDLE file = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+    if( file == INVALID_HANDLE_VALUE ) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if( !GetFileSizeEx( file, &size ) ) {
+        CloseHandle( file );
+        return false;
+    }
+    mapping.data = nullptr;
+    mapping.size = static_cast<file_size>( size.QuadPart );
+    if( mapping.size > 0 ) {
+        HANDLE map = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+        void *data = map != NULL ? MapViewOfFile( map, FILE_MAP_READ, 0, 0, 0 ) : nullptr;
+        /* the view keeps the file and the mapping */
+        if( map != NULL ) {
+            CloseHandle( map );
+        }
+        if( data == nullptr ) {
+            CloseHandle( file );
+            mapping.size = 0;
+            return false;
+        }
+        mapping.data = data;
+    }
+    CloseHandle( file );
+    return true;
+}
+
+/* unmap_file */
+void unmap_file( file_mapping &mapping )
+{
+    if( mapping.data != nullptr ) {
+        UnmapViewOfFile( mapping.data );
+    }
+    mapping.data = nullptr;
+    mapping.size = 0;
+}
+
+} /* namespace engine::core::platform */
@@ -0,0 +1,282 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <core/types.hpp>
+#include <core/string.hpp>
+#include <core/vector.hpp>
+#include <core/shared_ptr.hpp>
+#include <core/assert.hpp>
+#include <core/common.hpp>
+#include <core/filesystem.hpp>
+#include <core/mapped_file.hpp>
+#include <core/hash.hpp>
+
+namespace engine::core
+{
+
+/* memory of one resource */
+struct resource_size
+{
+    size_t          cpuBytes{0};
+    size_t          gpuBytes{0};
+};
+
+struct resource_cache_stats
+{
+    int             hits{0};            /* found by the path */
+    int             deduplicated{0};    /* a new path with the contents of an entry */
+    int             misses{0};          /* loaded */
+    int             evictions{0};
+    int             entries{0};
+    size_t          cpuBytes{0};
+    size_t          gpuBytes{0};
+};
+
+/* resource_cache
+* resources of type T shared by core::shared_ptr. The entries are found by
+* the path, a new path is read and found by the hash of its contents, so
+* the same file under two names is loaded once. The contents of the equal
+* hash are compared with the file of the entry before it is shared. When
+* the sizes of the entries exceed the budget the least recently used
+* entries which are referenced by the cache only are evicted. Used by the
+* main thread only */
+template <typename T>
+class resource_cache
+{
+public:
+    typedef core::shared_ptr<T>     handle;
+                    /* makes the resource of the file and returns its size,
+                    * the file may be moved out (see async_loader) */
+    typedef std::function<bool( mapped_file &file, T &resource, resource_size &resSize )> load_fn;
+
+public:
+                    resource_cache( load_fn load, size_t budget = SIZE_MAX );
+                    resource_cache( const resource_cache& ) = delete;
+    resource_cache &    operator=( const resource_cache& ) = delete;
+
+                    /* nullptr if the file can not be opened or loaded */
+    handle          get( const string &path );
+    bool            contains( const string &path ) const;
+                    /* the size is changed after the upload to the GPU etc */
+    void            set_size( const handle &resource, const resource_size &resSize );
+
+                    /* evicts the entries if the new budget is exceeded */
+    void            set_budget( size_t bytes );
+    size_t          get_budget() const;
+                    /* evicts the unreferenced entries until the budget is met,
+                    * returns the number of the evicted entries */
+    int             evict();
+                    /* removes all unreferenced entries */
+    void            clear();
+
+    const resource_cache_stats &    get_stats() const;
+
+private:
+    struct entry
+    {
+        handle                  resource;
+        std::uint64_t           hash;
+        size_t                  contentsSize;
+        resource_size           resSize;
+        core::vector<string>    paths;
+    };
+
+    typedef std::list<entry>                    entry_list;
+    typedef typename entry_list::iterator       entry_iterator;
+
+                    /* true if a file of the entry has the contents */
+    bool            is_same_contents( const entry &e, const byte *data, size_t size ) const;
+    void            touch( entry_iterator it );
+    void            remove( entry_iterator it );
+    size_t          get_total() const;
+
+    load_fn         load;
+    size_t          budget;
+    entry_list      entries;            /* the most recently used first */
+    std::unordered_map<string, entry_iterator, std::hash<std::string>>  byPath;
+    std::unordered_map<std::uint64_t, entry_iterator>                   byHash;
+    std::unordered_map<const T*, entry_iterator>                        byResource;
+    resource_cache_stats    stats;
+}; /* class resource_cache */
+
+
+
+/* resource_cache::resource_cache */
+template <typename T>
+inline resource_cache<T>::resource_cache( load_fn load, size_t budget ) :
+    load{std::move( load )},
+    budget{budget}
+{
+    assert( this->load != nullptr );
+}
+
+/* resource_cache::get */
+template <typename T>
+inline typename resource_cache<T>::handle resource_cache<T>::get( const string &path )
+{
+    auto found = byPath.find( path );
+    if( found != byPath.end() ) {
+        stats.hits++;
+        touch( found->second );
+        return found->second->resource;
+    }
+
+    mapped_file file( filesystem::open_mapped( path ) );
+    if( !file.is_open() ) {
+        common::error() << "resource_cache::get() error: cannot open " << path << std::endl;
+        return nullptr;
+    }
+    std::uint64_t hash = hash64( file.data(), file.size() );
+    auto same = byHash.find( hash );
+    if( same != byHash.end() && is_same_contents( *same->second, file.data(), file.size() ) ) {
+        stats.deduplicated++;
+        same->second->paths.push_back( path );
+        byPath[path] = same->second;
+        touch( same->second );
+        return same->second->resource;
+    }
+
+    handle resource{ new T };
+    resource_size resSize;
+    size_t contentsSize = file.size();
+    if( !load( file, *resource, resSize ) ) {
+        common::error() << "resource_cache::get() error: cannot load " << path << std::endl;
+        return nullptr;
+    }
+    stats.misses++;
+    stats.entries++;
+    stats.cpuBytes += resSize.cpuBytes;
+    stats.gpuBytes += resSize.gpuBytes;
+    entries.push_front( entry{ resource, hash, contentsSize, resSize, core::vector<string>( 1, path ) } );
+    byPath[path] = entries.begin();
+    if( same == byHash.end() ) {
+        byHash[hash] = entries.begin();
+    }
+    byResource[resource.get()] = entries.begin();
+    evict();
+    return resource;
+}
+
+/* resource_cache::contains */
+template <typename T>
+inline bool resource_cache<T>::contains( const string &path ) const
+{
+    return byPath.find( path ) != byPath.end();
+}
+
+/* resource_cache::set_size */
+template <typename T>
+inline void resource_cache<T>::set_size( const handle &resource, const resource_size &resSize )
+{
+    auto found = byResource.find( resource.get() );
+    assert( found != byResource.end() );
+    entry &e = *found->second;
+    stats.cpuBytes += resSize.cpuBytes - e.resSize.cpuBytes;
+    stats.gpuBytes += resSize.gpuBytes - e.resSize.gpuBytes;
+    e.resSize = resSize;
+    evict();
+}
+
+/* resource_cache::set_budget */
+template <typename T>
+inline void resource_cache<T>::set_budget( size_t bytes )
+{
+    budget = bytes;
+    evict();
+}
+
+/* resource_cache::get_budget */
+template <typename T>
+inline size_t resource_cache<T>::get_budget() const
+{
+    return budget;
+}
+
+/* resource_cache::evict */
+template <typename T>
+inline int resource_cache<T>::evict()
+{
+    int evicted = 0;
+    auto it = entries.end();
+    while( get_total() > budget && it != entries.begin() ) {
+        --it;
+        if( it->resource.use_count() == 1 ) {
+            auto next = std::next( it );
+            remove( it );
+            it = next;
+            evicted++;
+        }
+    }
+    stats.evictions += evicted;
+    return evicted;
+}
+
+/* resource_cache::clear */
+template <typename T>
+inline void resource_cache<T>::clear()
+{
+    for( auto it = entries.begin(); it != entries.end(); ) {
+        auto next = std::next( it );
+        if( it->resource.use_count() == 1 ) {
+            remove( it );
+        }
+        it = next;
+    }
+}
+
+/* resource_cache::get_stats */
+template <typename T>
+inline const resource_cache_stats &resource_cache<T>::get_stats() const
+{
+    return stats;
+}
+
+/* resource_cache::is_same_contents
+* the first path of the entry is read again, the file may be changed
+* since it was loaded, then the contents are not shared */
+template <typename T>
+inline bool resource_cache<T>::is_same_contents( const entry &e, const byte *data, size_t size ) const
+{
+    if( e.contentsSize != size ) {
+        return false;
+    }
+    mapped_file file( filesystem::open_mapped( e.paths.front() ) );
+    return file.is_open() && file.size() == size && (size == 0 || std::memcmp( file.data(), data, size ) == 0);
+}
+
+/* resource_cache::touch */
+template <typename T>
+inline void resource_cache<T>::touch( entry_iterator it )
+{
+    entries.splice( entries.begin(), entries, it );
+}
+
+/* resource_cache::remove */
+template <typename T>
+inline void resource_cache<T>::remove( entry_iterator it )
+{
+    for( const auto &path : it->paths ) {
+        byPath.erase( path );
+    }
+    auto same = byHash.find( it->hash );
+    if( same != byHash.end() && same->second == it ) {
+        byHash.erase( same );
+    }
+    byResource.erase( it->resource.get() );
+    stats.entries--;
+    stats.cpuBytes -= it->resSize.cpuBytes;
+    stats.gpuBytes -= it->resSize.gpuBytes;
+    entries.erase( it );
+}
+
+/* resource_cache::get_total */
+template <typename T>
+inline size_t resource_cache<T>::get_total() const
+{
+    return stats.cpuBytes + stats.gpuBytes;
+}
+
+} /* namespace engine::core */
@@ -0,0 +1,9 @@
+#pragma once
+#include <core/config.hpp>
+
+/* compiler intrinsics for the enabled SIMD instruction sets */
+#if SIMD_AVX2_ENABLED
+#   include <immintrin.h>
+#elif SIMD_SSE4_1_ENABLED
+#   include <smmintrin.h>
+#endif /* SIMD_AVX2_ENABLED */
@@ -1,6 +1,9 @@
 #pragma once
 #include <fstream>
-#include <windows.h>
+#include <core/config.hpp>
+#if PLATFORM_WIN64_ENABLED
+#   include <windows.h>
+#endif /* PLATFORM_WIN64_ENABLED */
 
 namespace engine
 {
@@ -9,7 +12,11 @@ typedef unsigned char   byte;
 typedef unsigned short  word;
 typedef unsigned int    dword;
 
+#if PLATFORM_WIN64_ENABLED
 typedef HWND            whandle_t;
+#else
+typedef void *          whandle_t;      /* no windows, see headless_loop */
+#endif /* PLATFORM_WIN64_ENABLED */
 
 typedef ::std::ifstream     ifstream;
 typedef ::std::ofstream     ofstream;
@@ -39,6 +39,34 @@ void basic_mesh::add_vertices( const char *vert, int size, int num ) {
     verticesNum += num;
 }
 
+/* basic_mesh::get_position_offset */
+int basic_mesh::get_position_offset() {
+    for( int i = 0; i < presentVertex.numAttrib; i++ ) {
+        if( presentVertex.attributes[i].type == PRESENT_VERTEX_ATTRIB_XYZ ) {
+            return presentVertex.attributes[i].offset;
+        }
+    }
+    return -1;
+}
+
+/* basic_mesh::get_bounding_box */
+aabb basic_mesh::get_bounding_box() {
+    auto offset = get_position_offset();
+    if( offset < 0 || verticesNum == 0 ) {
+        return aabb();
+    }
+    return aabb::from_points( vertices.data() + offset, presentVertex.vertexSize, verticesNum );
+}
+
+/* basic_mesh::get_bounding_sphere */
+sphere basic_mesh::get_bounding_sphere() {
+    auto offset = get_position_offset();
+    if( offset < 0 || verticesNum == 0 ) {
+        return sphere();
+    }
+    return sphere::from_points( vertices.data() + offset, presentVertex.vertexSize, verticesNum );
+}
+
 /* basic_mesh::add_indices */
 void basic_mesh::add_indices( const char *ind, int size, int num ) {
     assert( presentIndex != PRESENT_INDEX_NO_INDEX );
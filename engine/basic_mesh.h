@@ -2,9 +2,12 @@
 #include <core/types.hpp>
 #include <core/vector.hpp>
 #include <core/assert.hpp>
+#include <core/math.hpp>
 #include "basic_mesh_present.h"
 namespace engine {
 
+using namespace engine::core::math;
+
 const int BASIC_MESH_EXTRA_SIZE = 256;
 
 /* basic_mesh container for mesh class */
@@ -24,7 +27,14 @@ public:
     unsigned int        get_restart_index();
     char                *get_extra_ptr();
 
+                        /* bounds of the XYZ attribute of the vertices,
+                        * empty if the mesh has no positions */
+    aabb                get_bounding_box();
+    sphere              get_bounding_sphere();
+
 protected:
+                        /* offset of the XYZ attribute or -1 */
+    int                 get_position_offset();
     void                add_vertex( const char *vert, int size );
     void                add_vertices( const char *vert, int size, int num );
     void                add_index( const char *ind, int size );
@@ -0,0 +1,36 @@
+#include "headless_loop.h"
+namespace engine {
+
+/* headless_loop::headless_loop */
+headless_loop::headless_loop( int framesNumber, float fixedStep ) :
+        framesNumber{framesNumber}, fixedStep{fixedStep} {
+    assert( framesNumber >= 0 );
+    assert( fixedStep >= 0.0f );
+}
+
+/* headless_loop::run */
+void headless_loop::run( const frame_function &fn ) {
+    stats = statistics();
+    isRunning = true;
+    core::timer frameTimer;
+    float dt = fixedStep;
+    for( int frame = 0; isRunning && (framesNumber == 0 || frame < framesNumber); frame++ ) {
+        frameTimer.start();
+        if( !fn( frame, dt ) ) {
+            isRunning = false;
+        }
+        auto msec = frameTimer.get_elapsed_msec();
+        if( stats.frames == 0 || msec < stats.minMsec ) {
+            stats.minMsec = msec;
+        }
+        if( stats.frames == 0 || msec > stats.maxMsec ) {
+            stats.maxMsec = msec;
+        }
+        stats.totalMsec += msec;
+        stats.frames++;
+        dt = fixedStep > 0.0f ? fixedStep : msec * 0.001f;
+    }
+    isRunning = false;
+}
+
+} /* namespace engine */
@@ -0,0 +1,60 @@
+#pragma once
+#include <functional>
+#include <core/timer.hpp>
+#include <core/assert.hpp>
+namespace engine {
+
+/* headless_loop
+* application loop without a window and input: the frame function
+* is called until it returns false or the number of frames is done.
+* With a fixed step the frames get the same delta time on every run,
+* so rendered images can be compared between runs */
+class headless_loop {
+public:
+                        /* frame index and delta time in seconds,
+                        * returns false to stop the loop */
+    typedef std::function<bool( int frame, float dt )>  frame_function;
+
+    struct statistics {
+        int             frames{0};
+        float           totalMsec{0.0f};
+        float           minMsec{0.0f};
+        float           maxMsec{0.0f};
+    };
+
+public:
+                        /* framesNumber = 0 - until the function returns false,
+                        * fixedStep = 0 - measured time of the previous frame */
+                        headless_loop( int framesNumber = 0, float fixedStep = 0.0f );
+
+    void                run( const frame_function &fn );
+    void                stop();
+
+    const statistics &  get_statistics() const;
+    float               get_average_msec() const;
+
+private:
+    int                 framesNumber;
+    float               fixedStep;
+    bool                isRunning{false};
+    statistics          stats;
+};
+
+
+
+/* headless_loop::stop */
+inline void headless_loop::stop() {
+    isRunning = false;
+}
+
+/* headless_loop::get_statistics */
+inline const headless_loop::statistics &headless_loop::get_statistics() const {
+    return stats;
+}
+
+/* headless_loop::get_average_msec */
+inline float headless_loop::get_average_msec() const {
+    return stats.frames > 0 ? stats.totalMsec / stats.frames : 0.0f;
+}
+
+} /* namespace engine */
@@ -0,0 +1,433 @@
+#include "loose_octree.h"
+#include <cmath>
+namespace engine {
+
+/* loose_octree::loose_octree */
+loose_octree::loose_octree( const vec3 &center, float halfSize, int maxDepth ) : maxDepth{maxDepth} {
+    assert( halfSize > 0.0f );
+    assert( maxDepth >= 0 );
+    allocate_node( center, halfSize, 0, -1 );
+}
+
+/* loose_octree::clear */
+void loose_octree::clear() {
+    auto center = nodes[0].center;
+    auto halfSize = nodes[0].halfSize;
+    nodes.clear();
+    objects.clear();
+    freeNodes = -1;
+    freeObjects = -1;
+    objectsNumber = 0;
+    nodesNumber = 0;
+    allocate_node( center, halfSize, 0, -1 );
+}
+
+/* loose_octree::insert */
+loose_octree::handle loose_octree::insert( const sphere &bounds ) {
+    assert( bounds.radius >= 0.0f );
+    handle h;
+    if( freeObjects >= 0 ) {
+        h = freeObjects;
+        freeObjects = objects[h].slot;
+    } else {
+        h = static_cast<handle>( objects.size() );
+        objects.emplace_back();
+    }
+    objects[h].bounds = bounds;
+    link( h, find_node( bounds ) );
+    objectsNumber++;
+    return h;
+}
+
+/* loose_octree::remove */
+void loose_octree::remove( handle h ) {
+    assert( h >= 0 && h < static_cast<int>( objects.size() ) && objects[h].node >= 0 );
+    unlink( h );
+    objects[h].slot = freeObjects;
+    freeObjects = h;
+    objectsNumber--;
+}
+
+/* loose_octree::move */
+void loose_octree::move( handle h, const sphere &bounds ) {
+    assert( h >= 0 && h < static_cast<int>( objects.size() ) && objects[h].node >= 0 );
+    objects[h].bounds = bounds;
+    if( stays_in_node( objects[h].node, bounds ) ) {
+        /* refit only */
+        return;
+    }
+    unlink( h );
+    link( h, find_node( bounds ) );
+}
+
+/* loose_octree::allocate_node */
+int loose_octree::allocate_node( const vec3 &center, float halfSize, int depth, int parent ) {
+    int n;
+    if( freeNodes >= 0 ) {
+        n = freeNodes;
+        freeNodes = nodes[n].parent;
+    } else {
+        n = static_cast<int>( nodes.size() );
+        nodes.emplace_back();
+    }
+    auto &nd = nodes[n];
+    nd.center = center;
+    nd.halfSize = halfSize;
+    nd.depth = depth;
+    nd.parent = parent;
+    for( auto &child : nd.children ) {
+        child = -1;
+    }
+    nd.childrenNumber = 0;
+    nd.objects.clear();
+    nodesNumber++;
+    return n;
+}
+
+/* loose_octree::release_node
+* removes empty leaf nodes up to the root */
+void loose_octree::release_node( int n ) {
+    while( n > 0 && nodes[n].objects.empty() && nodes[n].childrenNumber == 0 ) {
+        int parent = nodes[n].parent;
+        auto &p = nodes[parent];
+        for( auto &child : p.children ) {
+            if( child == n ) {
+                child = -1;
+                break;
+            }
+        }
+        p.childrenNumber--;
+        nodes[n].parent = freeNodes;
+        freeNodes = n;
+        nodesNumber--;
+        n = parent;
+    }
+}
+
+/* loose_octree::get_octant
+* child of the node for the object, -1 if it stays in the node */
+int loose_octree::get_octant( int n, const sphere &bounds ) const {
+    const auto &nd = nodes[n];
+    if( nd.depth >= maxDepth || bounds.radius > nd.halfSize * 0.5f ) {
+        return -1;
+    }
+    const auto &c = bounds.center;
+    if( n == 0 ) {
+        /* objects outside the root cell live in the root */
+        auto d = c - nd.center;
+        if( std::fabs( d.x ) > nd.halfSize || std::fabs( d.y ) > nd.halfSize || std::fabs( d.z ) > nd.halfSize ) {
+            return -1;
+        }
+    }
+    return (c.x >= nd.center.x ? 1 : 0) | (c.y >= nd.center.y ? 2 : 0) | (c.z >= nd.center.z ? 4 : 0);
+}
+
+/* loose_octree::get_child
+* creates the child if it does not exist */
+int loose_octree::get_child( int n, int octant ) {
+    int child = nodes[n].children[octant];
+    if( child < 0 ) {
+        auto childHalf = nodes[n].halfSize * 0.5f;
+        auto childCenter = get_child_center( n, octant );
+        /* nodes may be reallocated here */
+        child = allocate_node( childCenter, childHalf, nodes[n].depth + 1, n );
+        nodes[n].children[octant] = child;
+        nodes[n].childrenNumber++;
+    }
+    return child;
+}
+
+/* loose_octree::get_child_center */
+vec3 loose_octree::get_child_center( int n, int octant ) const {
+    auto childHalf = nodes[n].halfSize * 0.5f;
+    const auto &center = nodes[n].center;
+    return vec3(
+        center.x + ((octant & 1) ? childHalf : -childHalf),
+        center.y + ((octant & 2) ? childHalf : -childHalf),
+        center.z + ((octant & 4) ? childHalf : -childHalf) );
+}
+
+/* loose_octree::find_node
+* goes down while the child cell holding the center is large enough,
+* leaf nodes are not split here, see link() */
+int loose_octree::find_node( const sphere &bounds ) {
+    int n = 0;
+    for( ;; ) {
+        int octant = get_octant( n, bounds );
+        if( octant < 0 || nodes[n].childrenNumber == 0 ) {
+            return n;
+        }
+        n = get_child( n, octant );
+    }
+}
+
+/* loose_octree::split
+* moves objects of the leaf node which fit in children down. An object
+* moved inside the loose bounds of the node may have its center out of
+* the node cell, the child of its octant may not hold it, so the object
+* goes down only if the loose bounds of the child contain its sphere */
+void loose_octree::split( int n ) {
+    assert( nodes[n].childrenNumber == 0 );
+    auto list = nodes[n].objects;
+    for( auto h : list ) {
+        const auto &bounds = objects[h].bounds;
+        int octant = get_octant( n, bounds );
+        if( octant < 0 ) {
+            continue;
+        }
+        auto d = bounds.center - get_child_center( n, octant );
+        auto limit = nodes[n].halfSize - bounds.radius;
+        if( std::fabs( d.x ) <= limit && std::fabs( d.y ) <= limit && std::fabs( d.z ) <= limit ) {
+            unlink_object( h );
+            link( h, get_child( n, octant ) );
+        }
+    }
+}
+
+/* loose_octree::stays_in_node */
+bool loose_octree::stays_in_node( int n, const sphere &bounds ) const {
+    const auto &nd = nodes[n];
+    auto d = bounds.center - nd.center;
+    if( n == 0 ) {
+        /* the root keeps objects which cannot go deeper or while it is a leaf */
+        bool outside = std::fabs( d.x ) > nd.halfSize || std::fabs( d.y ) > nd.halfSize || std::fabs( d.z ) > nd.halfSize;
+        return outside || nd.childrenNumber == 0 || maxDepth == 0 || bounds.radius > nd.halfSize * 0.5f;
+    }
+    /* the sphere must be inside the loose bounds */
+    auto limit = nd.halfSize * 2.0f - bounds.radius;
+    return std::fabs( d.x ) <= limit && std::fabs( d.y ) <= limit && std::fabs( d.z ) <= limit;
+}
+
+/* loose_octree::link */
+void loose_octree::link( handle h, int n ) {
+    auto &obj = objects[h];
+    auto &nd = nodes[n];
+    obj.node = n;
+    obj.slot = static_cast<int>( nd.objects.size() );
+    nd.objects.push_back( h );
+    if( nd.childrenNumber == 0 && nd.depth < maxDepth &&
+            static_cast<int>( nd.objects.size() ) > LEAF_OBJECTS ) {
+        split( n );
+    }
+}
+
+/* loose_octree::unlink */
+void loose_octree::unlink( handle h ) {
+    int n = objects[h].node;
+    unlink_object( h );
+    release_node( n );
+}
+
+/* loose_octree::unlink_object
+* removes the object from its node, the node is kept */
+void loose_octree::unlink_object( handle h ) {
+    auto &obj = objects[h];
+    auto &nd = nodes[obj.node];
+    /* swap with the last object of the node */
+    auto last = nd.objects.back();
+    nd.objects[obj.slot] = last;
+    objects[last].slot = obj.slot;
+    nd.objects.pop_back();
+    obj.node = -1;
+}
+
+/* loose_octree::collect
+* all objects of the subtree */
+void loose_octree::collect( int n, core::vector<handle> &out ) const {
+    core::vector<int> stack;
+    stack.push_back( n );
+    while( !stack.empty() ) {
+        const auto &nd = nodes[stack.back()];
+        stack.pop_back();
+        out.insert( out.end(), nd.objects.begin(), nd.objects.end() );
+        for( auto child : nd.children ) {
+            if( child >= 0 ) {
+                stack.push_back( child );
+            }
+        }
+    }
+}
+
+/* loose_octree::query_frustum */
+void loose_octree::query_frustum( const frustum &view, core::vector<handle> &out ) const {
+    core::vector<int> stack;
+    stack.push_back( 0 );
+    while( !stack.empty() ) {
+        int n = stack.back();
+        stack.pop_back();
+        const auto &nd = nodes[n];
+        if( n != 0 ) {
+            auto result = view.classify_aabb( get_loose_bounds( n ) );
+            if( result == frustum::TEST_OUTSIDE ) {
+                continue;
+            }
+            if( result == frustum::TEST_INSIDE ) {
+                collect( n, out );
+                continue;
+            }
+        }
+        for( auto h : nd.objects ) {
+            if( view.test_sphere( objects[h].bounds ) ) {
+                out.push_back( h );
+            }
+        }
+        for( auto child : nd.children ) {
+            if( child >= 0 ) {
+                stack.push_back( child );
+            }
+        }
+    }
+}
+
+/* loose_octree::query_sphere */
+void loose_octree::query_sphere( const sphere &s, core::vector<handle> &out ) const {
+    core::vector<int> stack;
+    stack.push_back( 0 );
+    while( !stack.empty() ) {
+        int n = stack.back();
+        stack.pop_back();
+        const auto &nd = nodes[n];
+        if( n != 0 ) {
+            /* distance from the sphere center to the box */
+            auto box = get_loose_bounds( n );
+            float dist2 = 0.0f;
+            for( int i = 0; i < 3; i++ ) {
+                auto v = s.center[i];
+                if( v < box.min[i] ) {
+                    dist2 += squr( box.min[i] - v );
+                } else if( v > box.max[i] ) {
+                    dist2 += squr( v - box.max[i] );
+                }
+            }
+            if( dist2 > s.radius * s.radius ) {
+                continue;
+            }
+        }
+        for( auto h : nd.objects ) {
+            const auto &b = objects[h].bounds;
+            auto d = b.center - s.center;
+            auto r = b.radius + s.radius;
+            if( d * d <= r * r ) {
+                out.push_back( h );
+            }
+        }
+        for( auto child : nd.children ) {
+            if( child >= 0 ) {
+                stack.push_back( child );
+            }
+        }
+    }
+}
+
+/* loose_octree::intersect_ray_box
+* slab test, enter is the distance where the ray enters the box */
+bool loose_octree::intersect_ray_box( const vec3 &origin, const vec3 &invDir, const aabb &box, float maxDistance, float &enter ) {
+    float tmin = 0.0f;
+    float tmax = maxDistance;
+    for( int i = 0; i < 3; i++ ) {
+        auto t1 = (box.min[i] - origin[i]) * invDir[i];
+        auto t2 = (box.max[i] - origin[i]) * invDir[i];
+        if( t1 > t2 ) {
+            auto t = t1;
+            t1 = t2;
+            t2 = t;
+        }
+        /* NaN of 0 * inf fails both comparisons and keeps the interval */
+        tmin = t1 > tmin ? t1 : tmin;
+        tmax = t2 < tmax ? t2 : tmax;
+        if( tmin > tmax ) {
+            return false;
+        }
+    }
+    enter = tmin;
+    return true;
+}
+
+/* loose_octree::intersect_ray_sphere */
+bool loose_octree::intersect_ray_sphere( const vec3 &origin, const vec3 &dir, const sphere &s, float maxDistance, float &distance ) {
+    auto m = origin - s.center;
+    auto b = m * dir;
+    auto c = m * m - s.radius * s.radius;
+    if( c > 0.0f && b > 0.0f ) {
+        /* outside and pointing away */
+        return false;
+    }
+    auto discr = b * b - c;
+    if( discr < 0.0f ) {
+        return false;
+    }
+    auto t = -b - sqrt( discr );
+    t = t < 0.0f ? 0.0f : t;
+    if( t > maxDistance ) {
+        return false;
+    }
+    distance = t;
+    return true;
+}
+
+/* loose_octree::query_ray */
+void loose_octree::query_ray( const vec3 &origin, const vec3 &dir, float maxDistance, core::vector<handle> &out ) const {
+    vec3 invDir( 1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z );
+    core::vector<int> stack;
+    stack.push_back( 0 );
+    while( !stack.empty() ) {
+        int n = stack.back();
+        stack.pop_back();
+        const auto &nd = nodes[n];
+        float enter;
+        if( n != 0 && !intersect_ray_box( origin, invDir, get_loose_bounds( n ), maxDistance, enter ) ) {
+            continue;
+        }
+        for( auto h : nd.objects ) {
+            float distance;
+            if( intersect_ray_sphere( origin, dir, objects[h].bounds, maxDistance, distance ) ) {
+                out.push_back( h );
+            }
+        }
+        for( auto child : nd.children ) {
+            if( child >= 0 ) {
+                stack.push_back( child );
+            }
+        }
+    }
+}
+
+/* loose_octree::raycast
+* nodes farther than the nearest hit found so far are skipped */
+bool loose_octree::raycast( const vec3 &origin, const vec3 &dir, float maxDistance, handle &hit, float &distance ) const {
+    vec3 invDir( 1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z );
+    float nearest = maxDistance;
+    bool found = false;
+    core::vector<int> stack;
+    stack.push_back( 0 );
+    while( !stack.empty() ) {
+        int n = stack.back();
+        stack.pop_back();
+        const auto &nd = nodes[n];
+        float enter;
+        if( n != 0 && !intersect_ray_box( origin, invDir, get_loose_bounds( n ), nearest, enter ) ) {
+            continue;
+        }
+        for( auto h : nd.objects ) {
+            float t;
+            if( intersect_ray_sphere( origin, dir, objects[h].bounds, nearest, t ) ) {
+                if( !found || t < nearest ) {
+                    nearest = t;
+                    hit = h;
+                    found = true;
+                }
+            }
+        }
+        for( auto child : nd.children ) {
+            if( child >= 0 ) {
+                stack.push_back( child );
+            }
+        }
+    }
+    if( found ) {
+        distance = nearest;
+    }
+    return found;
+}
+
+} /* namespace engine */
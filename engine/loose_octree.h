@@ -0,0 +1,111 @@
+#pragma once
+#include <core/math.hpp>
+#include <core/vector.hpp>
+#include <core/assert.hpp>
+namespace engine {
+
+using namespace engine::core::math;
+
+/* loose_octree
+* spatial index of bounding spheres. Every node is twice as large as
+* its cell, so an object is stored in the deepest node whose cell holds
+* its center and whose half size is not smaller than its radius.
+* Objects moved inside the loose bounds of their node stay in place,
+* so small movements cost only the bounds update.
+* A leaf node is split when it holds more than LEAF_OBJECTS objects */
+class loose_octree {
+public:
+    typedef int     handle;
+
+    static const int    LEAF_OBJECTS = 16;
+
+public:
+                    /* cube of the world cells, objects outside are kept in the root */
+                    loose_octree( const vec3 &center, float halfSize, int maxDepth = 8 );
+
+    handle          insert( const sphere &bounds );
+    void            remove( handle h );
+    void            move( handle h, const sphere &bounds );
+    void            clear();
+
+    const sphere &  get_bounds( handle h ) const;
+    int             size() const;
+    int             get_nodes_number() const;
+
+                    /* handles of the objects are appended to out */
+    void            query_frustum( const frustum &view, core::vector<handle> &out ) const;
+    void            query_sphere( const sphere &s, core::vector<handle> &out ) const;
+                    /* dir must be normalized, objects hit in [0..maxDistance] */
+    void            query_ray( const vec3 &origin, const vec3 &dir, float maxDistance, core::vector<handle> &out ) const;
+                    /* nearest object hit by the ray, returns false if none */
+    bool            raycast( const vec3 &origin, const vec3 &dir, float maxDistance, handle &hit, float &distance ) const;
+
+private:
+    struct node {
+        vec3        center;
+        float       halfSize;       /* half size of the cell, loose bounds are twice larger */
+        int         depth;
+        int         parent;
+        int         children[8];
+        int         childrenNumber;
+        core::vector<handle>    objects;
+    };
+    struct object {
+        sphere      bounds;
+        int         node{-1};       /* -1 for free slots */
+        int         slot{0};        /* index in node::objects or the next free object */
+    };
+
+    int             allocate_node( const vec3 &center, float halfSize, int depth, int parent );
+    void            release_node( int n );
+    int             find_node( const sphere &bounds );
+    int             get_child( int n, int octant );
+    vec3            get_child_center( int n, int octant ) const;
+    int             get_octant( int n, const sphere &bounds ) const;
+    void            split( int n );
+    bool            stays_in_node( int n, const sphere &bounds ) const;
+    void            link( handle h, int n );
+    void            unlink( handle h );
+    void            unlink_object( handle h );
+    aabb            get_loose_bounds( int n ) const;
+    void            collect( int n, core::vector<handle> &out ) const;
+    static bool     intersect_ray_box( const vec3 &origin, const vec3 &invDir, const aabb &box, float maxDistance, float &enter );
+    static bool     intersect_ray_sphere( const vec3 &origin, const vec3 &dir, const sphere &s, float maxDistance, float &distance );
+
+private:
+    core::vector<node>      nodes;
+    core::vector<object>    objects;
+    int                     freeNodes{-1};      /* list linked through node::parent */
+    int                     freeObjects{-1};    /* list linked through object::slot */
+    int                     objectsNumber{0};
+    int                     nodesNumber{0};
+    int                     maxDepth;
+};
+
+
+
+/* loose_octree::get_bounds */
+inline const sphere &loose_octree::get_bounds( handle h ) const {
+    assert( h >= 0 && h < static_cast<int>( objects.size() ) && objects[h].node >= 0 );
+    return objects[h].bounds;
+}
+
+/* loose_octree::size */
+inline int loose_octree::size() const {
+    return objectsNumber;
+}
+
+/* loose_octree::get_nodes_number */
+inline int loose_octree::get_nodes_number() const {
+    return nodesNumber;
+}
+
+/* loose_octree::get_loose_bounds */
+inline aabb loose_octree::get_loose_bounds( int n ) const {
+    const auto &nd = nodes[n];
+    auto size = nd.halfSize * 2.0f;
+    vec3 extents( size, size, size );
+    return aabb( nd.center - extents, nd.center + extents );
+}
+
+} /* namespace engine */
@@ -0,0 +1,202 @@
+#include "mesh_renderer.h"
+#include <core/assert.hpp>
+namespace engine {
+
+/* mesh_renderer::bind_mesh */
+void mesh_renderer::bind_mesh( basic_mesh &m ) {
+    mesh_binding *b = reinterpret_cast<mesh_binding*>(m.get_extra_ptr());
+    if( !(b->isInit) ) {
+        assert( b->vbo == 0 );
+        assert( b->ibo == 0 );
+        assert( b->vao == 0 );
+        const auto &vertPresent( m.get_present_vertex() );
+        const auto &indPresent( m.get_present_index() );
+        /* gen buffers and fill buffer data */
+        b->vao = backend.create_vertex_array();
+        backend.bind_vertex_array( b->vao );
+        /* bind vertex buffer object */
+        b->vbo = backend.create_buffer();
+        backend.bind_buffer( GL_ARRAY_BUFFER, b->vbo );
+        backend.buffer_data( GL_ARRAY_BUFFER, 
+                vertPresent.vertexSize * m.get_vertices_number(), 
+                m.get_vertex_ptr(0), GL_STATIC_DRAW );
+        /* present vertex attributes */
+        for( int i = 0; i < vertPresent.numAttrib; i++ ) {
+            auto offset = vertPresent.attributes[i].offset;
+            switch( vertPresent.attributes[i].type ) {
+                case PRESENT_VERTEX_ATTRIB_XYZ:
+                    backend.vertex_attrib_pointer( i, 3, GL_FLOAT, vertPresent.vertexSize, offset );
+                    break;
+                case PRESENT_VERTEX_ATTRIB_UV:
+                    backend.vertex_attrib_pointer( i, 2, GL_FLOAT, vertPresent.vertexSize, offset );
+                    break;
+                case PRESENT_VERTEX_ATTRIB_MAX_NUMBER:
+                    assert(0);
+                    break;
+            }
+        }
+        /* present index attributes */
+        if( indPresent != PRESENT_INDEX_NO_INDEX ) {
+            int indexBytes = 0;
+            /* set gl index type */
+            switch( indPresent ) {
+                case PRESENT_INDEX_32BITS:
+                    b->indexType = GL_UNSIGNED_INT;
+                    b->restartIndex = 0xffffffff;
+                    indexBytes = 4;
+                    break;
+                case PRESENT_INDEX_16BITS:
+                    b->indexType = GL_UNSIGNED_SHORT;
+                    b->restartIndex = 0xffff;
+                    indexBytes = 2;
+                    break;
+                case PRESENT_INDEX_8BITS:
+                    b->indexType = GL_UNSIGNED_BYTE;
+                    b->restartIndex = 0xff;
+                    indexBytes = 1;
+                    break;
+                default:
+                    assert(0);
+            }
+            /* bind index buffer object */
+            b->ibo = backend.create_buffer();
+            backend.bind_buffer( GL_ELEMENT_ARRAY_BUFFER, b->ibo );
+            backend.buffer_data( GL_ELEMENT_ARRAY_BUFFER, 
+                    indexBytes * m.get_indices_number(), 
+                    m.get_index_ptr(0), GL_STATIC_DRAW );
+        } else {
+            b->indexType = 0;
+            b->restartIndex = 0;
+        }
+        backend.bind_vertex_array( 0 );
+        b->isInit = true;
+    }
+    assert( b->vao != 0 );
+    backend.bind_vertex_array( b->vao );
+}
+
+/* mesh_renderer::draw_mesh */
+void mesh_renderer::draw_mesh( basic_mesh &m ) {
+    bind_mesh( m );
+    mesh_binding *b = reinterpret_cast<mesh_binding*>(m.get_extra_ptr());
+    submit_draws( m, *b, 0 );
+}
+
+/* mesh_renderer::draw_bound_mesh */
+void mesh_renderer::draw_bound_mesh( basic_mesh &m ) {
+    mesh_binding *b = reinterpret_cast<mesh_binding*>(m.get_extra_ptr());
+    assert( b->isInit );
+    submit_draws( m, *b, 0 );
+}
+
+/* mesh_renderer::get_vertex_array */
+GLuint mesh_renderer::get_vertex_array( basic_mesh &m ) {
+    mesh_binding *b = reinterpret_cast<mesh_binding*>(m.get_extra_ptr());
+    if( !b->isInit ) {
+        bind_mesh( m );
+    }
+    return b->vao;
+}
+
+/* mesh_renderer::draw_mesh_instanced */
+void mesh_renderer::draw_mesh_instanced( basic_mesh &m, const mat4 *transforms, int count ) {
+    assert( count >= 0 );
+    assert( transforms != nullptr || count == 0 );
+    if( count == 0 ) {
+        return;
+    }
+    bind_mesh( m );
+    mesh_binding *b = reinterpret_cast<mesh_binding*>(m.get_extra_ptr());
+    bind_instances( *b, transforms, count );
+    submit_draws( m, *b, count );
+}
+
+/* mesh_renderer::bind_instances
+* the vertex array of the mesh must be bound */
+void mesh_renderer::bind_instances( mesh_binding &b, const mat4 *transforms, int count ) {
+    const GLsizei matrixSize = sizeof(mat4);
+    if( b.instanceVbo == 0 ) {
+        /* the instance buffer layout is stored in the vertex array:
+        * four vec4 attributes, one row of the matrix each */
+        b.instanceVbo = backend.create_buffer();
+        backend.bind_buffer( GL_ARRAY_BUFFER, b.instanceVbo );
+        for( int row = 0; row < 4; row++ ) {
+            const GLuint index = INSTANCE_ATTRIB_LOCATION + row;
+            backend.vertex_attrib_pointer( index, 4, GL_FLOAT, matrixSize, row * sizeof(vec4) );
+            backend.vertex_attrib_divisor( index, 1 );
+            backend.enable_vertex_attrib( index );
+        }
+    } else {
+        backend.bind_buffer( GL_ARRAY_BUFFER, b.instanceVbo );
+    }
+    if( count > b.instanceCapacity ) {
+        b.instanceCapacity = count > 2 * b.instanceCapacity ? count : 2 * b.instanceCapacity;
+    }
+    /* orphan the old storage so the driver does not wait for the previous frame */
+    backend.buffer_data( GL_ARRAY_BUFFER, b.instanceCapacity * matrixSize, nullptr, GL_STREAM_DRAW );
+    backend.buffer_sub_data( GL_ARRAY_BUFFER, 0, count * matrixSize, transforms );
+}
+
+/* mesh_renderer::submit_draws
+* instances = 0 - not instanced draw calls */
+void mesh_renderer::submit_draws( basic_mesh &m, mesh_binding &b, int instances ) {
+    const auto &vertPresent( m.get_present_vertex() );
+    for( int i = 0; i < vertPresent.numAttrib; i++ ) {
+        backend.enable_vertex_attrib(i);
+    }
+    /* draw calls */
+    const auto &drawing = m.get_present_drawing();
+    if( b.indexType != 0 ) {
+        backend.primitive_restart_index( b.restartIndex );
+        for( int i = 0; i < drawing.numDraws; i++ ) {
+            auto mode = primitive_type_to_gl_type( drawing.drawing[i].type );
+            if( instances ) {
+                backend.draw_elements_instanced( mode, drawing.drawing[i].count, b.indexType, 
+                        drawing.drawing[i].offset, instances );
+            } else {
+                backend.draw_elements( mode, drawing.drawing[i].count, b.indexType, 
+                        drawing.drawing[i].offset );
+            }
+        }
+    } else {
+        for( int i = 0; i < drawing.numDraws; i++ ) {
+            auto mode = primitive_type_to_gl_type( drawing.drawing[i].type );
+            if( instances ) {
+                backend.draw_arrays_instanced( mode, drawing.drawing[i].offset, drawing.drawing[i].count, instances );
+            } else {
+                backend.draw_arrays( mode, drawing.drawing[i].offset, drawing.drawing[i].count );
+            }
+        }
+    }
+}
+
+/* mesh_renderer::primitive_type_to_gl_type */
+GLenum mesh_renderer::primitive_type_to_gl_type( primitive_type type ) {
+    switch( type ) {
+        case PRIMITIVE_TYPE_POINTS:
+            return GL_POINTS;
+        case PRIMITIVE_TYPE_LINES:
+            return GL_LINES;
+        case PRIMITIVE_TYPE_LINES_ADJACENCY:
+            return GL_LINES_ADJACENCY;
+        case PRIMITIVE_TYPE_LINE_STRIP:
+            return GL_LINE_STRIP;
+        case PRIMITIVE_TYPE_LINE_STRIP_ADJACENCY:
+            return GL_LINE_STRIP_ADJACENCY;
+        case PRIMITIVE_TYPE_LINE_LOOP:
+            return GL_LINE_LOOP;
+        case PRIMITIVE_TYPE_TRIANGLES:
+            return GL_TRIANGLES;
+        case PRIMITIVE_TYPE_TRIANGLES_ADJACENCY:
+            return GL_TRIANGLES_ADJACENCY;
+        case PRIMITIVE_TYPE_TRIANGLE_STRIP:
+            return GL_TRIANGLE_STRIP;
+        case PRIMITIVE_TYPE_TRIANGLE_FAN:
+            return GL_TRIANGLE_FAN;
+        default:
+            assert(0);
+    }
+    return 0;
+}
+
+} /* namespace engine */
@@ -0,0 +1,52 @@
+#pragma once
+#include <core/math.hpp>
+#include <renderer/render_backend.h>
+#include "basic_mesh.h"
+namespace engine {
+
+using namespace engine::core::math;
+
+/* API objects of the mesh, lives in basic_mesh::get_extra_ptr() */
+struct mesh_binding {
+    bool        isInit{false};
+    GLuint      vbo{0};     /* GL vertex buffer object */
+    GLuint      ibo{0};     /* GL index buffer object */
+    GLuint      vao{0};     /* GL vertex array object */
+    GLenum      indexType{0};
+    GLuint      restartIndex{0};
+    GLuint      instanceVbo{0};         /* per-instance matrices */
+    int         instanceCapacity{0};    /* matrices in instanceVbo */
+};
+static_assert( sizeof(mesh_binding) <= BASIC_MESH_EXTRA_SIZE, "mesh_binding does not fit in basic_mesh extra" );
+
+/* mesh_renderer
+* creates API objects of meshes and submits draw calls through the backend */
+class mesh_renderer {
+public:
+                        /* first of the four attribute locations of the instance
+                        * matrix rows, see resources/shader_instanced.vsh */
+    static const int    INSTANCE_ATTRIB_LOCATION = 4;
+
+public:
+                        mesh_renderer( render_backend &backend ) : backend{backend} {}
+
+    void                bind_mesh( basic_mesh &m );
+    void                draw_mesh( basic_mesh &m );
+                        /* draw count copies of the mesh, the row-major matrices
+                        * are streamed to the per-instance attribute buffer */
+    void                draw_mesh_instanced( basic_mesh &m, const mat4 *transforms, int count );
+                        /* draw the mesh bound by the last bind_mesh() */
+    void                draw_bound_mesh( basic_mesh &m );
+                        /* returns vertex array object of the mesh, creates it if needed */
+    GLuint              get_vertex_array( basic_mesh &m );
+
+    static GLenum       primitive_type_to_gl_type( primitive_type type );
+private:
+    void                bind_instances( mesh_binding &b, const mat4 *transforms, int count );
+    void                submit_draws( basic_mesh &m, mesh_binding &b, int instances );
+
+private:
+    render_backend      &backend;
+};
+
+} /* namespace engine */
@@ -22,6 +22,9 @@ public:
     const vec3      &get_scale();
 
     const mat4      &operator()();
+                    /* mesh bounds moved to the object location */
+    aabb            transform_bounds( const aabb &box );
+    sphere          transform_bounds( const sphere &s );
 protected:
     mat4            out{MAT4_ZERO};     /* out matrix */
     quat            rot{QUAT_ZERO};     /* object rotation */
@@ -83,4 +86,14 @@ inline const vec3 &object3d_location::get_scale() {
     return scl;
 }
 
+/* object3d_location::transform_bounds */
+inline aabb object3d_location::transform_bounds( const aabb &box ) {
+    return box.transform( (*this)() );
+}
+
+/* object3d_location::transform_bounds */
+inline sphere object3d_location::transform_bounds( const sphere &s ) {
+    return s.transform( (*this)() );
+}
+
 } /* namespace engine */
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "render_queue.h"
+#include <core/assert.hpp>
+namespace engine {
+
+/* render_queue::add */
+void render_queue::add( shader::idprog prog, GLuint texture, basic_mesh &m, 
+        const uniform &world, const mat4 &transform, float depth ) {
+    auto vao = meshes.get_vertex_array( m );
+    keys.push_back( {make_key( prog, texture, vao, depth ), static_cast<int>( items.size() )} );
+    items.push_back( {transform, &m, prog, texture, vao, world.get_location()} );
+}
+
+/* render_queue::clear */
+void render_queue::clear() {
+    items.clear();
+    keys.clear();
+}
+
+/* render_queue::make_key */
+render_queue::sort_key render_queue::make_key( shader::idprog prog, GLuint texture, GLuint vao, float depth ) {
+    /* shader programs are numbered from 65536, 0 - no program */
+    sort_key program = prog ? static_cast<sort_key>( prog - 65535 ) : 0;
+    assert( program < (1 << 12) );
+    assert( texture < (1 << 16) );
+    assert( vao < (1 << 20) );
+    depth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+    auto bucket = static_cast<sort_key>( depth * 65535.0f );
+    return (program << 52) | (static_cast<sort_key>(texture) << 36) | 
+            (static_cast<sort_key>(vao) << 16) | bucket;
+}
+
+/* render_queue::get_depth */
+float render_queue::get_depth( const mat4 &worldViewProj ) {
+    /* clip coordinates of the origin are the last column */
+    float w = worldViewProj.w.w;
+    if( w <= 0.0f ) {
+        return 1.0f;
+    }
+    return worldViewProj.z.w / w * 0.5f + 0.5f;
+}
+
+/* render_queue::sort
+* LSD radix sort by bytes, it is stable so equal keys keep
+* the order of add(). Bytes equal in all keys are skipped */
+void render_queue::sort() {
+    const int n = static_cast<int>( keys.size() );
+    sorted.resize( n );
+    for( int shift = 0; shift < 64; shift += 8 ) {
+        int counts[256] = {0};
+        for( const auto &k : keys ) {
+            counts[(k.key >> shift) & 0xff]++;
+        }
+        if( counts[(keys[0].key >> shift) & 0xff] == n ) {
+            continue;
+        }
+        int offset = 0;
+        for( auto &c : counts ) {
+            int count = c;
+            c = offset;
+            offset += count;
+        }
+        for( const auto &k : keys ) {
+            sorted[counts[(k.key >> shift) & 0xff]++] = k;
+        }
+        keys.swap( sorted );
+    }
+}
+
+/* render_queue::submit */
+void render_queue::submit() {
+    stats = statistics();
+    stats.items = size();
+    if( items.empty() ) {
+        return;
+    }
+    sort();
+    /* the state before the queue is unknown, the first item binds everything */
+    bool first = true;
+    shader::idprog prog = 0;
+    GLuint texture = 0;
+    GLuint vao = 0;
+    for( const auto &k : keys ) {
+        const auto &it = items[k.index];
+        if( first || it.prog != prog ) {
+            backend.use_program( shader::get_program_object( it.prog ) );
+            prog = it.prog;
+            stats.programBinds++;
+        } else {
+            stats.programBindsAvoided++;
+        }
+        if( first || it.texture != texture ) {
+            backend.bind_texture( GL_TEXTURE_2D, it.texture );
+            texture = it.texture;
+            stats.textureBinds++;
+        } else {
+            stats.textureBindsAvoided++;
+        }
+        if( first || it.vao != vao ) {
+            backend.bind_vertex_array( it.vao );
+            vao = it.vao;
+            stats.meshBinds++;
+        } else {
+            stats.meshBindsAvoided++;
+        }
+        first = false;
+        if( it.world != -1 ) {
+            backend.uniform_matrix( it.world, it.transform.get_ptr() );
+        }
+        meshes.draw_bound_mesh( *it.mesh );
+    }
+    clear();
+}
+
+} /* namespace engine */
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <core/math.hpp>
+#include <core/vector.hpp>
+#include <renderer/shader.h>
+#include <renderer/uniform.h>
+#include <renderer/render_backend.h>
+#include "mesh_renderer.h"
+namespace engine {
+
+using namespace engine::core::math;
+
+/* render_queue
+* draw items recorded during the frame are sorted by a 64-bit key
+* and submitted in one pass without repeating bound state:
+*   bits 63..52 shader program (12 bits)
+*   bits 51..36 texture object (16 bits)
+*   bits 35..16 mesh vertex array object (20 bits)
+*   bits 15..0  depth bucket, front to back (16 bits)
+*/
+class render_queue {
+public:
+    typedef std::uint64_t   sort_key;
+
+    struct statistics {
+        int         items{0};
+        int         programBinds{0};
+        int         programBindsAvoided{0};
+        int         textureBinds{0};
+        int         textureBindsAvoided{0};
+        int         meshBinds{0};
+        int         meshBindsAvoided{0};
+    };
+
+public:
+                        render_queue( mesh_renderer &meshes, render_backend &backend ) :
+                                meshes{meshes}, backend{backend} {}
+
+                        /* depth 0 - near .. 1 - far, world is the uniform
+                        * which receives the transform of the item */
+    void                add( shader::idprog prog, GLuint texture, basic_mesh &m, 
+                                const uniform &world, const mat4 &transform, float depth );
+                        /* sort and submit the items, then clear the queue */
+    void                submit();
+    void                clear();
+    int                 size() const;
+
+    const statistics &  get_statistics() const;
+
+    static sort_key     make_key( shader::idprog prog, GLuint texture, GLuint vao, float depth );
+                        /* depth of the object origin for add() */
+    static float        get_depth( const mat4 &worldViewProj );
+
+private:
+    void                sort();
+
+private:
+    struct item {
+        mat4            transform;
+        basic_mesh      *mesh;
+        shader::idprog  prog;
+        GLuint          texture;
+        GLuint          vao;
+        GLint           world;
+    };
+    struct key_index {
+        sort_key        key;
+        int             index;
+    };
+
+    mesh_renderer       &meshes;
+    render_backend      &backend;
+    core::vector<item>  items;
+    core::vector<key_index> keys;
+    core::vector<key_index> sorted;     /* radix sort buffer */
+    statistics          stats;
+};
+
+
+
+/* render_queue::size */
+inline int render_queue::size() const {
+    return static_cast<int>( items.size() );
+}
+
+/* render_queue::get_statistics */
+inline const render_queue::statistics &render_queue::get_statistics() const {
+    return stats;
+}
+
+} /* namespace engine */
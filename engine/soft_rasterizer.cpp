@@ -0,0 +1,656 @@
+#include "soft_rasterizer.h"
+#include <core/jobs.hpp>
+#include <core/simd.hpp>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+namespace engine {
+
+using namespace engine::core::jobs;
+using namespace engine::renderer;
+
+namespace {
+
+/* x and y clip planes are moved out by the guard band, so only triangles
+* which are far outside are clipped, the fixed point screen positions
+* of the vertices still fit in the edge functions */
+const float GUARD_BAND = 2.0f;
+const int   CLIP_PLANES_NUMBER = 6;
+const int   MAX_CLIP_VERTICES = 3 + CLIP_PLANES_NUMBER;
+
+/* distance to the clip plane, negative outside */
+inline float clip_distance( const vec4 &p, int plane ) {
+    switch( plane ) {
+        case 0: return p.x + GUARD_BAND * p.w;
+        case 1: return GUARD_BAND * p.w - p.x;
+        case 2: return p.y + GUARD_BAND * p.w;
+        case 3: return GUARD_BAND * p.w - p.y;
+        case 4: return p.z + p.w;
+        default: return p.w - p.z;
+    }
+}
+
+/* bit per clip plane outside of which the point is */
+inline int clip_code( const vec4 &p ) {
+    int code = 0;
+    for( int plane = 0; plane < CLIP_PLANES_NUMBER; plane++ ) {
+        if( clip_distance( p, plane ) < 0.0f ) {
+            code |= 1 << plane;
+        }
+    }
+    return code;
+}
+
+/* RGBA color, R is the lowest byte */
+inline dword pack_color( int r, int g, int b, int a ) {
+    return static_cast<dword>( r ) | (static_cast<dword>( g ) << 8) |
+            (static_cast<dword>( b ) << 16) | (static_cast<dword>( a ) << 24);
+}
+
+inline int to_byte( float c ) {
+    c = c < 0.0f ? 0.0f : (c > 1.0f ? 1.0f : c);
+    return static_cast<int>( c * 255.0f + 0.5f );
+}
+
+} /* namespace */
+
+/* soft_rasterizer::soft_rasterizer */
+soft_rasterizer::soft_rasterizer( int width, int height ) {
+    resize( width, height );
+}
+
+/* soft_rasterizer::resize */
+void soft_rasterizer::resize( int width, int height ) {
+    assert( width > 0 && width <= MAX_SIZE );
+    assert( height > 0 && height <= MAX_SIZE );
+    this->width = width;
+    this->height = height;
+    tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    /* the buffers are padded to whole tiles, so groups of 4 pixels
+    * never cross the end of the row */
+    pitch = tilesX * TILE_SIZE;
+    colors.assign( pitch * tilesY * TILE_SIZE, 0 );
+    depths.assign( pitch * tilesY * TILE_SIZE, 1.0f );
+    bins.clear();
+    bins.resize( tilesX * tilesY );
+    triangles.clear();
+}
+
+/* soft_rasterizer::create_texture */
+int soft_rasterizer::create_texture( renderer::image &img ) {
+    assert( !img.is_empty() );
+    texture tex;
+    tex.width = img.get_width();
+    tex.height = img.get_height();
+    tex.texels.resize( tex.width * tex.height );
+    auto fmt = img.get_pixel_format();
+    for( int y = 0; y < tex.height; y++ ) {
+        const byte *src = img.get_line_ptr( y );
+        dword *dst = tex.texels.data() + y * tex.width;
+        for( int x = 0; x < tex.width; x++ ) {
+            switch( fmt ) {
+                case PIXEL_FORMAT_GRAY8:
+                    dst[x] = pack_color( src[0], src[0], src[0], 255 );
+                    src += 1;
+                    break;
+                case PIXEL_FORMAT_BGR8:
+                    dst[x] = pack_color( src[2], src[1], src[0], 255 );
+                    src += 3;
+                    break;
+                case PIXEL_FORMAT_BGRA8:
+                    dst[x] = pack_color( src[2], src[1], src[0], src[3] );
+                    src += 4;
+                    break;
+                case PIXEL_FORMAT_RGB8:
+                    dst[x] = pack_color( src[0], src[1], src[2], 255 );
+                    src += 3;
+                    break;
+                case PIXEL_FORMAT_RGBA8:
+                    dst[x] = pack_color( src[0], src[1], src[2], src[3] );
+                    src += 4;
+                    break;
+                default:
+                    assert(0);
+            }
+        }
+    }
+    textures.push_back( std::move( tex ) );
+    return static_cast<int>( textures.size() ) - 1;
+}
+
+/* soft_rasterizer::clear
+* the triangles not flushed yet are dropped */
+void soft_rasterizer::clear( const vec4 &color, float depth ) {
+    auto c = pack_color( to_byte( color.x ), to_byte( color.y ), to_byte( color.z ), to_byte( color.w ) );
+    triangles.clear();
+    for( auto &bin : bins ) {
+        bin.clear();
+    }
+    parallel_for( 0, tilesY * TILE_SIZE, TILE_SIZE, [this, c, depth]( int first, int last ) {
+        std::fill( colors.begin() + first * pitch, colors.begin() + last * pitch, c );
+        std::fill( depths.begin() + first * pitch, depths.begin() + last * pitch, depth );
+    } );
+    stats = statistics();
+}
+
+/* soft_rasterizer::draw_mesh */
+void soft_rasterizer::draw_mesh( basic_mesh &m, const mat4 &wvp ) {
+    transform_vertices( m, wvp );
+    draw_primitives( m );
+}
+
+/* soft_rasterizer::draw_mesh_instanced */
+void soft_rasterizer::draw_mesh_instanced( basic_mesh &m, const mat4 *transforms, int count ) {
+    assert( count >= 0 );
+    assert( transforms != nullptr || count == 0 );
+    for( int i = 0; i < count; i++ ) {
+        draw_mesh( m, transforms[i] );
+    }
+}
+
+/* soft_rasterizer::transform_vertices */
+void soft_rasterizer::transform_vertices( basic_mesh &m, const mat4 &wvp ) {
+    const auto &present = m.get_present_vertex();
+    int posOffset = -1;
+    int uvOffset = -1;
+    for( int i = 0; i < present.numAttrib; i++ ) {
+        if( present.attributes[i].type == PRESENT_VERTEX_ATTRIB_XYZ ) {
+            posOffset = present.attributes[i].offset;
+        } else if( present.attributes[i].type == PRESENT_VERTEX_ATTRIB_UV ) {
+            uvOffset = present.attributes[i].offset;
+        }
+    }
+    assert( posOffset >= 0 );
+    int count = m.get_vertices_number();
+    vertices.resize( count );
+    parallel_for( 0, count, 1024, [&]( int first, int last ) {
+        for( int i = first; i < last; i++ ) {
+            const char *vert = m.get_vertex_ptr( i );
+            float pos[3];
+            std::memcpy( pos, vert + posOffset, sizeof(pos) );
+            auto &v = vertices[i];
+            v.pos = wvp * vec4( pos[0], pos[1], pos[2], 1.0f );
+            if( uvOffset >= 0 ) {
+                std::memcpy( &v.uv.x, vert + uvOffset, sizeof(float) );
+                std::memcpy( &v.uv.y, vert + uvOffset + sizeof(float), sizeof(float) );
+            } else {
+                v.uv = vec2( 0.0f, 0.0f );
+            }
+        }
+    } );
+}
+
+/* soft_rasterizer::draw_primitives
+* assembles triangles of the drawings as GL does with primitive restart,
+* points and lines are not rasterized */
+void soft_rasterizer::draw_primitives( basic_mesh &m ) {
+    const auto presentIndex = m.get_present_index();
+    const bool isIndexed = presentIndex != PRESENT_INDEX_NO_INDEX;
+    dword restartIndex = 0;
+    switch( presentIndex ) {
+        case PRESENT_INDEX_32BITS:
+            restartIndex = 0xffffffff;
+            break;
+        case PRESENT_INDEX_16BITS:
+            restartIndex = 0xffff;
+            break;
+        case PRESENT_INDEX_8BITS:
+            restartIndex = 0xff;
+            break;
+        default:
+            break;
+    }
+    const auto &drawing = m.get_present_drawing();
+    for( int d = 0; d < drawing.numDraws; d++ ) {
+        const auto type = drawing.drawing[d].type;
+        if( type != PRIMITIVE_TYPE_TRIANGLES && type != PRIMITIVE_TYPE_TRIANGLE_STRIP &&
+                type != PRIMITIVE_TYPE_TRIANGLE_FAN ) {
+            continue;
+        }
+        const int offset = drawing.drawing[d].offset;
+        int run = 0;            /* vertices since the start or the restart */
+        int first = 0;
+        int prev0 = 0;
+        int prev1 = 0;
+        for( int k = 0; k < drawing.drawing[d].count; k++ ) {
+            dword index;
+            if( isIndexed ) {
+                const char *ptr = m.get_index_ptr( offset + k );
+                switch( presentIndex ) {
+                    case PRESENT_INDEX_32BITS: {
+                        std::uint32_t i32;
+                        std::memcpy( &i32, ptr, sizeof(i32) );
+                        index = i32;
+                        break;
+                    }
+                    case PRESENT_INDEX_16BITS: {
+                        std::uint16_t i16;
+                        std::memcpy( &i16, ptr, sizeof(i16) );
+                        index = i16;
+                        break;
+                    }
+                    default:
+                        index = static_cast<byte>( *ptr );
+                        break;
+                }
+                if( index == restartIndex ) {
+                    run = 0;
+                    continue;
+                }
+            } else {
+                index = static_cast<dword>( offset + k );
+            }
+            assert( index < static_cast<dword>( m.get_vertices_number() ) );
+            int v = static_cast<int>( index );
+            switch( type ) {
+                case PRIMITIVE_TYPE_TRIANGLES:
+                    if( run % 3 == 2 ) {
+                        add_triangle( prev0, prev1, v );
+                    }
+                    break;
+                case PRIMITIVE_TYPE_TRIANGLE_STRIP:
+                    /* odd triangles swap the first two vertices to keep the winding */
+                    if( run >= 2 ) {
+                        if( run & 1 ) {
+                            add_triangle( prev1, prev0, v );
+                        } else {
+                            add_triangle( prev0, prev1, v );
+                        }
+                    }
+                    break;
+                default:
+                    if( run >= 2 ) {
+                        add_triangle( first, prev1, v );
+                    }
+                    break;
+            }
+            if( run == 0 ) {
+                first = v;
+            }
+            prev0 = prev1;
+            prev1 = v;
+            run++;
+        }
+    }
+}
+
+/* soft_rasterizer::add_triangle */
+void soft_rasterizer::add_triangle( int i0, int i1, int i2 ) {
+    stats.triangles++;
+    clip_triangle( vertices[i0], vertices[i1], vertices[i2] );
+}
+
+/* soft_rasterizer::clip_triangle
+* Sutherland-Hodgman against the planes crossed by the triangle */
+void soft_rasterizer::clip_triangle( const clip_vertex &v0, const clip_vertex &v1, const clip_vertex &v2 ) {
+    int c0 = clip_code( v0.pos );
+    int c1 = clip_code( v1.pos );
+    int c2 = clip_code( v2.pos );
+    if( c0 & c1 & c2 ) {
+        stats.culled++;
+        return;
+    }
+    int crossed = c0 | c1 | c2;
+    if( crossed == 0 ) {
+        setup_triangle( v0, v1, v2 );
+        return;
+    }
+    stats.clipped++;
+    clip_vertex buffers[2][MAX_CLIP_VERTICES];
+    clip_vertex *in = buffers[0];
+    clip_vertex *out = buffers[1];
+    in[0] = v0;
+    in[1] = v1;
+    in[2] = v2;
+    int n = 3;
+    for( int plane = 0; plane < CLIP_PLANES_NUMBER && n >= 3; plane++ ) {
+        if( !(crossed & (1 << plane)) ) {
+            continue;
+        }
+        int outN = 0;
+        for( int i = 0; i < n; i++ ) {
+            const auto &a = in[i];
+            const auto &b = in[(i + 1) % n];
+            float da = clip_distance( a.pos, plane );
+            float db = clip_distance( b.pos, plane );
+            if( da >= 0.0f ) {
+                out[outN++] = a;
+            }
+            if( (da >= 0.0f) != (db >= 0.0f) ) {
+                float t = da / (da - db);
+                auto &v = out[outN++];
+                v.pos = vec4( a.pos.x + (b.pos.x - a.pos.x) * t, a.pos.y + (b.pos.y - a.pos.y) * t,
+                        a.pos.z + (b.pos.z - a.pos.z) * t, a.pos.w + (b.pos.w - a.pos.w) * t );
+                v.uv = vec2( a.uv.x + (b.uv.x - a.uv.x) * t, a.uv.y + (b.uv.y - a.uv.y) * t );
+            }
+        }
+        std::swap( in, out );
+        n = outN;
+    }
+    for( int i = 2; i < n; i++ ) {
+        setup_triangle( in[0], in[i - 1], in[i] );
+    }
+}
+
+/* soft_rasterizer::setup_triangle
+* screen position, edge orientation, attribute planes and binning */
+void soft_rasterizer::setup_triangle( const clip_vertex &v0, const clip_vertex &v1, const clip_vertex &v2 ) {
+    const clip_vertex *v[3] = { &v0, &v1, &v2 };
+    const float subpixel = static_cast<float>( 1 << SUBPIXEL_BITS );
+    triangle t;
+    float sx[3], sy[3], attrib[4][3];
+    for( int i = 0; i < 3; i++ ) {
+        const auto &p = v[i]->pos;
+        if( p.w <= 0.0f ) {
+            stats.culled++;
+            return;
+        }
+        float invW = 1.0f / p.w;
+        t.x[i] = static_cast<int>( std::lrint( (p.x * invW * 0.5f + 0.5f) * width * subpixel ) );
+        t.y[i] = static_cast<int>( std::lrint( (0.5f - p.y * invW * 0.5f) * height * subpixel ) );
+        sx[i] = t.x[i] / subpixel;
+        sy[i] = t.y[i] / subpixel;
+        attrib[0][i] = p.z * invW * 0.5f + 0.5f;
+        attrib[1][i] = invW;
+        attrib[2][i] = v[i]->uv.x * invW;
+        attrib[3][i] = v[i]->uv.y * invW;
+    }
+    /* the screen y goes down, so counter-clockwise triangles have negative area */
+    std::int64_t area = static_cast<std::int64_t>( t.x[1] - t.x[0] ) * (t.y[2] - t.y[0]) -
+            static_cast<std::int64_t>( t.x[2] - t.x[0] ) * (t.y[1] - t.y[0]);
+    if( area == 0 || (area > 0 && cullFace) ) {
+        stats.culled++;
+        return;
+    }
+    if( area < 0 ) {
+        std::swap( t.x[1], t.x[2] );
+        std::swap( t.y[1], t.y[2] );
+        std::swap( sx[1], sx[2] );
+        std::swap( sy[1], sy[2] );
+        for( auto &a : attrib ) {
+            std::swap( a[1], a[2] );
+        }
+    }
+    /* pixels whose centers are inside the bounds */
+    const int half = 1 << (SUBPIXEL_BITS - 1);
+    const int one = 1 << SUBPIXEL_BITS;
+    int minX = std::min( t.x[0], std::min( t.x[1], t.x[2] ) );
+    int minY = std::min( t.y[0], std::min( t.y[1], t.y[2] ) );
+    int maxX = std::max( t.x[0], std::max( t.x[1], t.x[2] ) );
+    int maxY = std::max( t.y[0], std::max( t.y[1], t.y[2] ) );
+    t.minX = std::max( (minX - half + one - 1) >> SUBPIXEL_BITS, 0 );
+    t.minY = std::max( (minY - half + one - 1) >> SUBPIXEL_BITS, 0 );
+    t.maxX = std::min( (maxX - half) >> SUBPIXEL_BITS, width - 1 );
+    t.maxY = std::min( (maxY - half) >> SUBPIXEL_BITS, height - 1 );
+    if( t.minX > t.maxX || t.minY > t.maxY ) {
+        stats.culled++;
+        return;
+    }
+    /* a = a0 + dadx * (x - x0) + dady * (y - y0) */
+    float dx1 = sx[1] - sx[0];
+    float dy1 = sy[1] - sy[0];
+    float dx2 = sx[2] - sx[0];
+    float dy2 = sy[2] - sy[0];
+    float invDet = 1.0f / (dx1 * dy2 - dx2 * dy1);
+    for( int a = 0; a < 4; a++ ) {
+        float da1 = attrib[a][1] - attrib[a][0];
+        float da2 = attrib[a][2] - attrib[a][0];
+        t.planes[a][0] = attrib[a][0];
+        t.planes[a][1] = (da1 * dy2 - da2 * dy1) * invDet;
+        t.planes[a][2] = (da2 * dx1 - da1 * dx2) * invDet;
+    }
+    t.refX = sx[0];
+    t.refY = sy[0];
+    t.texture = currentTexture;
+    int index = static_cast<int>( triangles.size() );
+    triangles.push_back( t );
+    stats.rasterized++;
+    for( int ty = t.minY / TILE_SIZE; ty <= t.maxY / TILE_SIZE; ty++ ) {
+        for( int tx = t.minX / TILE_SIZE; tx <= t.maxX / TILE_SIZE; tx++ ) {
+            bins[ty * tilesX + tx].push_back( index );
+            stats.binned++;
+        }
+    }
+}
+
+/* soft_rasterizer::flush */
+void soft_rasterizer::flush() {
+    if( triangles.empty() ) {
+        return;
+    }
+    parallel_for( 0, tilesX * tilesY, 1, [this]( int first, int last ) {
+        for( int tile = first; tile < last; tile++ ) {
+            rasterize_tile( tile );
+        }
+    } );
+    triangles.clear();
+}
+
+/* soft_rasterizer::rasterize_tile */
+void soft_rasterizer::rasterize_tile( int tile ) {
+    auto &bin = bins[tile];
+    const int tileX = (tile % tilesX) * TILE_SIZE;
+    const int tileY = (tile / tilesX) * TILE_SIZE;
+    for( auto index : bin ) {
+        const auto &t = triangles[index];
+        rasterize_triangle( t, std::max( t.minX, tileX ), std::max( t.minY, tileY ),
+                std::min( t.maxX, tileX + TILE_SIZE - 1 ), std::min( t.maxY, tileY + TILE_SIZE - 1 ) );
+    }
+    bin.clear();
+}
+
+/* soft_rasterizer::rasterize_triangle
+* [x0..x1] x [y0..y1] - pixels of the triangle in one tile.
+* The edge functions are exact in integers. Edges which do not cross
+* the tile are dropped, for the others the values fit in 32 bits */
+void soft_rasterizer::rasterize_triangle( const triangle &t, int x0, int y0, int x1, int y1 ) {
+    /* groups of 4 pixels start at multiple of 4 */
+    x0 &= ~3;
+    const int lastX = x1 | 3;
+    const int half = 1 << (SUBPIXEL_BITS - 1);
+    const std::int64_t px = (static_cast<std::int64_t>( x0 ) << SUBPIXEL_BITS) + half;
+    const std::int64_t py = (static_cast<std::int64_t>( y0 ) << SUBPIXEL_BITS) + half;
+    int rowE[3], stepX[3], stepY[3];
+    for( int e = 0; e < 3; e++ ) {
+        const int a = e;
+        const int b = e == 2 ? 0 : e + 1;
+        const std::int64_t dx = t.x[b] - t.x[a];
+        const std::int64_t dy = t.y[b] - t.y[a];
+        /* top-left fill rule: pixels on the other edges are outside */
+        const int bias = (dy < 0 || (dy == 0 && dx > 0)) ? 0 : -1;
+        std::int64_t e0 = dx * (py - t.y[a]) - dy * (px - t.x[a]) + bias;
+        std::int64_t sx = -dy * (1 << SUBPIXEL_BITS);
+        std::int64_t sy = dx * (1 << SUBPIXEL_BITS);
+        std::int64_t w = sx * (lastX - x0);
+        std::int64_t h = sy * (y1 - y0);
+        std::int64_t minE = e0 + std::min<std::int64_t>( w, 0 ) + std::min<std::int64_t>( h, 0 );
+        std::int64_t maxE = e0 + std::max<std::int64_t>( w, 0 ) + std::max<std::int64_t>( h, 0 );
+        if( maxE < 0 ) {
+            return;
+        }
+        if( minE >= 0 ) {
+            rowE[e] = 0;
+            stepX[e] = 0;
+            stepY[e] = 0;
+        } else {
+            rowE[e] = static_cast<int>( e0 );
+            stepX[e] = static_cast<int>( sx );
+            stepY[e] = static_cast<int>( sy );
+        }
+    }
+#if SIMD_SSE4_1_ENABLED
+    const __m128i lanes = _mm_setr_epi32( 0, 1, 2, 3 );
+    __m128i stepX4[3], stepLanes[3];
+    for( int e = 0; e < 3; e++ ) {
+        stepX4[e] = _mm_set1_epi32( stepX[e] * 4 );
+        stepLanes[e] = _mm_mullo_epi32( _mm_set1_epi32( stepX[e] ), lanes );
+    }
+#endif /* SIMD_SSE4_1_ENABLED */
+    for( int y = y0; y <= y1; y++ ) {
+#if SIMD_SSE4_1_ENABLED
+        __m128i e0 = _mm_add_epi32( _mm_set1_epi32( rowE[0] ), stepLanes[0] );
+        __m128i e1 = _mm_add_epi32( _mm_set1_epi32( rowE[1] ), stepLanes[1] );
+        __m128i e2 = _mm_add_epi32( _mm_set1_epi32( rowE[2] ), stepLanes[2] );
+        for( int x = x0; x <= x1; x += 4 ) {
+            /* the sign bit is set outside of any edge */
+            __m128i outside = _mm_or_si128( _mm_or_si128( e0, e1 ), e2 );
+            int mask = ~_mm_movemask_ps( _mm_castsi128_ps( outside ) ) & 0xf;
+            if( mask ) {
+                shade_pixels( t, x, y, mask );
+            }
+            e0 = _mm_add_epi32( e0, stepX4[0] );
+            e1 = _mm_add_epi32( e1, stepX4[1] );
+            e2 = _mm_add_epi32( e2, stepX4[2] );
+        }
+#else
+        int e[3] = { rowE[0], rowE[1], rowE[2] };
+        for( int x = x0; x <= x1; x += 4 ) {
+            int mask = 0;
+            for( int lane = 0; lane < 4; lane++ ) {
+                if( (e[0] | e[1] | e[2]) >= 0 ) {
+                    mask |= 1 << lane;
+                }
+                e[0] += stepX[0];
+                e[1] += stepX[1];
+                e[2] += stepX[2];
+            }
+            if( mask ) {
+                shade_pixels( t, x, y, mask );
+            }
+        }
+#endif /* SIMD_SSE4_1_ENABLED */
+        rowE[0] += stepY[0];
+        rowE[1] += stepY[1];
+        rowE[2] += stepY[2];
+    }
+}
+
+/* soft_rasterizer::shade_pixels
+* depth test, texturing and alpha test of 4 pixels from (x, y),
+* mask - covered pixels */
+void soft_rasterizer::shade_pixels( const triangle &t, int x, int y, int mask ) {
+    const int offset = y * pitch + x;
+    float *depth = depths.data() + offset;
+    dword *color = colors.data() + offset;
+    const float fx = x + 0.5f - t.refX;
+    const float fy = y + 0.5f - t.refY;
+    alignas(16) float z[4], u[4], v[4];
+#if SIMD_SSE4_1_ENABLED
+    const __m128 dx = _mm_add_ps( _mm_set1_ps( fx ), _mm_setr_ps( 0.0f, 1.0f, 2.0f, 3.0f ) );
+    const __m128 dy = _mm_set1_ps( fy );
+    __m128 plane[4];
+    for( int a = 0; a < 4; a++ ) {
+        plane[a] = _mm_add_ps( _mm_add_ps( _mm_set1_ps( t.planes[a][0] ),
+                _mm_mul_ps( _mm_set1_ps( t.planes[a][1] ), dx ) ),
+                _mm_mul_ps( _mm_set1_ps( t.planes[a][2] ), dy ) );
+    }
+    mask &= _mm_movemask_ps( _mm_cmplt_ps( plane[0], _mm_loadu_ps( depth ) ) );
+    if( !mask ) {
+        return;
+    }
+    _mm_store_ps( z, plane[0] );
+    _mm_store_ps( u, _mm_div_ps( plane[2], plane[1] ) );
+    _mm_store_ps( v, _mm_div_ps( plane[3], plane[1] ) );
+#else
+    for( int lane = 0; lane < 4; lane++ ) {
+        float px = fx + lane;
+        float value[4];
+        for( int a = 0; a < 4; a++ ) {
+            value[a] = t.planes[a][0] + t.planes[a][1] * px + t.planes[a][2] * fy;
+        }
+        if( !(value[0] < depth[lane]) ) {
+            mask &= ~(1 << lane);
+        }
+        z[lane] = value[0];
+        u[lane] = value[2] / value[1];
+        v[lane] = value[3] / value[1];
+    }
+#endif /* SIMD_SSE4_1_ENABLED */
+    for( ; mask; mask &= mask - 1 ) {
+        int lane = __builtin_ctz( mask );
+        dword c = t.texture >= 0 ? sample( textures[t.texture], u[lane], v[lane] ) : 0xffffffff;
+        /* resources/shader.psh discards not opaque pixels */
+        if( (c >> 24) < 255 ) {
+            continue;
+        }
+        color[lane] = c;
+        depth[lane] = z[lane];
+    }
+}
+
+/* soft_rasterizer::sample
+* bilinear filtering with repeat wrapping */
+dword soft_rasterizer::sample( const texture &tex, float u, float v ) const {
+    u -= std::floor( u );
+    v -= std::floor( v );
+    float fx = u * tex.width - 0.5f;
+    float fy = v * tex.height - 0.5f;
+    float ix = std::floor( fx );
+    float iy = std::floor( fy );
+    int wx = static_cast<int>( (fx - ix) * 256.0f );
+    int wy = static_cast<int>( (fy - iy) * 256.0f );
+    int x0 = static_cast<int>( ix );
+    int y0 = static_cast<int>( iy );
+    int x1 = x0 + 1;
+    int y1 = y0 + 1;
+    x0 = x0 < 0 ? tex.width - 1 : x0;
+    y0 = y0 < 0 ? tex.height - 1 : y0;
+    x1 = x1 >= tex.width ? 0 : x1;
+    y1 = y1 >= tex.height ? 0 : y1;
+    dword t00 = tex.texels[y0 * tex.width + x0];
+    dword t10 = tex.texels[y0 * tex.width + x1];
+    dword t01 = tex.texels[y1 * tex.width + x0];
+    dword t11 = tex.texels[y1 * tex.width + x1];
+    dword result = 0;
+    for( int shift = 0; shift < 32; shift += 8 ) {
+        int c00 = (t00 >> shift) & 0xff;
+        int c10 = (t10 >> shift) & 0xff;
+        int c01 = (t01 >> shift) & 0xff;
+        int c11 = (t11 >> shift) & 0xff;
+        int top = c00 * (256 - wx) + c10 * wx;
+        int bottom = c01 * (256 - wx) + c11 * wx;
+        int c = (top * (256 - wy) + bottom * wy + 32768) >> 16;
+        result |= static_cast<dword>( c ) << shift;
+    }
+    return result;
+}
+
+/* soft_rasterizer::read_pixels */
+void soft_rasterizer::read_pixels( renderer::image &out, pixel_format fmt ) {
+    assert( fmt != PIXEL_FORMAT_AUTO );
+    flush();
+    out.release();
+    out.reserve( width, height, fmt );
+    for( int y = 0; y < height; y++ ) {
+        const dword *src = colors.data() + y * pitch;
+        byte *dst = out.get_line_ptr( y );
+        for( int x = 0; x < width; x++ ) {
+            const int r = src[x] & 0xff;
+            const int g = (src[x] >> 8) & 0xff;
+            const int b = (src[x] >> 16) & 0xff;
+            const int a = src[x] >> 24;
+            switch( fmt ) {
+                case PIXEL_FORMAT_GRAY8:
+                    *dst++ = static_cast<byte>( (r * 77 + g * 150 + b * 29) >> 8 );
+                    break;
+                case PIXEL_FORMAT_BGR8:
+                    *dst++ = b; *dst++ = g; *dst++ = r;
+                    break;
+                case PIXEL_FORMAT_BGRA8:
+                    *dst++ = b; *dst++ = g; *dst++ = r; *dst++ = a;
+                    break;
+                case PIXEL_FORMAT_RGB8:
+                    *dst++ = r; *dst++ = g; *dst++ = b;
+                    break;
+                case PIXEL_FORMAT_RGBA8:
+                    *dst++ = r; *dst++ = g; *dst++ = b; *dst++ = a;
+                    break;
+                default:
+                    assert(0);
+            }
+        }
+    }
+}
+
+} /* namespace engine */
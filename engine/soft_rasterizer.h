@@ -0,0 +1,137 @@
+#pragma once
+#include <core/types.hpp>
+#include <core/vector.hpp>
+#include <core/assert.hpp>
+#include <core/math.hpp>
+#include <renderer/image.h>
+#include "basic_mesh.h"
+namespace engine {
+
+using namespace engine::core::math;
+
+/* soft_rasterizer
+* headless CPU renderer of basic_mesh with the pipeline of
+* resources/shader_instanced.vsh and resources/shader.psh:
+* clip = wvp * pos, the color is fetched from the texture by UV
+* (bilinear, repeat) and discarded if alpha < 1, GL_LESS depth test.
+* Draw calls transform, clip and bin triangles to screen tiles,
+* flush() rasterizes the tiles in parallel by the job system.
+* Tiles keep the order of the triangles, so the result does not
+* depend on the number of threads.
+* Row 0 of the color buffer is the top row of the screen */
+class soft_rasterizer {
+public:
+    static const int    TILE_SIZE = 64;         /* pixels, multiple of 4 */
+    static const int    SUBPIXEL_BITS = 4;
+    static const int    MAX_SIZE = 8192;        /* max width and height */
+
+    struct statistics {
+        int         triangles{0};       /* assembled from the primitives */
+        int         culled{0};          /* outside, back facing or zero area */
+        int         clipped{0};         /* crossed the clip planes */
+        int         rasterized{0};      /* set up and binned */
+        int         binned{0};          /* triangles in all tiles */
+    };
+
+public:
+                        soft_rasterizer( int width, int height );
+
+    void                resize( int width, int height );
+    int                 get_width() const;
+    int                 get_height() const;
+
+                        /* the image is converted to the internal RGBA format,
+                        * returns texture index for bind_texture() */
+    int                 create_texture( renderer::image &img );
+                        /* -1 - no texture, the color is white */
+    void                bind_texture( int texture );
+                        /* back faces, counter-clockwise triangles are front as in GL */
+    void                set_cull_face( bool enable );
+
+                        /* color components are 0..1, also resets the statistics */
+    void                clear( const vec4 &color, float depth = 1.0f );
+                        /* wvp - row-major world-view-projection matrix */
+    void                draw_mesh( basic_mesh &m, const mat4 &wvp );
+    void                draw_mesh_instanced( basic_mesh &m, const mat4 *transforms, int count );
+                        /* rasterize all binned triangles */
+    void                flush();
+                        /* flushes and copies the color buffer */
+    void                read_pixels( renderer::image &out, renderer::pixel_format fmt = renderer::PIXEL_FORMAT_RGBA8 );
+
+    const statistics &  get_statistics() const;
+
+private:
+    struct clip_vertex {
+        vec4            pos;        /* clip space */
+        vec2            uv;
+    };
+    struct texture {
+        int             width;
+        int             height;
+        core::vector<dword> texels;     /* RGBA, R is the lowest byte */
+    };
+    struct triangle {
+        int             x[3];       /* screen position, SUBPIXEL_BITS fixed point */
+        int             y[3];
+        int             minX, minY, maxX, maxY;     /* covered pixels */
+        float           refX, refY;                 /* screen position of the vertex 0 */
+        float           planes[4][3];   /* z, 1/w, u/w, v/w: value at ref, d/dx, d/dy */
+        int             texture;
+    };
+
+    void                draw_primitives( basic_mesh &m );
+    void                transform_vertices( basic_mesh &m, const mat4 &wvp );
+    void                add_triangle( int i0, int i1, int i2 );
+    void                clip_triangle( const clip_vertex &v0, const clip_vertex &v1, const clip_vertex &v2 );
+    void                setup_triangle( const clip_vertex &v0, const clip_vertex &v1, const clip_vertex &v2 );
+    void                rasterize_tile( int tile );
+    void                rasterize_triangle( const triangle &t, int x0, int y0, int x1, int y1 );
+    void                shade_pixels( const triangle &t, int x, int y, int mask );
+    dword               sample( const texture &tex, float u, float v ) const;
+
+private:
+    int                 width{0};
+    int                 height{0};
+    int                 pitch{0};           /* pixels in the row of the buffers */
+    int                 tilesX{0};
+    int                 tilesY{0};
+    core::vector<dword> colors;
+    core::vector<float> depths;
+    core::vector<texture>           textures;
+    core::vector<clip_vertex>       vertices;   /* transformed vertices of the draw call */
+    core::vector<triangle>          triangles;
+    core::vector<core::vector<int>> bins;       /* triangles of the tiles */
+    int                 currentTexture{-1};
+    bool                cullFace{false};
+    statistics          stats;
+};
+
+
+
+/* soft_rasterizer::get_width */
+inline int soft_rasterizer::get_width() const {
+    return width;
+}
+
+/* soft_rasterizer::get_height */
+inline int soft_rasterizer::get_height() const {
+    return height;
+}
+
+/* soft_rasterizer::bind_texture */
+inline void soft_rasterizer::bind_texture( int texture ) {
+    assert( texture >= -1 && texture < static_cast<int>( textures.size() ) );
+    currentTexture = texture;
+}
+
+/* soft_rasterizer::set_cull_face */
+inline void soft_rasterizer::set_cull_face( bool enable ) {
+    cullFace = enable;
+}
+
+/* soft_rasterizer::get_statistics */
+inline const soft_rasterizer::statistics &soft_rasterizer::get_statistics() const {
+    return stats;
+}
+
+} /* namespace engine */
@@ -0,0 +1,280 @@
+#include "transform_pool.h"
+#include <cstring>
+#include <cmath>
+#include <core/simd.hpp>
+namespace engine {
+
+/* transform_pool::add */
+transform_pool::handle transform_pool::add( const vec3 &pos, const quat &rot, const vec3 &scl ) {
+    handle h = count++;
+    /* the arrays are padded to a multiple of 4 objects for the vector pass */
+    auto padded = static_cast<size_t>( (count + 3) & ~3 );
+    if( posX.size() < padded ) {
+        posX.resize( padded, 0.0 );
+        posY.resize( padded, 0.0 );
+        posZ.resize( padded, 0.0 );
+        rotX.resize( padded, 0.0 );
+        rotY.resize( padded, 0.0 );
+        rotZ.resize( padded, 0.0 );
+        rotW.resize( padded, 1.0 );
+        sclX.resize( padded, 1.0 );
+        sclY.resize( padded, 1.0 );
+        sclZ.resize( padded, 1.0 );
+        world.resize( padded, MAT4_IDENTITY );
+    }
+    worldViewProj.resize( count, MAT4_IDENTITY );
+    dirty.resize( (count + DIRTY_WORD_BITS - 1) / DIRTY_WORD_BITS, 0 );
+    viewDirty.resize( dirty.size(), 0 );
+    set_position( h, pos );
+    set_rotation( h, rot );
+    set_scale( h, scl );
+    return h;
+}
+
+/* transform_pool::reserve */
+void transform_pool::reserve( int count ) {
+    auto padded = static_cast<size_t>( (count + 3) & ~3 );
+    for( auto v : {&posX, &posY, &posZ, &rotX, &rotY, &rotZ, &rotW, &sclX, &sclY, &sclZ} ) {
+        v->reserve( padded );
+    }
+    world.reserve( padded );
+    worldViewProj.reserve( count );
+    dirty.reserve( (count + DIRTY_WORD_BITS - 1) / DIRTY_WORD_BITS );
+    viewDirty.reserve( (count + DIRTY_WORD_BITS - 1) / DIRTY_WORD_BITS );
+}
+
+/* transform_pool::clear */
+void transform_pool::clear() {
+    for( auto v : {&posX, &posY, &posZ, &rotX, &rotY, &rotZ, &rotW, &sclX, &sclY, &sclZ} ) {
+        v->clear();
+    }
+    world.clear();
+    worldViewProj.clear();
+    dirty.clear();
+    viewDirty.clear();
+    count = 0;
+}
+
+/* transform_pool::rotate_all */
+void transform_pool::rotate_all( const quat *deltas ) {
+    assert( deltas != nullptr );
+    int i = 0;
+#if MATH_SIMD_ENABLED
+    for( ; i + 4 <= count; i += 4 ) {
+        /* four quaternions to x, y, z, w lanes */
+        auto ax = _mm_load_ps( &deltas[i + 0].x );
+        auto ay = _mm_load_ps( &deltas[i + 1].x );
+        auto az = _mm_load_ps( &deltas[i + 2].x );
+        auto aw = _mm_load_ps( &deltas[i + 3].x );
+        _MM_TRANSPOSE4_PS( ax, ay, az, aw );
+        auto x = _mm_loadu_ps( &rotX[i] );
+        auto y = _mm_loadu_ps( &rotY[i] );
+        auto z = _mm_loadu_ps( &rotZ[i] );
+        auto w = _mm_loadu_ps( &rotW[i] );
+        /* same products and order as quat::operator* */
+        auto nx = _mm_sub_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( w, ax ), _mm_mul_ps( x, aw ) ),
+                _mm_mul_ps( y, az ) ), _mm_mul_ps( z, ay ) );
+        auto ny = _mm_add_ps( _mm_add_ps( _mm_sub_ps( _mm_mul_ps( w, ay ), _mm_mul_ps( x, az ) ),
+                _mm_mul_ps( y, aw ) ), _mm_mul_ps( z, ax ) );
+        auto nz = _mm_add_ps( _mm_sub_ps( _mm_add_ps( _mm_mul_ps( w, az ), _mm_mul_ps( x, ay ) ),
+                _mm_mul_ps( y, ax ) ), _mm_mul_ps( z, aw ) );
+        auto nw = _mm_sub_ps( _mm_sub_ps( _mm_sub_ps( _mm_mul_ps( w, aw ), _mm_mul_ps( x, ax ) ),
+                _mm_mul_ps( y, ay ) ), _mm_mul_ps( z, az ) );
+        _mm_storeu_ps( &rotX[i], nx );
+        _mm_storeu_ps( &rotY[i], ny );
+        _mm_storeu_ps( &rotZ[i], nz );
+        _mm_storeu_ps( &rotW[i], nw );
+    }
+#endif /* MATH_SIMD_ENABLED */
+    for( ; i < count; i++ ) {
+        auto q = get_rotation( i ) * deltas[i];
+        rotX[i] = q.x;
+        rotY[i] = q.y;
+        rotZ[i] = q.z;
+        rotW[i] = q.w;
+    }
+    /* all objects are dirty now */
+    for( auto &word : dirty ) {
+        word = ~dirty_word(0);
+    }
+    if( auto tail = count % DIRTY_WORD_BITS; tail != 0 ) {
+        dirty.back() = (dirty_word(1) << tail) - 1;
+    }
+}
+
+/* transform_pool::update */
+void transform_pool::update( const mat4 &viewProjection ) {
+    set_view_projection( viewProjection );
+    update_range( 0, count );
+}
+
+/* transform_pool::set_view_projection */
+void transform_pool::set_view_projection( const mat4 &viewProjection ) {
+    viewChanged = std::memcmp( &viewProj, &viewProjection, sizeof(mat4) ) != 0;
+    viewProj = viewProjection;
+}
+
+/* transform_pool::update_range */
+void transform_pool::update_range( int begin, int end ) {
+    assert( begin >= 0 && begin <= end && end <= count );
+    assert( begin % DIRTY_WORD_BITS == 0 );
+    assert( end % DIRTY_WORD_BITS == 0 || end == count );
+    for( int word = begin / DIRTY_WORD_BITS; word * DIRTY_WORD_BITS < end; word++ ) {
+        auto bits = dirty[word];
+        int base = word * DIRTY_WORD_BITS;
+        for( int i = 0; bits && i < DIRTY_WORD_BITS && base + i < end; i += 4 ) {
+            /* a block of 4 objects is rebuilt if any of them is dirty */
+            if( (bits >> i) & 0xf ) {
+                update_world( base + i );
+            }
+        }
+        /* worlds rebuilt by update_world_range() need the view too */
+        bits |= viewDirty[word];
+        viewDirty[word] = 0;
+        if( !bits ) {
+            continue;
+        }
+        if( !viewChanged ) {
+            /* the view is the same, only moved objects need a new matrix */
+            for( ; bits; bits &= bits - 1 ) {
+                int i = base + __builtin_ctzll( bits );
+                worldViewProj[i] = viewProj * world[i];
+            }
+        }
+        dirty[word] = 0;
+    }
+    if( viewChanged ) {
+        for( int i = begin; i < end; i++ ) {
+            worldViewProj[i] = viewProj * world[i];
+        }
+    }
+}
+
+/* transform_pool::update_world_range */
+void transform_pool::update_world_range( int begin, int end ) {
+    assert( begin >= 0 && begin <= end && end <= count );
+    assert( begin % DIRTY_WORD_BITS == 0 );
+    assert( end % DIRTY_WORD_BITS == 0 || end == count );
+    for( int word = begin / DIRTY_WORD_BITS; word * DIRTY_WORD_BITS < end; word++ ) {
+        auto bits = dirty[word];
+        if( !bits ) {
+            continue;
+        }
+        int base = word * DIRTY_WORD_BITS;
+        for( int i = 0; i < DIRTY_WORD_BITS && base + i < end; i += 4 ) {
+            if( (bits >> i) & 0xf ) {
+                update_world( base + i );
+            }
+        }
+        viewDirty[word] |= bits;
+        dirty[word] = 0;
+    }
+}
+
+/* transform_pool::cull */
+int transform_pool::cull( const frustum &view, const sphere &bounds, int begin, int end, int *visible ) const {
+    assert( begin >= 0 && begin <= end && end <= count );
+    assert( visible != nullptr );
+    /* world spheres of a block of objects are gathered to arrays for the vector test */
+    const int BLOCK = 64;
+    alignas(16) float x[BLOCK], y[BLOCK], z[BLOCK], r[BLOCK];
+    const auto &c = bounds.center;
+    int n = 0;
+    for( int first = begin; first < end; first += BLOCK ) {
+        int number = end - first < BLOCK ? end - first : BLOCK;
+        for( int i = 0; i < number; i++ ) {
+            const auto &m = world[first + i];
+            x[i] = m.x.x * c.x + m.x.y * c.y + m.x.z * c.z + m.x.w;
+            y[i] = m.y.x * c.x + m.y.y * c.y + m.y.z * c.z + m.y.w;
+            z[i] = m.z.x * c.x + m.z.y * c.y + m.z.z * c.z + m.z.w;
+            /* rotation keeps the radius, the largest scale stretches it */
+            auto sx = std::fabs( sclX[first + i] );
+            auto sy = std::fabs( sclY[first + i] );
+            auto sz = std::fabs( sclZ[first + i] );
+            r[i] = bounds.radius * max( sx, sy, sz );
+        }
+        int visibleNumber = view.test_spheres( x, y, z, r, number, visible + n );
+        for( int i = n; i < n + visibleNumber; i++ ) {
+            visible[i] += first;
+        }
+        n += visibleNumber;
+    }
+    return n;
+}
+
+#if MATH_SIMD_ENABLED
+/* transform_pool::update_world
+* world = translation * scale * rotation for objects [first..first + 4) */
+void transform_pool::update_world( int first ) {
+    assert( first % 4 == 0 );
+    auto x = _mm_loadu_ps( &rotX[first] );
+    auto y = _mm_loadu_ps( &rotY[first] );
+    auto z = _mm_loadu_ps( &rotZ[first] );
+    auto w = _mm_loadu_ps( &rotW[first] );
+    auto x2 = _mm_add_ps( x, x );
+    auto y2 = _mm_add_ps( y, y );
+    auto z2 = _mm_add_ps( z, z );
+    auto xx = _mm_mul_ps( x, x2 );
+    auto xy = _mm_mul_ps( x, y2 );
+    auto xz = _mm_mul_ps( x, z2 );
+    auto yy = _mm_mul_ps( y, y2 );
+    auto yz = _mm_mul_ps( y, z2 );
+    auto zz = _mm_mul_ps( z, z2 );
+    auto wx = _mm_mul_ps( w, x2 );
+    auto wy = _mm_mul_ps( w, y2 );
+    auto wz = _mm_mul_ps( w, z2 );
+    auto one = _mm_set1_ps( 1.0 );
+    auto sx = _mm_loadu_ps( &sclX[first] );
+    auto sy = _mm_loadu_ps( &sclY[first] );
+    auto sz = _mm_loadu_ps( &sclZ[first] );
+    /* rows of the matrices in object lanes */
+    auto m0 = _mm_mul_ps( sx, _mm_sub_ps( one, _mm_add_ps( yy, zz ) ) );
+    auto m1 = _mm_mul_ps( sx, _mm_sub_ps( xy, wz ) );
+    auto m2 = _mm_mul_ps( sx, _mm_add_ps( xz, wy ) );
+    auto m3 = _mm_loadu_ps( &posX[first] );
+    _MM_TRANSPOSE4_PS( m0, m1, m2, m3 );
+    _mm_store_ps( world[first + 0].x.get_ptr(), m0 );
+    _mm_store_ps( world[first + 1].x.get_ptr(), m1 );
+    _mm_store_ps( world[first + 2].x.get_ptr(), m2 );
+    _mm_store_ps( world[first + 3].x.get_ptr(), m3 );
+    m0 = _mm_mul_ps( sy, _mm_add_ps( xy, wz ) );
+    m1 = _mm_mul_ps( sy, _mm_sub_ps( one, _mm_add_ps( xx, zz ) ) );
+    m2 = _mm_mul_ps( sy, _mm_sub_ps( yz, wx ) );
+    m3 = _mm_loadu_ps( &posY[first] );
+    _MM_TRANSPOSE4_PS( m0, m1, m2, m3 );
+    _mm_store_ps( world[first + 0].y.get_ptr(), m0 );
+    _mm_store_ps( world[first + 1].y.get_ptr(), m1 );
+    _mm_store_ps( world[first + 2].y.get_ptr(), m2 );
+    _mm_store_ps( world[first + 3].y.get_ptr(), m3 );
+    m0 = _mm_mul_ps( sz, _mm_sub_ps( xz, wy ) );
+    m1 = _mm_mul_ps( sz, _mm_add_ps( yz, wx ) );
+    m2 = _mm_mul_ps( sz, _mm_sub_ps( one, _mm_add_ps( xx, yy ) ) );
+    m3 = _mm_loadu_ps( &posZ[first] );
+    _MM_TRANSPOSE4_PS( m0, m1, m2, m3 );
+    _mm_store_ps( world[first + 0].z.get_ptr(), m0 );
+    _mm_store_ps( world[first + 1].z.get_ptr(), m1 );
+    _mm_store_ps( world[first + 2].z.get_ptr(), m2 );
+    _mm_store_ps( world[first + 3].z.get_ptr(), m3 );
+    auto lastRow = _mm_set_ps( 1.0, 0.0, 0.0, 0.0 );
+    for( int i = 0; i < 4; i++ ) {
+        _mm_store_ps( world[first + i].w.get_ptr(), lastRow );
+    }
+}
+#else
+/* transform_pool::update_world
+* world = translation * scale * rotation for objects [first..first + 4) */
+void transform_pool::update_world( int first ) {
+    assert( first % 4 == 0 );
+    for( int i = first; i < first + 4; i++ ) {
+        quat q( get_rotation( i ) );
+        auto rot = q.to_mat4();
+        auto &out = world[i];
+        out.x = vec4( sclX[i] * rot.x.x, sclX[i] * rot.x.y, sclX[i] * rot.x.z, posX[i] );
+        out.y = vec4( sclY[i] * rot.y.x, sclY[i] * rot.y.y, sclY[i] * rot.y.z, posY[i] );
+        out.z = vec4( sclZ[i] * rot.z.x, sclZ[i] * rot.z.y, sclZ[i] * rot.z.z, posZ[i] );
+        out.w = vec4( 0.0, 0.0, 0.0, 1.0 );
+    }
+}
+#endif /* MATH_SIMD_ENABLED */
+
+} /* namespace engine */
@@ -0,0 +1,155 @@
+#pragma once
+#include <cstdint>
+#include <core/math.hpp>
+#include <core/vector.hpp>
+#include <core/assert.hpp>
+namespace engine {
+
+using namespace engine::core::math;
+
+/* transform_pool
+* batched storage of object transforms as a structure of arrays:
+* positions, rotations and scales live in separate contiguous arrays,
+* changed objects are marked in a dirty bitset and all matrices are
+* rebuilt in one pass per frame by update()
+*/
+class transform_pool {
+public:
+    typedef int     handle;
+
+public:
+                    /* returns handle of the new object */
+    handle          add( const vec3 &pos, const quat &rot, const vec3 &scl );
+    void            reserve( int count );
+    void            clear();
+    int             size() const;
+
+    void            rotate( handle h, const quat &q );
+                    /* rotate every object by its own quaternion: deltas[size()] */
+    void            rotate_all( const quat *deltas );
+    void            move( handle h, const vec3 &delta );
+
+    void            set_rotation( handle h, const quat &q );
+    const quat      get_rotation( handle h ) const;
+    void            set_position( handle h, const vec3 &pos );
+    const vec3      get_position( handle h ) const;
+    void            set_scale( handle h, const vec3 &scale );
+    const vec3      get_scale( handle h ) const;
+
+                    /* rebuild world matrices of the dirty objects and
+                    * world-view-projection matrices of the changed ones */
+    void            update( const mat4 &viewProjection );
+                    /* update() split for parallel work: set the view once, then
+                    * update ranges [begin..end), begin must be a multiple of 64 */
+    void            set_view_projection( const mat4 &viewProjection );
+    void            update_range( int begin, int end );
+                    /* rebuild world matrices only, for callers which cull the
+                    * objects first, same range rules as update_range() */
+    void            update_world_range( int begin, int end );
+
+                    /* test bounds of objects [begin..end) moved by their world
+                    * matrices, write indices of the visible ones to visible,
+                    * returns their number */
+    int             cull( const frustum &view, const sphere &bounds, int begin, int end, int *visible ) const;
+
+    const mat4 &    get_world( handle h ) const;
+                    /* flat array of size() matrices ready for upload */
+    const mat4 *    get_world_view_projection() const;
+
+private:
+    void            mark_dirty( handle h );
+    void            update_world( int first );
+
+private:
+    typedef std::uint64_t   dirty_word;
+    static const int        DIRTY_WORD_BITS = 64;
+
+    int                     count{0};
+    core::vector<float>     posX, posY, posZ;       /* object positions */
+    core::vector<float>     rotX, rotY, rotZ, rotW; /* object rotations */
+    core::vector<float>     sclX, sclY, sclZ;       /* object scales */
+    core::vector<dirty_word> dirty;                 /* need update world matrix */
+    core::vector<dirty_word> viewDirty;             /* world changed after the last update_range() */
+    core::vector<mat4>      world;                  /* out world matrices */
+    core::vector<mat4>      worldViewProj;          /* out world-view-projection matrices */
+    mat4                    viewProj{MAT4_ZERO};    /* last view-projection matrix */
+    bool                    viewChanged{true};      /* view-projection matrix was changed */
+};
+
+
+
+/* transform_pool::size */
+inline int transform_pool::size() const {
+    return count;
+}
+
+/* transform_pool::mark_dirty */
+inline void transform_pool::mark_dirty( handle h ) {
+    assert( h >= 0 && h < count );
+    dirty[h / DIRTY_WORD_BITS] |= dirty_word(1) << (h % DIRTY_WORD_BITS);
+}
+
+/* transform_pool::move */
+inline void transform_pool::move( handle h, const vec3 &delta ) {
+    posX[h] += delta.x;
+    posY[h] += delta.y;
+    posZ[h] += delta.z;
+    mark_dirty( h );
+}
+
+/* transform_pool::set_rotation */
+inline void transform_pool::set_rotation( handle h, const quat &q ) {
+    rotX[h] = q.x;
+    rotY[h] = q.y;
+    rotZ[h] = q.z;
+    rotW[h] = q.w;
+    mark_dirty( h );
+}
+
+/* transform_pool::get_rotation */
+inline const quat transform_pool::get_rotation( handle h ) const {
+    return quat( rotX[h], rotY[h], rotZ[h], rotW[h] );
+}
+
+/* transform_pool::set_position */
+inline void transform_pool::set_position( handle h, const vec3 &pos ) {
+    posX[h] = pos.x;
+    posY[h] = pos.y;
+    posZ[h] = pos.z;
+    mark_dirty( h );
+}
+
+/* transform_pool::get_position */
+inline const vec3 transform_pool::get_position( handle h ) const {
+    return vec3( posX[h], posY[h], posZ[h] );
+}
+
+/* transform_pool::set_scale */
+inline void transform_pool::set_scale( handle h, const vec3 &scale ) {
+    sclX[h] = scale.x;
+    sclY[h] = scale.y;
+    sclZ[h] = scale.z;
+    mark_dirty( h );
+}
+
+/* transform_pool::get_scale */
+inline const vec3 transform_pool::get_scale( handle h ) const {
+    return vec3( sclX[h], sclY[h], sclZ[h] );
+}
+
+/* transform_pool::rotate */
+inline void transform_pool::rotate( handle h, const quat &q ) {
+    set_rotation( h, get_rotation( h ) * q );
+}
+
+/* transform_pool::get_world */
+inline const mat4 &transform_pool::get_world( handle h ) const {
+    return world[h];
+}
+
+/* transform_pool::get_world_view_projection */
+inline const mat4 *transform_pool::get_world_view_projection() const {
+    return worldViewProj.data();
+}
+
+} /* namespace engine */
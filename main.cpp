@@ -9,18 +9,29 @@
 #include <core/math.hpp>
 #include <core/filesystem.hpp>
 #include <core/types.hpp>
+#include <core/jobs.hpp>
+#include <core/async_loader.hpp>
+#include <core/resource_cache.hpp>
 #include <renderer/opengl/gl.h>
 #include <engine/object3d_location.h>
+#include <engine/transform_pool.h>
 #include <engine/mesh.h>
+#include <engine/mesh_renderer.h>
+#include <engine/render_queue.h>
+#include <renderer/opengl/gl_render_backend.h>
+#include <renderer/opengl/gl_state_cache.h>
 #include <renderer/shader.h>
 #include <engine/controlled_camera.h>
 #include <core/common.hpp>
 #include <core/filesystem.hpp>
 #include <engine/onoff_key.h>
 #include <renderer/image.h>
+#include <renderer/mip_chain.h>
+#include <renderer/texture_file.h>
 #include <core/shared_ptr.hpp>
 #include <core/unique_ptr.hpp>
 #include <cstdlib>
+#include <algorithm>
 #include <ctime>
 #pragma comment (lib, "opengl32.lib")
 
@@ -238,15 +249,6 @@ void window::process_messages() {
 }
 
 
-struct mesh_binding {
-    bool        isInit{false};
-    GLuint      vbo{0};     /* GL vertex buffer object */
-    GLuint      ibo{0};     /* GL index buffer object */
-    GLuint      vao{0};     /* GL vertex array object */
-    GLenum      indexType{0};
-    GLuint      restartIndex{0};
-};
-
 class opengl_render {
 public:
                         opengl_render( const whandle_t handle );
@@ -254,13 +256,17 @@ public:
     void                clear();  
     void                bind_mesh( basic_mesh &m );
     void                draw_mesh( basic_mesh &m );
+    void                draw_mesh_instanced( basic_mesh &m, const mat4 *transforms, int count );
+    render_queue &      get_queue();
     void                display_frame();
 
-    static GLenum       primitive_type_to_gl_type( primitive_type type );
 private:
     HDC                 hdc;
     HGLRC               hrc;
     whandle_t           hWnd;
+    gl_render_backend   backend;
+    mesh_renderer       meshes{backend};
+    render_queue        queue{meshes, backend};
 };
 
 /* opengl_render::opengl_render */
@@ -283,6 +289,7 @@ opengl_render::opengl_render( const whandle_t handle ) {
     /* create and enable the render context (RC) */
     hrc = wglCreateContext( hdc );
     wglMakeCurrent( hdc, hrc );
+    gl_state_cache::reset();
     /* set default clear color */
     glClearColor( 1.0f, 1.0f, 1.0f, 0.0f );
 }
@@ -296,105 +303,28 @@ opengl_render::~opengl_render() {
 
 /* opengl_render::clear */
 void opengl_render::clear() {
+    gl_state_cache::begin_frame();
     glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
 }
 
 /* opengl_render::bind_mesh */
 void opengl_render::bind_mesh( basic_mesh &m ) {
-    mesh_binding *b = reinterpret_cast<mesh_binding*>(m.get_extra_ptr());
-    if( !(b->isInit) ) {
-        assert( b->vbo == 0 );
-        assert( b->ibo == 0 );
-        assert( b->vao == 0 );
-        const auto &vertPresent( m.get_present_vertex() );
-        const auto &indPresent( m.get_present_index() );
-        /* gen buffers and fill buffer data */
-        glGenVertexArrays( 1, &b->vao );
-        glBindVertexArray( b->vao );
-        /* bind vertex buffer object */
-        glGenBuffers( 1, &b->vbo );
-        glBindBuffer( GL_ARRAY_BUFFER, b->vbo );
-        glBufferData( GL_ARRAY_BUFFER, 
-                vertPresent.vertexSize * m.get_vertices_number(), 
-                m.get_vertex_ptr(0), GL_STATIC_DRAW );
-        /* present vertex attributes */
-        for( int i = 0; i < vertPresent.numAttrib; i++ ) {
-            auto offset = vertPresent.attributes[i].offset;
-            switch( vertPresent.attributes[i].type ) {
-                case PRESENT_VERTEX_ATTRIB_XYZ:
-                    glVertexAttribPointer( i, 3, GL_FLOAT, GL_FALSE, vertPresent.vertexSize, reinterpret_cast<void*>(offset) );
-                    break;
-                case PRESENT_VERTEX_ATTRIB_UV:
-                    glVertexAttribPointer( i, 2, GL_FLOAT, GL_FALSE, vertPresent.vertexSize, reinterpret_cast<void*>(offset) );
-                    break;
-                case PRESENT_VERTEX_ATTRIB_MAX_NUMBER:
-                    assert(0);
-                    break;
-            }
-        }
-        /* present index attributes */
-        if( indPresent != PRESENT_INDEX_NO_INDEX ) {
-            int indexBytes = 0;
-            /* set gl index type */
-            switch( indPresent ) {
-                case PRESENT_INDEX_32BITS:
-                    b->indexType = GL_UNSIGNED_INT;
-                    b->restartIndex = 0xffffffff;
-                    indexBytes = 4;
-                    break;
-                case PRESENT_INDEX_16BITS:
-                    b->indexType = GL_UNSIGNED_SHORT;
-                    b->restartIndex = 0xffff;
-                    indexBytes = 2;
-                    break;
-                case PRESENT_INDEX_8BITS:
-                    b->indexType = GL_UNSIGNED_BYTE;
-                    b->restartIndex = 0xff;
-                    indexBytes = 1;
-                    break;
-                default:
-                    assert(0);
-            }
-            /* bind index buffer object */
-            glGenBuffers( 1, &b->ibo );
-            glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, b->ibo );
-            glBufferData( GL_ELEMENT_ARRAY_BUFFER, 
-                    indexBytes * m.get_indices_number(), 
-                    m.get_index_ptr(0), GL_STATIC_DRAW );
-        } else {
-            b->indexType = 0;
-            b->restartIndex = 0;
-        }
-        glBindVertexArray( 0 );
-        b->isInit = true;
-    }
-    assert( b->vao != 0 );
-    glBindVertexArray( b->vao );
+    meshes.bind_mesh( m );
 }
 
 /* opengl_render::draw_mesh */
 void opengl_render::draw_mesh( basic_mesh &m ) {
-    bind_mesh( m );
-    mesh_binding *b = reinterpret_cast<mesh_binding*>(m.get_extra_ptr());
-    const auto &vertPresent( m.get_present_vertex() );
-    for( int i = 0; i < vertPresent.numAttrib; i++ ) {
-        glEnableVertexAttribArray(i);
-    }
-    /* draw calls */
-    const auto &drawing = m.get_present_drawing();
-    if( b->indexType != 0 ) {
-        glPrimitiveRestartIndex( b->restartIndex );
-        for( int i = 0; i < drawing.numDraws; i++ ) {
-            auto mode = primitive_type_to_gl_type( drawing.drawing[i].type );
-            glDrawElements( mode, drawing.drawing[i].count, b->indexType, 
-                    reinterpret_cast<void*>(drawing.drawing[i].offset) );
-        }
-    } else {
-        for( int i = 0; i < drawing.numDraws; i++ ) {
-            auto mode = primitive_type_to_gl_type( drawing.drawing[i].type );
-            glDrawArrays( mode, drawing.drawing[i].offset, drawing.drawing[i].count );
-        }
-    }
+    meshes.draw_mesh( m );
+}
+
+/* opengl_render::draw_mesh_instanced */
+void opengl_render::draw_mesh_instanced( basic_mesh &m, const mat4 *transforms, int count ) {
+    meshes.draw_mesh_instanced( m, transforms, count );
+}
+
+/* opengl_render::get_queue */
+render_queue &opengl_render::get_queue() {
+    return queue;
 }
 
 /* opengl_render::display_frame */
@@ -402,34 +332,6 @@ void opengl_render::display_frame() {
     ::SwapBuffers( hdc );
 }
 
-/* opengl_render::primitive_type_to_gl_type */
-GLenum opengl_render::primitive_type_to_gl_type( primitive_type type ) {
-    switch( type ) {
-        case PRIMITIVE_TYPE_POINTS:
-            return GL_POINTS;
-        case PRIMITIVE_TYPE_LINES:
-            return GL_LINES;
-        case PRIMITIVE_TYPE_LINES_ADJACENCY:
-            return GL_LINES_ADJACENCY;
-        case PRIMITIVE_TYPE_LINE_STRIP:
-            return GL_LINE_STRIP;
-        case PRIMITIVE_TYPE_LINE_STRIP_ADJACENCY:
-            return GL_LINE_STRIP_ADJACENCY;
-        case PRIMITIVE_TYPE_LINE_LOOP:
-            return GL_LINE_LOOP;
-        case PRIMITIVE_TYPE_TRIANGLES:
-            return GL_TRIANGLES;
-        case PRIMITIVE_TYPE_TRIANGLES_ADJACENCY:
-            return GL_TRIANGLES_ADJACENCY;
-        case PRIMITIVE_TYPE_TRIANGLE_STRIP:
-            return GL_TRIANGLE_STRIP;
-        case PRIMITIVE_TYPE_TRIANGLE_FAN:
-            return GL_TRIANGLE_FAN;
-        default:
-            assert(0);
-    }
-    return 0;
-}
 
 
 
@@ -451,21 +353,141 @@ float rand_float( float min, float max ) {
     return min + rnd;
 }
 
+/* S3TC and BPTC internal formats, they are not in renderer/opengl/gl.h */
+static const GLenum GL_COMPRESSED_RGB_S3TC_DXT1 = 0x83F0;
+static const GLenum GL_COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
+static const GLenum GL_COMPRESSED_RGBA_BPTC_UNORM = 0x8E8C;
+
+/* upload_texture
+* the levels of the mapped texture file go to the texture as is */
+void upload_texture( const renderer::texture_file &tex ) {
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+    for( int level = 0; level < tex.get_levels_number(); level++ ) {
+        if( tex.is_compressed() ) {
+            GLenum fmt = GL_COMPRESSED_RGB_S3TC_DXT1;
+            switch( tex.get_block_format() ) {
+                case renderer::BLOCK_FORMAT_BC1:
+                    fmt = GL_COMPRESSED_RGB_S3TC_DXT1;
+                    break;
+                case renderer::BLOCK_FORMAT_BC3:
+                    fmt = GL_COMPRESSED_RGBA_S3TC_DXT5;
+                    break;
+                case renderer::BLOCK_FORMAT_BC7:
+                    fmt = GL_COMPRESSED_RGBA_BPTC_UNORM;
+                    break;
+            }
+            glCompressedTexImage2D( GL_TEXTURE_2D, level, fmt, tex.get_width( level ), tex.get_height( level ),
+                    0, static_cast<GLsizei>(tex.get_level_size( level )), tex.get_level_ptr( level ) );
+        } else {
+            GLenum fmt = tex.get_pixel_format() == renderer::PIXEL_FORMAT_RGBA8 ? GL_RGBA : GL_RGB;
+            glTexImage2D( GL_TEXTURE_2D, level, fmt, tex.get_width( level ), tex.get_height( level ),
+                    0, fmt, GL_UNSIGNED_BYTE, tex.get_level_ptr( level ) );
+        }
+    }
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, tex.get_levels_number() - 1 );
+}
+
+/* upload_mips */
+void upload_mips( const renderer::mip_chain &mips ) {
+    GLenum fmt = mips.get_pixel_format() == renderer::PIXEL_FORMAT_RGBA8 ? GL_RGBA : GL_RGB;
+    /* the levels are in one buffer, the rows are not padded */
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+    for( int level = 0; level < mips.get_levels_number(); level++ ) {
+        glTexImage2D( GL_TEXTURE_2D, level, fmt,
+                mips.get_width( level ), mips.get_height( level ),
+                0, fmt, GL_UNSIGNED_BYTE, mips.get_level_ptr( level ) );
+    }
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mips.get_levels_number() - 1 );
+}
+
+/* texture
+* the texture object of the cache */
+struct texture {
+                    ~texture() { gl_state_cache::delete_texture( obj ); }
 
-struct temp_s {
-    object3d_location   loc;
-    quat                qu;
+    GLuint          obj{0};
 };
 
+/* shader_object
+* the compiled shader of the cache */
+struct shader_object {
+                    ~shader_object() { shader::delete_shader_object( id ); }
+
+    shader::idobj   id{0};
+};
+
+/* load_cooked_texture
+* the levels of the file of _texture_cooker are uploaded as is, the GPU
+* memory is the size of the texture in the cache */
+bool load_cooked_texture( mapped_file &file, texture &tex, resource_size &size ) {
+    renderer::texture_file cooked;
+    if( !cooked.open( std::move( file ) ) ) {
+        return false;
+    }
+    glGenTextures( 1, &tex.obj );
+    gl_state_cache::bind_texture( GL_TEXTURE_2D, tex.obj );
+    upload_texture( cooked );
+    for( int level = 0; level < cooked.get_levels_number(); level++ ) {
+        size.gpuBytes += cooked.get_level_size( level );
+    }
+    return true;
+}
+
+/* make_shader_loader
+* compiles the text of the file as the shader of the type */
+resource_cache<shader_object>::load_fn make_shader_loader( GLenum type ) {
+    return [type]( mapped_file &file, shader_object &obj, resource_size &size ) {
+        obj.id = shader::compile_shader_object( reinterpret_cast<const char*>( file.data() ), file.size(), type );
+        size.gpuBytes = file.size();
+        return obj.id != 0;
+    };
+}
+
+/* load_program
+* the files of the caches are compiled once, the programs of the
+* same files are linked once by shader */
+bool load_program( shader &sh, resource_cache<shader_object> &vertexShaders,
+        resource_cache<shader_object> &fragmentShaders, const string &vshName, const string &fshName ) {
+    auto vsh = vertexShaders.get( vshName );
+    auto fsh = fragmentShaders.get( fshName );
+    return vsh && fsh && sh.load( vsh->id, fsh->id );
+}
+
+/* load_texture
+* the texture cooked by _texture_cooker is mapped and uploaded by the
+* cache. If there is no one then 1234.png is decoded by the loader thread,
+* its mips are generated and uploaded when the loader finalizes the request.
+* Returns the texture object, cooked keeps the texture of the cache */
+GLuint load_texture( resource_cache<texture> &textures, async_loader &loader, core::shared_ptr<texture> &cooked ) {
+    cooked = textures.get( "1234.tex" );
+    if( cooked ) {
+        return cooked->obj;
+    }
+    GLuint textureObj;
+    glGenTextures( 1, &textureObj );
+    core::shared_ptr<renderer::mip_chain> mips{ new renderer::mip_chain };
+    loader.load( "1234.png", LOAD_PRIORITY_HIGH,
+        [mips]( mapped_file &file ) {
+            renderer::image img;
+            return img.load_from_memory( file.data(), file.size() ) &&
+                    mips->generate( img, renderer::MIP_FILTER_BOX, true );
+        },
+        [mips, textureObj]( load_status status ) {
+            if( status == LOAD_STATUS_SUCCEEDED ) {
+                gl_state_cache::bind_texture( GL_TEXTURE_2D, textureObj );
+                upload_mips( *mips );
+            }
+        } );
+    return textureObj;
+}
+
 
 #define __unused(v)   static_cast<void>(v)
 int WinMain( HINSTANCE hInst, HINSTANCE hPrevInst, LPSTR lpCmdLine, int nCmdShow ) {
     __unused(hInst); __unused(hPrevInst); __unused(lpCmdLine); __unused(nCmdShow);
 
-    renderer::image img;
     core::timer tm;
     
-    img.load_from_file( "1234.png" );
     /*tm.start();
     img.save_to_file( "image_out.jpg" );
     std::cout << "time: " << tm.get_elapsed_msec() << std::endl;*/
@@ -487,12 +509,20 @@ int WinMain( HINSTANCE hInst, HINSTANCE hPrevInst, LPSTR lpCmdLine, int nCmdShow
     std::cout << "renderer initialized\n";
 
 
+    /* shader.psh of both programs is compiled once */
+    resource_cache<shader_object> vertexShaders( make_shader_loader( GL_VERTEX_SHADER ) );
+    resource_cache<shader_object> fragmentShaders( make_shader_loader( GL_FRAGMENT_SHADER ) );
     shader sh;
-    sh.load( "shader.vsh", "shader.psh" );
+    load_program( sh, vertexShaders, fragmentShaders, "shader.vsh", "shader.psh" );
 
     auto uniWorld = sh.get_uniform( "gWorld" );
     auto uniTex = sh.get_uniform( "gTex" );
 
+    /* the same fragment shader, matrices come from the instance buffer */
+    shader shInstanced;
+    load_program( shInstanced, vertexShaders, fragmentShaders, "shader_instanced.vsh", "shader.psh" );
+    auto uniTexInstanced = shInstanced.get_uniform( "gTex" );
+
     std::cout << "sh loaded\n";
   
     const draw_vertex Verts[] = {
@@ -573,35 +603,37 @@ int WinMain( HINSTANCE hInst, HINSTANCE hPrevInst, LPSTR lpCmdLine, int nCmdShow
 
     //glFrontFace( GL_CCW ); /* default */
     //glCullFace( GL_BACK ); /* default */
-    glEnable( GL_CULL_FACE );
-    glEnable( GL_PRIMITIVE_RESTART );
-    glEnable( GL_DEPTH_TEST );
+    gl_state_cache::enable( GL_CULL_FACE );
+    gl_state_cache::enable( GL_PRIMITIVE_RESTART );
+    gl_state_cache::enable( GL_DEPTH_TEST );
     raw_input::key currentKey = VKRAW_F1;
 
-    /* texturing */
-    GLuint textureObj;
-    glGenTextures(1, &textureObj);
-    glBindTexture(GL_TEXTURE_2D, textureObj);
-    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, 
-            img.get_width(), img.get_height(),
-            0, GL_RGBA, GL_UNSIGNED_BYTE, img.get_line_ptr(0) );
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, textureObj);
+    jobs::job_system::initialize();
 
+    /* texturing, the texture of png is uploaded by the loader in the main loop */
+    resource_cache<texture> textures( load_cooked_texture );
+    core::shared_ptr<texture> cookedTexture;
+    async_loader loader;
+    loader.start();
+    GLuint textureObj = load_texture( textures, loader, cookedTexture );
+    gl_state_cache::bind_texture( GL_TEXTURE_2D, textureObj );
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    gl_state_cache::active_texture( GL_TEXTURE0 );
+    gl_state_cache::bind_texture( GL_TEXTURE_2D, textureObj );
 
     srand( time(NULL) );
     int locationsCount = 10000;
-    temp_s *locations = new temp_s[locationsCount];
+    transform_pool locations;
+    core::vector<quat> spins( locationsCount );
+    locations.reserve( locationsCount );
     for( int i = 0; i < locationsCount; i++ ) {
         float x, y, z;
         float s = rand_float(0.1, 4.0);
-        locations[i].loc.set_scale( vec3(s,  s,  s) );
         x = rand_float(-500, 500);
         y = rand_float(-500, 500);
         z = rand_float(-500, 500);
-        locations[i].loc.set_position( vec3(x, y, z) );
+        locations.add( vec3(x, y, z), QUAT_ZERO, vec3(s,  s,  s) );
         x = rand_float(-500, 500);
         y = rand_float(-500, 500);
         z = rand_float(-500, 500);
@@ -610,8 +642,14 @@ int WinMain( HINSTANCE hInst, HINSTANCE hPrevInst, LPSTR lpCmdLine, int nCmdShow
             del = 100;
         }
         quat q( vec3(x,y,z), pi / del );
-        locations[i].qu = q;
+        spins[i] = q;
     }
+    /* culling buffers */
+    auto cubeBounds = cube.get_bounding_sphere();
+    core::vector<int> visible( locationsCount );
+    core::vector<int> visibleNumbers;
+    core::vector<mat4> instances( locationsCount );
+    int frameCounter = 0;
 
     std::cout << "run main loop\n";
     while( appIsRun ) {
@@ -622,27 +660,27 @@ int WinMain( HINSTANCE hInst, HINSTANCE hPrevInst, LPSTR lpCmdLine, int nCmdShow
 
         if( raw_input::is_key_pressed(VKRAW_F1) && currentKey != VKRAW_F1 ) {
             currentKey = VKRAW_F1;
-            glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
+            gl_state_cache::polygon_mode( GL_FILL );
             common::log() << "Polygon mode: FILL\n";
         }
         if( raw_input::is_key_pressed(VKRAW_F2) && currentKey != VKRAW_F2 ) {
             currentKey = VKRAW_F2;
-            glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
+            gl_state_cache::polygon_mode( GL_LINE );
             common::log() << "Polygon mode: LINE\n";
         }
         if( raw_input::is_key_pressed(VKRAW_F3) && currentKey != VKRAW_F3 ) {
             currentKey = VKRAW_F3;
-            glPolygonMode( GL_FRONT_AND_BACK, GL_POINT );
+            gl_state_cache::polygon_mode( GL_POINT );
             common::log() << "Polygon mode: POINT\n";
         }
         if( raw_input::is_key_pressed(VKRAW_F5) && currentKey != VKRAW_F5 ) {
             currentKey = VKRAW_F5;
-            glEnable( GL_CULL_FACE );
+            gl_state_cache::enable( GL_CULL_FACE );
             common::log() << "Enable: CULL FACE\n";
         }
         if( raw_input::is_key_pressed(VKRAW_F6) && currentKey != VKRAW_F6 ) {
             currentKey = VKRAW_F6;
-            glDisable( GL_CULL_FACE );
+            gl_state_cache::disable( GL_CULL_FACE );
             common::log() << "Disable: CULL FACE\n";
         }
         
@@ -675,42 +713,61 @@ int WinMain( HINSTANCE hInst, HINSTANCE hPrevInst, LPSTR lpCmdLine, int nCmdShow
 
 
         render.clear();
-        
+
+        /* single objects are sorted by the queue */
+        auto &queue = render.get_queue();
         auto toShader = cam() * loc();
+        queue.add( sh.get_program(), textureObj, cube, uniWorld, toShader, render_queue::get_depth( toShader ) );
+        toShader = cam() * loc2();
+        queue.add( sh.get_program(), textureObj, cube, uniWorld, toShader, render_queue::get_depth( toShader ) );
+        toShader = cam() * loc3();
+        queue.add( sh.get_program(), textureObj, sphere, uniWorld, toShader, render_queue::get_depth( toShader ) );
         sh.use();
-        uniWorld.set( toShader );
-        glBindTexture(GL_TEXTURE_2D, textureObj);
-
         uniTex.set( GL_TEXTURE0 );
-
-
-        uniWorld.set( toShader );
-        render.draw_mesh( cube );
-
-        for( int i = 0; i < locationsCount; i++ ) {
-            toShader = cam() * locations[i].loc();
-            uniWorld.set( toShader );
-            render.draw_mesh( cube );
-            locations[i].loc.rotate( locations[i].qu );
+        queue.submit();
+
+        /* world matrices are rebuilt by all the workers, ranges must be
+        * aligned to 64 objects of the dirty words. Then every range is
+        * culled and matrices are built for the visible objects only */
+        const int grain = 1024;
+        auto viewProj = cam();
+        frustum view( viewProj );
+        visibleNumbers.assign( (locations.size() + grain - 1) / grain, 0 );
+        jobs::parallel_for( 0, locations.size(), grain, [&]( int begin, int end ) {
+            locations.update_world_range( begin, end );
+            visibleNumbers[begin / grain] = locations.cull( view, cubeBounds, begin, end, &visible[begin] );
+        } );
+        int visibleNumber = 0;
+        for( int i = 0; i < static_cast<int>( visibleNumbers.size() ); i++ ) {
+            std::copy_n( &visible[i * grain], visibleNumbers[i], &visible[visibleNumber] );
+            visibleNumber += visibleNumbers[i];
+        }
+        jobs::parallel_for( 0, visibleNumber, grain, [&]( int begin, int end ) {
+            for( int i = begin; i < end; i++ ) {
+                instances[i] = viewProj * locations.get_world( visible[i] );
+            }
+        } );
+        shInstanced.use();
+        uniTexInstanced.set( GL_TEXTURE0 );
+        render.draw_mesh_instanced( cube, instances.data(), visibleNumber );
+        locations.rotate_all( spins.data() );
+        if( frameCounter++ % 60 == 0 ) {
+            string title( "visible: " );
+            title += std::to_string( visibleNumber );
+            title += " culled: ";
+            title += std::to_string( locations.size() - visibleNumber );
+            w->set_title( title );
         }
-        
-
-
-        sh.use();
-        toShader = cam() * loc2();
-        uniWorld.set( toShader );
-        render.draw_mesh( cube );
 
-        toShader = cam() * loc3();
-        uniWorld.set( toShader );
-        render.draw_mesh( sphere );
+        /* the finished loads are uploaded within 2 ms of the frame */
+        loader.update( 2.0f );
 
         auto skip = static_cast<int>(1000.0 / 60.0 - timer.get_elapsed_msec());
         Sleep( skip > 0 ? skip : 0 );
         render.display_frame();
     }    
-    
-    delete[] locations;
 
+    loader.stop();
+    jobs::job_system::shutdown();
     return 0;
 }
@@ -0,0 +1,371 @@
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <atomic>
+#include <thread>
+#include <core/vector.hpp>
+#include <core/timer.hpp>
+#include <core/jobs.hpp>
+#include <core/common.hpp>
+#include <core/math.hpp>
+#include <engine/transform_pool.h>
+#include <engine/object3d_location.h>
+#include <engine/camera.h>
+#include <engine/loose_octree.h>
+
+using namespace engine::core;
+using namespace engine::core::math;
+
+namespace engine {
+
+/* command line options */
+struct options {
+    int             frames{10};         /* measured frames of every bench */
+    int             threads{0};         /* 0 - one per core */
+    core::vector<const char*>   benches;
+};
+
+/* print_usage */
+static void print_usage() {
+    common::log() << "usage: _engine_bench [--frames N] [--threads N] BENCH...\n"
+            "runs the benches of the engine code and prints the time per frame:\n"
+            "    transforms - transform_pool against object3d_location, 10k, 100k, 1M objects\n"
+            "    jobs - 1M transforms updated by parallel_for and 100k empty jobs, 1 to N threads\n"
+            "    culling - frustum test of 100k and 1M bounding spheres, one by one and batched\n"
+            "    octree - loose_octree build, moves and queries of 100k objects against a linear scan\n";
+}
+
+/* parse_options */
+static bool parse_options( int argc, char **argv, options &opt ) {
+    int i = 1;
+    for( ; i < argc && argv[i][0] == '-'; i++ ) {
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if( !value ) {
+            return false;
+        }
+        if( std::strcmp( argv[i], "--frames" ) == 0 ) {
+            opt.frames = std::atoi( value );
+        } else if( std::strcmp( argv[i], "--threads" ) == 0 ) {
+            opt.threads = std::atoi( value );
+        } else {
+            return false;
+        }
+        i++;
+    }
+    for( ; i < argc; i++ ) {
+        opt.benches.push_back( argv[i] );
+    }
+    return opt.frames > 0 && opt.threads >= 0 && !opt.benches.empty();
+}
+
+/* rand_float */
+static float rand_float( float min, float max ) {
+    return min + (max - min) * static_cast<float>( std::rand() ) / RAND_MAX;
+}
+
+/* bench_transforms
+* every frame rotates all objects and rebuilds their world-view-projection
+* matrices: the structure of arrays of transform_pool and the array of
+* object3d_location structures, both on one thread */
+static bool bench_transforms( const options &opt ) {
+    static const int counts[] = { 10000, 100000, 1000000 };
+    auto viewProj = mat4::perspective( pi / 3.0, 16.0 / 9.0, 0.1, 1000.0 );
+    core::timer tm;
+    for( int count : counts ) {
+        /* fixed seed, both layouts get the same objects */
+        std::srand( 1 );
+        transform_pool pool;
+        core::vector<object3d_location> locations( count );
+        core::vector<quat> spins( count );
+        core::vector<mat4> worldViewProj( count );
+        pool.reserve( count );
+        for( int i = 0; i < count; i++ ) {
+            float s = rand_float( 0.1, 4.0 );
+            vec3 pos( rand_float( -500, 500 ), rand_float( -500, 500 ), rand_float( -500, 500 ) );
+            vec3 axis( rand_float( -1, 1 ), rand_float( -1, 1 ), rand_float( -1, 1 ) );
+            spins[i] = quat( axis, rand_float( 0.01, 0.1 ) );
+            pool.add( pos, QUAT_ZERO, vec3( s, s, s ) );
+            locations[i].set_position( pos );
+            locations[i].set_rotation( QUAT_ZERO );
+            locations[i].set_scale( vec3( s, s, s ) );
+        }
+
+        tm.start();
+        for( int frame = 0; frame < opt.frames; frame++ ) {
+            for( int i = 0; i < count; i++ ) {
+                locations[i].rotate( spins[i] );
+                worldViewProj[i] = viewProj * locations[i]();
+            }
+        }
+        double aosMsec = tm.get_elapsed_msec() / opt.frames;
+
+        tm.start();
+        for( int frame = 0; frame < opt.frames; frame++ ) {
+            pool.rotate_all( spins.data() );
+            pool.update( viewProj );
+        }
+        double soaMsec = tm.get_elapsed_msec() / opt.frames;
+
+        common::log() << "transforms " << count << ": object3d_location " << aosMsec << " ms, "
+                << aosMsec * 1.0e6 / count << " ns/object, transform_pool " << soaMsec << " ms, "
+                << soaMsec * 1.0e6 / count << " ns/object, x" << aosMsec / soaMsec << std::endl;
+    }
+    return true;
+}
+
+/* bench_jobs
+* the job system is restarted with 1, 2, 4... threads up to --threads
+* (or the number of cores). The parallel update shows the scaling of
+* the real work, the empty jobs show the cost of run() and stealing */
+static bool bench_jobs( const options &opt ) {
+    const int objectsNumber = 1000000;
+    const int grain = 1024;
+    const int emptyJobsNumber = 100000;
+    int maxThreads = opt.threads;
+    if( maxThreads == 0 ) {
+        maxThreads = static_cast<int>( std::thread::hardware_concurrency() );
+        maxThreads = maxThreads > 0 ? maxThreads : 1;
+    }
+    std::srand( 1 );
+    transform_pool pool;
+    core::vector<quat> spins( objectsNumber );
+    pool.reserve( objectsNumber );
+    for( int i = 0; i < objectsNumber; i++ ) {
+        vec3 pos( rand_float( -500, 500 ), rand_float( -500, 500 ), rand_float( -500, 500 ) );
+        vec3 axis( rand_float( -1, 1 ), rand_float( -1, 1 ), rand_float( -1, 1 ) );
+        spins[i] = quat( axis, rand_float( 0.01, 0.1 ) );
+        pool.add( pos, QUAT_ZERO, vec3( 1.0, 1.0, 1.0 ) );
+    }
+    auto viewProj = mat4::perspective( pi / 3.0, 16.0 / 9.0, 0.1, 1000.0 );
+
+    jobs::job_system::shutdown();
+    core::timer tm;
+    double firstMsec = 0.0;
+    for( int threads = 1; ; threads = threads * 2 < maxThreads ? threads * 2 : maxThreads ) {
+        jobs::job_system::initialize( threads );
+        tm.start();
+        for( int frame = 0; frame < opt.frames; frame++ ) {
+            pool.rotate_all( spins.data() );
+            pool.set_view_projection( viewProj );
+            jobs::parallel_for( 0, pool.size(), grain, [&]( int begin, int end ) {
+                pool.update_range( begin, end );
+            } );
+        }
+        double updateMsec = tm.get_elapsed_msec() / opt.frames;
+        firstMsec = threads == 1 ? updateMsec : firstMsec;
+
+        std::atomic<int> executed{0};
+        jobs::counter done;
+        tm.start();
+        for( int i = 0; i < emptyJobsNumber; i++ ) {
+            jobs::job_system::run( [&executed]() { executed.fetch_add( 1, std::memory_order_relaxed ); }, &done );
+        }
+        jobs::job_system::wait( done );
+        double jobsMsec = tm.get_elapsed_msec();
+        jobs::job_system::shutdown();
+
+        common::log() << "jobs " << threads << " threads: update " << updateMsec << " ms, x"
+                << firstMsec / updateMsec << ", empty job " << jobsMsec * 1.0e6 / emptyJobsNumber
+                << " ns" << std::endl;
+        if( threads == maxThreads ) {
+            break;
+        }
+    }
+    jobs::job_system::initialize( opt.threads );
+    return true;
+}
+
+/* bench_culling
+* the spheres moved by the world matrices are tested against the frustum
+* one by one with sphere::transform() and frustum::test_sphere() and by
+* transform_pool::cull() in batches, on one thread and by parallel_for.
+* The camera at the center of the scene sees about a tenth of it */
+static bool bench_culling( const options &opt ) {
+    static const int counts[] = { 100000, 1000000 };
+    const int grain = 1024;
+    camera cam( vec3( 0, 0, 0 ), vec3( 0, 1, 0 ), vec3( 0, 0, 1 ) );
+    cam.set_perspective_projection( pi / 3.0, 16.0 / 9.0, 0.1, 1000 );
+    frustum view( cam() );
+    const sphere bounds( vec3( 0, 0, 0 ), 1.7320508f );
+    core::timer tm;
+    bool succeeded = true;
+    for( int count : counts ) {
+        std::srand( 1 );
+        transform_pool pool;
+        pool.reserve( count );
+        for( int i = 0; i < count; i++ ) {
+            float s = rand_float( 0.1, 4.0 );
+            vec3 pos( rand_float( -500, 500 ), rand_float( -500, 500 ), rand_float( -500, 500 ) );
+            vec3 axis( rand_float( -1, 1 ), rand_float( -1, 1 ), rand_float( -1, 1 ) );
+            pool.add( pos, quat( axis, rand_float( -pi, pi ) ), vec3( s, s, s ) );
+        }
+        pool.update( cam() );
+        core::vector<int> visible( count );
+        core::vector<int> visibleNumbers( (count + grain - 1) / grain );
+
+        int singleVisible = 0;
+        tm.start();
+        for( int frame = 0; frame < opt.frames; frame++ ) {
+            singleVisible = 0;
+            for( int i = 0; i < count; i++ ) {
+                if( view.test_sphere( bounds.transform( pool.get_world( i ) ) ) ) {
+                    visible[singleVisible++] = i;
+                }
+            }
+        }
+        double singleMsec = tm.get_elapsed_msec() / opt.frames;
+
+        int batchVisible = 0;
+        tm.start();
+        for( int frame = 0; frame < opt.frames; frame++ ) {
+            batchVisible = pool.cull( view, bounds, 0, count, visible.data() );
+        }
+        double batchMsec = tm.get_elapsed_msec() / opt.frames;
+
+        int parallelVisible = 0;
+        tm.start();
+        for( int frame = 0; frame < opt.frames; frame++ ) {
+            jobs::parallel_for( 0, count, grain, [&]( int begin, int end ) {
+                visibleNumbers[begin / grain] = pool.cull( view, bounds, begin, end, &visible[begin] );
+            } );
+            parallelVisible = 0;
+            for( int n : visibleNumbers ) {
+                parallelVisible += n;
+            }
+        }
+        double parallelMsec = tm.get_elapsed_msec() / opt.frames;
+
+        common::log() << "culling " << count << ": visible " << batchVisible << ", test_sphere " << singleMsec
+                << " ms, cull " << batchMsec << " ms, x" << singleMsec / batchMsec << ", parallel cull "
+                << parallelMsec << " ms, x" << singleMsec / parallelMsec << std::endl;
+        /* the batched test is the same test of the same spheres */
+        if( singleVisible != batchVisible || parallelVisible != batchVisible ) {
+            common::error() << "culling " << count << ": test_sphere sees " << singleVisible << ", cull "
+                    << batchVisible << ", parallel cull " << parallelVisible << std::endl;
+            succeeded = false;
+        }
+    }
+    return succeeded;
+}
+
+/* bench_octree
+* every frame moves a tenth of the objects a little and runs frustum,
+* sphere and ray queries, the same queries test every object in the
+* linear scan. The found numbers must be equal */
+static bool bench_octree( const options &opt ) {
+    const int objectsNumber = 100000;
+    const int queriesNumber = 100;
+    const float extent = 1000.0f;
+    std::srand( 1 );
+    core::vector<sphere> spheres( objectsNumber );
+    for( auto &s : spheres ) {
+        s = sphere( vec3( rand_float( -extent, extent ), rand_float( -extent, extent ),
+                rand_float( -extent, extent ) ), rand_float( 0.5, 5.0 ) );
+    }
+    core::timer tm;
+    tm.start();
+    loose_octree tree( vec3( 0, 0, 0 ), extent );
+    core::vector<loose_octree::handle> handles( objectsNumber );
+    for( int i = 0; i < objectsNumber; i++ ) {
+        handles[i] = tree.insert( spheres[i] );
+    }
+    double buildMsec = tm.get_elapsed_msec();
+
+    double moveMsec = 0.0;
+    double treeMsec = 0.0;
+    double scanMsec = 0.0;
+    int treeFound = 0;
+    int scanFound = 0;
+    core::vector<loose_octree::handle> found;
+    for( int frame = 0; frame < opt.frames; frame++ ) {
+        tm.start();
+        for( int i = frame % 10; i < objectsNumber; i += 10 ) {
+            spheres[i].center += vec3( rand_float( -5, 5 ), rand_float( -5, 5 ), rand_float( -5, 5 ) );
+            tree.move( handles[i], spheres[i] );
+        }
+        moveMsec += tm.get_elapsed_msec();
+
+        for( int q = 0; q < queriesNumber; q++ ) {
+            vec3 pos( rand_float( -extent, extent ), rand_float( -extent, extent ), rand_float( -extent, extent ) );
+            vec3 dir( rand_float( -1, 1 ), rand_float( -1, 1 ), rand_float( -1, 1 ) );
+            dir = dir * (1.0f / sqrt( dir * dir + 1.0e-6f ));
+            camera cam( pos, dir, std::fabs( dir.z ) < 0.9f ? vec3( 0, 0, 1 ) : vec3( 1, 0, 0 ) );
+            cam.set_perspective_projection( pi / 3.0, 16.0 / 9.0, 0.1, 200 );
+            frustum view( cam() );
+            sphere area( pos, 50.0f );
+
+            tm.start();
+            found.clear();
+            tree.query_frustum( view, found );
+            tree.query_sphere( area, found );
+            tree.query_ray( pos, dir, 500.0f, found );
+            treeMsec += tm.get_elapsed_msec();
+            treeFound += static_cast<int>( found.size() );
+
+            tm.start();
+            int n = 0;
+            for( const auto &s : spheres ) {
+                n += view.test_sphere( s ) ? 1 : 0;
+                auto d = s.center - area.center;
+                n += d * d <= squr( s.radius + area.radius ) ? 1 : 0;
+                /* the ray test of loose_octree */
+                auto m = pos - s.center;
+                auto b = m * dir;
+                auto c = m * m - s.radius * s.radius;
+                auto discr = b * b - c;
+                if( !(c > 0.0f && b > 0.0f) && discr >= 0.0f ) {
+                    auto t = -b - sqrt( discr );
+                    n += t <= 500.0f ? 1 : 0;
+                }
+            }
+            scanMsec += tm.get_elapsed_msec();
+            scanFound += n;
+        }
+    }
+    int queries = opt.frames * queriesNumber;
+    common::log() << "octree " << objectsNumber << ": build " << buildMsec << " ms, nodes "
+            << tree.get_nodes_number() << ", move " << moveMsec / opt.frames << " ms/frame, query "
+            << treeMsec * 1000.0 / queries << " us, scan " << scanMsec * 1000.0 / queries << " us, x"
+            << scanMsec / treeMsec << std::endl;
+    if( treeFound != scanFound ) {
+        common::error() << "octree: the queries found " << treeFound << ", the scan " << scanFound << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} /* namespace engine */
+
+int main( int argc, char **argv ) {
+    static const struct {
+        const char *    name;
+        bool            (*run)( const engine::options &opt );
+    } benches[] = {
+        { "transforms", engine::bench_transforms },
+        { "jobs", engine::bench_jobs },
+        { "culling", engine::bench_culling },
+        { "octree", engine::bench_octree }
+    };
+    engine::options opt;
+    if( !engine::parse_options( argc, argv, opt ) ) {
+        engine::print_usage();
+        return 1;
+    }
+    engine::core::jobs::job_system::initialize( opt.threads );
+    int result = 0;
+    for( const char *name : opt.benches ) {
+        bool found = false;
+        for( const auto &b : benches ) {
+            if( std::strcmp( b.name, name ) == 0 ) {
+                found = true;
+                result |= b.run( opt ) ? 0 : 1;
+            }
+        }
+        if( !found ) {
+            engine::common::error() << "unknown bench " << name << std::endl;
+            result = 1;
+        }
+    }
+    engine::core::jobs::job_system::shutdown();
+    return result;
+}
@@ -0,0 +1,252 @@
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <core/string.hpp>
+#include <core/assert.hpp>
+#include <core/math.hpp>
+#include <core/filesystem.hpp>
+#include <core/jobs.hpp>
+#include <core/common.hpp>
+#include <engine/transform_pool.h>
+#include <engine/camera.h>
+#include <engine/mesh.h>
+#include <engine/soft_rasterizer.h>
+#include <engine/headless_loop.h>
+#include <renderer/image.h>
+
+using namespace engine::core::math;
+using namespace engine::core;
+
+namespace engine {
+
+/* command line options */
+struct options {
+    int             frames{100};
+    int             width{1366};
+    int             height{768};
+    int             threads{0};         /* 0 - one per core */
+    int             objects{10000};
+    const char *    resources{nullptr};
+    const char *    output{nullptr};    /* image of the last frame, relative to resources */
+    const char *    golden{nullptr};    /* the last frame must be equal to this image */
+};
+
+/* print_usage */
+static void print_usage() {
+    common::log() << "usage: _headless [--frames N] [--size WxH] [--threads N] [--objects N]\n"
+            "                 [--resources DIR] [--output FILE.bmp] [--golden FILE.png]\n"
+            "--golden compares the last frame with the lossless image and fails\n"
+            "if any pixel differs, the frame is the same with any number of threads\n";
+}
+
+/* parse_options */
+static bool parse_options( int argc, char **argv, options &opt ) {
+    for( int i = 1; i < argc; i++ ) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if( !value ) {
+            return false;
+        }
+        if( std::strcmp( arg, "--frames" ) == 0 ) {
+            opt.frames = std::atoi( value );
+        } else if( std::strcmp( arg, "--size" ) == 0 ) {
+            if( std::sscanf( value, "%dx%d", &opt.width, &opt.height ) != 2 ) {
+                return false;
+            }
+        } else if( std::strcmp( arg, "--threads" ) == 0 ) {
+            opt.threads = std::atoi( value );
+        } else if( std::strcmp( arg, "--objects" ) == 0 ) {
+            opt.objects = std::atoi( value );
+        } else if( std::strcmp( arg, "--resources" ) == 0 ) {
+            opt.resources = value;
+        } else if( std::strcmp( arg, "--output" ) == 0 ) {
+            opt.output = value;
+        } else if( std::strcmp( arg, "--golden" ) == 0 ) {
+            opt.golden = value;
+        } else {
+            return false;
+        }
+        i++;
+    }
+    return opt.frames >= 0 && opt.threads >= 0 && opt.objects > 0 &&
+            opt.width > 0 && opt.width <= soft_rasterizer::MAX_SIZE &&
+            opt.height > 0 && opt.height <= soft_rasterizer::MAX_SIZE;
+}
+
+/* rand_float */
+static float rand_float( float min, float max ) {
+    float delta = max - min;
+    float rnd = (rand() / (float)RAND_MAX) * delta;
+    return min + rnd;
+}
+
+/* compare_golden
+* counts the different pixels of the RGB frame and the golden image */
+static bool compare_golden( const renderer::image &frame, const char *name ) {
+    renderer::image golden;
+    if( !golden.load_from_file( name, renderer::PIXEL_FORMAT_RGB8 ) ) {
+        common::error() << "cannot load " << name << std::endl;
+        return false;
+    }
+    if( golden.get_width() != frame.get_width() || golden.get_height() != frame.get_height() ) {
+        common::error() << "golden " << name << " is " << golden.get_width() << "x" << golden.get_height()
+                << ", the frame is " << frame.get_width() << "x" << frame.get_height() << std::endl;
+        return false;
+    }
+    int different = 0;
+    int maxDelta = 0;
+    for( int y = 0; y < frame.get_height(); y++ ) {
+        const byte *a = frame.get_line_ptr( y );
+        const byte *b = golden.get_line_ptr( y );
+        for( int x = 0; x < frame.get_width(); x++ ) {
+            int delta = 0;
+            for( int c = 0; c < 3; c++ ) {
+                int d = std::abs( a[x * 3 + c] - b[x * 3 + c] );
+                delta = d > delta ? d : delta;
+            }
+            different += delta ? 1 : 0;
+            maxDelta = delta > maxDelta ? delta : maxDelta;
+        }
+    }
+    if( different ) {
+        common::error() << "golden " << name << ": " << different << " pixels differ, max delta " << maxDelta << std::endl;
+        return false;
+    }
+    common::log() << "golden " << name << ": equal" << std::endl;
+    return true;
+}
+
+/* run
+* the instanced cubes of main.cpp rendered by the software rasterizer */
+static int run( const options &opt ) {
+    if( opt.resources ) {
+        filesystem::set_resources_dir( opt.resources );
+    }
+    jobs::job_system::initialize( opt.threads );
+
+    soft_rasterizer rasterizer( opt.width, opt.height );
+    renderer::image img;
+    if( img.load_from_file( "1234.png" ) ) {
+        rasterizer.bind_texture( rasterizer.create_texture( img ) );
+    } else {
+        common::error() << "texture 1234.png is not found in " << filesystem::get_resources_dir() << std::endl;
+    }
+    rasterizer.set_cull_face( true );
+
+    const draw_vertex vert[] {
+        {{-1.0, -1.0, -1.0},{0.0, 0.0}},
+        {{-1.0,  1.0, -1.0},{0.0, 1.0}},
+        {{ 1.0, -1.0, -1.0},{1.0, 0.0}},
+        {{ 1.0,  1.0, -1.0},{1.0, 1.0}},
+        {{ 1.0, -1.0,  1.0},{0.0, 0.0}},
+        {{ 1.0,  1.0,  1.0},{0.0, 1.0}},
+        {{-1.0, -1.0,  1.0},{1.0, 0.0}},
+        {{-1.0,  1.0,  1.0},{1.0, 1.0}}
+    };
+    unsigned char Indices[] = {
+        0,1,2,3,4,5,6,7,0xff,2,4,0,6,1,7,3,5
+    };
+    mesh cube(PRESENT_INDEX_8BITS);
+    for( const auto &v : vert ) {
+        cube.add_vertex( v );
+    }
+    for( auto i : Indices ) {
+        cube.add_index( i );
+    }
+    cube.add_present_drawing( 
+                PRIMITIVE_TYPE_TRIANGLE_STRIP, 
+                cube.get_indices_number(), 0 );
+
+    /* fixed seed, every run renders the same frames */
+    srand( 1 );
+    transform_pool locations;
+    core::vector<quat> spins( opt.objects );
+    locations.reserve( opt.objects );
+    for( int i = 0; i < opt.objects; i++ ) {
+        float s = rand_float(0.1, 4.0);
+        vec3 pos( rand_float(-500, 500), rand_float(-500, 500), rand_float(-500, 500) );
+        locations.add( pos, QUAT_ZERO, vec3(s,  s,  s) );
+        vec3 axis( rand_float(-500, 500), rand_float(-500, 500), rand_float(-500, 500) );
+        float del = rand_float(-500, 500);
+        if( del == 0 ) {
+            del = 100;
+        }
+        spins[i] = quat( axis, pi / del );
+    }
+
+    camera cam( vec3(0,0,0), vec3(0,1,0), vec3(0,0,1) );
+    cam.set_perspective_projection( pi / 3.0, static_cast<float>( opt.width ) / opt.height, 0.1, 1000 );
+    auto cubeBounds = cube.get_bounding_sphere();
+    core::vector<int> visible( opt.objects );
+    core::vector<int> visibleNumbers;
+    core::vector<mat4> instances( opt.objects );
+    int visibleNumber = 0;
+
+    headless_loop loop( opt.frames, 1.0f / 60.0f );
+    loop.run( [&]( int frame, float dt ) {
+        (void)frame;
+        (void)dt;
+        /* the same culling as the windowed loop */
+        const int grain = 1024;
+        auto viewProj = cam();
+        frustum view( viewProj );
+        visibleNumbers.assign( (locations.size() + grain - 1) / grain, 0 );
+        jobs::parallel_for( 0, locations.size(), grain, [&]( int begin, int end ) {
+            locations.update_world_range( begin, end );
+            visibleNumbers[begin / grain] = locations.cull( view, cubeBounds, begin, end, &visible[begin] );
+        } );
+        visibleNumber = 0;
+        for( int i = 0; i < static_cast<int>( visibleNumbers.size() ); i++ ) {
+            std::copy_n( &visible[i * grain], visibleNumbers[i], &visible[visibleNumber] );
+            visibleNumber += visibleNumbers[i];
+        }
+        jobs::parallel_for( 0, visibleNumber, grain, [&]( int begin, int end ) {
+            for( int i = begin; i < end; i++ ) {
+                instances[i] = viewProj * locations.get_world( visible[i] );
+            }
+        } );
+        rasterizer.clear( vec4( 0.0f, 0.0f, 0.0f, 1.0f ) );
+        rasterizer.draw_mesh_instanced( cube, instances.data(), visibleNumber );
+        rasterizer.flush();
+        locations.rotate_all( spins.data() );
+        return true;
+    } );
+
+    const auto &frames = loop.get_statistics();
+    const auto &raster = rasterizer.get_statistics();
+    common::log() << "frames: " << frames.frames << " threads: " << jobs::job_system::get_threads_number()
+            << " size: " << opt.width << "x" << opt.height << "\n"
+            << "frame msec avg: " << loop.get_average_msec() << " min: " << frames.minMsec
+            << " max: " << frames.maxMsec << "\n"
+            << "last frame visible: " << visibleNumber << " triangles: " << raster.triangles
+            << " culled: " << raster.culled << " clipped: " << raster.clipped
+            << " rasterized: " << raster.rasterized << " binned: " << raster.binned << std::endl;
+
+    int result = 0;
+    if( (opt.output || opt.golden) && frames.frames > 0 ) {
+        renderer::image frame;
+        rasterizer.read_pixels( frame, renderer::PIXEL_FORMAT_RGB8 );
+        if( opt.output && !frame.save_to_file( opt.output, 100 ) ) {
+            common::error() << "cannot save " << opt.output << std::endl;
+            result = 1;
+        }
+        if( opt.golden && !compare_golden( frame, opt.golden ) ) {
+            result = 1;
+        }
+    }
+    jobs::job_system::shutdown();
+    return result;
+}
+
+} /* namespace engine */
+
+int main( int argc, char **argv ) {
+    engine::options opt;
+    if( !engine::parse_options( argc, argv, opt ) ) {
+        engine::print_usage();
+        return 1;
+    }
+    return engine::run( opt );
+}
@@ -0,0 +1,1904 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <core/string.hpp>
+#include <core/vector.hpp>
+#include <core/timer.hpp>
+#include <core/filesystem.hpp>
+#include <core/mapped_file.hpp>
+#include <core/jobs.hpp>
+#include <core/common.hpp>
+#include <renderer/image.h>
+#include <renderer/pixel_convert.h>
+#include <renderer/mip_chain.h>
+#include <renderer/texture_file.h>
+extern "C" {
+#include <jpeg-6b/jpeglib.h>
+#include <jpeg-6b/jdatarw.h>
+#include <lpng1637/png.h>
+}
+
+using namespace engine::core;
+
+namespace engine {
+
+/* command line options */
+struct options {
+    int             loads{10};          /* decodes of every file */
+    int             threads{0};         /* 0 - one per core */
+    bool            pngFilters{false};  /* the PNG files are saved with every row filter */
+    bool            convert{false};     /* the row conversions of the pixel formats, no files */
+    bool            tga{false};         /* the RLE TGA writer, no files */
+    bool            pngRoundtrip{false};    /* the PNG writer through the PNG reader, no files */
+    bool            mips{false};        /* the mip chain filters, no files */
+    bool            jpegSimd{false};    /* the SIMD decodes of libjpeg, the files are optional */
+    bool            decode{false};      /* image::decode() against the loads, no files */
+    bool            decoder{false};     /* image_decoder against the loads, the files are optional */
+    bool            jpegBatch{false};   /* the batches of load_jpg_files and save_jpg_files, no files */
+    core::vector<const char*>   files;
+};
+
+/* print_usage */
+static void print_usage() {
+    common::log() << "usage: _image_bench [--loads N] [--threads N] FILE...\n"
+            "       _image_bench [--loads N] [--threads N] --png-filters [FILE...]\n"
+            "       _image_bench [--loads N] --convert\n"
+            "       _image_bench [--loads N] --tga\n"
+            "       _image_bench [--threads N] --png-roundtrip\n"
+            "       _image_bench [--loads N] [--threads N] --mips\n"
+            "       _image_bench [--loads N] --jpeg-simd [FILE...]\n"
+            "       _image_bench --decode\n"
+            "       _image_bench --decoder [FILE...]\n"
+            "       _image_bench [--threads N] --jpeg-batch\n"
+            "decodes every image from memory N times and prints the throughput,\n"
+            "--png-filters saves the generated images and every image as PNG\n"
+            "with each row filter, decodes them by the portable, SSE2, SSSE3 and\n"
+            "dispatched filters of libpng, the pixels must be equal, prints the\n"
+            "encode time and the decode times per filter,\n"
+            "--convert checks every row conversion of the pixel formats against\n"
+            "the conversion of single pixels and prints its throughput,\n"
+            "--tga checks the RLE TGA files against the packets of the pixel\n"
+            "by pixel encoder and the decoded pixels, prints the write time,\n"
+            "--png-roundtrip saves the images with each row filter, by one\n"
+            "stream and by the parallel strips, the loaded pixels must be equal,\n"
+            "--mips checks the box and Kaiser mip chains against the filters\n"
+            "computed in double and prints the time of the 4096x4096 chains,\n"
+            "--jpeg-simd decodes the sample JPEGs and the files by the portable\n"
+            "code, without AVX2 and by all SIMD of libjpeg, the pixels must be\n"
+            "equal, prints the decode time of the files,\n"
+            "--decode decodes the generated PNG, TGA, BMP, TEX and JPEG files\n"
+            "to the padded and flipped targets, the rows must be the loaded ones,\n"
+            "--decoder pushes the generated PNG and JPEG files and the files by\n"
+            "random chunks to image_decoder under the row and time budgets, the\n"
+            "completed rows must be the loaded ones,\n"
+            "--jpeg-batch saves and loads the batches of JPEG files with the\n"
+            "corrupt files between the valid ones, every item must be the single\n"
+            "save or load.\n"
+            "the paths are relative to the current directory\n";
+}
+
+/* parse_options */
+static bool parse_options( int argc, char **argv, options &opt ) {
+    int i = 1;
+    for( ; i < argc && argv[i][0] == '-'; i++ ) {
+        if( std::strcmp( argv[i], "--png-filters" ) == 0 ) {
+            opt.pngFilters = true;
+            continue;
+        }
+        if( std::strcmp( argv[i], "--convert" ) == 0 ) {
+            opt.convert = true;
+            continue;
+        }
+        if( std::strcmp( argv[i], "--tga" ) == 0 ) {
+            opt.tga = true;
+            continue;
+        }
+        if( std::strcmp( argv[i], "--png-roundtrip" ) == 0 ) {
+            opt.pngRoundtrip = true;
+            continue;
+        }
+        if( std::strcmp( argv[i], "--mips" ) == 0 ) {
+            opt.mips = true;
+            continue;
+        }
+        if( std::strcmp( argv[i], "--jpeg-simd" ) == 0 ) {
+            opt.jpegSimd = true;
+            continue;
+        }
+        if( std::strcmp( argv[i], "--decode" ) == 0 ) {
+            opt.decode = true;
+            continue;
+        }
+        if( std::strcmp( argv[i], "--decoder" ) == 0 ) {
+            opt.decoder = true;
+            continue;
+        }
+        if( std::strcmp( argv[i], "--jpeg-batch" ) == 0 ) {
+            opt.jpegBatch = true;
+            continue;
+        }
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if( !value ) {
+            return false;
+        }
+        if( std::strcmp( argv[i], "--loads" ) == 0 ) {
+            opt.loads = std::atoi( value );
+        } else if( std::strcmp( argv[i], "--threads" ) == 0 ) {
+            opt.threads = std::atoi( value );
+        } else {
+            return false;
+        }
+        i++;
+    }
+    for( ; i < argc; i++ ) {
+        opt.files.push_back( argv[i] );
+    }
+    return opt.loads > 0 && opt.threads >= 0 && (!opt.files.empty() || opt.pngFilters || opt.convert || opt.tga || opt.pngRoundtrip || opt.mips || opt.jpegSimd ||
+            opt.decode || opt.decoder || opt.jpegBatch);
+}
+
+/* bench
+* the file is mapped and read once, the decode does not wait for the disk.
+* The throughput is in megapixels, in bytes of the decoded pixels and
+* in bytes of the file */
+static bool bench( const options &opt ) {
+    core::timer tm;
+    double totalMsec = 0.0;
+    double totalPixels = 0.0;
+    double totalPixelBytes = 0.0;
+    double totalFileBytes = 0.0;
+    bool succeeded = true;
+    for( const char *name : opt.files ) {
+        mapped_file file( filesystem::open_mapped( name ) );
+        if( !file.is_open() ) {
+            common::error() << "cannot open " << name << std::endl;
+            succeeded = false;
+            continue;
+        }
+        core::vector<byte> data( file.data(), file.data() + file.size() );
+        double msec = 0.0;
+        int width = 0;
+        int height = 0;
+        int bpp = 0;
+        for( int i = 0; i < opt.loads; i++ ) {
+            renderer::image img;
+            tm.start();
+            bool loaded = img.load_from_memory( data.data(), data.size() );
+            msec += tm.get_elapsed_msec();
+            if( !loaded ) {
+                common::error() << "cannot decode " << name << std::endl;
+                succeeded = false;
+                break;
+            }
+            width = img.get_width();
+            height = img.get_height();
+            bpp = img.get_bpp();
+        }
+        if( bpp == 0 ) {
+            continue;
+        }
+        double avgMsec = msec / opt.loads;
+        double pixels = static_cast<double>( width ) * height;
+        double pixelBytes = pixels * bpp / 8;
+        common::log() << name << ": " << width << "x" << height << "x" << bpp << ", " << avgMsec << " ms, "
+                << pixels / (avgMsec * 1000.0) << " Mpx/s, "
+                << pixelBytes / (avgMsec * 1000.0) << " MB/s pixels, "
+                << data.size() / (avgMsec * 1000.0) << " MB/s file" << std::endl;
+        totalMsec += avgMsec;
+        totalPixels += pixels;
+        totalPixelBytes += pixelBytes;
+        totalFileBytes += data.size();
+    }
+    if( opt.files.size() > 1 && totalMsec > 0.0 ) {
+        common::log() << "total: " << totalMsec << " ms, "
+                << totalPixels / (totalMsec * 1000.0) << " Mpx/s, "
+                << totalPixelBytes / (totalMsec * 1000.0) << " MB/s pixels, "
+                << totalFileBytes / (totalMsec * 1000.0) << " MB/s file" << std::endl;
+    }
+    return succeeded;
+}
+
+/* the row filters of PNG */
+static const struct {
+    const char *                name;
+    renderer::png_row_filter    filter;
+} pngFilters[] = {
+    { "none", renderer::PNG_ROW_FILTER_NONE },
+    { "sub", renderer::PNG_ROW_FILTER_SUB },
+    { "up", renderer::PNG_ROW_FILTER_UP },
+    { "average", renderer::PNG_ROW_FILTER_AVERAGE },
+    { "paeth", renderer::PNG_ROW_FILTER_PAETH },
+    { "adaptive", renderer::PNG_ROW_FILTER_ADAPTIVE },
+    { "adaptive fast", renderer::PNG_ROW_FILTER_ADAPTIVE_FAST }
+};
+
+/* the channels of the pixel formats, -1 - no channel */
+struct format_layout {
+    renderer::pixel_format  fmt;
+    const char *            name;
+    int                     size;
+    int                     r, g, b, a;
+};
+static const format_layout layouts[] = {
+    { renderer::PIXEL_FORMAT_GRAY8, "gray8", 1, 0, 0, 0, -1 },
+    { renderer::PIXEL_FORMAT_BGR8, "bgr8", 3, 2, 1, 0, -1 },
+    { renderer::PIXEL_FORMAT_BGRA8, "bgra8", 4, 2, 1, 0, 3 },
+    { renderer::PIXEL_FORMAT_RGB8, "rgb8", 3, 0, 1, 2, -1 },
+    { renderer::PIXEL_FORMAT_RGBA8, "rgba8", 4, 0, 1, 2, 3 }
+};
+
+/* convert_pixels
+* the reference conversion pixel by pixel, see renderer/pixel_convert.h */
+static void convert_pixels( const format_layout &from, const format_layout &to, const byte *src, byte *dst, int count ) {
+    for( int i = 0; i < count; i++, src += from.size, dst += to.size ) {
+        int r = src[from.r];
+        int g = src[from.g];
+        int b = src[from.b];
+        int a = from.a >= 0 ? src[from.a] : 0;
+        if( to.size == 1 ) {
+            dst[0] = static_cast<byte>( from.size == 1 ? r : (r + g + b) / 3 );
+            continue;
+        }
+        dst[to.r] = static_cast<byte>( r );
+        dst[to.g] = static_cast<byte>( g );
+        dst[to.b] = static_cast<byte>( b );
+        if( to.a >= 0 ) {
+            dst[to.a] = static_cast<byte>( a );
+        }
+    }
+}
+
+/* bench_convert
+* every conversion is checked on the rows of 0..64 pixels at all
+* offsets of the source, which covers the tails of the vector loops,
+* and on a row of 1M pixels, whose conversion is timed. The throughput
+* counts the read and the written bytes */
+static bool bench_convert( const options &opt ) {
+    const int rowPixels = 1 << 20;
+    core::vector<byte> src( rowPixels * 4 + 64 );
+    core::vector<byte> dst( rowPixels * 4 + 64 );
+    core::vector<byte> expected( rowPixels * 4 + 64 );
+    unsigned seed = 1;
+    for( auto &b : src ) {
+        seed = seed * 1103515245u + 12345u;
+        b = static_cast<byte>( seed >> 16 );
+    }
+    core::timer tm;
+    bool succeeded = true;
+    for( const auto &from : layouts ) {
+        for( const auto &to : layouts ) {
+            auto convert = renderer::get_convert_row_func( from.fmt, to.fmt );
+            bool equal = true;
+            for( int count = 0; count <= 64 && equal; count++ ) {
+                for( int offset = 0; offset < 16 && equal; offset++ ) {
+                    /* the bytes after the row must not be written */
+                    std::memset( dst.data(), 0xcd, count * to.size + 16 );
+                    std::memset( expected.data(), 0xcd, count * to.size + 16 );
+                    convert( src.data() + offset, dst.data(), count );
+                    convert_pixels( from, to, src.data() + offset, expected.data(), count );
+                    equal = std::memcmp( dst.data(), expected.data(), count * to.size + 16 ) == 0;
+                }
+            }
+            double msec = 0.0;
+            for( int i = 0; i < opt.loads; i++ ) {
+                tm.start();
+                convert( src.data(), dst.data(), rowPixels );
+                msec += tm.get_elapsed_msec();
+            }
+            convert_pixels( from, to, src.data(), expected.data(), rowPixels );
+            equal = equal && std::memcmp( dst.data(), expected.data(), static_cast<size_t>( rowPixels ) * to.size ) == 0;
+            double bytes = static_cast<double>( rowPixels ) * (from.size + to.size);
+            common::log() << from.name << " -> " << to.name << ": " << bytes / (msec / opt.loads * 1.0e6)
+                    << " GB/s" << (equal ? "" : ", DIFFERS from the pixel conversion") << std::endl;
+            succeeded = succeeded && equal;
+        }
+    }
+    return succeeded;
+}
+
+/* make_tga_image
+* the pixels go as in the TGA file, from the bottom line, the runs of
+* 1..3 and 127..129 equal pixels and the noise of the close values
+* cross the line ends */
+static void make_tga_image( renderer::image &img, int width, int height, renderer::pixel_format fmt, unsigned seed ) {
+    static const int runs[] = { 1, 2, 3, 127, 128, 129, 200 };
+    img.reserve( width, height, fmt );
+    const int pxSize = img.get_bpp() >> 3;
+    byte run[4] = {};
+    int left = 0;
+    bool noise = false;
+    for( int j = 0; j < width * height; j++ ) {
+        if( left == 0 ) {
+            seed = seed * 1103515245u + 12345u;
+            noise = (seed >> 16) & 1;
+            left = noise ? 1 + ((seed >> 17) & 255) : runs[(seed >> 18) % 7];
+            for( auto &c : run ) {
+                seed = seed * 1103515245u + 12345u;
+                c = static_cast<byte>( seed >> 16 );
+            }
+        }
+        byte *px = img.get_line_ptr( height - 1 - j / width ) + (j % width) * pxSize;
+        for( int c = 0; c < pxSize; c++ ) {
+            seed = seed * 1103515245u + 12345u;
+            px[c] = noise ? static_cast<byte>( run[c] + ((seed >> 16) & 15) ) : run[c];
+        }
+        left--;
+    }
+}
+
+/* is_tga_match */
+static bool is_tga_match( const byte *a, const byte *b, int pxSize, int compress ) {
+    for( int c = 0; c < pxSize; c++ ) {
+        if( std::abs( a[c] - b[c] ) > compress ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* write_tga_rle
+* the reference of the RLE writer of image.cpp pixel by pixel, returns
+* the packets without the header */
+static core::vector<byte> write_tga_rle( const renderer::image &img, const format_layout &from, const format_layout &to, int compress ) {
+    const int width = img.get_width();
+    const int height = img.get_height();
+    const int count = width * height;
+    auto pixel = [&]( int j ) {
+        return img.get_line_ptr( height - 1 - j / width ) + (j % width) * from.size;
+    };
+    core::vector<byte> packets;
+    byte converted[4];
+    for( int j = 0; j < count; ) {
+        int limit = std::min( count - j, 128 );
+        int k = 1;
+        while( k < limit && is_tga_match( pixel( j ), pixel( j + k ), from.size, compress ) ) {
+            k++;
+        }
+        if( k > 1 ) {
+            packets.push_back( static_cast<byte>( 0x80 | (k - 1) ) );
+            convert_pixels( from, to, pixel( j ), converted, 1 );
+            packets.insert( packets.end(), converted, converted + to.size );
+        } else {
+            while( k < limit && !is_tga_match( pixel( j + k - 1 ), pixel( j + k ), from.size, compress ) ) {
+                k++;
+            }
+            packets.push_back( static_cast<byte>( k - 1 ) );
+            for( int i = 0; i < k; i++ ) {
+                convert_pixels( from, to, pixel( j + i ), converted, 1 );
+                packets.insert( packets.end(), converted, converted + to.size );
+            }
+        }
+        j += k;
+    }
+    return packets;
+}
+
+/* check_tga
+* saves img as the RLE TGA, the packets must be those of the reference
+* writer, the decoded pixels differ at most by compress */
+static bool check_tga( renderer::image &img, const format_layout &from, const format_layout &to, int quality, const char *tempName ) {
+    int compress = (100 - quality) / 10;
+    if( !img.save_to_file( tempName, quality ) ) {
+        common::error() << "cannot save " << tempName << std::endl;
+        return false;
+    }
+    mapped_file file( filesystem::open_mapped( tempName ) );
+    if( !file.is_open() || file.size() < 18 ) {
+        common::error() << "cannot open " << tempName << std::endl;
+        return false;
+    }
+    auto expected = write_tga_rle( img, from, to, compress );
+    if( file.size() - 18 != expected.size() || std::memcmp( file.data() + 18, expected.data(), expected.size() ) != 0 ) {
+        common::error() << from.name << " " << img.get_width() << "x" << img.get_height() << ", compress "
+                << compress << ": the packets differ from the reference writer" << std::endl;
+        return false;
+    }
+    file.close();
+    renderer::image loaded;
+    if( !loaded.load_from_file( tempName, from.fmt ) || loaded.get_width() != img.get_width()
+            || loaded.get_height() != img.get_height() ) {
+        common::error() << "cannot load " << tempName << std::endl;
+        return false;
+    }
+    for( int y = 0; y < img.get_height(); y++ ) {
+        for( int x = 0; x < img.get_width(); x++ ) {
+            const byte *a = img.get_line_ptr( y ) + x * from.size;
+            const byte *b = loaded.get_line_ptr( y ) + x * from.size;
+            if( !is_tga_match( a, b, from.size, compress ) ) {
+                common::error() << from.name << " " << img.get_width() << "x" << img.get_height() << ", compress "
+                        << compress << ": the pixel " << x << ", " << y << " differs" << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* bench_tga
+* the writer is checked on the narrow and wide images, whose runs and
+* raw packets end at the 128 pixels limit and at the line ends. The
+* files are written to the current directory and removed */
+static bool bench_tga( const options &opt ) {
+    static const char * const TEMP_NAME = "_image_bench.tga";
+    /* the source formats and the formats of the file */
+    static const struct {
+        int     from;
+        int     to;
+    } formats[] = {
+        { 0, 0 },       /* gray8 */
+        { 1, 1 },       /* bgr8 */
+        { 2, 2 },       /* bgra8 */
+        { 3, 1 },       /* rgb8 to bgr8 */
+        { 4, 2 }        /* rgba8 to bgra8 */
+    };
+    static const int sizes[][2] = { { 1, 300 }, { 7, 60 }, { 127, 5 }, { 128, 5 }, { 129, 5 }, { 300, 7 } };
+    bool succeeded = true;
+    unsigned seed = 1;
+    for( const auto &f : formats ) {
+        const auto &from = layouts[f.from];
+        const auto &to = layouts[f.to];
+        for( const auto &size : sizes ) {
+            renderer::image img;
+            make_tga_image( img, size[0], size[1], from.fmt, seed++ );
+            /* lossless and compress 5 */
+            succeeded = check_tga( img, from, to, 95, TEMP_NAME ) && succeeded;
+            succeeded = check_tga( img, from, to, 50, TEMP_NAME ) && succeeded;
+        }
+
+        /* the write time */
+        renderer::image img;
+        make_tga_image( img, 2048, 2048, from.fmt, seed++ );
+        core::timer tm;
+        double msec = 0.0;
+        for( int i = 0; i < opt.loads; i++ ) {
+            tm.start();
+            bool saved = img.save_to_file( TEMP_NAME, 95 );
+            msec += tm.get_elapsed_msec();
+            if( !saved ) {
+                common::error() << "cannot save " << TEMP_NAME << std::endl;
+                succeeded = false;
+                break;
+            }
+        }
+        double pixelBytes = 2048.0 * 2048.0 * from.size;
+        common::log() << from.name << " 2048x2048: write " << msec / opt.loads << " ms, "
+                << pixelBytes / (msec / opt.loads * 1000.0) << " MB/s pixels" << std::endl;
+    }
+    std::remove( TEMP_NAME );
+    return succeeded;
+}
+
+/* make_png_image
+* the gradients, which the filters predict, and the noise lines */
+static void make_png_image( renderer::image &img, int width, int height, renderer::pixel_format fmt, unsigned seed ) {
+    img.reserve( width, height, fmt );
+    const int pxSize = img.get_bpp() >> 3;
+    for( int y = 0; y < height; y++ ) {
+        byte *row = img.get_line_ptr( y );
+        bool noise = y % 5 == 4;
+        for( int i = 0; i < width * pxSize; i++ ) {
+            seed = seed * 1103515245u + 12345u;
+            int value = noise ? (seed >> 16) : (i * 3 + y * 5 + ((seed >> 16) & 7));
+            row[i] = static_cast<byte>( value );
+        }
+    }
+}
+
+/* bench_png_roundtrip
+* every format is saved with each row filter by one stream and by the
+* parallel strips, the image of 600x500 has several strips with the
+* shorter last one. The file is written to the current directory and
+* removed */
+static bool bench_png_roundtrip( const options &opt ) {
+    static const char * const TEMP_NAME = "_image_bench.png";
+    static const int sizes[][2] = { { 1, 1 }, { 3, 17 }, { 61, 33 }, { 600, 500 } };
+    bool succeeded = true;
+    unsigned seed = 1;
+    for( const auto &fmt : layouts ) {
+        bool equalFormat = true;
+        for( const auto &size : sizes ) {
+            renderer::image img;
+            make_png_image( img, size[0], size[1], fmt.fmt, seed++ );
+            for( const auto &f : pngFilters ) {
+                for( bool parallel : { false, true } ) {
+                    renderer::png_save_params params;
+                    params.filter = f.filter;
+                    params.parallel = parallel;
+                    renderer::image loaded;
+                    bool equal = img.save_png_to_file( TEMP_NAME, params ) && loaded.load_from_file( TEMP_NAME, fmt.fmt )
+                            && loaded.get_width() == size[0] && loaded.get_height() == size[1];
+                    for( int y = 0; y < size[1] && equal; y++ ) {
+                        equal = std::memcmp( img.get_line_ptr( y ), loaded.get_line_ptr( y ), size[0] * fmt.size ) == 0;
+                    }
+                    if( !equal ) {
+                        common::error() << fmt.name << " " << size[0] << "x" << size[1] << ", " << f.name
+                                << (parallel ? ", parallel" : "") << ": the loaded image differs" << std::endl;
+                        equalFormat = false;
+                    }
+                }
+            }
+        }
+        common::log() << fmt.name << ": " << (equalFormat ? "equal" : "DIFFERS") << std::endl;
+        succeeded = succeeded && equalFormat;
+    }
+    std::remove( TEMP_NAME );
+    return succeeded;
+}
+
+/* the filters of the mip chains */
+static const struct {
+    const char *            name;
+    renderer::mip_filter    filter;
+    bool                    srgb;
+} mipFilters[] = {
+    { "box", renderer::MIP_FILTER_BOX, false },
+    { "box srgb", renderer::MIP_FILTER_BOX, true },
+    { "kaiser", renderer::MIP_FILTER_KAISER, false },
+    { "kaiser srgb", renderer::MIP_FILTER_KAISER, true }
+};
+
+/* to_linear */
+static double to_linear( int value ) {
+    double c = value / 255.0;
+    return c <= 0.04045 ? c / 12.92 : std::pow( (c + 0.055) / 1.055, 2.4 );
+}
+
+/* from_linear */
+static int from_linear( double value ) {
+    double c = value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow( value, 1.0 / 2.4 ) - 0.055;
+    return static_cast<int>( std::max( 0.0, std::min( c * 255.0 + 0.5, 255.0 ) ) );
+}
+
+/* filter_mip_pixel
+* one channel of the pixel x, y of the next level, the box averages
+* 2x2 pixels, the Kaiser windowed sinc (alpha 4) weights 8x8 pixels from
+* 2x - 3. The pixels out of the level are clamped to the edges */
+static int filter_mip_pixel( const byte *src, int width, int height, int pxSize, int x, int y, int c,
+        renderer::mip_filter filter, bool srgb, bool alpha ) {
+    const double pi = 3.14159265358979323846;
+    auto bessel_i0 = []( double x ) {
+        double sum = 1.0;
+        double term = 1.0;
+        for( int k = 1; k < 32; k++ ) {
+            term *= (x * 0.5 / k) * (x * 0.5 / k);
+            sum += term;
+        }
+        return sum;
+    };
+    int taps = 2;
+    int first = 0;
+    double weights[8] = { 0.5, 0.5 };
+    if( filter == renderer::MIP_FILTER_KAISER ) {
+        taps = 8;
+        first = -3;
+        double sum = 0.0;
+        for( int k = 0; k < taps; k++ ) {
+            double t = k + first - 0.5;
+            double u = t / 4.0;
+            weights[k] = std::sin( pi * t * 0.5 ) / (pi * t * 0.5) * bessel_i0( 4.0 * std::sqrt( 1.0 - u * u ) ) / bessel_i0( 4.0 );
+            sum += weights[k];
+        }
+        for( auto &w : weights ) {
+            w /= sum;
+        }
+    }
+    bool linear = srgb && !alpha;
+    double sum = 0.0;
+    for( int j = 0; j < taps; j++ ) {
+        int sy = std::max( 0, std::min( 2 * y + first + j, height - 1 ) );
+        for( int i = 0; i < taps; i++ ) {
+            int sx = std::max( 0, std::min( 2 * x + first + i, width - 1 ) );
+            int value = src[(static_cast<size_t>( sy ) * width + sx) * pxSize + c];
+            sum += weights[j] * weights[i] * (linear ? to_linear( value ) : value);
+        }
+    }
+    return linear ? from_linear( sum ) : static_cast<int>( std::max( 0.0, std::min( sum + 0.5, 255.0 ) ) );
+}
+
+/* check_mips
+* every level is compared with the filter of the level above it, the
+* box without sRGB is exact, the others differ at most by 1 */
+static bool check_mips( const renderer::mip_chain &mips, const format_layout &fmt, renderer::mip_filter filter, bool srgb ) {
+    int tolerance = filter == renderer::MIP_FILTER_BOX && !srgb ? 0 : 1;
+    for( int level = 1; level < mips.get_levels_number(); level++ ) {
+        const byte *src = mips.get_level_ptr( level - 1 );
+        const byte *dst = mips.get_level_ptr( level );
+        for( int y = 0; y < mips.get_height( level ); y++ ) {
+            for( int x = 0; x < mips.get_width( level ); x++ ) {
+                for( int c = 0; c < fmt.size; c++ ) {
+                    int expected = filter_mip_pixel( src, mips.get_width( level - 1 ), mips.get_height( level - 1 ),
+                            fmt.size, x, y, c, filter, srgb, c == fmt.a );
+                    int value = dst[(static_cast<size_t>( y ) * mips.get_width( level ) + x) * fmt.size + c];
+                    if( std::abs( value - expected ) > tolerance ) {
+                        common::error() << "level " << level << ", pixel " << x << ", " << y << ", channel " << c
+                                << ": " << value << ", expected " << expected << std::endl;
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/* make_mip_image
+* the gradients and the noise */
+static void make_mip_image( renderer::image &img, int width, int height, renderer::pixel_format fmt, unsigned seed ) {
+    img.reserve( width, height, fmt );
+    const int pxSize = img.get_bpp() >> 3;
+    for( int y = 0; y < height; y++ ) {
+        byte *row = img.get_line_ptr( y );
+        for( int i = 0; i < width * pxSize; i++ ) {
+            seed = seed * 1103515245u + 12345u;
+            row[i] = static_cast<byte>( y & 8 ? (seed >> 16) : i + y * 3 );
+        }
+    }
+}
+
+/* bench_mips
+* the filters are checked on the odd, thin and square sizes of every
+* pixel format, then the chains of 4096x4096 RGBA8 and GRAY8 are timed */
+static bool bench_mips( const options &opt ) {
+    static const int sizes[][2] = { { 1, 9 }, { 37, 23 }, { 64, 64 }, { 300, 2 } };
+    bool succeeded = true;
+    unsigned seed = 1;
+    for( const auto &fmt : layouts ) {
+        bool equalFormat = true;
+        for( const auto &size : sizes ) {
+            renderer::image img;
+            make_mip_image( img, size[0], size[1], fmt.fmt, seed++ );
+            for( const auto &f : mipFilters ) {
+                renderer::mip_chain mips;
+                if( !mips.generate( img, f.filter, f.srgb ) || !check_mips( mips, fmt, f.filter, f.srgb ) ) {
+                    common::error() << fmt.name << " " << size[0] << "x" << size[1] << ", " << f.name
+                            << ": the levels differ from the filter" << std::endl;
+                    equalFormat = false;
+                }
+            }
+        }
+        common::log() << fmt.name << ": " << (equalFormat ? "equal" : "DIFFERS") << std::endl;
+        succeeded = succeeded && equalFormat;
+    }
+
+    core::timer tm;
+    for( auto fmt : { renderer::PIXEL_FORMAT_RGBA8, renderer::PIXEL_FORMAT_GRAY8 } ) {
+        renderer::image img;
+        make_mip_image( img, 4096, 4096, fmt, seed++ );
+        for( const auto &f : mipFilters ) {
+            renderer::mip_chain mips;
+            double msec = 0.0;
+            for( int i = 0; i < opt.loads; i++ ) {
+                tm.start();
+                mips.generate( img, f.filter, f.srgb );
+                msec += tm.get_elapsed_msec();
+            }
+            common::log() << "4096x4096x" << img.get_bpp() << ", " << f.name << ": " << mips.get_levels_number()
+                    << " levels, " << msec / opt.loads << " ms" << std::endl;
+        }
+    }
+    return succeeded;
+}
+
+/* the code paths of libjpeg, see JSIMD_FORCENONE and JSIMD_FORCESSE41
+* in jpeg-6b/jsimd.c. The first one is the reference */
+static const struct {
+    const char *    name;
+    const char *    forceNone;
+    const char *    forceSse41;
+} jsimdLevels[] = {
+    { "portable", "1", "" },
+    { "no avx2", "", "1" },
+    { "simd", "", "" }
+};
+
+/* the samplings of the sample JPEGs, the factors of the luma,
+* the chroma is not subsampled */
+static const struct {
+    const char *    name;
+    J_COLOR_SPACE   space;
+    int             h;
+    int             v;
+    bool            progressive;
+} jpegSamplings[] = {
+    { "4:4:4", JCS_YCbCr, 1, 1, false },
+    { "4:2:2", JCS_YCbCr, 2, 1, false },
+    { "4:2:0", JCS_YCbCr, 2, 2, false },
+    { "4:4:0", JCS_YCbCr, 1, 2, false },
+    { "4:2:0 progressive", JCS_YCbCr, 2, 2, true },
+    { "gray", JCS_GRAYSCALE, 1, 1, false }
+};
+
+/* the IDCTs and the scales of the decodes */
+static const struct {
+    const char *    name;
+    bool            fastDct;
+    int             scale;
+} jpegDecodes[] = {
+    { "islow", false, 1 },
+    { "ifast", true, 1 },
+    { "islow 1/2", false, 2 },
+    { "ifast 1/2", true, 2 }
+};
+
+/* set_env
+* the empty value turns the variable off */
+static void set_env( const char *name, const char *value ) {
+#ifdef _WIN32
+    _putenv_s( name, value );
+#else
+    setenv( name, value, 1 );
+#endif
+}
+
+/* the code paths of libpng, see PNG_SIMD_FORCENONE in
+* lpng1637/intel/intel_init.c. The first one is the reference, the
+* SSSE3 Paeth runs also on the hosts of SSE4.1 */
+static const struct {
+    const char *    name;
+    const char *    forceNone;
+    const char *    forceSse2;
+    const char *    forceSsse3;
+} pngSimdLevels[] = {
+    { "portable", "1", "", "" },
+    { "sse2", "", "1", "" },
+    { "ssse3", "", "", "1" },
+    { "dispatched", "", "", "" }
+};
+static const int PNG_SIMD_LEVELS_NUMBER = sizeof( pngSimdLevels ) / sizeof( pngSimdLevels[0] );
+
+/* check_png_simd
+* the PNG is decoded by each code path loads times, the time of each one
+* is added to msec. The unfiltered rows must equal the portable ones */
+static bool check_png_simd( const std::string &name, const core::vector<byte> &data, int loads, double *msec ) {
+    core::timer tm;
+    renderer::image reference;
+    bool equal = true;
+    for( int level = 0; level < PNG_SIMD_LEVELS_NUMBER; level++ ) {
+        set_env( "PNG_SIMD_FORCENONE", pngSimdLevels[level].forceNone );
+        set_env( "PNG_SIMD_FORCESSE2", pngSimdLevels[level].forceSse2 );
+        set_env( "PNG_SIMD_FORCESSSE3", pngSimdLevels[level].forceSsse3 );
+        renderer::image decoded;
+        renderer::image &target = level == 0 ? reference : decoded;
+        for( int i = 0; i < loads; i++ ) {
+            target.release();
+            tm.start();
+            bool loaded = target.load_from_memory( data.data(), data.size() );
+            msec[level] += tm.get_elapsed_msec();
+            if( !loaded ) {
+                common::error() << name << ": cannot decode by " << pngSimdLevels[level].name << std::endl;
+                equal = false;
+                break;
+            }
+        }
+        if( !equal ) {
+            break;
+        }
+        if( level == 0 ) {
+            continue;
+        }
+        bool same = decoded.get_width() == reference.get_width() && decoded.get_height() == reference.get_height() &&
+                decoded.get_pixel_format() == reference.get_pixel_format();
+        for( int y = 0; y < reference.get_height() && same; y++ ) {
+            same = std::memcmp( decoded.get_line_ptr( y ), reference.get_line_ptr( y ), reference.get_width() * (reference.get_bpp() >> 3) ) == 0;
+        }
+        if( !same ) {
+            common::error() << name << ": " << pngSimdLevels[level].name << " differs from " << pngSimdLevels[0].name << std::endl;
+            equal = false;
+        }
+    }
+    set_env( "PNG_SIMD_FORCENONE", "" );
+    set_env( "PNG_SIMD_FORCESSE2", "" );
+    set_env( "PNG_SIMD_FORCESSSE3", "" );
+    return equal;
+}
+
+/* check_png_filters
+* the image is saved with one row filter for all rows, so the time of
+* the unfiltering of each filter is seen, by each code path of libpng
+* side by side. The file is written to the current directory */
+static bool check_png_filters( const std::string &name, renderer::image &img, const char *tempName, int loads, bool printTimes ) {
+    core::timer tm;
+    if( printTimes ) {
+        common::log() << name << ": " << img.get_width() << "x" << img.get_height() << "x" << img.get_bpp() << std::endl;
+    }
+    bool equal = true;
+    for( const auto &f : pngFilters ) {
+        renderer::png_save_params params;
+        params.filter = f.filter;
+        params.parallel = true;
+        tm.start();
+        bool saved = img.save_png_to_file( tempName, params );
+        float encodeMsec = tm.get_elapsed_msec();
+        mapped_file file( filesystem::open_mapped( tempName ) );
+        if( !saved || !file.is_open() ) {
+            common::error() << "cannot save " << tempName << std::endl;
+            return false;
+        }
+        core::vector<byte> data( file.data(), file.data() + file.size() );
+        file.close();
+        double decodeMsec[PNG_SIMD_LEVELS_NUMBER] = {};
+        equal = check_png_simd( name + ", " + f.name, data, loads, decodeMsec ) && equal;
+        if( printTimes ) {
+            auto &log = common::log();
+            log << "    " << f.name << ": " << data.size() << " bytes, encode " << encodeMsec << " ms, decode";
+            for( int level = 0; level < PNG_SIMD_LEVELS_NUMBER; level++ ) {
+                log << " " << pngSimdLevels[level].name << " " << decodeMsec[level] / loads << " ms";
+            }
+            log << std::endl;
+        }
+    }
+    return equal;
+}
+
+/* bench_png_filters
+* the generated images of the odd widths end in the partial vectors of
+* the filters, the files are timed. The file is removed */
+static bool bench_png_filters( const options &opt ) {
+    static const char * const TEMP_NAME = "_image_bench.png";
+    static const int sizes[][2] = { { 1, 1 }, { 3, 17 }, { 61, 33 }, { 301, 203 } };
+    bool succeeded = true;
+    unsigned seed = 1;
+    for( const auto &fmt : layouts ) {
+        bool equalFormat = true;
+        for( const auto &size : sizes ) {
+            renderer::image img;
+            make_png_image( img, size[0], size[1], fmt.fmt, seed++ );
+            auto name = std::string( fmt.name ) + " " + std::to_string( size[0] ) + "x" + std::to_string( size[1] );
+            equalFormat = check_png_filters( name, img, TEMP_NAME, 1, false ) && equalFormat;
+        }
+        common::log() << fmt.name << ": " << (equalFormat ? "equal" : "DIFFERS") << std::endl;
+        succeeded = succeeded && equalFormat;
+    }
+
+    for( const char *name : opt.files ) {
+        renderer::image img;
+        if( !img.load_from_file( name ) ) {
+            common::error() << "cannot load " << name << std::endl;
+            succeeded = false;
+            continue;
+        }
+        bool equal = check_png_filters( name, img, TEMP_NAME, opt.loads, true );
+        common::log() << name << ": " << (equal ? "equal" : "DIFFERS") << std::endl;
+        succeeded = succeeded && equal;
+    }
+    std::remove( TEMP_NAME );
+    return succeeded;
+}
+
+/* jpeg_write_bytes
+* appends the output of libjpeg to the vector */
+static int jpeg_write_bytes( void *file, const void *buf, int size ) {
+    auto *data = reinterpret_cast<core::vector<byte>*>( file );
+    const byte *bytes = reinterpret_cast<const byte*>( buf );
+    data->insert( data->end(), bytes, bytes + size );
+    return size;
+}
+
+/* make_jpeg
+* the RGB8 image is compressed with the sampling of the luma, the gray
+* JPEG is converted by libjpeg. The comment of commentSize bytes is made
+* of EOI markers, the decoders must skip it. The image is valid, the errors
+* of libjpeg exit */
+static void make_jpeg( const renderer::image &img, int sampling, int quality, core::vector<byte> &data, int commentSize = 0 ) {
+    const auto &s = jpegSamplings[sampling];
+    jpeg_compress_struct cinfo;
+    jpeg_error_mgr jerr;
+    jpeg_datarw_struct writer;
+    writer.file = &data;
+    writer.write = jpeg_write_bytes;
+    cinfo.err = jpeg_std_error( &jerr );
+    jpeg_create_compress( &cinfo );
+    jpeg_writer_dest( &cinfo, &writer );
+    cinfo.image_width = img.get_width();
+    cinfo.image_height = img.get_height();
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults( &cinfo );
+    jpeg_set_quality( &cinfo, quality, TRUE );
+    jpeg_set_colorspace( &cinfo, s.space );
+    cinfo.comp_info[0].h_samp_factor = s.h;
+    cinfo.comp_info[0].v_samp_factor = s.v;
+    if( s.progressive ) {
+        jpeg_simple_progression( &cinfo );
+    }
+    jpeg_start_compress( &cinfo, TRUE );
+    if( commentSize > 0 ) {
+        core::vector<JOCTET> comment( commentSize, JPEG_EOI );
+        for( int i = 0; i < commentSize; i += 2 ) {
+            comment[i] = 0xff;
+        }
+        jpeg_write_marker( &cinfo, JPEG_COM, comment.data(), commentSize );
+    }
+    while( cinfo.next_scanline < cinfo.image_height ) {
+        JSAMPROW row = const_cast<byte*>( img.get_line_ptr( cinfo.next_scanline ) );
+        jpeg_write_scanlines( &cinfo, &row, 1 );
+    }
+    jpeg_finish_compress( &cinfo );
+    jpeg_destroy_compress( &cinfo );
+}
+
+/* decode_jpeg
+* the packed pixels of the format, the time is added to msec */
+static bool decode_jpeg( const core::vector<byte> &data, renderer::pixel_format fmt, const renderer::jpeg_params &params,
+        core::vector<byte> &pixels, double &msec ) {
+    renderer::image_info info;
+    if( !renderer::image::get_image_info( data.data(), data.size(), info, fmt, params ) ) {
+        return false;
+    }
+    pixels.resize( static_cast<size_t>( info.width ) * info.height * (renderer::image::pixel_format_to_bpp( fmt ) >> 3) );
+    renderer::image_decode_target target;
+    target.pixels = pixels.data();
+    target.width = info.width;
+    target.height = info.height;
+    target.fmt = fmt;
+    core::timer tm;
+    tm.start();
+    bool decoded = renderer::image::decode( data.data(), data.size(), target, params );
+    msec += tm.get_elapsed_msec();
+    return decoded;
+}
+
+/* check_jpeg_simd
+* every format and IDCT is decoded by each code path, loads times for
+* the time. The pixels of the SIMD paths must equal the portable ones */
+static bool check_jpeg_simd( const char *name, const core::vector<byte> &data, int loads, bool printTimes ) {
+    const int levelsNumber = sizeof( jsimdLevels ) / sizeof( jsimdLevels[0] );
+    bool equal = true;
+    for( const auto &fmt : layouts ) {
+        for( const auto &d : jpegDecodes ) {
+            renderer::jpeg_params params;
+            params.fastDct = d.fastDct;
+            params.scale = d.scale;
+            core::vector<byte> reference;
+            double msec[levelsNumber] = {};
+            for( int level = 0; level < levelsNumber; level++ ) {
+                set_env( "JSIMD_FORCENONE", jsimdLevels[level].forceNone );
+                set_env( "JSIMD_FORCESSE41", jsimdLevels[level].forceSse41 );
+                core::vector<byte> pixels;
+                for( int i = 0; i < loads; i++ ) {
+                    if( !decode_jpeg( data, fmt.fmt, params, pixels, msec[level] ) ) {
+                        common::error() << name << ": cannot decode" << std::endl;
+                        return false;
+                    }
+                }
+                if( level == 0 ) {
+                    reference.swap( pixels );
+                } else if( pixels != reference ) {
+                    common::error() << name << " " << fmt.name << ", " << d.name << ": "
+                            << jsimdLevels[level].name << " differs from " << jsimdLevels[0].name << std::endl;
+                    equal = false;
+                }
+            }
+            if( printTimes ) {
+                auto &log = common::log();
+                log << name << " " << fmt.name << ", " << d.name << ":";
+                for( int level = 0; level < levelsNumber; level++ ) {
+                    log << " " << jsimdLevels[level].name << " " << msec[level] / loads << " ms";
+                }
+                log << std::endl;
+            }
+        }
+    }
+    set_env( "JSIMD_FORCENONE", "" );
+    set_env( "JSIMD_FORCESSE41", "" );
+    return equal;
+}
+
+/* bench_jpeg_simd
+* the sample JPEGs of every sampling end in the partial MCUs, the low
+* and the high quality give the small and the large coefficients. The
+* decode time is printed for the files */
+static bool bench_jpeg_simd( const options &opt ) {
+    static const int sizes[][2] = { { 3, 3 }, { 97, 61 }, { 333, 217 } };
+    static const int qualities[] = { 10, 75, 100 };
+    bool succeeded = true;
+    unsigned seed = 1;
+    for( int sampling = 0; sampling < static_cast<int>( sizeof( jpegSamplings ) / sizeof( jpegSamplings[0] ) ); sampling++ ) {
+        bool equalSampling = true;
+        for( const auto &size : sizes ) {
+            renderer::image img;
+            make_png_image( img, size[0], size[1], renderer::PIXEL_FORMAT_RGB8, seed++ );
+            for( int quality : qualities ) {
+                core::vector<byte> data;
+                make_jpeg( img, sampling, quality, data );
+                auto name = string( jpegSamplings[sampling].name ) + " " + std::to_string( size[0] ) + "x"
+                        + std::to_string( size[1] ) + " q" + std::to_string( quality );
+                equalSampling = check_jpeg_simd( name.c_str(), data, 1, false ) && equalSampling;
+            }
+        }
+        common::log() << jpegSamplings[sampling].name << ": " << (equalSampling ? "equal" : "DIFFERS") << std::endl;
+        succeeded = succeeded && equalSampling;
+    }
+
+    for( const char *name : opt.files ) {
+        mapped_file file( filesystem::open_mapped( name ) );
+        if( !file.is_open() ) {
+            common::error() << "cannot open " << name << std::endl;
+            succeeded = false;
+            continue;
+        }
+        core::vector<byte> data( file.data(), file.data() + file.size() );
+        bool equal = check_jpeg_simd( name, data, opt.loads, true );
+        common::log() << name << ": " << (equal ? "equal" : "DIFFERS") << std::endl;
+        succeeded = succeeded && equal;
+    }
+    return succeeded;
+}
+
+/* decode_reference
+* the pixels of the generated file, RGBA8 top-down. The gray of color
+* and the added alpha differ between libpng and the row conversions */
+struct decode_reference {
+    core::vector<byte>  rgba;               /* empty - the added alpha is checked only */
+    int                 width{0};
+    int                 height{0};
+    bool                color{true};
+    bool                alpha{false};
+    bool                luminance{false};   /* the gray of libpng, the average otherwise */
+    int                 addedAlpha{0};      /* 255 of libpng and libjpeg, 0 of the row conversions */
+};
+
+/* find_layout */
+static const format_layout &find_layout( renderer::pixel_format fmt ) {
+    for( const auto &l : layouts ) {
+        if( l.fmt == fmt ) {
+            return l;
+        }
+    }
+    assert( 0 );
+    return layouts[0];
+}
+
+/* is_filled
+* the bytes which the decode must not write */
+static bool is_filled( const byte *p, size_t size ) {
+    for( size_t i = 0; i < size; i++ ) {
+        if( p[i] != 0xcd ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* check_reference
+* the gray of libpng is rounded differently from its coefficients
+* in double, it may be 1 off */
+static bool check_reference( const decode_reference &ref, const renderer::image &img, const format_layout &fmt ) {
+    if( !ref.rgba.empty() && (img.get_width() != ref.width || img.get_height() != ref.height) ) {
+        return false;
+    }
+    for( int y = 0; y < img.get_height(); y++ ) {
+        const byte *row = img.get_line_ptr( y );
+        for( int x = 0; x < img.get_width(); x++ ) {
+            const byte *px = row + x * fmt.size;
+            if( fmt.a >= 0 && !ref.alpha && px[fmt.a] != ref.addedAlpha ) {
+                return false;
+            }
+            if( ref.rgba.empty() ) {
+                continue;
+            }
+            const byte *src = ref.rgba.data() + (static_cast<size_t>( y ) * ref.width + x) * 4;
+            if( fmt.size == 1 ) {
+                int expected = src[0];
+                int tolerance = 0;
+                if( ref.color && ref.luminance ) {
+                    expected = static_cast<int>( 0.2126 * src[0] + 0.7152 * src[1] + 0.0722 * src[2] + 0.5 );
+                    tolerance = 1;
+                } else if( ref.color ) {
+                    expected = (src[0] + src[1] + src[2]) / 3;
+                }
+                if( std::abs( px[0] - expected ) > tolerance ) {
+                    return false;
+                }
+                continue;
+            }
+            if( px[fmt.r] != src[0] || px[fmt.g] != src[1] || px[fmt.b] != src[2] ||
+                    (fmt.a >= 0 && ref.alpha && px[fmt.a] != src[3]) ) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* check_decode
+* every format is loaded, the load is checked against the reference and
+* decoded to the targets whose rows are padded, top-down and flipped,
+* between the guard bytes. The size which differs from the image and the
+* short stride must be rejected without a write */
+static bool check_decode( const std::string &name, const core::vector<byte> &data, const decode_reference *ref ) {
+    static const size_t GUARD_SIZE = 16;
+    static const int PADDING = 5;
+    bool equal = true;
+    auto fail = [&]( const char *fmtName, const char *what ) {
+        common::error() << name << " " << fmtName << ": " << what << std::endl;
+        equal = false;
+    };
+    const int layoutsNumber = static_cast<int>( sizeof( layouts ) / sizeof( layouts[0] ) );
+    for( int f = -1; f < layoutsNumber; f++ ) {
+        const auto fmt = f < 0 ? renderer::PIXEL_FORMAT_AUTO : layouts[f].fmt;
+        const char *fmtName = f < 0 ? "auto" : layouts[f].name;
+        renderer::image img;
+        if( !img.load_from_memory( data.data(), data.size(), fmt ) ) {
+            fail( fmtName, "cannot load" );
+            continue;
+        }
+        const auto &layout = find_layout( img.get_pixel_format() );
+        if( ref != nullptr && !check_reference( *ref, img, layout ) ) {
+            fail( fmtName, "the pixels differ from the file" );
+        }
+        renderer::image_info info;
+        if( !renderer::image::get_image_info( data.data(), data.size(), info, fmt ) || info.width != img.get_width() ||
+                info.height != img.get_height() || info.fmt != img.get_pixel_format() ) {
+            fail( fmtName, "get_image_info() differs from the load" );
+        }
+
+        const int width = img.get_width();
+        const int height = img.get_height();
+        const int rowSize = width * layout.size;
+        const int stride = rowSize + PADDING;
+        core::vector<byte> buffer( GUARD_SIZE * 2 + static_cast<size_t>( stride ) * height );
+        renderer::image_decode_target target;
+        target.pixels = buffer.data() + GUARD_SIZE;
+        target.width = width;
+        target.height = height;
+        target.stride = stride;
+        target.fmt = fmt;
+        for( bool flip : { false, true } ) {
+            std::fill( buffer.begin(), buffer.end(), 0xcd );
+            target.flipVertical = flip;
+            if( !renderer::image::decode( data.data(), data.size(), target ) ) {
+                fail( fmtName, "cannot decode" );
+                continue;
+            }
+            bool same = is_filled( buffer.data(), GUARD_SIZE ) && is_filled( buffer.data() + buffer.size() - GUARD_SIZE, GUARD_SIZE );
+            for( int y = 0; y < height && same; y++ ) {
+                const byte *row = target.pixels + static_cast<size_t>( stride ) * (flip ? height - y - 1 : y);
+                same = std::memcmp( row, img.get_line_ptr( y ), rowSize ) == 0 && is_filled( row + rowSize, PADDING );
+            }
+            if( !same ) {
+                fail( fmtName, flip ? "the flipped decode differs from the load" : "the decode differs from the load" );
+            }
+        }
+        if( f >= 0 ) {
+            continue;
+        }
+        /* the wrong targets, once per file */
+        std::fill( buffer.begin(), buffer.end(), 0xcd );
+        target.flipVertical = false;
+        target.width = width + 1;
+        if( renderer::image::decode( data.data(), data.size(), target ) || !is_filled( buffer.data(), buffer.size() ) ) {
+            fail( fmtName, "the wider target is not rejected" );
+        }
+        target.width = width;
+        target.height = height - 1;
+        if( renderer::image::decode( data.data(), data.size(), target ) || !is_filled( buffer.data(), buffer.size() ) ) {
+            fail( fmtName, "the lower target is not rejected" );
+        }
+        target.height = height;
+        target.stride = rowSize - 1;
+        if( rowSize > 1 && (renderer::image::decode( data.data(), data.size(), target ) || !is_filled( buffer.data(), buffer.size() )) ) {
+            fail( fmtName, "the short stride is not rejected" );
+        }
+    }
+    return equal;
+}
+
+/* make_reference
+* the noise pixels, the gray ones have r = g = b */
+static void make_reference( decode_reference &ref, int width, int height, bool color, bool alpha, unsigned seed ) {
+    ref.width = width;
+    ref.height = height;
+    ref.color = color;
+    ref.alpha = alpha;
+    ref.rgba.resize( static_cast<size_t>( width ) * height * 4 );
+    for( size_t i = 0; i < ref.rgba.size(); i += 4 ) {
+        for( int c = 0; c < 4; c++ ) {
+            seed = seed * 1103515245u + 12345u;
+            ref.rgba[i + c] = static_cast<byte>( seed >> 16 );
+        }
+        if( !color ) {
+            ref.rgba[i + 1] = ref.rgba[i + 2] = ref.rgba[i];
+        }
+    }
+}
+
+/* the PNG files of --decode: every color type and bit depth of libpng,
+* the palettes and tRNS */
+static const struct {
+    const char *    name;
+    int             colorType;
+    int             bitDepth;
+    bool            trns;
+} decodePngs[] = {
+    { "gray 1", PNG_COLOR_TYPE_GRAY, 1, false },
+    { "gray 2", PNG_COLOR_TYPE_GRAY, 2, false },
+    { "gray 4", PNG_COLOR_TYPE_GRAY, 4, false },
+    { "gray 8", PNG_COLOR_TYPE_GRAY, 8, false },
+    { "gray 16", PNG_COLOR_TYPE_GRAY, 16, false },
+    { "gray 8 tRNS", PNG_COLOR_TYPE_GRAY, 8, true },
+    { "gray alpha 8", PNG_COLOR_TYPE_GRAY_ALPHA, 8, false },
+    { "gray alpha 16", PNG_COLOR_TYPE_GRAY_ALPHA, 16, false },
+    { "rgb 8", PNG_COLOR_TYPE_RGB, 8, false },
+    { "rgb 16", PNG_COLOR_TYPE_RGB, 16, false },
+    { "rgba 8", PNG_COLOR_TYPE_RGB_ALPHA, 8, false },
+    { "rgba 16", PNG_COLOR_TYPE_RGB_ALPHA, 16, false },
+    { "palette 8", PNG_COLOR_TYPE_PALETTE, 8, false },
+    { "palette 4 tRNS", PNG_COLOR_TYPE_PALETTE, 4, true }
+};
+
+/* png_write_bytes */
+static void png_write_bytes( png_structp png, png_bytep data, size_t length ) {
+    auto *out = reinterpret_cast<core::vector<byte>*>( png_get_io_ptr( png ) );
+    out->insert( out->end(), data, data + length );
+}
+
+/* png_flush_bytes */
+static void png_flush_bytes( png_structp ) {
+}
+
+/* make_decode_png
+* the rows of the color type are packed from the reference, which is
+* changed to the pixels the file holds: the expanded gray levels, the
+* palette colors and the alpha of tRNS */
+static bool make_decode_png( int type, bool interlaced, decode_reference &ref, core::vector<byte> &data ) {
+    const auto &t = decodePngs[type];
+    const bool palette = t.colorType == PNG_COLOR_TYPE_PALETTE;
+    const int channels = palette ? 1 : (t.colorType & PNG_COLOR_MASK_COLOR ? 3 : 1) + (t.colorType & PNG_COLOR_MASK_ALPHA ? 1 : 0);
+    const int maxValue = (1 << t.bitDepth) - 1;
+    const int rowBytes = (ref.width * channels * t.bitDepth + 7) / 8;
+    core::vector<byte> pixels( static_cast<size_t>( rowBytes ) * ref.height );
+    core::vector<png_bytep> rows( ref.height );
+    png_color colors[256];
+    png_byte trns[256];
+    const int colorsNumber = palette ? 1 << t.bitDepth : 0;
+    for( int i = 0; i < colorsNumber; i++ ) {
+        colors[i].red = static_cast<png_byte>( i * 37 );
+        colors[i].green = static_cast<png_byte>( 255 - i * 11 );
+        colors[i].blue = static_cast<png_byte>( i * i );
+        trns[i] = static_cast<png_byte>( i * 17 );
+    }
+    png_color_16 trnsGray = {};
+    trnsGray.gray = ref.rgba[0];
+
+    ref.alpha = t.colorType & PNG_COLOR_MASK_ALPHA || t.trns;
+    for( int y = 0; y < ref.height; y++ ) {
+        rows[y] = pixels.data() + static_cast<size_t>( rowBytes ) * y;
+        for( int x = 0; x < ref.width; x++ ) {
+            byte *px = ref.rgba.data() + (static_cast<size_t>( y ) * ref.width + x) * 4;
+            int values[4] = { px[0], px[1], px[2], px[3] };
+            if( palette ) {
+                int index = px[0] & maxValue;
+                values[0] = index;
+                px[0] = colors[index].red;
+                px[1] = colors[index].green;
+                px[2] = colors[index].blue;
+                px[3] = t.trns ? trns[index] : 255;
+            } else if( t.bitDepth < 8 ) {
+                /* the expansion of libpng replicates the bits */
+                values[0] = px[0] >> (8 - t.bitDepth);
+                px[0] = px[1] = px[2] = static_cast<byte>( values[0] * 255 / maxValue );
+            } else if( t.trns ) {
+                px[3] = px[0] == trnsGray.gray ? 0 : 255;
+            } else if( t.colorType == PNG_COLOR_TYPE_GRAY_ALPHA ) {
+                values[1] = px[3];
+            }
+            for( int c = 0; c < channels; c++ ) {
+                int i = x * channels + c;
+                if( t.bitDepth == 16 ) {
+                    rows[y][i * 2] = rows[y][i * 2 + 1] = static_cast<byte>( values[c] );
+                } else if( t.bitDepth == 8 ) {
+                    rows[y][i] = static_cast<byte>( values[c] );
+                } else {
+                    int shift = 8 - t.bitDepth - (i * t.bitDepth) % 8;
+                    rows[y][i * t.bitDepth / 8] |= static_cast<byte>( values[c] << shift );
+                }
+            }
+        }
+    }
+    ref.color = t.colorType & PNG_COLOR_MASK_COLOR;
+    ref.luminance = true;
+    ref.addedAlpha = 255;
+
+    png_structp png = png_create_write_struct( PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr );
+    png_infop info = png ? png_create_info_struct( png ) : nullptr;
+    if( info == nullptr || setjmp( png_jmpbuf( png ) ) ) {
+        png_destroy_write_struct( &png, &info );
+        return false;
+    }
+    png_set_write_fn( png, &data, png_write_bytes, png_flush_bytes );
+    png_set_IHDR( png, info, ref.width, ref.height, t.bitDepth, t.colorType,
+            interlaced ? PNG_INTERLACE_ADAM7 : PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT );
+    if( palette ) {
+        png_set_PLTE( png, info, colors, colorsNumber );
+    }
+    if( t.trns ) {
+        png_set_tRNS( png, info, trns, colorsNumber, palette ? nullptr : &trnsGray );
+    }
+    png_set_rows( png, info, rows.data() );
+    png_write_png( png, info, PNG_TRANSFORM_IDENTITY, nullptr );
+    png_destroy_write_struct( &png, &info );
+    return true;
+}
+
+/* the TGA files of --decode */
+static const struct {
+    const char *    name;
+    int             dataType;
+    int             bpp;
+} decodeTgas[] = {
+    { "rle gray", 11, 8 },
+    { "rle bgr", 10, 24 },
+    { "rle bgra", 10, 32 },
+    { "rle 16", 10, 16 },
+    { "bgr", 2, 24 }
+};
+
+/* make_decode_tga
+* the pixels are written in the order of the origin, the runs and the
+* raw packets cross the rows. The 16 bits pixels are not in the reference */
+static void make_decode_tga( int type, int attrib, decode_reference &ref, core::vector<byte> &data, unsigned seed ) {
+    static const int runs[] = { 1, 2, 3, 127, 128, 129, 200 };
+    const auto &t = decodeTgas[type];
+    const int pxSize = t.bpp / 8;
+    const bool rle = t.dataType != 2;
+    ref.color = t.bpp != 8;
+    ref.alpha = t.bpp == 32;
+    for( size_t i = 0; i < ref.rgba.size() && !ref.color; i += 4 ) {
+        ref.rgba[i + 1] = ref.rgba[i + 2] = ref.rgba[i];
+    }
+    const byte header[18] = { 0, 0, static_cast<byte>( t.dataType ), 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        static_cast<byte>( ref.width ), static_cast<byte>( ref.width >> 8 ),
+        static_cast<byte>( ref.height ), static_cast<byte>( ref.height >> 8 ),
+        static_cast<byte>( t.bpp ), static_cast<byte>( attrib | (ref.alpha ? 8 : 0) ) };
+    data.assign( header, header + sizeof( header ) );
+
+    /* the file order of the pixels of the reference */
+    const int count = ref.width * ref.height;
+    core::vector<byte *> order( count );
+    for( int i = 0; i < count; i++ ) {
+        int row = i / ref.width;
+        int column = i % ref.width;
+        int y = attrib & 0x20 ? row : ref.height - row - 1;
+        int x = attrib & 0x10 ? ref.width - column - 1 : column;
+        order[i] = ref.rgba.data() + (static_cast<size_t>( y ) * ref.width + x) * 4;
+    }
+    auto put = [&]( const byte *px ) {
+        byte bytes[4] = { px[2], px[1], px[0], px[3] };
+        if( pxSize == 1 ) {
+            bytes[0] = px[0];
+        }
+        data.insert( data.end(), bytes, bytes + pxSize );
+    };
+    for( int i = 0; i < count; ) {
+        seed = seed * 1103515245u + 12345u;
+        bool run = rle && ((seed >> 16) & 1);
+        int length = std::min( count - i, run ? runs[(seed >> 18) % 7] : 1 + static_cast<int>( (seed >> 17) & 255 ) );
+        if( run ) {
+            for( int j = 1; j < length; j++ ) {
+                std::memcpy( order[i + j], order[i], 4 );
+            }
+        }
+        for( int packet; length > 0; length -= packet, i += packet ) {
+            packet = rle ? std::min( length, 128 ) : length;
+            if( rle ) {
+                data.push_back( static_cast<byte>( (run ? 0x80 : 0) | (packet - 1) ) );
+            }
+            for( int j = 0; j < (run ? 1 : packet); j++ ) {
+                put( order[i + j] );
+            }
+        }
+    }
+}
+
+/* read_temp_file
+* the file written by the image is read and removed */
+static bool read_temp_file( const char *name, core::vector<byte> &data ) {
+    {
+        mapped_file file( filesystem::open_mapped( name ) );
+        if( file.is_open() ) {
+            data.assign( file.data(), file.data() + file.size() );
+        }
+    }
+    std::remove( name );
+    return !data.empty();
+}
+
+/* bench_decode
+* the files of every decoder are generated, the odd sizes have the
+* interlace passes with no pixels of the last columns */
+static bool bench_decode() {
+    static const int sizes[][2] = { { 37, 23 }, { 5, 2 }, { 1, 1 } };
+    static const int tgaOrigins[] = { 0x00, 0x10, 0x20, 0x30 };
+    bool succeeded = true;
+    unsigned seed = 1;
+    auto report = [&succeeded]( const char *kind, bool equal ) {
+        common::log() << kind << ": " << (equal ? "equal" : "DIFFERS") << std::endl;
+        succeeded = succeeded && equal;
+    };
+
+    bool equal = true;
+    for( int type = 0; type < static_cast<int>( sizeof( decodePngs ) / sizeof( decodePngs[0] ) ); type++ ) {
+        for( const auto &size : sizes ) {
+            for( bool interlaced : { false, true } ) {
+                decode_reference ref;
+                core::vector<byte> data;
+                make_reference( ref, size[0], size[1], decodePngs[type].colorType & PNG_COLOR_MASK_COLOR, false, seed++ );
+                auto name = std::string( "png " ) + decodePngs[type].name + (interlaced ? " interlaced " : " ")
+                        + std::to_string( size[0] ) + "x" + std::to_string( size[1] );
+                if( !make_decode_png( type, interlaced, ref, data ) ) {
+                    common::error() << name << ": cannot write" << std::endl;
+                    equal = false;
+                    continue;
+                }
+                equal = check_decode( name, data, &ref ) && equal;
+            }
+        }
+    }
+    report( "png", equal );
+
+    equal = true;
+    for( int type = 0; type < static_cast<int>( sizeof( decodeTgas ) / sizeof( decodeTgas[0] ) ); type++ ) {
+        for( int attrib : tgaOrigins ) {
+            decode_reference ref;
+            core::vector<byte> data;
+            make_reference( ref, 37, 23, true, false, seed++ );
+            make_decode_tga( type, attrib, ref, data, seed++ );
+            auto name = std::string( "tga " ) + decodeTgas[type].name + " origin " + std::to_string( attrib );
+            equal = check_decode( name, data, decodeTgas[type].bpp != 16 ? &ref : nullptr ) && equal;
+        }
+    }
+    report( "tga", equal );
+
+    /* BMP and TEX are written by the engine, BMP of 24 bits has no padding */
+    equal = true;
+    for( auto fmt : { renderer::PIXEL_FORMAT_BGR8, renderer::PIXEL_FORMAT_BGRA8 } ) {
+        static const char * const TEMP_NAME = "_image_bench.bmp";
+        decode_reference ref;
+        core::vector<byte> data;
+        make_reference( ref, 36, 23, true, fmt == renderer::PIXEL_FORMAT_BGRA8, seed++ );
+        renderer::image img( ref.width, ref.height, renderer::PIXEL_FORMAT_RGBA8 );
+        std::memcpy( img.get_line_ptr( 0 ), ref.rgba.data(), ref.rgba.size() );
+        std::string name = fmt == renderer::PIXEL_FORMAT_BGR8 ? "bmp 24" : "bmp 32";
+        if( !img.save_to_file( TEMP_NAME, 95, fmt, renderer::IMAGE_FORMAT_BMP ) || !read_temp_file( TEMP_NAME, data ) ) {
+            common::error() << name << ": cannot write" << std::endl;
+            equal = false;
+            continue;
+        }
+        equal = check_decode( name, data, &ref ) && equal;
+    }
+    report( "bmp", equal );
+
+    equal = true;
+    for( auto fmt : { renderer::PIXEL_FORMAT_RGB8, renderer::PIXEL_FORMAT_RGBA8, renderer::PIXEL_FORMAT_GRAY8 } ) {
+        static const char * const TEMP_NAME = "_image_bench.tex";
+        const auto &layout = find_layout( fmt );
+        decode_reference ref;
+        core::vector<byte> data;
+        make_reference( ref, 37, 23, fmt != renderer::PIXEL_FORMAT_GRAY8, fmt == renderer::PIXEL_FORMAT_RGBA8, seed++ );
+        renderer::image img( ref.width, ref.height, fmt );
+        convert_pixels( find_layout( renderer::PIXEL_FORMAT_RGBA8 ), layout, ref.rgba.data(), img.get_line_ptr( 0 ), ref.width * ref.height );
+        renderer::mip_chain mips;
+        std::string name = std::string( "tex " ) + layout.name;
+        if( !mips.generate( img, renderer::MIP_FILTER_BOX, false ) || !renderer::texture_file::save( TEMP_NAME, mips, false ) ||
+                !read_temp_file( TEMP_NAME, data ) ) {
+            common::error() << name << ": cannot write" << std::endl;
+            equal = false;
+            continue;
+        }
+        equal = check_decode( name, data, &ref ) && equal;
+    }
+    report( "tex", equal );
+
+    /* the pixels of JPEG are lossy, the added alpha is checked */
+    equal = true;
+    for( int sampling = 0; sampling < static_cast<int>( sizeof( jpegSamplings ) / sizeof( jpegSamplings[0] ) ); sampling++ ) {
+        renderer::image img;
+        core::vector<byte> data;
+        make_png_image( img, 37, 23, renderer::PIXEL_FORMAT_RGB8, seed++ );
+        make_jpeg( img, sampling, 75, data );
+        decode_reference ref;
+        ref.addedAlpha = 255;
+        equal = check_decode( std::string( "jpeg " ) + jpegSamplings[sampling].name, data, &ref ) && equal;
+    }
+    report( "jpeg", equal );
+    return succeeded;
+}
+
+/* check_decoder_rows
+* the rows of the decoder are the rows of the load */
+static bool check_decoder_rows( renderer::image &img, const renderer::image &expected, int first, int last ) {
+    if( img.get_width() != expected.get_width() || img.get_height() != expected.get_height() ||
+            img.get_pixel_format() != expected.get_pixel_format() ) {
+        return false;
+    }
+    const size_t rowSize = static_cast<size_t>( expected.get_width() ) * (expected.get_bpp() >> 3);
+    for( int y = first; y < last; y++ ) {
+        if( std::memcmp( img.get_line_ptr( y ), expected.get_line_ptr( y ), rowSize ) != 0 ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* check_decoder
+* the file is pushed by the chunks of 1 byte to 16 KB, sometimes while
+* the decoder is suspended. Every decode() has a random budget of time
+* and rows. The completed rows never go back and are compared with the
+* load when they are completed */
+static bool check_decoder( const std::string &name, const core::vector<byte> &data, renderer::pixel_format fmt, unsigned seed ) {
+    static const float budgets[] = { 0.0f, 0.02f, 1.0f };
+    static const int rowLimits[] = { 0, 1, 5, 64 };
+    static const int MAX_CALLS = 1000000;
+    renderer::image expected;
+    if( !expected.load_from_memory( data.data(), data.size(), fmt ) ) {
+        common::error() << name << ": cannot load" << std::endl;
+        return false;
+    }
+    renderer::image_decoder decoder( fmt );
+    auto status = renderer::IMAGE_DECODER_NEED_DATA;
+    size_t pushed = 0;
+    int rows = 0;
+    int calls = 0;
+    auto next = [&seed]() {
+        seed = seed * 1103515245u + 12345u;
+        return seed >> 16;
+    };
+    for( ; calls < MAX_CALLS && (status == renderer::IMAGE_DECODER_NEED_DATA || status == renderer::IMAGE_DECODER_SUSPENDED); calls++ ) {
+        if( pushed < data.size() && (status == renderer::IMAGE_DECODER_NEED_DATA || (next() & 1)) ) {
+            const unsigned bits = next() % 15;
+            const size_t chunk = std::min( data.size() - pushed, static_cast<size_t>( 1 + (next() & ((1u << bits) - 1)) ) );
+            decoder.push( data.data() + pushed, chunk );
+            pushed += chunk;
+            if( pushed == data.size() ) {
+                decoder.finish();
+            }
+        }
+        status = decoder.decode( budgets[next() % 3], rowLimits[next() % 4] );
+        if( status == renderer::IMAGE_DECODER_FAILED ) {
+            break;
+        }
+        const int completed = decoder.get_rows_completed();
+        if( completed < rows || (completed > 0 && !decoder.has_info()) ) {
+            common::error() << name << ": the completed rows go back from " << rows << " to " << completed << std::endl;
+            return false;
+        }
+        if( completed > rows && !check_decoder_rows( decoder.get_image(), expected, rows, completed ) ) {
+            common::error() << name << ": the rows " << rows << "-" << completed << " are not final" << std::endl;
+            return false;
+        }
+        rows = completed;
+    }
+    if( status != renderer::IMAGE_DECODER_DONE ) {
+        common::error() << name << ": the decoder ends by the status " << status << " after " << calls << " calls" << std::endl;
+        return false;
+    }
+    const auto info = decoder.get_info();
+    if( rows != expected.get_height() || info.width != expected.get_width() || info.height != expected.get_height() ||
+            info.fmt != expected.get_pixel_format() || !check_decoder_rows( decoder.get_image(), expected, 0, rows ) ) {
+        common::error() << name << ": the decoded image differs from the load" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/* check_decoder_truncated
+* the truncated PNG fails, the truncated JPEG is completed by libjpeg */
+static bool check_decoder_truncated( const std::string &name, const core::vector<byte> &data ) {
+    const bool png = renderer::image::get_image_format( data.data(), data.size() ) == renderer::IMAGE_FORMAT_PNG;
+    renderer::image_decoder decoder;
+    decoder.push( data.data(), data.size() / 2 );
+    decoder.finish();
+    auto status = decoder.decode( 0.0f );
+    if( status != (png ? renderer::IMAGE_DECODER_FAILED : renderer::IMAGE_DECODER_DONE) ||
+            (png && decoder.get_rows_completed() != 0) ) {
+        common::error() << name << ": the truncated file ends by the status " << status << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/* insert_jpeg_tables
+* a DQT segment of tableCount copies of the table 0 is inserted after SOI,
+* the tables of the image replace it. libjpeg reads the segment at once */
+static void insert_jpeg_tables( core::vector<byte> &data, int tableCount ) {
+    const int length = 2 + tableCount * (1 + DCTSIZE2);
+    core::vector<byte> segment;
+    segment.push_back( 0xff );
+    segment.push_back( 0xdb );
+    segment.push_back( static_cast<byte>( length >> 8 ) );
+    segment.push_back( static_cast<byte>( length ) );
+    for( int i = 0; i < tableCount; i++ ) {
+        segment.push_back( 0 );
+        segment.insert( segment.end(), DCTSIZE2, 1 );
+    }
+    data.insert( data.begin() + 2, segment.begin(), segment.end() );
+}
+
+/* bench_decoder
+* the interlaced PNGs and the progressive JPEGs complete the rows at the
+* end, the others by the slices. The comment of the JPEG is longer than
+* the slice of the decoder, its skip is carried to the next pushes. The
+* DQT segment is longer than the slice, the slice grows until it fits */
+static bool bench_decoder( const options &opt ) {
+    static const renderer::pixel_format formats[] = { renderer::PIXEL_FORMAT_AUTO, renderer::PIXEL_FORMAT_RGBA8, renderer::PIXEL_FORMAT_GRAY8 };
+    static const int pngTypes[] = { 3, 6, 10, 13 };     /* gray 8, gray alpha 8, rgba 8, palette 4 tRNS */
+    static const int jpegTypes[] = { 0, 2, 4, 5 };      /* 4:4:4, 4:2:0, 4:2:0 progressive, gray */
+    struct sample {
+        std::string         name;
+        core::vector<byte>  data;
+    };
+    core::vector<sample> samples;
+    unsigned seed = 1;
+    for( int type : pngTypes ) {
+        for( bool interlaced : { false, true } ) {
+            sample s;
+            s.name = std::string( "png " ) + decodePngs[type].name + (interlaced ? " interlaced" : "");
+            decode_reference ref;
+            make_reference( ref, 301, 203, decodePngs[type].colorType & PNG_COLOR_MASK_COLOR, false, seed++ );
+            make_decode_png( type, interlaced, ref, s.data );
+            samples.push_back( std::move( s ) );
+        }
+    }
+    for( int type : jpegTypes ) {
+        sample s;
+        s.name = std::string( "jpeg " ) + jpegSamplings[type].name;
+        renderer::image img;
+        make_png_image( img, 640, 480, renderer::PIXEL_FORMAT_RGB8, seed++ );
+        make_jpeg( img, type, 90, s.data, 60000 );
+        insert_jpeg_tables( s.data, 100 );
+        samples.push_back( std::move( s ) );
+    }
+    bool succeeded = true;
+    for( const char *name : opt.files ) {
+        mapped_file file( filesystem::open_mapped( name ) );
+        if( !file.is_open() ) {
+            common::error() << "cannot open " << name << std::endl;
+            succeeded = false;
+            continue;
+        }
+        sample s;
+        s.name = name;
+        s.data.assign( file.data(), file.data() + file.size() );
+        samples.push_back( std::move( s ) );
+    }
+
+    for( const auto &s : samples ) {
+        bool equal = check_decoder_truncated( s.name, s.data );
+        for( auto fmt : formats ) {
+            equal = check_decoder( s.name, s.data, fmt, seed++ ) && equal;
+        }
+        common::log() << s.name << ": " << (equal ? "equal" : "DIFFERS") << std::endl;
+        succeeded = succeeded && equal;
+    }
+    return succeeded;
+}
+
+/* write_temp_file */
+static bool write_temp_file( const char *name, const core::vector<byte> &data ) {
+    ofstream file( filesystem::open_write( name ) );
+    return file.is_open() && file.write( reinterpret_cast<const char*>( data.data() ), data.size() ).good();
+}
+
+/* find_jpeg_marker
+* the offset of the marker after the offset, 0 if there is none */
+static size_t find_jpeg_marker( const core::vector<byte> &data, byte marker, size_t offset ) {
+    for( size_t i = offset; i + 1 < data.size(); i++ ) {
+        if( data[i] == 0xff && data[i + 1] == marker ) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+/* check_jpeg_batch_loads
+* every valid item must be the single load, the corrupt ones fail empty */
+static bool check_jpeg_batch_loads( core::vector<renderer::jpeg_batch_item> &items, const core::vector<bool> &valid,
+        renderer::pixel_format fmt ) {
+    renderer::jpeg_params params;
+    int validNumber = 0;
+    for( size_t i = 0; i < items.size(); i++ ) {
+        items[i].img->release();
+        validNumber += valid[i] ? 1 : 0;
+    }
+    bool equal = renderer::image::load_jpg_files( items.data(), static_cast<int>( items.size() ), params, fmt ) == validNumber;
+    for( size_t i = 0; i < items.size(); i++ ) {
+        const auto &item = items[i];
+        if( !valid[i] ) {
+            if( item.succeeded || !item.img->is_empty() ) {
+                common::error() << item.name << ": the corrupt file is loaded" << std::endl;
+                equal = false;
+            }
+            continue;
+        }
+        renderer::image single;
+        bool same = item.succeeded && single.load_jpg_from_file( item.name, params, fmt ) &&
+                single.get_width() == item.img->get_width() && single.get_height() == item.img->get_height() &&
+                single.get_pixel_format() == item.img->get_pixel_format();
+        for( int y = 0; y < single.get_height() && same; y++ ) {
+            same = std::memcmp( single.get_line_ptr( y ), item.img->get_line_ptr( y ), single.get_stride() ) == 0;
+        }
+        if( !same ) {
+            common::error() << item.name << ": the batch load differs from the single load" << std::endl;
+            equal = false;
+        }
+    }
+    return equal;
+}
+
+/* bench_jpeg_batch
+* the saved files are the single saves, the image too wide for libjpeg
+* and the write to /dev/full fail between the valid ones. The corrupt
+* files of the loads fail in jpeg_read_header, in jpeg_start_decompress
+* of the progressive JPEG and after the rows. Every failure is followed
+* by a valid file on the same thread, the codec of the thread is reused
+* after the longjmp. The files are written to the current directory and
+* removed */
+static bool bench_jpeg_batch() {
+    static const int IMAGES_NUMBER = 12;
+    const std::string prefix = "_image_bench_batch_";
+    core::timer tm;
+    bool succeeded = true;
+
+    /* the saves */
+    core::vector<renderer::image> images( IMAGES_NUMBER );
+    core::vector<renderer::jpeg_batch_item> items;
+    core::vector<bool> valid;
+    unsigned seed = 1;
+    for( int i = 0; i < IMAGES_NUMBER; i++ ) {
+        const auto &fmt = layouts[i % (sizeof( layouts ) / sizeof( layouts[0] ))];
+        renderer::jpeg_batch_item item;
+        item.img = &images[i];
+        item.name = (prefix + std::to_string( i ) + ".jpg").c_str();
+        make_png_image( images[i], 1 + (i * 37) % 200, 1 + (i * 53) % 150, fmt.fmt, seed++ );
+        items.push_back( item );
+        valid.push_back( true );
+    }
+    renderer::jpeg_batch_item failing;
+    renderer::image wide;
+    make_png_image( wide, 70000, 1, renderer::PIXEL_FORMAT_GRAY8, seed++ );
+    failing.img = &wide;
+    failing.name = (prefix + "wide.jpg").c_str();
+    items.insert( items.begin() + 3, failing );
+    valid.insert( valid.begin() + 3, false );
+#ifdef __linux__
+    /* the write of the full output buffer fails in jpeg_write_scanlines */
+    renderer::image full;
+    make_png_image( full, 640, 480, renderer::PIXEL_FORMAT_RGB8, seed++ );
+    failing.img = &full;
+    failing.name = "/dev/full";
+    items.insert( items.begin() + 8, failing );
+    valid.insert( valid.begin() + 8, false );
+#endif
+    renderer::jpeg_params params;
+    params.quality = 85;
+    tm.start();
+    int saved = renderer::image::save_jpg_files( items.data(), static_cast<int>( items.size() ), params );
+    float saveMsec = tm.get_elapsed_msec();
+    std::remove( (prefix + "wide.jpg").c_str() );
+    bool equal = saved == IMAGES_NUMBER;
+    core::vector<renderer::jpeg_batch_item> loadItems;
+    for( size_t i = 0; i < items.size(); i++ ) {
+        const auto &item = items[i];
+        if( !valid[i] ) {
+            if( item.succeeded ) {
+                common::error() << item.name << ": the failing save succeeds" << std::endl;
+                equal = false;
+            }
+            continue;
+        }
+        loadItems.push_back( item );
+        core::vector<byte> batch;
+        core::vector<byte> single;
+        {
+            mapped_file file( filesystem::open_mapped( item.name.c_str() ) );
+            if( file.is_open() ) {
+                batch.assign( file.data(), file.data() + file.size() );
+            }
+        }
+        const std::string singleName = prefix + "single.jpg";
+        if( !item.succeeded || !item.img->save_jpg_to_file( singleName.c_str(), params ) || !read_temp_file( singleName.c_str(), single ) ||
+                batch != single ) {
+            common::error() << item.name << ": the batch save differs from the single save" << std::endl;
+            equal = false;
+        }
+    }
+    common::log() << "save: " << (equal ? "equal" : "DIFFERS") << ", " << saveMsec << " ms" << std::endl;
+    succeeded = succeeded && equal;
+
+    /* the corrupt files */
+    items.swap( loadItems );
+    valid.assign( items.size(), true );
+    core::vector<byte> data;
+    {
+        mapped_file file( filesystem::open_mapped( items[1].name.c_str() ) );
+        data.assign( file.data(), file.data() + file.size() );
+    }
+    const size_t sos = find_jpeg_marker( data, 0xda, 2 );
+    core::vector<byte> header( data.begin(), data.begin() + sos / 2 );
+    /* the second scan of the sequential JPEG fails after the rows */
+    core::vector<byte> scan( data );
+    const size_t sosLength = 2 + (data[sos + 2] << 8) + data[sos + 3];
+    scan.insert( scan.end() - 2, data.begin() + sos, data.begin() + sos + sosLength );
+    renderer::image img;
+    make_png_image( img, 64, 48, renderer::PIXEL_FORMAT_RGB8, seed++ );
+    core::vector<byte> progressive;
+    make_jpeg( img, 4, 75, progressive );
+    const size_t secondSos = find_jpeg_marker( progressive, 0xda, find_jpeg_marker( progressive, 0xda, 2 ) + 2 );
+    const size_t components = progressive[secondSos + 4];
+    progressive[secondSos + 5 + components * 2] = 0x40;
+    const core::vector<byte> *corrupt[] = { &header, &scan, &progressive };
+    const char *corruptNames[] = { "header.jpg", "scan.jpg", "progressive.jpg" };
+    core::vector<renderer::image> corruptImages( 3 );
+    for( int i = 0; i < 3; i++ ) {
+        renderer::jpeg_batch_item item;
+        item.name = (prefix + corruptNames[i]).c_str();
+        item.img = &corruptImages[i];
+        if( !write_temp_file( item.name.c_str(), *corrupt[i] ) ) {
+            common::error() << "cannot write " << item.name << std::endl;
+            succeeded = false;
+        }
+        items.insert( items.begin() + 1 + i * 2, item );
+        valid.insert( valid.begin() + 1 + i * 2, false );
+    }
+
+    /* the loads */
+    static const struct {
+        renderer::pixel_format  fmt;
+        const char *            name;
+    } loadFormats[] = {
+        { renderer::PIXEL_FORMAT_AUTO, "auto" },
+        { renderer::PIXEL_FORMAT_GRAY8, "gray8" },
+        { renderer::PIXEL_FORMAT_RGBA8, "rgba8" }
+    };
+    for( const auto &f : loadFormats ) {
+        tm.start();
+        equal = check_jpeg_batch_loads( items, valid, f.fmt );
+        common::log() << "load " << f.name << ": " << (equal ? "equal" : "DIFFERS") << ", " << tm.get_elapsed_msec() << " ms" << std::endl;
+        succeeded = succeeded && equal;
+    }
+    for( const auto &item : items ) {
+        std::remove( item.name.c_str() );
+    }
+    return succeeded;
+}
+
+} /* namespace engine */
+
+int main( int argc, char **argv ) {
+    engine::options opt;
+    if( !engine::parse_options( argc, argv, opt ) ) {
+        engine::print_usage();
+        return 1;
+    }
+    /* the paths of the command line are not resources */
+    engine::core::filesystem::set_resources_dir( "" );
+    engine::core::jobs::job_system::initialize( opt.threads );
+    bool succeeded;
+    if( opt.convert ) {
+        succeeded = engine::bench_convert( opt );
+    } else if( opt.tga ) {
+        succeeded = engine::bench_tga( opt );
+    } else if( opt.pngRoundtrip ) {
+        succeeded = engine::bench_png_roundtrip( opt );
+    } else if( opt.mips ) {
+        succeeded = engine::bench_mips( opt );
+    } else if( opt.jpegSimd ) {
+        succeeded = engine::bench_jpeg_simd( opt );
+    } else if( opt.decode ) {
+        succeeded = engine::bench_decode();
+    } else if( opt.decoder ) {
+        succeeded = engine::bench_decoder( opt );
+    } else if( opt.jpegBatch ) {
+        succeeded = engine::bench_jpeg_batch();
+    } else if( opt.pngFilters ) {
+        succeeded = engine::bench_png_filters( opt );
+    } else {
+        succeeded = engine::bench( opt );
+    }
+    int result = succeeded ? 0 : 1;
+    engine::core::jobs::job_system::shutdown();
+    return result;
+}
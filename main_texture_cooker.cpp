@@ -0,0 +1,338 @@
+#include <cstdlib>
+#include <cstring>
+#include <core/string.hpp>
+#include <core/vector.hpp>
+#include <core/timer.hpp>
+#include <core/filesystem.hpp>
+#include <core/jobs.hpp>
+#include <core/common.hpp>
+#include <renderer/image.h>
+#include <renderer/pixel_convert.h>
+#include <renderer/mip_chain.h>
+#include <renderer/compressed_image.h>
+#include <renderer/texture_file.h>
+
+using namespace engine::core;
+
+namespace engine {
+
+/* bc1, bc3 and bc7 with the fast, normal and best quality */
+const int PSNR_RESULTS = 9;
+
+/* command line options */
+struct options {
+    const char *    input{nullptr};
+    const char *    output{nullptr};
+    const char *    format{nullptr};    /* nullptr - rgba8 or rgb8 of the source */
+    renderer::compress_quality  quality{renderer::COMPRESS_QUALITY_NORMAL};
+    renderer::mip_filter        filter{renderer::MIP_FILTER_BOX};
+    bool            srgb{true};
+    int             threads{0};         /* 0 - one per core */
+    int             bench{0};           /* number of the loads of the benchmark */
+    bool            psnr{false};        /* the quality of the block formats, no output */
+    double          minPsnr[PSNR_RESULTS]{};    /* the lowest PSNR of each format and quality */
+};
+
+/* print_usage */
+static void print_usage() {
+    common::log() << "usage: _texture_cooker [--format rgb8|rgba8|bc1|bc3|bc7] [--quality fast|normal|best]\n"
+            "                       [--filter box|kaiser] [--linear] [--threads N]\n"
+            "                       [--bench N] INPUT OUTPUT.tex\n"
+            "       _texture_cooker --psnr [--min-psnr DB[,DB...]] [--threads N] INPUT\n"
+            "--psnr compresses the first level of INPUT to bc1, bc3 and bc7 with\n"
+            "every quality and prints the PSNR of the decoded image and the time,\n"
+            "fails if a better quality has a lower PSNR or a PSNR is below its DB.\n"
+            "one DB is the floor of all the results, nine are the floors in the\n"
+            "printed order.\n"
+            "the paths are relative to the current directory\n";
+}
+
+/* parse_min_psnr
+* one floor for all the results or one per result */
+static bool parse_min_psnr( const char *value, double *minPsnr ) {
+    int count = 0;
+    for( const char *s = value; ; s++ ) {
+        char *end;
+        double db = std::strtod( s, &end );
+        if( end == s || count == PSNR_RESULTS ) {
+            return false;
+        }
+        minPsnr[count++] = db;
+        if( *end == '\0' ) {
+            break;
+        }
+        if( *end != ',' ) {
+            return false;
+        }
+        s = end;
+    }
+    for( int i = count; count == 1 && i < PSNR_RESULTS; i++ ) {
+        minPsnr[i] = minPsnr[0];
+    }
+    return count == 1 || count == PSNR_RESULTS;
+}
+
+/* parse_options */
+static bool parse_options( int argc, char **argv, options &opt ) {
+    int i = 1;
+    for( ; i < argc && argv[i][0] == '-'; i++ ) {
+        const char *arg = argv[i];
+        if( std::strcmp( arg, "--linear" ) == 0 ) {
+            opt.srgb = false;
+            continue;
+        }
+        if( std::strcmp( arg, "--psnr" ) == 0 ) {
+            opt.psnr = true;
+            continue;
+        }
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if( !value ) {
+            return false;
+        }
+        if( std::strcmp( arg, "--format" ) == 0 ) {
+            opt.format = value;
+        } else if( std::strcmp( arg, "--quality" ) == 0 ) {
+            if( std::strcmp( value, "fast" ) == 0 ) {
+                opt.quality = renderer::COMPRESS_QUALITY_FAST;
+            } else if( std::strcmp( value, "normal" ) == 0 ) {
+                opt.quality = renderer::COMPRESS_QUALITY_NORMAL;
+            } else if( std::strcmp( value, "best" ) == 0 ) {
+                opt.quality = renderer::COMPRESS_QUALITY_BEST;
+            } else {
+                return false;
+            }
+        } else if( std::strcmp( arg, "--filter" ) == 0 ) {
+            if( std::strcmp( value, "box" ) == 0 ) {
+                opt.filter = renderer::MIP_FILTER_BOX;
+            } else if( std::strcmp( value, "kaiser" ) == 0 ) {
+                opt.filter = renderer::MIP_FILTER_KAISER;
+            } else {
+                return false;
+            }
+        } else if( std::strcmp( arg, "--threads" ) == 0 ) {
+            opt.threads = std::atoi( value );
+        } else if( std::strcmp( arg, "--bench" ) == 0 ) {
+            opt.bench = std::atoi( value );
+        } else if( std::strcmp( arg, "--min-psnr" ) == 0 ) {
+            if( !parse_min_psnr( value, opt.minPsnr ) ) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+        i++;
+    }
+    if( argc - i != (opt.psnr ? 1 : 2) ) {
+        return false;
+    }
+    opt.input = argv[i];
+    opt.output = opt.psnr ? nullptr : argv[i + 1];
+    return opt.threads >= 0 && opt.bench >= 0;
+}
+
+/* cook
+* all mips of the image are written as is or compressed level by level */
+static bool cook( const options &opt ) {
+    renderer::image img;
+    if( !img.load_from_file( opt.input ) ) {
+        common::error() << "cannot load " << opt.input << std::endl;
+        return false;
+    }
+    string format( opt.format ? opt.format : (img.get_bpp() == 32 ? "rgba8" : "rgb8") );
+    bool compressed = true;
+    renderer::block_format blockFmt = renderer::BLOCK_FORMAT_BC1;
+    renderer::pixel_format pixelFmt = renderer::PIXEL_FORMAT_RGBA8;
+    if( format == "rgb8" ) {
+        compressed = false;
+        pixelFmt = renderer::PIXEL_FORMAT_RGB8;
+    } else if( format == "rgba8" ) {
+        compressed = false;
+    } else if( format == "bc1" ) {
+        blockFmt = renderer::BLOCK_FORMAT_BC1;
+    } else if( format == "bc3" ) {
+        blockFmt = renderer::BLOCK_FORMAT_BC3;
+    } else if( format == "bc7" ) {
+        blockFmt = renderer::BLOCK_FORMAT_BC7;
+    } else {
+        common::error() << "unknown format " << format << std::endl;
+        return false;
+    }
+
+    core::timer tm;
+    tm.start();
+    /* the rows are not padded, the pixels are converted as one row */
+    renderer::image src;
+    src.reserve( img.get_width(), img.get_height(), pixelFmt );
+    renderer::convert_row( img.get_pixel_format(), pixelFmt, img.get_line_ptr( 0 ), src.get_line_ptr( 0 ),
+            img.get_width() * img.get_height() );
+    renderer::mip_chain mips;
+    if( !mips.generate( src, opt.filter, opt.srgb ) ) {
+        common::error() << "cannot generate the mips of " << opt.input << std::endl;
+        return false;
+    }
+    int levelsNumber = mips.get_levels_number();
+    bool succeeded;
+    if( compressed ) {
+        core::vector<renderer::compressed_image> levels( levelsNumber );
+        for( int i = 0; i < levelsNumber; i++ ) {
+            if( !levels[i].compress( mips.get_level_ptr( i ), mips.get_width( i ), mips.get_height( i ),
+                    mips.get_width( i ) * 4, pixelFmt, blockFmt, opt.quality ) ) {
+                common::error() << "cannot compress the level " << i << " of " << opt.input << " to " << format << std::endl;
+                return false;
+            }
+        }
+        succeeded = renderer::texture_file::save( opt.output, levels.data(), levelsNumber, opt.srgb );
+    } else {
+        succeeded = renderer::texture_file::save( opt.output, mips, opt.srgb );
+    }
+    if( succeeded ) {
+        common::log() << opt.input << " -> " << opt.output << ": " << format << ", "
+                << img.get_width() << "x" << img.get_height() << ", " << levelsNumber << " levels, "
+                << tm.get_elapsed_msec() << " ms" << std::endl;
+    }
+    return succeeded;
+}
+
+/* bench
+* loading of the source image and of the cooked texture, the
+* files are in the system cache after the first load. The image
+* loads the first level of the uncompressed texture only */
+static void bench( const options &opt ) {
+    core::timer tm;
+    float sourceMsec = 0.0f;
+    float imageMsec = 0.0f;
+    float mappedMsec = 0.0f;
+    renderer::texture_file cookedFile;
+    bool compressed = cookedFile.open( opt.output ) && cookedFile.is_compressed();
+    cookedFile.close();
+    core::vector<byte> upload;
+    for( int i = 0; i < opt.bench; i++ ) {
+        renderer::image source;
+        tm.start();
+        source.load_from_file( opt.input );
+        sourceMsec += tm.get_elapsed_msec();
+
+        if( !compressed ) {
+            renderer::image cooked;
+            tm.start();
+            cooked.load_from_file( opt.output );
+            imageMsec += tm.get_elapsed_msec();
+        }
+
+        /* the mapping and the copy of all levels as the upload does */
+        renderer::texture_file tex;
+        tm.start();
+        if( tex.open( opt.output ) ) {
+            size_t size = 0;
+            for( int level = 0; level < tex.get_levels_number(); level++ ) {
+                size += tex.get_level_size( level );
+            }
+            upload.resize( size );
+            size = 0;
+            for( int level = 0; level < tex.get_levels_number(); level++ ) {
+                memcpy( upload.data() + size, tex.get_level_ptr( level ), tex.get_level_size( level ) );
+                size += tex.get_level_size( level );
+            }
+        }
+        mappedMsec += tm.get_elapsed_msec();
+    }
+    common::log() << "loads: " << opt.bench << "\n"
+            << "source image msec avg: " << sourceMsec / opt.bench << "\n";
+    if( !compressed ) {
+        common::log() << "cooked image msec avg: " << imageMsec / opt.bench << "\n";
+    }
+    common::log() << "cooked mapped all levels msec avg: " << mappedMsec / opt.bench << std::endl;
+}
+
+/* psnr
+* the source is compressed as RGBA8, the formats without alpha compare
+* the RGB channels only. The time is of the compression. The qualities
+* are from the fastest, each one is at least as good as the previous */
+static bool psnr( const options &opt ) {
+    static const struct {
+        const char *            name;
+        renderer::block_format  fmt;
+        bool                    alpha;
+    } formats[] = {
+        { "bc1", renderer::BLOCK_FORMAT_BC1, false },
+        { "bc3", renderer::BLOCK_FORMAT_BC3, true },
+        { "bc7", renderer::BLOCK_FORMAT_BC7, true }
+    };
+    static const struct {
+        const char *                name;
+        renderer::compress_quality  quality;
+    } qualities[] = {
+        { "fast", renderer::COMPRESS_QUALITY_FAST },
+        { "normal", renderer::COMPRESS_QUALITY_NORMAL },
+        { "best", renderer::COMPRESS_QUALITY_BEST }
+    };
+    renderer::image img;
+    if( !img.load_from_file( opt.input, renderer::PIXEL_FORMAT_RGBA8 ) ) {
+        common::error() << "cannot load " << opt.input << std::endl;
+        return false;
+    }
+    common::log() << opt.input << ": " << img.get_width() << "x" << img.get_height() << std::endl;
+    core::timer tm;
+    bool succeeded = true;
+    int result = 0;
+    for( const auto &f : formats ) {
+        const char *previous = nullptr;
+        double previousDb = 0.0;
+        for( const auto &q : qualities ) {
+            const double minPsnr = opt.minPsnr[result++];
+            renderer::compressed_image compressed;
+            tm.start();
+            bool encoded = compressed.compress( img, f.fmt, q.quality );
+            float msec = tm.get_elapsed_msec();
+            if( !encoded ) {
+                common::error() << f.name << " " << q.name << ": cannot compress" << std::endl;
+                succeeded = false;
+                continue;
+            }
+            renderer::image decoded;
+            if( !compressed.decompress( decoded ) ) {
+                common::error() << f.name << " " << q.name << ": cannot decompress" << std::endl;
+                succeeded = false;
+                continue;
+            }
+            double db = renderer::compressed_image::get_psnr( img, decoded, f.alpha );
+            common::log() << "    " << f.name << " " << q.name << ": " << db << " dB " << (f.alpha ? "RGBA" : "RGB")
+                    << ", " << msec << " ms" << std::endl;
+            if( db < minPsnr ) {
+                common::error() << f.name << " " << q.name << ": the PSNR is below " << minPsnr << " dB" << std::endl;
+                succeeded = false;
+            }
+            if( previous && db < previousDb ) {
+                common::error() << f.name << " " << q.name << ": the PSNR is below the " << previous << " one" << std::endl;
+                succeeded = false;
+            }
+            previous = q.name;
+            previousDb = db;
+        }
+    }
+    return succeeded;
+}
+
+} /* namespace engine */
+
+int main( int argc, char **argv ) {
+    engine::options opt;
+    if( !engine::parse_options( argc, argv, opt ) ) {
+        engine::print_usage();
+        return 1;
+    }
+    /* the paths of the command line are not resources */
+    engine::core::filesystem::set_resources_dir( "" );
+    engine::core::jobs::job_system::initialize( opt.threads );
+    if( opt.psnr ) {
+        int result = engine::psnr( opt ) ? 0 : 1;
+        engine::core::jobs::job_system::shutdown();
+        return result;
+    }
+    int result = engine::cook( opt ) ? 0 : 1;
+    if( result == 0 && opt.bench > 0 ) {
+        engine::bench( opt );
+    }
+    engine::core::jobs::job_system::shutdown();
+    return result;
+}
@@ -0,0 +1,797 @@
+#include "compressed_image.h"
+#include "pixel_convert.h"
+#include <core/common.hpp>
+#include <core/jobs.hpp>
+#include <core/simd.hpp>
+#include <cmath>
+#include <cstring>
+#include <climits>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+
+namespace engine {
+namespace renderer {
+
+/*
+================================================
+            Common block functions
+================================================
+*/
+
+/* block of 4x4 RGBA8 pixels */
+static const int BLOCK_PIXELS = 16;
+static const int BLOCK_BYTES = BLOCK_PIXELS * 4;
+
+/* interpolation weights of the BC7 4 bits indices */
+static const int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+/* weights of the second endpoint of the BC1 4 color indices */
+static const float BC1_WEIGHTS[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+/* find_indices
+* the nearest palette color of every pixel of the block, returns the sum of
+* the squared errors. Only the first channels are compared (3 or 4) */
+static int find_indices( const byte *block, const byte *palette, int paletteSize, int channels, byte *indices ) {
+#if SIMD_SSE4_1_ENABLED
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i mask = channels == 4 ? _mm_set1_epi32( -1 ) : _mm_set1_epi32( 0x00ffffff );
+    __m128i pal[16];
+    for( int p = 0; p < paletteSize; p++ ) {
+        int color;
+        memcpy( &color, palette + p * 4, 4 );
+        pal[p] = _mm_unpacklo_epi8( _mm_and_si128( _mm_set1_epi32( color ), mask ), zero );
+    }
+    __m128i total = zero;
+    for( int i = 0; i < BLOCK_PIXELS; i += 4 ) {
+        __m128i px = _mm_and_si128( _mm_loadu_si128( reinterpret_cast<const __m128i*>( block + i * 4 ) ), mask );
+        __m128i lo = _mm_unpacklo_epi8( px, zero );
+        __m128i hi = _mm_unpackhi_epi8( px, zero );
+        __m128i best = _mm_set1_epi32( INT_MAX );
+        __m128i bestIndex = zero;
+        for( int p = 0; p < paletteSize; p++ ) {
+            /* squared distances of 4 pixels */
+            __m128i dlo = _mm_sub_epi16( lo, pal[p] );
+            __m128i dhi = _mm_sub_epi16( hi, pal[p] );
+            __m128i dist = _mm_hadd_epi32( _mm_madd_epi16( dlo, dlo ), _mm_madd_epi16( dhi, dhi ) );
+            __m128i less = _mm_cmplt_epi32( dist, best );
+            best = _mm_min_epi32( best, dist );
+            bestIndex = _mm_blendv_epi8( bestIndex, _mm_set1_epi32( p ), less );
+        }
+        total = _mm_add_epi32( total, best );
+        alignas(16) int index[4];
+        _mm_store_si128( reinterpret_cast<__m128i*>( index ), bestIndex );
+        for( int j = 0; j < 4; j++ ) {
+            indices[i + j] = static_cast<byte>(index[j]);
+        }
+    }
+    total = _mm_hadd_epi32( total, total );
+    total = _mm_hadd_epi32( total, total );
+    return _mm_cvtsi128_si32( total );
+#else
+    int total = 0;
+    for( int i = 0; i < BLOCK_PIXELS; i++ ) {
+        const byte *px = block + i * 4;
+        int best = INT_MAX;
+        for( int p = 0; p < paletteSize; p++ ) {
+            int dist = 0;
+            for( int c = 0; c < channels; c++ ) {
+                int d = px[c] - palette[p * 4 + c];
+                dist += d * d;
+            }
+            if( dist < best ) {
+                best = dist;
+                indices[i] = static_cast<byte>(p);
+            }
+        }
+        total += best;
+    }
+    return total;
+#endif /* SIMD_SSE4_1_ENABLED */
+}
+
+/* bounds_endpoints
+* the diagonal of the bounding box, the channels which go down
+* along the channel of the maximum range are flipped */
+static void bounds_endpoints( const byte *block, int channels, float *e0, float *e1 ) {
+    int lo[4] = { 255, 255, 255, 255 };
+    int hi[4] = { 0, 0, 0, 0 };
+    float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for( int i = 0; i < BLOCK_PIXELS; i++ ) {
+        for( int c = 0; c < channels; c++ ) {
+            lo[c] = std::min<int>( lo[c], block[i * 4 + c] );
+            hi[c] = std::max<int>( hi[c], block[i * 4 + c] );
+            mean[c] += block[i * 4 + c] * (1.0f / BLOCK_PIXELS);
+        }
+    }
+    int major = 0;
+    for( int c = 1; c < channels; c++ ) {
+        if( hi[c] - lo[c] > hi[major] - lo[major] ) {
+            major = c;
+        }
+    }
+    for( int c = 0; c < channels; c++ ) {
+        float cov = 0.0f;
+        for( int i = 0; i < BLOCK_PIXELS; i++ ) {
+            cov += (block[i * 4 + c] - mean[c]) * (block[i * 4 + major] - mean[major]);
+        }
+        e0[c] = static_cast<float>(cov < 0.0f ? hi[c] : lo[c]);
+        e1[c] = static_cast<float>(cov < 0.0f ? lo[c] : hi[c]);
+    }
+}
+
+/* principal_endpoints
+* the pixels projected to the principal axis of the channels */
+static void principal_endpoints( const byte *block, int channels, float *e0, float *e1 ) {
+    float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for( int i = 0; i < BLOCK_PIXELS; i++ ) {
+        for( int c = 0; c < channels; c++ ) {
+            mean[c] += block[i * 4 + c] * (1.0f / BLOCK_PIXELS);
+        }
+    }
+    float cov[4][4] = {};
+    for( int i = 0; i < BLOCK_PIXELS; i++ ) {
+        float d[4];
+        for( int c = 0; c < channels; c++ ) {
+            d[c] = block[i * 4 + c] - mean[c];
+        }
+        for( int a = 0; a < channels; a++ ) {
+            for( int b = a; b < channels; b++ ) {
+                cov[a][b] += d[a] * d[b];
+            }
+        }
+    }
+    /* power iterations from the bounding box diagonal */
+    float axis[4];
+    bounds_endpoints( block, channels, e0, e1 );
+    for( int c = 0; c < channels; c++ ) {
+        axis[c] = e1[c] - e0[c];
+    }
+    for( int iteration = 0; iteration < 8; iteration++ ) {
+        float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float length = 0.0f;
+        for( int a = 0; a < channels; a++ ) {
+            for( int b = 0; b < channels; b++ ) {
+                next[a] += (a <= b ? cov[a][b] : cov[b][a]) * axis[b];
+            }
+            length = std::max( length, std::fabs( next[a] ) );
+        }
+        if( length < 1e-6f ) {
+            break;
+        }
+        for( int c = 0; c < channels; c++ ) {
+            axis[c] = next[c] / length;
+        }
+    }
+    float length = 0.0f;
+    for( int c = 0; c < channels; c++ ) {
+        length += axis[c] * axis[c];
+    }
+    if( length < 1e-12f ) {
+        /* the solid block */
+        for( int c = 0; c < channels; c++ ) {
+            e0[c] = e1[c] = mean[c];
+        }
+        return;
+    }
+    float lo = std::numeric_limits<float>::max();
+    float hi = -lo;
+    for( int i = 0; i < BLOCK_PIXELS; i++ ) {
+        float t = 0.0f;
+        for( int c = 0; c < channels; c++ ) {
+            t += (block[i * 4 + c] - mean[c]) * axis[c];
+        }
+        lo = std::min( lo, t );
+        hi = std::max( hi, t );
+    }
+    for( int c = 0; c < channels; c++ ) {
+        e0[c] = std::max( 0.0f, std::min( mean[c] + axis[c] * lo / length, 255.0f ) );
+        e1[c] = std::max( 0.0f, std::min( mean[c] + axis[c] * hi / length, 255.0f ) );
+    }
+}
+
+/* refine_endpoints
+* least squares endpoints for the indices, weights are the positions
+* of the indices from e0 to e1. Returns false if there is no solution */
+static bool refine_endpoints( const byte *block, int channels, const byte *indices, const float *weights, float *e0, float *e1 ) {
+    float aa = 0.0f;
+    float bb = 0.0f;
+    float ab = 0.0f;
+    float ax[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    float bx[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for( int i = 0; i < BLOCK_PIXELS; i++ ) {
+        float b = weights[indices[i]];
+        float a = 1.0f - b;
+        aa += a * a;
+        bb += b * b;
+        ab += a * b;
+        for( int c = 0; c < channels; c++ ) {
+            ax[c] += a * block[i * 4 + c];
+            bx[c] += b * block[i * 4 + c];
+        }
+    }
+    float det = aa * bb - ab * ab;
+    if( std::fabs( det ) < 1e-6f ) {
+        return false;
+    }
+    float inv = 1.0f / det;
+    for( int c = 0; c < channels; c++ ) {
+        e0[c] = std::max( 0.0f, std::min( (ax[c] * bb - bx[c] * ab) * inv, 255.0f ) );
+        e1[c] = std::max( 0.0f, std::min( (bx[c] * aa - ax[c] * ab) * inv, 255.0f ) );
+    }
+    return true;
+}
+
+/* get_refinements */
+static int get_refinements( compress_quality quality ) {
+    switch( quality ) {
+        case COMPRESS_QUALITY_FAST:
+            return 0;
+        case COMPRESS_QUALITY_NORMAL:
+            return 1;
+        case COMPRESS_QUALITY_BEST:
+            return 4;
+    }
+    return 0;
+}
+
+/*
+================================================
+            BC1 color block
+================================================
+*/
+
+/* color_to_565 */
+inline static int color_to_565( const float *color ) {
+    int r = static_cast<int>(color[0] * (31.0f / 255.0f) + 0.5f);
+    int g = static_cast<int>(color[1] * (63.0f / 255.0f) + 0.5f);
+    int b = static_cast<int>(color[2] * (31.0f / 255.0f) + 0.5f);
+    return (r << 11) | (g << 5) | b;
+}
+
+/* color_from_565 */
+inline static void color_from_565( int color, byte *rgba ) {
+    int r = (color >> 11) & 31;
+    int g = (color >> 5) & 63;
+    int b = color & 31;
+    rgba[0] = static_cast<byte>((r << 3) | (r >> 2));
+    rgba[1] = static_cast<byte>((g << 2) | (g >> 4));
+    rgba[2] = static_cast<byte>((b << 3) | (b >> 2));
+    rgba[3] = 255;
+}
+
+/* bc1_palette
+* 4 RGBA colors of the endpoints. If c0 <= c1 and the
+* three colors are allowed, the last color is transparent black */
+static void bc1_palette( int c0, int c1, bool threeColors, byte *palette ) {
+    color_from_565( c0, palette );
+    color_from_565( c1, palette + 4 );
+    if( c0 > c1 || !threeColors ) {
+        for( int c = 0; c < 3; c++ ) {
+            palette[8 + c] = static_cast<byte>((2 * palette[c] + palette[4 + c]) / 3);
+            palette[12 + c] = static_cast<byte>((palette[c] + 2 * palette[4 + c]) / 3);
+        }
+        palette[11] = 255;
+        palette[15] = 255;
+    } else {
+        for( int c = 0; c < 3; c++ ) {
+            palette[8 + c] = static_cast<byte>((palette[c] + palette[4 + c]) / 2);
+            palette[12 + c] = 0;
+        }
+        palette[11] = 255;
+        palette[15] = 0;
+    }
+}
+
+/* bc1_fit
+* quantizes the endpoints so c0 >= c1 and finds the indices */
+static int bc1_fit( const byte *block, const float *e0, const float *e1, bool threeColors, int &c0, int &c1, byte *indices ) {
+    c0 = color_to_565( e0 );
+    c1 = color_to_565( e1 );
+    if( c0 < c1 ) {
+        std::swap( c0, c1 );
+    }
+    byte palette[16];
+    bc1_palette( c0, c1, threeColors, palette );
+    /* equal endpoints select the three colors, the transparent black is not used */
+    return find_indices( block, palette, c0 == c1 && threeColors ? 3 : 4, 3, indices );
+}
+
+/* bc1_encode_block
+* threeColors is false for the color block of BC3 */
+static void bc1_encode_block( const byte *block, compress_quality quality, bool threeColors, byte *out ) {
+    float e0[4];
+    float e1[4];
+    if( quality == COMPRESS_QUALITY_FAST ) {
+        bounds_endpoints( block, 3, e0, e1 );
+    } else {
+        principal_endpoints( block, 3, e0, e1 );
+    }
+    int c0;
+    int c1;
+    byte indices[BLOCK_PIXELS];
+    int error = bc1_fit( block, e0, e1, threeColors, c0, c1, indices );
+    for( int i = get_refinements( quality ); i > 0 && error > 0 && c0 != c1; i-- ) {
+        int n0;
+        int n1;
+        byte nextIndices[BLOCK_PIXELS];
+        if( !refine_endpoints( block, 3, indices, BC1_WEIGHTS, e0, e1 ) ) {
+            break;
+        }
+        int nextError = bc1_fit( block, e0, e1, threeColors, n0, n1, nextIndices );
+        if( nextError >= error ) {
+            break;
+        }
+        error = nextError;
+        c0 = n0;
+        c1 = n1;
+        memcpy( indices, nextIndices, BLOCK_PIXELS );
+    }
+
+    dword bits = 0;
+    for( int i = 0; i < BLOCK_PIXELS; i++ ) {
+        bits |= static_cast<dword>(indices[i]) << (2 * i);
+    }
+    out[0] = static_cast<byte>(c0);
+    out[1] = static_cast<byte>(c0 >> 8);
+    out[2] = static_cast<byte>(c1);
+    out[3] = static_cast<byte>(c1 >> 8);
+    for( int i = 0; i < 4; i++ ) {
+        out[4 + i] = static_cast<byte>(bits >> (8 * i));
+    }
+}
+
+/* bc1_decode_block */
+static void bc1_decode_block( const byte *in, bool threeColors, byte *block ) {
+    int c0 = in[0] | (in[1] << 8);
+    int c1 = in[2] | (in[3] << 8);
+    byte palette[16];
+    bc1_palette( c0, c1, threeColors, palette );
+    for( int i = 0; i < BLOCK_PIXELS; i++ ) {
+        int index = (in[4 + i / 4] >> (2 * (i % 4))) & 3;
+        memcpy( block + i * 4, palette + index * 4, 4 );
+    }
+}
+
+/*
+================================================
+            BC3 alpha block
+================================================
+*/
+
+/* alpha_palette
+* 8 interpolated values for a0 > a1 */
+static void alpha_palette( int a0, int a1, int *palette ) {
+    palette[0] = a0;
+    palette[1] = a1;
+    if( a0 > a1 ) {
+        for( int i = 1; i < 7; i++ ) {
+            palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+        }
+    } else {
+        for( int i = 1; i < 5; i++ ) {
+            palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+/* alpha_fit */
+static int alpha_fit( const byte *block, int a0, int a1, byte *indices ) {
+    int palette[8];
+    alpha_palette( a0, a1, palette );
+    int error = 0;
+    for( int i = 0; i < BLOCK_PIXELS; i++ ) {
+        int alpha = block[i * 4 + 3];
+        int best = INT_MAX;
+        for( int p = 0; p < 8; p++ ) {
+            int d = (alpha - palette[p]) * (alpha - palette[p]);
+            if( d < best ) {
+                best = d;
+                indices[i] = static_cast<byte>(p);
+            }
+        }
+        error += best;
+    }
+    return error;
+}
+
+/* alpha_encode_block
+* the 8 values mode, the best quality tries the endpoints inside the range */
+static void alpha_encode_block( const byte *block, compress_quality quality, byte *out ) {
+    int lo = 255;
+    int hi = 0;
+    for( int i = 0; i < BLOCK_PIXELS; i++ ) {
+        lo = std::min<int>( lo, block[i * 4 + 3] );
+        hi = std::max<int>( hi, block[i * 4 + 3] );
+    }
+    int a0 = hi;
+    int a1 = lo;
+    byte indices[BLOCK_PIXELS];
+    int error = alpha_fit( block, a0, a1, indices );
+    if( quality == COMPRESS_QUALITY_BEST ) {
+        const int range = 3;
+        for( int d0 = 0; d0 <= range && error > 0; d0++ ) {
+            for( int d1 = 0; d1 <= range; d1++ ) {
+                if( (d0 == 0 && d1 == 0) || hi - d0 <= lo + d1 ) {
+                    continue;
+                }
+                byte nextIndices[BLOCK_PIXELS];
+                int nextError = alpha_fit( block, hi - d0, lo + d1, nextIndices );
+                if( nextError < error ) {
+                    error = nextError;
+                    a0 = hi - d0;
+                    a1 = lo + d1;
+                    memcpy( indices, nextIndices, BLOCK_PIXELS );
+                }
+            }
+        }
+    }
+
+    out[0] = static_cast<byte>(a0);
+    out[1] = static_cast<byte>(a1);
+    uint64_t bits = 0;
+    for( int i = 0; i < BLOCK_PIXELS; i++ ) {
+        bits |= static_cast<uint64_t>(indices[i]) << (3 * i);
+    }
+    for( int i = 0; i < 6; i++ ) {
+        out[2 + i] = static_cast<byte>(bits >> (8 * i));
+    }
+}
+
+/* alpha_decode_block */
+static void alpha_decode_block( const byte *in, byte *block ) {
+    int palette[8];
+    alpha_palette( in[0], in[1], palette );
+    uint64_t bits = 0;
+    for( int i = 0; i < 6; i++ ) {
+        bits |= static_cast<uint64_t>(in[2 + i]) << (8 * i);
+    }
+    for( int i = 0; i < BLOCK_PIXELS; i++ ) {
+        block[i * 4 + 3] = static_cast<byte>(palette[(bits >> (3 * i)) & 7]);
+    }
+}
+
+/*
+================================================
+            BC7 mode 6 block
+================================================
+*/
+
+/* bc7_endpoints
+* endpoint of 7 bits per channel and the shared lowest bit */
+struct bc7_endpoints {
+    int             color[2][4];    /* 7 bits */
+    int             pbit[2];
+};
+
+/* bc7_palette */
+static void bc7_palette( const bc7_endpoints &e, byte *palette ) {
+    int e0[4];
+    int e1[4];
+    for( int c = 0; c < 4; c++ ) {
+        e0[c] = (e.color[0][c] << 1) | e.pbit[0];
+        e1[c] = (e.color[1][c] << 1) | e.pbit[1];
+    }
+    for( int i = 0; i < 16; i++ ) {
+        for( int c = 0; c < 4; c++ ) {
+            palette[i * 4 + c] = static_cast<byte>(((64 - BC7_WEIGHTS[i]) * e0[c] + BC7_WEIGHTS[i] * e1[c] + 32) >> 6);
+        }
+    }
+}
+
+/* bc7_quantize */
+inline static void bc7_quantize( const float *endpoint, int pbit, int *color ) {
+    for( int c = 0; c < 4; c++ ) {
+        int value = static_cast<int>((endpoint[c] - pbit) * 0.5f + 0.5f);
+        color[c] = std::max( 0, std::min( value, 127 ) );
+    }
+}
+
+/* bc7_fit
+* quantizes the endpoints with the p-bits of the quality
+* and finds the indices, opaque blocks keep alpha 255 */
+static int bc7_fit( const byte *block, const float *e0, const float *e1, bool opaque, compress_quality quality,
+        bc7_endpoints &best, byte *indices ) {
+    int bestError = INT_MAX;
+    for( int p = 0; p < 4; p++ ) {
+        bc7_endpoints e;
+        e.pbit[0] = p & 1;
+        e.pbit[1] = p >> 1;
+        if( opaque && p != 3 ) {
+            continue;
+        }
+        if( quality == COMPRESS_QUALITY_FAST && !opaque ) {
+            /* the p-bit of the rounded green */
+            int g0 = static_cast<int>(e0[1] + 0.5f) & 1;
+            int g1 = static_cast<int>(e1[1] + 0.5f) & 1;
+            if( e.pbit[0] != g0 || e.pbit[1] != g1 ) {
+                continue;
+            }
+        }
+        bc7_quantize( e0, e.pbit[0], e.color[0] );
+        bc7_quantize( e1, e.pbit[1], e.color[1] );
+        if( opaque ) {
+            e.color[0][3] = e.color[1][3] = 127;
+        }
+        byte palette[64];
+        byte nextIndices[BLOCK_PIXELS];
+        bc7_palette( e, palette );
+        int error = find_indices( block, palette, 16, 4, nextIndices );
+        if( error < bestError ) {
+            bestError = error;
+            best = e;
+            memcpy( indices, nextIndices, BLOCK_PIXELS );
+        }
+    }
+    return bestError;
+}
+
+/* bit_writer
+* the bits are written from the lowest bit of the first byte */
+class bit_writer {
+public:
+                    bit_writer( byte *data ) : data{data} {}
+    void            write( int value, int bits );
+private:
+    byte *          data;
+    int             position{0};
+};
+
+/* bit_writer::write */
+inline void bit_writer::write( int value, int bits ) {
+    for( int i = 0; i < bits; i++, position++ ) {
+        if( (value >> i) & 1 ) {
+            data[position >> 3] |= static_cast<byte>(1 << (position & 7));
+        }
+    }
+}
+
+/* bit_reader */
+class bit_reader {
+public:
+                    bit_reader( const byte *data ) : data{data} {}
+    int             read( int bits );
+private:
+    const byte *    data;
+    int             position{0};
+};
+
+/* bit_reader::read */
+inline int bit_reader::read( int bits ) {
+    int value = 0;
+    for( int i = 0; i < bits; i++, position++ ) {
+        value |= ((data[position >> 3] >> (position & 7)) & 1) << i;
+    }
+    return value;
+}
+
+/* bc7_encode_block */
+static void bc7_encode_block( const byte *block, compress_quality quality, byte *out ) {
+    bool opaque = true;
+    for( int i = 0; i < BLOCK_PIXELS; i++ ) {
+        opaque = opaque && block[i * 4 + 3] == 255;
+    }
+    float e0[4];
+    float e1[4];
+    if( quality == COMPRESS_QUALITY_FAST ) {
+        bounds_endpoints( block, 4, e0, e1 );
+    } else {
+        principal_endpoints( block, 4, e0, e1 );
+    }
+    bc7_endpoints e;
+    byte indices[BLOCK_PIXELS];
+    int error = bc7_fit( block, e0, e1, opaque, quality, e, indices );
+    float weights[16];
+    for( int i = 0; i < 16; i++ ) {
+        weights[i] = BC7_WEIGHTS[i] / 64.0f;
+    }
+    for( int i = get_refinements( quality ); i > 0 && error > 0; i-- ) {
+        bc7_endpoints next;
+        byte nextIndices[BLOCK_PIXELS];
+        if( !refine_endpoints( block, 4, indices, weights, e0, e1 ) ) {
+            break;
+        }
+        int nextError = bc7_fit( block, e0, e1, opaque, quality, next, nextIndices );
+        if( nextError >= error ) {
+            break;
+        }
+        error = nextError;
+        e = next;
+        memcpy( indices, nextIndices, BLOCK_PIXELS );
+    }
+
+    /* the highest bit of the first index is implicit zero */
+    if( indices[0] >= 8 ) {
+        std::swap( e.color[0], e.color[1] );
+        std::swap( e.pbit[0], e.pbit[1] );
+        for( int i = 0; i < BLOCK_PIXELS; i++ ) {
+            indices[i] = static_cast<byte>(15 - indices[i]);
+        }
+    }
+
+    memset( out, 0, 16 );
+    bit_writer bits( out );
+    bits.write( 1 << 6, 7 );
+    for( int c = 0; c < 4; c++ ) {
+        bits.write( e.color[0][c], 7 );
+        bits.write( e.color[1][c], 7 );
+    }
+    bits.write( e.pbit[0], 1 );
+    bits.write( e.pbit[1], 1 );
+    bits.write( indices[0], 3 );
+    for( int i = 1; i < BLOCK_PIXELS; i++ ) {
+        bits.write( indices[i], 4 );
+    }
+}
+
+/* bc7_decode_block
+* returns false for the modes other than 6 */
+static bool bc7_decode_block( const byte *in, byte *block ) {
+    if( (in[0] & 0x7f) != 0x40 ) {
+        memset( block, 0, BLOCK_BYTES );
+        return false;
+    }
+    bit_reader bits( in );
+    bits.read( 7 );
+    bc7_endpoints e;
+    for( int c = 0; c < 4; c++ ) {
+        e.color[0][c] = bits.read( 7 );
+        e.color[1][c] = bits.read( 7 );
+    }
+    e.pbit[0] = bits.read( 1 );
+    e.pbit[1] = bits.read( 1 );
+    byte palette[64];
+    bc7_palette( e, palette );
+    for( int i = 0; i < BLOCK_PIXELS; i++ ) {
+        int index = bits.read( i == 0 ? 3 : 4 );
+        memcpy( block + i * 4, palette + index * 4, 4 );
+    }
+    return true;
+}
+
+/*
+================================================
+            compressed_image
+================================================
+*/
+
+/* compressed_image::compress */
+bool compressed_image::compress( const image &img, block_format fmt, compress_quality quality ) {
+    if( img.is_empty() ) {
+        common::error() << "compressed_image::compress() error: the image is empty" << std::endl;
+        return false;
+    }
+    return compress( img.get_line_ptr( 0 ), img.get_width(), img.get_height(), img.get_stride(),
+            img.get_pixel_format(), fmt, quality );
+}
+
+/* compressed_image::compress */
+bool compressed_image::compress( const byte *pixels, int width, int height, int stride, pixel_format pixelFmt,
+        block_format fmt, compress_quality quality ) {
+    assert( pixels != nullptr );
+    assert( width > 0 && height > 0 );
+    release();
+    this->width = width;
+    this->height = height;
+    this->fmt = fmt;
+    data.resize( get_compressed_size( width, height, fmt ) );
+
+    const int blocksX = (width + 3) / 4;
+    const int blocksY = (height + 3) / 4;
+    const int blockSize = get_block_size( fmt );
+    const bool opaque = pixelFmt != PIXEL_FORMAT_RGBA8 && pixelFmt != PIXEL_FORMAT_BGRA8;
+    auto cvt = get_convert_row_func( pixelFmt, PIXEL_FORMAT_RGBA8 );
+    jobs::parallel_for( 0, blocksY, 1, [&]( int first, int last ) {
+        /* 4 rows of RGBA8 pixels */
+        core::vector<byte> rows( width * 4 * 4 );
+        alignas(16) byte block[BLOCK_BYTES];
+        for( int by = first; by < last; by++ ) {
+            for( int y = 0; y < 4; y++ ) {
+                byte *row = rows.data() + width * 4 * y;
+                cvt( pixels + static_cast<size_t>(stride) * std::min( by * 4 + y, height - 1 ), row, width );
+                for( int x = 0; opaque && x < width; x++ ) {
+                    row[x * 4 + 3] = 255;
+                }
+            }
+            byte *out = data.data() + static_cast<size_t>(blockSize) * blocksX * by;
+            for( int bx = 0; bx < blocksX; bx++, out += blockSize ) {
+                for( int i = 0; i < BLOCK_PIXELS; i++ ) {
+                    int x = std::min( bx * 4 + i % 4, width - 1 );
+                    memcpy( block + i * 4, rows.data() + width * 4 * (i / 4) + x * 4, 4 );
+                }
+                switch( fmt ) {
+                    case BLOCK_FORMAT_BC1:
+                        bc1_encode_block( block, quality, true, out );
+                        break;
+                    case BLOCK_FORMAT_BC3:
+                        alpha_encode_block( block, quality, out );
+                        bc1_encode_block( block, quality, false, out + 8 );
+                        break;
+                    case BLOCK_FORMAT_BC7:
+                        bc7_encode_block( block, quality, out );
+                        break;
+                }
+            }
+        }
+    } );
+    return true;
+}
+
+/* compressed_image::decompress */
+bool compressed_image::decompress( image &img ) const {
+    assert( !is_empty() );
+    img.release();
+    img.reserve( width, height, PIXEL_FORMAT_RGBA8 );
+
+    const int blocksX = (width + 3) / 4;
+    const int blocksY = (height + 3) / 4;
+    const int blockSize = get_block_size( fmt );
+    bool succeeded = true;
+    for( int by = 0; by < blocksY; by++ ) {
+        const byte *in = data.data() + static_cast<size_t>(blockSize) * blocksX * by;
+        for( int bx = 0; bx < blocksX; bx++, in += blockSize ) {
+            byte block[BLOCK_BYTES];
+            switch( fmt ) {
+                case BLOCK_FORMAT_BC1:
+                    bc1_decode_block( in, true, block );
+                    break;
+                case BLOCK_FORMAT_BC3:
+                    bc1_decode_block( in + 8, false, block );
+                    alpha_decode_block( in, block );
+                    break;
+                case BLOCK_FORMAT_BC7:
+                    succeeded = bc7_decode_block( in, block ) && succeeded;
+                    break;
+            }
+            int w = std::min( 4, width - bx * 4 );
+            int h = std::min( 4, height - by * 4 );
+            for( int y = 0; y < h; y++ ) {
+                memcpy( img.get_pixel_ptr( bx * 4, by * 4 + y ), block + y * 16, w * 4 );
+            }
+        }
+    }
+    if( !succeeded ) {
+        common::error() << "compressed_image::decompress() error: unsupported BC7 mode" << std::endl;
+    }
+    return succeeded;
+}
+
+/* compressed_image::release */
+void compressed_image::release() {
+    data.clear();
+    data.shrink_to_fit();
+    width = 0;
+    height = 0;
+}
+
+/* compressed_image::get_psnr */
+double compressed_image::get_psnr( const image &a, const image &b, bool alpha ) {
+    assert( a.get_width() == b.get_width() && a.get_height() == b.get_height() );
+    const int width = a.get_width();
+    const int channels = alpha ? 4 : 3;
+    core::vector<byte> rowA( width * 4 );
+    core::vector<byte> rowB( width * 4 );
+    double sum = 0.0;
+    for( int y = 0; y < a.get_height(); y++ ) {
+        convert_row( a.get_pixel_format(), PIXEL_FORMAT_RGBA8, a.get_line_ptr( y ), rowA.data(), width );
+        convert_row( b.get_pixel_format(), PIXEL_FORMAT_RGBA8, b.get_line_ptr( y ), rowB.data(), width );
+        uint64_t rowSum = 0;
+        for( int x = 0; x < width; x++ ) {
+            for( int c = 0; c < channels; c++ ) {
+                int d = rowA[x * 4 + c] - rowB[x * 4 + c];
+                rowSum += d * d;
+            }
+        }
+        sum += static_cast<double>(rowSum);
+    }
+    double mse = sum / (static_cast<double>(width) * a.get_height() * channels);
+    if( mse == 0.0 ) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return 10.0 * std::log10( 255.0 * 255.0 / mse );
+}
+
+} /* namespace renderer */
+} /* namespace engine */
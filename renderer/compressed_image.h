@@ -0,0 +1,104 @@
+#pragma once
+#include <core/types.hpp>
+#include <core/vector.hpp>
+#include <core/assert.hpp>
+#include "image.h"
+
+using namespace engine::core;
+
+namespace engine {
+namespace renderer {
+
+enum block_format {
+    BLOCK_FORMAT_BC1,           /* RGB 4 bits per pixel, opaque */
+    BLOCK_FORMAT_BC3,           /* RGBA 8 bits per pixel, BC1 color and 3 bits alpha */
+    BLOCK_FORMAT_BC7            /* RGBA 8 bits per pixel, the encoder writes mode 6 */
+};
+
+enum compress_quality {
+    COMPRESS_QUALITY_FAST,      /* bounding box endpoints */
+    COMPRESS_QUALITY_NORMAL,    /* principal axis endpoints refined by least squares */
+    COMPRESS_QUALITY_BEST       /* more refinements and the endpoint search */
+};
+
+/* compressed_image
+* 4x4 pixel blocks of the image, the blocks are stored by rows.
+* The pixels of the blocks outside of the image repeat the edge */
+class compressed_image {
+public:
+                    compressed_image() {}
+
+                    /* the blocks are compressed by the job system,
+                    * the pixels of the formats without alpha are opaque */
+    bool            compress( const image &img, block_format fmt, compress_quality quality = COMPRESS_QUALITY_NORMAL );
+    bool            compress( const byte *pixels, int width, int height, int stride, pixel_format pixelFmt,
+                            block_format fmt, compress_quality quality = COMPRESS_QUALITY_NORMAL );
+                    /* decodes to RGBA8, returns false for the BC7 modes other than 6 */
+    bool            decompress( image &img ) const;
+    void            release();
+
+    bool            is_empty() const;
+    int             get_width() const;
+    int             get_height() const;
+    block_format    get_format() const;
+    const byte *    get_data() const;
+    size_t          get_size() const;
+
+                    /* bytes of one block */
+    static int      get_block_size( block_format fmt );
+    static size_t   get_compressed_size( int width, int height, block_format fmt );
+                    /* peak signal to noise ratio of the RGB or RGBA channels in dB,
+                    * the images must have the same size */
+    static double   get_psnr( const image &a, const image &b, bool alpha = false );
+
+private:
+    core::vector<byte>  data;
+    int             width{0};
+    int             height{0};
+    block_format    fmt{BLOCK_FORMAT_BC1};
+};
+
+
+
+/* compressed_image::is_empty */
+inline bool compressed_image::is_empty() const {
+    return data.empty();
+}
+
+/* compressed_image::get_width */
+inline int compressed_image::get_width() const {
+    return width;
+}
+
+/* compressed_image::get_height */
+inline int compressed_image::get_height() const {
+    return height;
+}
+
+/* compressed_image::get_format */
+inline block_format compressed_image::get_format() const {
+    return fmt;
+}
+
+/* compressed_image::get_data */
+inline const byte *compressed_image::get_data() const {
+    return data.data();
+}
+
+/* compressed_image::get_size */
+inline size_t compressed_image::get_size() const {
+    return data.size();
+}
+
+/* compressed_image::get_block_size */
+inline int compressed_image::get_block_size( block_format fmt ) {
+    return fmt == BLOCK_FORMAT_BC1 ? 8 : 16;
+}
+
+/* compressed_image::get_compressed_size */
+inline size_t compressed_image::get_compressed_size( int width, int height, block_format fmt ) {
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * get_block_size( fmt );
+}
+
+} /* namespace renderer */
+} /* namespace engine */
@@ -1,7 +1,15 @@
 #include "image.h"
+#include "pixel_convert.h"
+#include "texture_file.h"
 #include <core/common.hpp>
 #include <core/filesystem.hpp>
 #include <core/math.hpp>
+#include <core/simd.hpp>
+#include <core/jobs.hpp>
+#include <core/timer.hpp>
+#include <cstring>
+#include <algorithm>
+#include <climits>
 extern "C" {
 #include <jpeg-6b/jpeglib.h>
 #include <jpeg-6b/jdatarw.h>
@@ -18,8 +26,114 @@ extern "C" {
 namespace engine {
 namespace renderer {
 
-typedef void(*fnPxcvtFunc)(const byte*,byte*);
-typedef int(*fnPxcmpFunc)(const byte*,const byte*);
+/* image_output
+* destination of the decoders: the image being loaded or the target of
+* image::decode(). A decoder opens it when the size is known and writes
+* the rows straight to it, the flipped target is addressed bottom-up */
+class image_output {
+public:
+                    /* the image is reserved by open() */
+                    image_output( image *img, pixel_format fmt );
+                    image_output( const image_decode_target &target );
+                    /* the headers are read only, open() returns false */
+                    explicit image_output( pixel_format fmt );
+
+                    /* the AUTO format becomes the format of the file.
+                    * Returns false if the rows must not be written */
+    bool            open( int width, int height, pixel_format fileFmt );
+
+                    /* AUTO until open() if the format of the file is requested */
+    pixel_format    get_pixel_format() const;
+    image_info      get_info() const;
+    byte *          get_line_ptr( int y ) const;
+
+private:
+    image *         img{nullptr};
+    byte *          pixels{nullptr};
+    int             width{0};
+    int             height{0};
+    int             targetWidth{0};
+    int             targetHeight{0};
+    int             stride{0};
+    pixel_format    fmt{PIXEL_FORMAT_AUTO};
+    bool            flip{false};
+    bool            infoOnly{false};
+};
+
+/* image_output::image_output */
+image_output::image_output( image *img, pixel_format fmt ) : img( img ), fmt( fmt ) {
+    assert( img != nullptr );
+}
+
+/* image_output::image_output */
+image_output::image_output( const image_decode_target &target ) : 
+        pixels( target.pixels ), 
+        targetWidth( target.width ), 
+        targetHeight( target.height ), 
+        stride( target.stride ), 
+        fmt( target.fmt ), 
+        flip( target.flipVertical ) {
+    assert( pixels != nullptr );
+    assert( stride >= 0 );
+}
+
+/* image_output::image_output */
+image_output::image_output( pixel_format fmt ) : fmt( fmt ), infoOnly( true ) {
+}
+
+/* image_output::open */
+bool image_output::open( int width, int height, pixel_format fileFmt ) {
+    assert( fileFmt != PIXEL_FORMAT_AUTO );
+    if( fmt == PIXEL_FORMAT_AUTO ) {
+        fmt = fileFmt;
+    }
+    this->width = width;
+    this->height = height;
+    if( infoOnly ) {
+        return false;
+    }
+    if( img != nullptr ) {
+        img->reserve( width, height, fmt );
+        pixels = img->get_line_ptr( 0 );
+        stride = img->get_stride();
+        return true;
+    }
+    if( width != targetWidth || height != targetHeight ) {
+        common::error() << "image::decode() error: the image is " << width << "x" << height 
+                << ", the target is " << targetWidth << "x" << targetHeight << std::endl;
+        return false;
+    }
+    const int rowSize = width * (image::pixel_format_to_bpp( fmt ) >> 3);
+    if( stride == 0 ) {
+        stride = rowSize;
+    }
+    if( stride < rowSize ) {
+        common::error() << "image::decode() error: the stride of the target is less than the row" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/* image_output::get_pixel_format */
+inline pixel_format image_output::get_pixel_format() const {
+    return fmt;
+}
+
+/* image_output::get_info */
+image_info image_output::get_info() const {
+    image_info info;
+    info.width = width;
+    info.height = height;
+    info.fmt = fmt;
+    return info;
+}
+
+/* image_output::get_line_ptr */
+inline byte *image_output::get_line_ptr( int y ) const {
+    assert( y >= 0 && y < height );
+    return pixels + static_cast<size_t>(stride) * (flip ? height - y - 1 : y);
+}
+
 
 /* image::image */
 image::image( int width, int height, const pixel_format fmt ) {
@@ -34,21 +148,55 @@ image::~image() {
 /* image::load_from_file */
 bool image::load_from_file( const string &name, pixel_format fmt ) {
     assert( is_empty() );
-    ifstream file( filesystem::open_read(name) );
-    if( file.is_open() ) {
-        if( load_bmp( file, fmt ) ) {
-            return true;
-        } else if( load_png( file, fmt ) ) {
-            return true;
-        } else if( load_tga( file, fmt ) ) {
-            return true;
-        } else if( load_jpg( file, fmt ) ) {
-            return true;
-        }
+    mapped_file file( filesystem::open_mapped(name) );
+    if( !file.is_open() ) {
+        return false;
+    }
+    return load_from_memory( file.data(), file.size(), fmt );
+}
+
+/* image::load_from_memory */
+bool image::load_from_memory( const byte *data, size_t size, pixel_format fmt ) {
+    assert( is_empty() );
+    memory_istream is( data, size );
+    switch( get_image_format( data, size ) ) {
+        case IMAGE_FORMAT_BMP:
+            return load_bmp( is, fmt );
+        case IMAGE_FORMAT_TGA:
+            return load_tga( is, fmt );
+        case IMAGE_FORMAT_JPG:
+            return load_jpg( is, fmt );
+        case IMAGE_FORMAT_PNG:
+            return load_png( is, fmt );
+        case IMAGE_FORMAT_TEX:
+            return load_tex( is, fmt );
+        case IMAGE_FORMAT_AUTO:
+            break;
     }
     return false;
 }
 
+/* image::get_image_format */
+image_format image::get_image_format( const byte *data, size_t size ) {
+    if( size >= 2 && data[0] == 'B' && data[1] == 'M' ) {
+        return IMAGE_FORMAT_BMP;
+    }
+    if( size >= 8 && !png_sig_cmp( data, 0, 8 ) ) {
+        return IMAGE_FORMAT_PNG;
+    }
+    if( size >= 3 && data[0] == 0xff && data[1] == 0xd8 && data[2] == 0xff ) {
+        return IMAGE_FORMAT_JPG;
+    }
+    if( size >= 4 && data[0] == 'E' && data[1] == 'T' && data[2] == 'E' && data[3] == 'X' ) {
+        return IMAGE_FORMAT_TEX;
+    }
+    /* TGA has no signature, load_tga() checks the header */
+    if( size >= 18 ) {
+        return IMAGE_FORMAT_TGA;
+    }
+    return IMAGE_FORMAT_AUTO;
+}
+
 /* image::save_to_file */
 bool image::save_to_file( const string &name, int quality, const pixel_format fmt, image_format imfmt ) {
     assert( !is_empty() );
@@ -93,8 +241,16 @@ bool image::save_to_file( const string &name, int quality, const pixel_format fm
                 compress /= 10;
                 return save_tga( file, fmt, useRle, compress );
             }
-            case IMAGE_FORMAT_JPG:
-                return save_jpg( file, fmt, quality );
+            case IMAGE_FORMAT_JPG: {
+                jpeg_params params;
+                params.quality = quality;
+                return save_jpg( file, fmt, params );
+            }
+            case IMAGE_FORMAT_PNG: {
+                png_save_params params;
+                params.level = 9 - quality * 9 / 100;
+                return save_png( file, fmt, params );
+            }
 
             default:
                 assert( 0 && "Unknown file format" );
@@ -103,6 +259,16 @@ bool image::save_to_file( const string &name, int quality, const pixel_format fm
     return false;
 }
 
+/* image::save_png_to_file */
+bool image::save_png_to_file( const string &name, const png_save_params &params, const pixel_format fmt ) {
+    assert( !is_empty() );
+    ofstream file( filesystem::open_write(name) );
+    if( !file.is_open() ) {
+        return false;
+    }
+    return save_png( file, fmt, params );
+}
+
 /* image::horizontal_flip */
 void image::horizontal_flip() {
     assert( !is_empty() );
@@ -255,214 +421,46 @@ struct rgba32 {
 };
 #pragma pack(pop)
 
-/* pixel covert functions */
-static void pxcvt_bgr8_rgb8( const byte *from, byte *to ) {
-    to[0] = from[2];
-    to[1] = from[1];
-    to[2] = from[0];
-}
-
-static void pxcvt_bgr8_rgba8( const byte *from, byte *to ) {
-    to[0] = from[2];
-    to[1] = from[1];
-    to[2] = from[0];
-    to[3] = 0;
-}
-
-static void pxcvt_bgr8_gray8( const byte *from, byte *to ) {
-    to[0] = (from[2] + from[1] + from[0]) / 3;
-}
-
-static void pxcvt_gray8_bgr8( const byte *from, byte *to ) {
-    to[0] = from[0];
-    to[1] = from[0];
-    to[2] = from[0];
-}
-
-static void pxcvt_gray8_bgra8( const byte *from, byte *to ) {
-    to[0] = from[0];
-    to[1] = from[0];
-    to[2] = from[0];
-    to[3] = 0;
-}
-
-static void pxcvt_bgra8_rgba8( const byte *from, byte *to ) {
-    to[0] = from[2];
-    to[1] = from[1];
-    to[2] = from[0];
-    to[3] = from[3];
-}
-
-static void pxcpy1( const byte *from, byte *to ) {
-    to[0] = from[0];
-}
-
-static void pxcpy3( const byte *from, byte *to ) {
-    to[0] = from[0];
-    to[1] = from[1];
-    to[2] = from[2];
-}
-
-static void pxcpy3_expand1( const byte *from, byte *to ) {
-    to[0] = from[0];
-    to[1] = from[1];
-    to[2] = from[2];
-    to[3] = 0;
-}
-
-static void pxcpy4( const byte *from, byte *to ) {
-    to[0] = from[0];
-    to[1] = from[1];
-    to[2] = from[2];
-    to[3] = from[3];
-}
-
-/* get_pxcvt_func */
-static fnPxcvtFunc get_pxcvt_func( pixel_format from, pixel_format to ) {
-    assert( from != PIXEL_FORMAT_AUTO );
-    assert( to != PIXEL_FORMAT_AUTO );
-    switch(from) {
-        case PIXEL_FORMAT_GRAY8:
-            switch(to) {
-                case PIXEL_FORMAT_GRAY8:    return pxcpy1;
-                case PIXEL_FORMAT_BGR8:     return pxcvt_gray8_bgr8;
-                case PIXEL_FORMAT_BGRA8:    return pxcvt_gray8_bgra8;
-                case PIXEL_FORMAT_RGB8:     return pxcvt_gray8_bgr8;
-                case PIXEL_FORMAT_RGBA8:    return pxcvt_gray8_bgra8;
-                case PIXEL_FORMAT_AUTO:     break;
-            }
-            break;
-        case PIXEL_FORMAT_BGR8:
-            switch(to) {
-                case PIXEL_FORMAT_GRAY8:    return pxcvt_bgr8_gray8;
-                case PIXEL_FORMAT_BGR8:     return pxcpy3;
-                case PIXEL_FORMAT_BGRA8:    return pxcpy3_expand1;
-                case PIXEL_FORMAT_RGB8:     return pxcvt_bgr8_rgb8;
-                case PIXEL_FORMAT_RGBA8:    return pxcvt_bgr8_rgba8;
-                case PIXEL_FORMAT_AUTO:     break;
-            }
-            break;
-        case PIXEL_FORMAT_BGRA8:
-            switch(to) {
-                case PIXEL_FORMAT_GRAY8:    return pxcvt_bgr8_gray8;
-                case PIXEL_FORMAT_BGR8:     return pxcpy3;
-                case PIXEL_FORMAT_BGRA8:    return pxcpy4;
-                case PIXEL_FORMAT_RGB8:     return pxcvt_bgr8_rgb8;
-                case PIXEL_FORMAT_RGBA8:    return pxcvt_bgra8_rgba8;
-                case PIXEL_FORMAT_AUTO:     break;
-            }
-            break;
-        case PIXEL_FORMAT_RGB8:
-            switch(to) {
-                case PIXEL_FORMAT_GRAY8:    return pxcvt_bgr8_gray8;
-                case PIXEL_FORMAT_BGR8:     return pxcvt_bgr8_rgb8;
-                case PIXEL_FORMAT_BGRA8:    return pxcvt_bgr8_rgba8;
-                case PIXEL_FORMAT_RGB8:     return pxcpy3;
-                case PIXEL_FORMAT_RGBA8:    return pxcpy3_expand1;
-                case PIXEL_FORMAT_AUTO:     break;
-            }
-            break;
-        case PIXEL_FORMAT_RGBA8:
-            switch(to) {
-                case PIXEL_FORMAT_GRAY8:    return pxcvt_bgr8_gray8;
-                case PIXEL_FORMAT_BGR8:     return pxcvt_bgr8_rgb8;
-                case PIXEL_FORMAT_BGRA8:    return pxcvt_bgra8_rgba8;
-                case PIXEL_FORMAT_RGB8:     return pxcpy3;
-                case PIXEL_FORMAT_RGBA8:    return pxcpy4;
-                case PIXEL_FORMAT_AUTO:     break;
-            }
-            break;
-        case PIXEL_FORMAT_AUTO: break;
-    }
-    assert(0);
-    return nullptr;
-}
-
-/* pixel comparer */
-static int pxcmp_8( const byte *a, const byte *b ) {
-    return static_cast<int>(*a - *b);
-}
-
-static int pxcmp_24( const byte *a, const byte *b ) {
-    int cmp = 0;
-    for( int i = 0; i < 3; i++ ) {
-        int c = a[i] - b[i];
-        if( core::math::abs(c) > core::math::abs(cmp) ) {
-            cmp = c;
-        }
-    }
-    return cmp;
-}
-
-static int pxcmp_32( const byte *a, const byte *b ) {
-    int cmp = 0;
-    for( int i = 0; i < 4; i++ ) {
-        int c = a[i] - b[i];
-        if( core::math::abs(c) > core::math::abs(cmp) ) {
-            cmp = c;
-        }
-    }
-    return cmp;
-}
-
-/* get_pxcmp_func */
-static fnPxcmpFunc get_pxcmp_func( pixel_format fmt ) {
-    switch(fmt) {
-        case PIXEL_FORMAT_GRAY8:    return pxcmp_8;
-        case PIXEL_FORMAT_BGR8:     return pxcmp_24;
-        case PIXEL_FORMAT_BGRA8:    return pxcmp_32;
-        case PIXEL_FORMAT_RGB8:     return pxcmp_24;
-        case PIXEL_FORMAT_RGBA8:    return pxcmp_32;
-        case PIXEL_FORMAT_AUTO:     break;
-    }
-    assert(0);
-    return nullptr;
-}
-
-/* image::load_bmp */
-bool image::load_bmp( istream &is, pixel_format fmt ) {
+/* bmp_decode */
+static bool bmp_decode( memory_istream &is, image_output &out ) {
     bitmap_file_header header;
     bitmap_info_header info;
     
-    auto pos = is.tellg();
+    auto pos = is.tell();
     /* Check for correct data */
     if( !is.read( reinterpret_cast<char*>(&header), sizeof(header) ) ) {
-        is.seekg( pos );
+        is.seek( pos );
         return false;
     }
     if( !is.read( reinterpret_cast<char*>(&info), sizeof(info) ) ) {
-        is.seekg( pos );
-        return false;
-    }
-    if( !is.good() ) {
-        is.seekg( pos );
+        is.seek( pos );
         return false;
     }
     if( header.signature != BITMAP_SIGNATURE ) {
-        is.seekg( pos );
+        is.seek( pos );
         return false;
     }
     if( info.size != sizeof(info) ) {
         common::error() << "image::load_bmp() error: info.size != sizeof(info)" << std::endl;
-        is.seekg( pos );
+        is.seek( pos );
         return false;
     }
     /* check supported formats */
     if( auto b = info.bitCount; !(b == 8 || b == 16 || b == 24 || b == 32) ) {
         common::error() << "image::load_bmp() error: unsupported format info.bitCount: '" 
             << info.bitCount << "'" << std::endl;
-        is.seekg( pos );
+        is.seek( pos );
         return false;
     }
     if( info.width <= 0 || info.height <= 0 ) {
         common::error() << "image::load_bmp() error: wrong image size" << std::endl;
-        is.seekg( pos );
+        is.seek( pos );
         return false;
     }
     if( info.compression != BITMAP_RGB ) {
         common::error() << "image::load_bmp() error: unsupported compression: '"
                 << info.compression << "'" << std::endl;
-        is.seekg( pos );
+        is.seek( pos );
         return false;
     }
 
@@ -474,12 +472,7 @@ bool image::load_bmp( istream &is, pixel_format fmt ) {
         for( int i = 0; i < static_cast<int>(info.colorUsed); i++ ) {
             if( bitmap_rgba quad; !is.read( reinterpret_cast<char*>(&quad), sizeof(quad) ) ) {
                 common::error() << "image::load_bmp() error: reading error (read quad)" << std::endl;
-                is.seekg( pos );
-                return false;
-            }
-            if( !is.good() ) {
-                common::error() << "image::load_bmp() error: reading error (is good)" << std::endl;
-                is.seekg( pos );
+                is.seek( pos );
                 return false;
             }
         }
@@ -504,41 +497,44 @@ bool image::load_bmp( istream &is, pixel_format fmt ) {
             assert(0);
     }
 
-    /* check pixel format and reserve image */
-    if( fmt == PIXEL_FORMAT_AUTO ) {
-        fmt = bmpFmt;
+    /* the image is reserved or the target is checked */
+    if( !out.open( info.width, info.height, bmpFmt ) ) {
+        is.seek( pos );
+        return false;
     }
-    reserve( info.width, info.height, fmt );
 
-    int bmpPxSize = info.bitCount >> 3;
-    int pxSize = get_bpp() >> 3;
     int stride = ((info.bitCount * info.width + 31) & ~31) >> 3;
     int rowSize = ((info.bitCount * info.width + 7) & ~7) >> 3;
     int dataPadding = stride - rowSize;
     assert( dataPadding == 0 );
-    byte buffer[256];
-    //byte bufferTo[256];
-    fnPxcvtFunc cvt = get_pxcvt_func( bmpFmt, fmt );
+    fnRowcvtFunc cvt = get_convert_row_func( bmpFmt, out.get_pixel_format() );
 
-    is.seekg( header.offset, std::ios_base::beg );
+    /* lines are converted from the file data in place */
+    if( !is.seek( pos + header.offset ) ) {
+        common::error() << "image::load_bmp() error: wrong data offset" << std::endl;
+        is.seek( pos );
+        return false;
+    }
     for( int i = 0; i < info.height; i++ ) {
-        /* Set pointer for copying data */
-        byte *data = this->data.data() + this->stride * (info.height - i - 1);
-        for( int j = 0; j < info.width; j++ ) {
-            /* Read one pixel data from file */
-            if( !is.read( reinterpret_cast<char*>(buffer), bmpPxSize ) ) {
-                release();
-                common::error() << "image::load_bmp() error: reading error (read data)" << std::endl;
-                is.seekg( pos );
-                return false;
-            }
-            cvt( buffer, data );
-            data += pxSize;
-            //this->data.insert( this->data.end(), bufferTo, bufferTo + bmpPxSize );
-        }
-        if( dataPadding ) {
-            is.seekg( dataPadding, std::ios_base::cur );
+        /* Read one line of pixels from file */
+        const byte *line = is.get_ptr( rowSize );
+        if( line == nullptr || !is.skip( dataPadding ) ) {
+            common::error() << "image::load_bmp() error: reading error (read data)" << std::endl;
+            is.seek( pos );
+            return false;
         }
+        /* the rows are stored bottom-up */
+        cvt( line, out.get_line_ptr( info.height - i - 1 ), info.width );
+    }
+    return true;
+}
+
+/* image::load_bmp */
+bool image::load_bmp( memory_istream &is, pixel_format fmt ) {
+    image_output out( this, fmt );
+    if( !bmp_decode( is, out ) ) {
+        release();
+        return false;
     }
     return true;
 }
@@ -591,10 +587,9 @@ bool image::save_bmp( ostream &os, pixel_format fmt ) {
     info.colorUsed = 0;
     info.colorImportant = 0;
 
-    fnPxcvtFunc cvt = get_pxcvt_func( this->fmt, fmt );
+    fnRowcvtFunc cvt = get_convert_row_func( this->fmt, fmt );
     int bmpPxSize = bmpBpp >> 3;
-    int pxSize = get_bpp() >> 3;
-    byte buffer[256];
+    core::vector<byte> buffer( bmpPxSize * this->width );
     
     /* Write file and info headers */
     if( !os.write( reinterpret_cast<char*>(&header), sizeof(header) ) ) {
@@ -608,13 +603,10 @@ bool image::save_bmp( ostream &os, pixel_format fmt ) {
     /* Write bitmap data */
     for( int i = 0; i < this->height; i++ ) {
         byte *data = this->data.data() + this->stride * (this->height - i - 1);
-        for( int j = 0; j < this->width; j++ ) {
-            cvt( data, buffer );
-            if( !os.write( reinterpret_cast<char*>(buffer), bmpPxSize ) ) {
-                common::error() << "image::save_bmp() error: writing error (info)" << std::endl;
-                goto goRetErr;
-            }
-            data += pxSize;
+        cvt( data, buffer.data(), this->width );
+        if( !os.write( reinterpret_cast<char*>(buffer.data()), buffer.size() ) ) {
+            common::error() << "image::save_bmp() error: writing error (data)" << std::endl;
+            goto goRetErr;
         }
         if( dataPadding ) {
             if( dword zero = 0; !os.write( reinterpret_cast<char*>(&zero), dataPadding ) ) {
@@ -693,122 +685,133 @@ inline static void tga_16_to_bgra8( byte *pixels ) {
     pixels[3] = a;
 }
 
-/* load_tga_read_rle */
-static bool load_tga_read_rle( istream &is, targa_header &header, byte *dataPtr, int pxSize, fnPxcvtFunc cvt, int stride ) {
-    byte buffer[256];
-    int tgaPxSize = header.bpp >> 3;
-    /* Runlength encoded data (RLE) */
-    for( int i = 0; i < header.height; ) {
-        byte *data = dataPtr + stride * (header.height - i - 1);
-        for( int j = 0; j < header.width; ) {
-            byte chunkHeader;
-            /* read one byte (RLE packet header) */
-            if( !is.read( reinterpret_cast<char*>(&chunkHeader), 1 ) ) {
-                common::error() << "image::load_tga() error: reading error (read RLE packet header)" << std::endl;
-                return false;
-            }
-            byte chunkSize = (chunkHeader & 0x7f) + 1;
-            if( chunkHeader & 0x80 ) {
-                /* it is RLE */
-                /* Read pixel data */
-                if( !is.read( reinterpret_cast<char*>(buffer), tgaPxSize ) ) {
-                    common::error() << "image::load_tga() error: reading error (read packed RLE data)" << std::endl;
-                    return false;
-                }
-                if( header.bpp == 16 ) {
-                    /* firstly convert to supported pixel format */
-                    tga_16_to_bgra8( buffer );
-                }
-                for( int k = 0; k < chunkSize; k++ ) {
-                    cvt( buffer, data );
-                    if( ++j == header.width ) {
-                        j = 0;
-                        if( ++i == header.height ) {
-                            goto goOut;
-                        }
-                        data = dataPtr + stride * (header.height - i - 1);
-                    } else {
-                        data += pxSize;
-                    }
-                }
+/* tga_convert_pixels
+* count pixels of the file are converted to the row of the image,
+* 16 bits pixels are unpacked to BGRA8 on the stack by parts */
+static void tga_convert_pixels( const byte *from, byte *to, int count, int bpp, int pxSize, fnRowcvtFunc cvt ) {
+    if( bpp != 16 ) {
+        cvt( from, to, count );
+        return;
+    }
+    byte pixels[4 * 64];
+    while( count > 0 ) {
+        int n = std::min( count, 64 );
+        for( int j = 0; j < n; j++ ) {
+            pixels[j * 4] = from[j * 2];
+            pixels[j * 4 + 1] = from[j * 2 + 1];
+            tga_16_to_bgra8( pixels + j * 4 );
+        }
+        cvt( pixels, to, n );
+        from += n * 2;
+        to += n * pxSize;
+        count -= n;
+    }
+}
+
+/* tga_fill_pixels
+* the first pixel is repeated count times by doubling copies */
+static void tga_fill_pixels( byte *to, int count, int pxSize ) {
+    for( int done = 1; done < count; ) {
+        int n = std::min( done, count - done );
+        memcpy( to + done * pxSize, to, n * pxSize );
+        done += n;
+    }
+}
+
+/* tga_decode_rle
+* the raw packets are converted from the file data in place, the RLE
+* packets convert one pixel and repeat it. The packets may cross the rows */
+static bool tga_decode_rle( memory_istream &is, const targa_header &header, image_output &out, fnRowcvtFunc cvt, bool topDown ) {
+    const int tgaPxSize = header.bpp >> 3;
+    const int pxSize = image::pixel_format_to_bpp( out.get_pixel_format() ) >> 3;
+    int x = 0;
+    int y = 0;
+    byte *row = out.get_line_ptr( topDown ? 0 : header.height - 1 );
+    while( y < header.height ) {
+        const byte *chunkHeader = is.get_ptr( 1 );
+        if( chunkHeader == nullptr ) {
+            common::error() << "image::load_tga() error: reading error (read RLE packet header)" << std::endl;
+            return false;
+        }
+        int chunkSize = (*chunkHeader & 0x7f) + 1;
+        bool packed = *chunkHeader & 0x80;
+        /* the RLE packet has one pixel, the raw packet has chunkSize pixels */
+        const byte *pixels = is.get_ptr( packed ? tgaPxSize : tgaPxSize * chunkSize );
+        if( pixels == nullptr ) {
+            common::error() << "image::load_tga() error: reading error (read " 
+                    << (packed ? "packed RLE data" : "packed data") << ")" << std::endl;
+            return false;
+        }
+        while( chunkSize > 0 ) {
+            int count = std::min( chunkSize, header.width - x );
+            byte *to = row + x * pxSize;
+            if( packed ) {
+                tga_convert_pixels( pixels, to, 1, header.bpp, pxSize, cvt );
+                tga_fill_pixels( to, count, pxSize );
             } else {
-                for( int k = 0; k < chunkSize; k++ ) {
-                    /* Read pixel data */
-                    if( !is.read( reinterpret_cast<char*>(buffer), tgaPxSize ) ) {
-                        common::error() << "image::load_tga() error: reading error (read packed data)" << std::endl;
-                        return false;
-                    }
-                    if( header.bpp == 16 ) {
-                        /* firstly convert to supported pixel format */
-                        tga_16_to_bgra8( buffer );
-                    }
-                    cvt( buffer, data );
-                    if( ++j == header.width ) {
-                        j = 0;
-                        if( ++i == header.height ) {
-                            goto goOut;
-                        }
-                        data = dataPtr + stride * (header.height - i - 1);
-                    } else {
-                        data += pxSize;
-                    }
+                tga_convert_pixels( pixels, to, count, header.bpp, pxSize, cvt );
+                pixels += count * tgaPxSize;
+            }
+            chunkSize -= count;
+            x += count;
+            if( x == header.width ) {
+                x = 0;
+                if( ++y == header.height ) {
+                    break;
                 }
+                row = out.get_line_ptr( topDown ? y : header.height - y - 1 );
             }
         }
     }
-goOut:
     return true;
 }
 
-/* image::load_tga */
-bool image::load_tga( istream &is, pixel_format fmt ) {
+/* tga_mirror_row */
+static void tga_mirror_row( byte *row, int width, int pxSize ) {
+    for( int i = 0, j = width - 1; i < j; i++, j-- ) {
+        std::swap_ranges( row + i * pxSize, row + (i + 1) * pxSize, row + j * pxSize );
+    }
+}
+
+/* tga_decode */
+static bool tga_decode( memory_istream &is, image_output &out ) {
     targa_header header;
-    byte buffer[256];
 
-    auto pos = is.tellg();
+    auto pos = is.tell();
     /* Check for correct data */
     if( !is.read( reinterpret_cast<char*>(&header), sizeof(header) ) ) {
-        is.seekg( pos );
-        return false;
-    }
-    if( !is.good() ) {
-        is.seekg( pos );
+        is.seek( pos );
         return false;
     }
     /* is this exactly a tga file? check this */
     if( auto t = header.colormapType; !(t == 0 || t == 1) ) {
         /* this file not a TGA */
-        is.seekg( pos );
+        is.seek( pos );
         return false;
     }
     if( auto t = header.dataType; !(t == 0 || t == 1 || t == 2 || t == 3 || 
             t == 9 || t == 10 || t == 11) ) {
         /* this file not a TGA */
-        is.seekg( pos );
+        is.seek( pos );
         return false;
     }
     if( auto t = header.bpp; !(t == 8 || t == 16 || t == 24 || t == 32) )  {
         /* this file not a TGA */
-        is.seekg( pos );
+        is.seek( pos );
         return false;
     }
     /* checks supported formats */
     if( header.colormapType != 0 || header.dataType == 1 || header.dataType == 9 ) {
         common::error() << "image::load_tga() error: colormaps not supported" << std::endl;
-        is.seekg( pos );
+        is.seek( pos );
         return false;
     }
     if( header.idLength != 0 ) {
-        if( !is.read( reinterpret_cast<char*>(buffer), header.idLength ) ) {
-            is.seekg( pos );
+        if( !is.skip( header.idLength ) ) {
+            is.seek( pos );
             common::error() << "image::load_tga() error: reading error (header.idLength)" << std::endl;
             return false;
         }
-        if( !is.good() ) {
-            common::error() << "image::load_tga() error: reading error (header.idLength !is.good())" << std::endl;
-            is.seekg( pos );
-            return false;
-        }
     }
     
     pixel_format tgaFmt = PIXEL_FORMAT_AUTO;
@@ -829,51 +832,64 @@ bool image::load_tga( istream &is, pixel_format fmt ) {
             assert(0);
     }
     assert( tgaFmt != PIXEL_FORMAT_AUTO );
-    fmt = fmt == PIXEL_FORMAT_AUTO ? tgaFmt : fmt;
-    int tgaPxSize = header.bpp >> 3;
-    fnPxcvtFunc cvt = get_pxcvt_func( tgaFmt, fmt );
-    
-    reserve( header.width, header.height, fmt );
+    if( header.width == 0 || header.height == 0 ) {
+        common::error() << "image::load_tga() error: wrong image size" << std::endl;
+        is.seek( pos );
+        return false;
+    }
+    if( !out.open( header.width, header.height, tgaFmt ) ) {
+        is.seek( pos );
+        return false;
+    }
+    const pixel_format fmt = out.get_pixel_format();
+    const int pxSize = image::pixel_format_to_bpp( fmt ) >> 3;
+    const int tgaPxSize = header.bpp >> 3;
+    fnRowcvtFunc cvt = get_convert_row_func( tgaFmt, fmt );
+    /* the rows are bottom-up unless the origin is the upper corner,
+    * they are written to their place, the image is not flipped later */
+    const bool topDown = header.attrib & 0x20;
 
     if( header.dataType == 2 || header.dataType == 3 ) { 
         /* Uncompressed data */
+        int lineSize = tgaPxSize * header.width;
         for( int i = 0; i < header.height; i++ ) {
-            byte *data = this->data.data() + this->stride * (height - i - 1);
-            for( int j = 0; j < header.width; j++ ) {
-                /* Read one pixel data from file */
-                if( !is.read( reinterpret_cast<char*>(buffer), tgaPxSize ) ) {
-                    release();
-                    common::error() << "image::load_tga() error: reading error (read data)" << std::endl;
-                    is.seekg( pos );
-                    return false;
-                }
-                if( header.bpp == 16 ) {
-                    /* firstly convert to supported pixel format */
-                    tga_16_to_bgra8( buffer );
-                }
-                cvt( buffer, data );
-                data += this->bpp >> 3;
+            /* Read one line of pixels from file, it is converted in place */
+            const byte *line = is.get_ptr( lineSize );
+            if( line == nullptr ) {
+                common::error() << "image::load_tga() error: reading error (read data)" << std::endl;
+                is.seek( pos );
+                return false;
             }
+            byte *row = out.get_line_ptr( topDown ? i : header.height - i - 1 );
+            tga_convert_pixels( line, row, header.width, header.bpp, pxSize, cvt );
         }
     } else if ( header.dataType == 10 || header.dataType == 11 ) {
-        if( !load_tga_read_rle( is, header, this->data.data(), this->bpp >> 3, cvt, this->stride ) ) {
-            release();
-            is.seekg( pos );
+        if( !tga_decode_rle( is, header, out, cvt, topDown ) ) {
+            is.seek( pos );
             return false;
         }
     }
 
-    /* flip image */
-    if( header.attrib & 0x20 ) {
-        vertical_flip();
-    }
+    /* the origin is the right corner */
     if( header.attrib & 0x10 ) {
-        horizontal_flip();
+        for( int i = 0; i < header.height; i++ ) {
+            tga_mirror_row( out.get_line_ptr( i ), header.width, pxSize );
+        }
     }
 
     return true;
 }
 
+/* image::load_tga */
+bool image::load_tga( memory_istream &is, pixel_format fmt ) {
+    image_output out( this, fmt );
+    if( !tga_decode( is, out ) ) {
+        release();
+        return false;
+    }
+    return true;
+}
+
 /* tga_get_best_save_format */
 static pixel_format tga_get_best_save_format( pixel_format fmt ) {
     switch( fmt ) {
@@ -892,10 +908,238 @@ static pixel_format tga_get_best_save_format( pixel_format fmt ) {
     return PIXEL_FORMAT_AUTO;
 }
 
+/* tga_output
+* the encoded data is collected to the large buffer, so the stream
+* is written by big blocks */
+class tga_output {
+public:
+    static const int    BUFFER_SIZE = 256 * 1024;   /* holds the longest line */
+
+                        tga_output( ostream &os ) : os{os}, buffer( BUFFER_SIZE ) {}
+
+                        /* returns the place for size bytes */
+    byte *              append( int size );
+                        /* returns false if any write failed */
+    bool                flush();
+
+private:
+    ostream &           os;
+    core::vector<byte>  buffer;
+    int                 used{0};
+    bool                failed{false};
+};
+
+/* tga_output::append */
+inline byte *tga_output::append( int size ) {
+    assert( size <= BUFFER_SIZE );
+    if( used + size > BUFFER_SIZE ) {
+        flush();
+    }
+    byte *ptr = buffer.data() + used;
+    used += size;
+    return ptr;
+}
+
+/* tga_output::flush */
+bool tga_output::flush() {
+    if( used > 0 && !failed && !os.write( reinterpret_cast<char*>(buffer.data()), used ) ) {
+        failed = true;
+    }
+    used = 0;
+    return !failed;
+}
+
+/* tga_px_match
+* true if no channel differs more than compress */
+inline static bool tga_px_match( const byte *a, const byte *b, int pxSize, int compress ) {
+    for( int i = 0; i < pxSize; i++ ) {
+        if( core::math::abs( a[i] - b[i] ) > compress ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#if SIMD_SSE4_1_ENABLED
+/* tga_get_diff_mask
+* bit per byte of 16 pixels bytes, set if the byte differs more than compress */
+inline static int tga_get_diff_mask( __m128i a, __m128i b, __m128i compress ) {
+    __m128i diff = _mm_or_si128( _mm_subs_epu8( a, b ), _mm_subs_epu8( b, a ) );
+    __m128i match = _mm_cmpeq_epi8( _mm_subs_epu8( diff, compress ), _mm_setzero_si128() );
+    return ~_mm_movemask_epi8( match ) & 0xffff;
+}
+#endif /* SIMD_SSE4_1_ENABLED */
+
+/* tga_match_length
+* returns the number of the first pixels that match ref, the pixels are
+* compared by 16 bytes: 16 gray, 5 BGR8 or 4 BGRA8 pixels at once */
+static int tga_match_length( const byte *ref, const byte *px, int count, int pxSize, int compress ) {
+    /* short runs are usual for the noisy images */
+    if( count == 0 || !tga_px_match( ref, px, pxSize, compress ) ) {
+        return 0;
+    }
+    int i = 1;
+#if SIMD_SSE4_1_ENABLED
+    const int group = 16 / pxSize;
+    const int minPixels = (16 + pxSize - 1) / pxSize;
+    const int groupMask = (1 << (group * pxSize)) - 1;
+    /* ref repeated in 16 bytes */
+    int value = 0;
+    memcpy( &value, ref, pxSize );
+    __m128i refs;
+    if( pxSize == 1 ) {
+        refs = _mm_set1_epi8( static_cast<char>( value ) );
+    } else if( pxSize == 3 ) {
+        refs = _mm_shuffle_epi8( _mm_cvtsi32_si128( value ),
+                _mm_setr_epi8( 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0 ) );
+    } else {
+        refs = _mm_set1_epi32( value );
+    }
+    const __m128i limit = _mm_set1_epi8( static_cast<char>( compress ) );
+    for( ; count - i >= minPixels; i += group ) {
+        __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( px + i * pxSize ) );
+        if( int diff = tga_get_diff_mask( v, refs, limit ) & groupMask; diff != 0 ) {
+            return i + __builtin_ctz( diff ) / pxSize;
+        }
+    }
+#endif /* SIMD_SSE4_1_ENABLED */
+    for( ; i < count; i++ ) {
+        if( !tga_px_match( ref, px + i * pxSize, pxSize, compress ) ) {
+            break;
+        }
+    }
+    return i;
+}
+
+/* tga_differ_length
+* returns the number of the first pixels that do not match the previous
+* one, prev is the pixel before the first (it can be on the other line) */
+static int tga_differ_length( const byte *prev, const byte *px, int count, int pxSize, int compress ) {
+    if( count == 0 || tga_px_match( prev, px, pxSize, compress ) ) {
+        return 0;
+    }
+    int i = 1;
+#if SIMD_SSE4_1_ENABLED
+    const int group = 16 / pxSize;
+    const int minPixels = (16 + pxSize - 1) / pxSize;
+    const int pxMask = (1 << pxSize) - 1;
+    const __m128i limit = _mm_set1_epi8( static_cast<char>( compress ) );
+    for( ; count - i >= minPixels; i += group ) {
+        __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( px + i * pxSize ) );
+        __m128i p = _mm_loadu_si128( reinterpret_cast<const __m128i*>( px + (i - 1) * pxSize ) );
+        int diff = tga_get_diff_mask( v, p, limit );
+        for( int j = 0; j < group; j++ ) {
+            if( ((diff >> (j * pxSize)) & pxMask) == 0 ) {
+                return i + j;
+            }
+        }
+    }
+#endif /* SIMD_SSE4_1_ENABLED */
+    for( ; i < count; i++ ) {
+        if( tga_px_match( px + (i - 1) * pxSize, px + i * pxSize, pxSize, compress ) ) {
+            break;
+        }
+    }
+    return i;
+}
+
+/* tga_write_rle
+* pixels go from the bottom line to the top one and the packets may
+* cross the lines. A run packet holds the pixels matching its first
+* pixel, a raw packet ends before the pixel matching the previous one.
+* The pixels are compared in the image pixel format */
+static void tga_write_rle( tga_output &out, image &img, fnRowcvtFunc cvt, int tgaPxSize, byte compress ) {
+    const int width = img.get_width();
+    const int height = img.get_height();
+    const int pxSize = img.get_bpp() >> 3;
+    /* position of the packet */
+    int line = 0;
+    int x = 0;
+    const byte *row = img.get_line_ptr( height - 1 );
+
+    while( line < height ) {
+        const byte *first = row + x * pxSize;
+        long long left = static_cast<long long>( height - line ) * width - x;
+        int limit = left < 128 ? static_cast<int>( left ) : 128;
+
+        /* the run of the pixels matching the first one */
+        int k = 1;
+        int scanLine = line;
+        int scanX = x + 1;
+        const byte *scanRow = row;
+        while( k < limit ) {
+            if( scanX == width ) {
+                scanX = 0;
+                scanRow = img.get_line_ptr( height - 1 - ++scanLine );
+            }
+            int n = std::min( limit - k, width - scanX );
+            int m = tga_match_length( first, scanRow + scanX * pxSize, n, pxSize, compress );
+            k += m;
+            scanX += m;
+            if( m < n ) {
+                break;
+            }
+        }
+
+        if( k > 1 ) {
+            /* write rle packet */
+            byte *packet = out.append( 1 + tgaPxSize );
+            packet[0] = 0x80 | static_cast<byte>((k - 1) & 0x7f);
+            cvt( first, packet + 1, 1 );
+        } else {
+            /* the raw pixels, each differs from the previous one */
+            const byte *prev = first;
+            scanLine = line;
+            scanX = x + 1;
+            scanRow = row;
+            while( k < limit ) {
+                if( scanX == width ) {
+                    scanX = 0;
+                    scanRow = img.get_line_ptr( height - 1 - ++scanLine );
+                }
+                int n = std::min( limit - k, width - scanX );
+                int m = tga_differ_length( prev, scanRow + scanX * pxSize, n, pxSize, compress );
+                k += m;
+                scanX += m;
+                if( m < n ) {
+                    break;
+                }
+                prev = scanRow + (scanX - 1) * pxSize;
+            }
+            /* write raw packet, the pixels are converted by the lines */
+            byte *packet = out.append( 1 + tgaPxSize * k );
+            packet[0] = static_cast<byte>((k - 1) & 0x7f);
+            byte *to = packet + 1;
+            const byte *from = row;
+            for( int cvtLine = line, cvtX = x, rest = k; rest > 0; ) {
+                if( cvtX == width ) {
+                    cvtX = 0;
+                    from = img.get_line_ptr( height - 1 - ++cvtLine );
+                }
+                int n = std::min( rest, width - cvtX );
+                cvt( from + cvtX * pxSize, to, n );
+                to += n * tgaPxSize;
+                cvtX += n;
+                rest -= n;
+            }
+        }
+
+        /* next packet */
+        x += k;
+        while( x >= width ) {
+            x -= width;
+            if( ++line < height ) {
+                row = img.get_line_ptr( height - 1 - line );
+            } else {
+                break;
+            }
+        }
+    }
+}
+
 /* image::save_tga */
 bool image::save_tga( ostream &os, pixel_format fmt, bool rle, byte compress ) {
     targa_header header;
-    byte buffer[256 * 4];
     
     /* if needed then get best pixel format to save */
     if( fmt == PIXEL_FORMAT_AUTO ) {
@@ -903,8 +1147,7 @@ bool image::save_tga( ostream &os, pixel_format fmt, bool rle, byte compress ) {
     }
     auto tgaBpp = pixel_format_to_bpp( fmt );
     auto tgaPxSize = tgaBpp >> 3;
-    auto pxSize = get_bpp() >> 3;
-    auto cvt = get_pxcvt_func( this->fmt, fmt );
+    auto cvt = get_convert_row_func( this->fmt, fmt );
 
     /* fill tga header */
     header.idLength = 0;
@@ -921,72 +1164,23 @@ bool image::save_tga( ostream &os, pixel_format fmt, bool rle, byte compress ) {
     header.attrib = 0;
 
     /* Write targa header */
-    if( !os.write( reinterpret_cast<char*>(&header), sizeof(header) ) ) {
-        common::error() << "image::save_tga() error: writing error (header)" << std::endl;
-        return false;
-    }
+    tga_output out( os );
+    memcpy( out.append( sizeof(header) ), &header, sizeof(header) );
 
     /* Save tga image */
     if( rle ) {
-        auto cmp = get_pxcmp_func( this->fmt );
-        auto pxCount = this->width * this->height;
-        auto get_linear_pixel_ptr = [this]( int i ) {
-            int line = i / this->width;
-            int y = this->height - line - 1;
-            int x = i - line * this->width;
-            return this->get_pixel_ptr( x, y );
-        };
-        for( int i = 0; i < pxCount; ) {
-            int k = 1;
-            auto firstPx = get_linear_pixel_ptr( i );
-            cvt( firstPx, buffer + 1 );
-            for( ; (i + k < pxCount) && (k < 128); k++ ) {
-                auto px = get_linear_pixel_ptr( i + k );
-                if( core::math::abs( cmp( firstPx, px ) ) > compress ) {
-                    break;
-                }
-            }
-            if( k > 1 ) {
-                /* write rle packet */
-                buffer[0] = 0x80 | static_cast<byte>((k - 1) & 0x7f);
-                i += k;
-                if( !os.write( reinterpret_cast<char*>(buffer), 1 + tgaPxSize ) ) {
-                    common::error() << "image::save_tga() error: writing error (rle packet)" << std::endl;
-                    return false;
-                }
-                continue;
-            }
-            auto prevPx = firstPx;
-            for( ; (i + k < pxCount) && (k < 128); k++ ) {
-                auto px = get_linear_pixel_ptr( i + k );
-                if( core::math::abs( cmp( prevPx, px ) ) <= compress ) {
-                    break;
-                }
-                /* copy pixel */
-                cvt( px, buffer + k * tgaPxSize + 1 );
-                prevPx = px;
-            }
-            buffer[0] = static_cast<byte>((k - 1) & 0x7f);
-            if( !os.write( reinterpret_cast<char*>(buffer), 1 + tgaPxSize * k ) ) {
-                common::error() << "image::save_tga() error: writing error (rle packet)" << std::endl;
-                return false;
-            }
-            i += k;
-        }
+        tga_write_rle( out, *this, cvt, tgaPxSize, compress );
     } else {
         /* Write uncompressed targa data */
         for( int i = 0; i < this->height; i++ ) {
-            byte *data = this->data.data() + this->stride * (this->height - i - 1);
-            for( int j = 0; j < this->width; j++ ) {
-                cvt( data, buffer );
-                if( !os.write( reinterpret_cast<char*>(buffer), tgaPxSize ) ) {
-                    common::error() << "image::save_tga() error: writing error (data)" << std::endl;
-                    return false;
-                }
-                data += pxSize;
-            }
+            const byte *data = this->data.data() + this->stride * (this->height - i - 1);
+            cvt( data, out.append( tgaPxSize * this->width ), this->width );
         }
     }
+    if( !out.flush() ) {
+        common::error() << "image::save_tga() error: writing error (data)" << std::endl;
+        return false;
+    }
     return true;
 }
 
@@ -1045,332 +1239,296 @@ void my_error_exit (j_common_ptr cinfo)
   longjmp(myerr->setjmp_buffer, 1);
 }
 
-/* my_jreader
-*/
-static int my_jreader( void *file, void *buf, int size ) {
-    assert(file != nullptr);
-    istream *is = reinterpret_cast<istream*>(file);
-    is->read( reinterpret_cast<char*>(buf), size );
-    auto nbytes = is->gcount();
-    return static_cast<int>(nbytes);
+/* number of rows passed to libjpeg by one call, enough
+* for the row of MCUs of the 2x2 subsampled image */
+static const int JPEG_ROWS_NUMBER = 16;
+
+/* jpeg_codec
+* libjpeg objects of the thread. They are created once and reused by
+* the next images, libjpeg keeps its permanent memory between them */
+struct jpeg_codec {
+                            jpeg_codec();
+                            ~jpeg_codec();
+
+    jpeg_decompress_struct  dinfo;
+    my_error_mgr            derr;
+    jpeg_compress_struct    cinfo;
+    my_error_mgr            cerr;
+};
+
+/* jpeg_codec::jpeg_codec */
+jpeg_codec::jpeg_codec() {
+    /* the standard error_exit() until the objects are created */
+    dinfo.err = jpeg_std_error( &derr.pub );
+    jpeg_create_decompress( &dinfo );
+    derr.pub.error_exit = my_error_exit;
+
+    cinfo.err = jpeg_std_error( &cerr.pub );
+    jpeg_create_compress( &cinfo );
+    cerr.pub.error_exit = my_error_exit;
 }
 
-/* image::load_jpg */
-bool image::load_jpg( istream &is, pixel_format fmt ) {
-  /* This struct contains the JPEG decompression parameters and pointers to
-   * working space (which is allocated as needed by the JPEG library).
-   */
-  struct jpeg_decompress_struct cinfo;
-  /* We use our private extension JPEG error handler.
-   * Note that this struct must live as long as the main JPEG parameter
-   * struct, to avoid dangling-pointer problems.
-   */
-  struct my_error_mgr jerr;
-  /* More stuff */
-  auto pos = is.tellg();
-  /* get file size */
- 
-
-  int row_stride;       /* physical row width in output buffer */
-
-  /* In this example we want to open the input file before doing anything else,
-   * so that the setjmp() error recovery below can assume the file is open.
-   * VERY IMPORTANT: use "b" option to fopen() if you are on a machine that
-   * requires it in order to read binary files.
-   */
-
-  /* Step 1: allocate and initialize JPEG decompression object */
-
-  /* We set up the normal JPEG error routines, then override error_exit. */
-  cinfo.err = jpeg_std_error(&jerr.pub);
-  jerr.pub.error_exit = my_error_exit;
-  /* Establish the setjmp return context for my_error_exit to use. */
-  if (setjmp(jerr.setjmp_buffer)) {
-    /* If we get here, the JPEG code has signaled an error.
-     * We need to clean up the JPEG object, close the input file, and return.
-     */
-    jpeg_destroy_decompress(&cinfo);
-    common::error() << "image::load_jpg() error: loading jpeg file" << std::endl;
-    is.seekg( pos, is.beg );
-    return false;
-  }
-  /* Now we can initialize the JPEG decompression object. */
-  jpeg_create_decompress(&cinfo);
-
-  /* Step 2: specify data source (eg, a file) */
-    jpeg_datarw_struct jreader;
-    jreader.read = my_jreader;
-    jreader.file = reinterpret_cast<void*>(&is);
-  jpeg_reader_src( &cinfo, &jreader );
-
-
-  /* Step 3: read file parameters with jpeg_read_header() */
-  (void) jpeg_read_header(&cinfo, TRUE);
-  /* We can ignore the return value from jpeg_read_header since
-   *   (a) suspension is not possible with the stdio data source, and
-   *   (b) we passed TRUE to reject a tables-only JPEG file as an error.
-   * See libjpeg.doc for more info.
-   */
-
-  /* Step 4: set parameters for decompression */
-  /* In this example, we don't need to change any of the defaults set by
-   * jpeg_read_header(), so we do nothing here.
-   */
-
-  /* Step 5: Start decompressor */
-  (void) jpeg_start_decompress(&cinfo);
-  /* We can ignore the return value since suspension is not possible
-   * with the stdio data source.
-   */
-
-  /* We may need to do some setup of our own at this point before reading
-   * the data.  After jpeg_start_decompress() we have the correct scaled
-   * output image dimensions available, as well as the output colormap
-   * if we asked for color quantization.
-   * In this example, we need to make an output work buffer of the right size.
-   */ 
-  /* JSAMPLEs per row in output buffer */
-  auto jpegFmt = PIXEL_FORMAT_AUTO;
-  row_stride = cinfo.output_width * cinfo.output_components;
-
-    switch( cinfo.output_components ) {
-        case 1:
-            jpegFmt = PIXEL_FORMAT_GRAY8;
-            break;
-        case 3:
-            jpegFmt = PIXEL_FORMAT_RGB8;
-            break;
-        case 4:
-            jpegFmt = PIXEL_FORMAT_RGBA8;
+/* jpeg_codec::~jpeg_codec */
+jpeg_codec::~jpeg_codec() {
+    jpeg_destroy_decompress( &dinfo );
+    jpeg_destroy_compress( &cinfo );
+}
+
+/* jpeg_get_codec
+* returns the codec of the calling thread */
+static jpeg_codec &jpeg_get_codec() {
+    static thread_local jpeg_codec codec;
+    return codec;
+}
+
+/* jpeg_color_space
+* libjpeg converts the pixels to the requested format itself. Gray of
+* the color images is the luminance, the chroma is not decoded */
+static J_COLOR_SPACE jpeg_color_space( const jpeg_decompress_struct &cinfo, pixel_format fmt ) {
+    const bool ycc = cinfo.jpeg_color_space == JCS_YCbCr;
+    const bool rgb = ycc || cinfo.jpeg_color_space == JCS_RGB || cinfo.jpeg_color_space == JCS_GRAYSCALE;
+    switch( fmt ) {
+        case PIXEL_FORMAT_GRAY8:
+            return ycc || cinfo.jpeg_color_space == JCS_GRAYSCALE ? JCS_GRAYSCALE : cinfo.out_color_space;
+        case PIXEL_FORMAT_RGB8:
+            return rgb ? JCS_RGB : cinfo.out_color_space;
+        case PIXEL_FORMAT_BGR8:
+            return rgb ? JCS_EXT_BGR : cinfo.out_color_space;
+        case PIXEL_FORMAT_RGBA8:
+            return rgb ? JCS_EXT_RGBA : cinfo.out_color_space;
+        case PIXEL_FORMAT_BGRA8:
+            return rgb ? JCS_EXT_BGRA : cinfo.out_color_space;
+        case PIXEL_FORMAT_AUTO:
             break;
+    }
+    return cinfo.out_color_space;
+}
+
+/* jpeg_pixel_format */
+static pixel_format jpeg_pixel_format( J_COLOR_SPACE space, int components ) {
+    switch( space ) {
+        case JCS_GRAYSCALE:
+            return PIXEL_FORMAT_GRAY8;
+        case JCS_RGB:
+            return PIXEL_FORMAT_RGB8;
+        case JCS_EXT_RGBA:
+            return PIXEL_FORMAT_RGBA8;
+        case JCS_EXT_BGR:
+            return PIXEL_FORMAT_BGR8;
+        case JCS_EXT_BGRA:
+            return PIXEL_FORMAT_BGRA8;
         default:
-            common::error() << "image::load_jpg() error: unsupported JPEG components '" 
-                    << cinfo.output_components << "'" << std::endl;
-            is.seekg( pos, is.beg );
-            return false;
+            break;
     }
+    /* CMYK is passed as it is */
+    return components == 4 ? PIXEL_FORMAT_RGBA8 : PIXEL_FORMAT_AUTO;
+}
 
-    if( fmt == PIXEL_FORMAT_AUTO ) {
-        fmt = jpegFmt;
-    }
-
-  /* Make a one-row-high sample array that will go away when done with image */
-    reserve( cinfo.output_width, cinfo.output_height, fmt );
-
-
-  /* Step 6: while (scan lines remain to be read) */
-  /*           jpeg_read_scanlines(...); */
-  /* Here we use the library's state variable cinfo.output_scanline as the
-   * loop counter, so that we don't have to keep track ourselves.
-   */
-    byte *dataPtr = this->data.data();
-  while (cinfo.output_scanline < cinfo.output_height) {
-    /* jpeg_read_scanlines expects an array of pointers to scanlines.
-     * Here the array is only one element long, but you could ask for
-     * more than one scanline at a time if that's more convenient.
-     */
-    /* Assume put_scanline_someplace wants a pointer and sample count. */
-
-    auto bufLine = dataPtr + (row_stride * cinfo.output_scanline);
-    (void) jpeg_read_scanlines(&cinfo, &bufLine, 1);
-  }
-
-  /* Step 7: Finish decompression */
-  (void) jpeg_finish_decompress(&cinfo);
-  /* We can ignore the return value since suspension is not possible
-   * with the stdio data source.
-   */
-
-  /* Step 8: Release JPEG decompression object */
-
-  /* This is an important step since it will release a good deal of memory. */
-  jpeg_destroy_decompress(&cinfo);
-  
-  /* After finish_decompress, we can close the input file.
-   * Here we postpone it until after no more JPEG errors are possible,
-   * so as to simplify the setjmp error logic above.  (Actually, I don't
-   * think that jpeg_destroy can do an error exit, but why assume anything...)
-   */
-
-  /* At this point you may want to check to see whether any corrupt-data
-   * warnings occurred (test whether jerr.pub.num_warnings is nonzero).
-   */
-
-  /* And we're done! */
+/* jpeg_decode */
+static bool jpeg_decode( memory_istream &is, image_output &out, const jpeg_params &params ) {
+    jpeg_codec &codec = jpeg_get_codec();
+    jpeg_decompress_struct &cinfo = codec.dinfo;
+    core::vector<byte> buffer;
+
+    /* libjpeg errors return here */
+    if( setjmp( codec.derr.setjmp_buffer ) ) {
+        jpeg_abort_decompress( &cinfo );
+        common::error() << "image::load_jpg() error: loading jpeg file" << std::endl;
+        return false;
+    }
+
+    /* the rest of the data is decoded in place */
+    jpeg_memory_src( &cinfo, is.data() + is.tell(), is.remaining() );
+    jpeg_read_header( &cinfo, TRUE );
+    cinfo.dct_method = params.fastDct ? JDCT_IFAST : JDCT_ISLOW;
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = std::max( 1, params.scale );
+    /* the color conversion writes the rows of the requested format */
+    cinfo.out_color_space = jpeg_color_space( cinfo, out.get_pixel_format() );
+    jpeg_calc_output_dimensions( &cinfo );
+
+    auto jpegFmt = jpeg_pixel_format( cinfo.out_color_space, cinfo.output_components );
+    if( jpegFmt == PIXEL_FORMAT_AUTO ) {
+        common::error() << "image::load_jpg() error: unsupported JPEG components '" 
+                << cinfo.output_components << "'" << std::endl;
+        jpeg_abort_decompress( &cinfo );
+        return false;
+    }
+    if( !out.open( cinfo.output_width, cinfo.output_height, jpegFmt ) ) {
+        jpeg_abort_decompress( &cinfo );
+        return false;
+    }
+    jpeg_start_decompress( &cinfo );
+
+    /* the rows are decoded to the output, only the rows of
+    * CMYK and of the gray RGB files are converted from the buffer */
+    const pixel_format fmt = out.get_pixel_format();
+    const int height = cinfo.output_height;
+    auto cvt = get_convert_row_func( jpegFmt, fmt );
+    int jpegStride = cinfo.output_width * cinfo.output_components;
+    if( fmt != jpegFmt ) {
+        buffer.resize( jpegStride * JPEG_ROWS_NUMBER );
+    }
+    JSAMPROW rows[JPEG_ROWS_NUMBER];
+    while( cinfo.output_scanline < cinfo.output_height ) {
+        int first = cinfo.output_scanline;
+        int count = std::min( JPEG_ROWS_NUMBER, height - first );
+        for( int i = 0; i < count; i++ ) {
+            rows[i] = fmt != jpegFmt ? buffer.data() + jpegStride * i : out.get_line_ptr( first + i );
+        }
+        int read = jpeg_read_scanlines( &cinfo, rows, count );
+        if( fmt != jpegFmt ) {
+            for( int i = 0; i < read; i++ ) {
+                cvt( rows[i], out.get_line_ptr( first + i ), cinfo.output_width );
+            }
+        }
+    }
+
+    jpeg_finish_decompress( &cinfo );
     return true;
 }
 
+/* image::load_jpg */
+bool image::load_jpg( memory_istream &is, pixel_format fmt, const jpeg_params &params ) {
+    image_output out( this, fmt );
+    if( !jpeg_decode( is, out, params ) ) {
+        release();
+        return false;
+    }
+    return true;
+}
 
-/* my_jwriter
-*/
-static int my_jwriter( void *file, const void *buf, int size ) {
-    assert(file != nullptr);
+/* jpeg_write_callback */
+static int jpeg_write_callback( void *file, const void *buf, int size ) {
+    assert( file != nullptr );
     ostream *os = reinterpret_cast<ostream*>(file);
-    auto before = os->tellp();
-    os->write( reinterpret_cast<const char*>(buf), size );
-    auto nbytes = os->tellp() - before;
-    return static_cast<int>(nbytes);
+    return os->write( reinterpret_cast<const char*>(buf), size ) ? size : 0;
 }
 
 /* image::save_jpg */
-bool image::save_jpg( ostream &os, pixel_format fmt, int quality ) {
-  /* This struct contains the JPEG compression parameters and pointers to
-   * working space (which is allocated as needed by the JPEG library).
-   * It is possible to have several such structures, representing multiple
-   * compression/decompression processes, in existence at once.  We refer
-   * to any one struct (and its associated working data) as a "JPEG object".
-   */
-  struct jpeg_compress_struct cinfo;
-  /* This struct represents a JPEG error handler.  It is declared separately
-   * because applications often want to supply a specialized error handler
-   * (see the second half of this file for an example).  But here we just
-   * take the easy way out and use the standard error handler, which will
-   * print a message on stderr and call exit() if compression fails.
-   * Note that this struct must live as long as the main JPEG parameter
-   * struct, to avoid dangling-pointer problems.
-   */
-  struct jpeg_error_mgr jerr;
-  /* More stuff */
-
-  /* Step 1: allocate and initialize JPEG compression object */
-
-  /* We have to set up the error handler first, in case the initialization
-   * step fails.  (Unlikely, but it could happen if you are out of memory.)
-   * This routine fills in the contents of struct jerr, and returns jerr's
-   * address which we place into the link field in cinfo.
-   */
-  cinfo.err = jpeg_std_error(&jerr);
-  /* Now we can initialize the JPEG compression object. */
-  jpeg_create_compress(&cinfo);
-
-  /* Step 2: specify data destination (eg, a file) */
-  /* Note: steps 2 and 3 can be done in either order. */
-
-  /* Here we use the library-supplied code to send compressed data to a
-   * stdio stream.  You can also write your own code to do something else.
-   * VERY IMPORTANT: use "b" option to fopen() if you are on a machine that
-   * requires it in order to write binary files.
-   */
-
+bool image::save_jpg( ostream &os, pixel_format fmt, const jpeg_params &params ) {
+    jpeg_codec &codec = jpeg_get_codec();
+    jpeg_compress_struct &cinfo = codec.cinfo;
+    core::vector<byte> buffer;
     jpeg_datarw_struct writer;
-    writer.write = my_jwriter;
+    writer.write = jpeg_write_callback;
     writer.file = reinterpret_cast<void*>(&os);
-  jpeg_writer_dest(&cinfo, &writer );
-
-  /* Step 3: set parameters for compression */
 
-  /* First we supply a description of the input image.
-   * Four fields of the cinfo struct must be filled in:
-   */
-  cinfo.image_width = this->width;  /* image width and height, in pixels */
-  cinfo.image_height = this->height;
-
-  if( fmt == PIXEL_FORMAT_AUTO ) {
-    switch( this->fmt ) {
-        case PIXEL_FORMAT_AUTO:
-            assert(0);
-            break;
-        case PIXEL_FORMAT_GRAY8:
-            cinfo.input_components = 1;
-            cinfo.in_color_space = JCS_GRAYSCALE;
-            break;
-        case PIXEL_FORMAT_BGR8:
-        case PIXEL_FORMAT_BGRA8:
-        case PIXEL_FORMAT_RGB8:
-        case PIXEL_FORMAT_RGBA8:
-            cinfo.input_components = 3;
-            cinfo.in_color_space = JCS_RGB;
-            fmt = PIXEL_FORMAT_RGB8;
-            break;
+    /* libjpeg errors return here */
+    if( setjmp( codec.cerr.setjmp_buffer ) ) {
+        jpeg_abort_compress( &cinfo );
+        common::error() << "image::save_jpg() error: writing jpeg file" << std::endl;
+        return false;
     }
-  } else {
+
+    /* the rows of BGR formats are written as is */
     switch( fmt ) {
         case PIXEL_FORMAT_AUTO:
-            assert(0);
+            fmt = this->fmt == PIXEL_FORMAT_GRAY8 ? PIXEL_FORMAT_GRAY8 : PIXEL_FORMAT_RGB8;
             break;
         case PIXEL_FORMAT_GRAY8:
-            cinfo.input_components = 1;
-            cinfo.in_color_space = JCS_GRAYSCALE;
             break;
         case PIXEL_FORMAT_BGR8:
         case PIXEL_FORMAT_BGRA8:
-            cinfo.input_components = 3;
-            cinfo.in_color_space = JCS_RGB;
             fmt = PIXEL_FORMAT_BGR8;
             break;
         case PIXEL_FORMAT_RGB8:
         case PIXEL_FORMAT_RGBA8:
-            cinfo.input_components = 3;
-            cinfo.in_color_space = JCS_RGB;
             fmt = PIXEL_FORMAT_RGB8;
             break;
     }
-  }
-  //cinfo.input_components = 3;       /* # of color components per pixel */
-  //cinfo.in_color_space = JCS_RGB;   /* colorspace of input image */
-  /* Now use the library's routine to set default compression parameters.
-   * (You must set at least cinfo.in_color_space before calling this,
-   * since the defaults depend on the source color space.)
-   */
-  jpeg_set_defaults(&cinfo);
-  /* Now you can set any non-default parameters you wish to.
-   * Here we just illustrate the use of quality (quantization table) scaling:
-   */
-  jpeg_set_quality( &cinfo, quality, TRUE /* limit to baseline-JPEG values */ );
-
-  /* Step 4: Start compressor */
-
-  /* TRUE ensures that we will write a complete interchange-JPEG file.
-   * Pass TRUE unless you are very sure of what you're doing.
-   */
-  jpeg_start_compress(&cinfo, TRUE);
-
-  /* Step 5: while (scan lines remain to be written) */
-  /*           jpeg_write_scanlines(...); */
-
-  /* Here we use the library's state variable cinfo.next_scanline as the
-   * loop counter, so that we don't have to keep track ourselves.
-   * To keep things simple, we pass one scanline per call; you can pass
-   * more if you wish, though.
-   */
-  auto cvt = get_pxcvt_func( this->fmt, fmt );
-  auto jpgPxSize = pixel_format_to_bpp( fmt ) >> 3;
-  auto srcPxSize = get_bpp() >> 3;
-  core::vector<byte> bufferCvtData;
-  bufferCvtData.reserve( jpgPxSize * this->width );
-  byte *jpgDataPtr = bufferCvtData.data();
-
-  while( cinfo.next_scanline < cinfo.image_height ) {
-    /* jpeg_write_scanlines expects an array of pointers to scanlines.
-     * Here the array is only one element long, but you could pass
-     * more than one scanline at a time if that's more convenient.
-     */
-    /* convert to new pixel format */
-    byte *jpgPx = jpgDataPtr;
-    byte *srcPx = get_line_ptr( cinfo.next_scanline );
-    for( int i = 0; i < this->width; i++ ) {
-        cvt( srcPx, jpgPx );
-        srcPx += srcPxSize;
-        jpgPx += jpgPxSize;
-    }
-
-    (void) jpeg_write_scanlines(&cinfo, &jpgDataPtr, 1);
-  }
-
-  /* Step 6: Finish compression */
-
-  jpeg_finish_compress(&cinfo);
-  /* After finish_compress, we can close the output file. */
-  /* Step 7: release JPEG compression object */
-
-  /* This is an important step since it will release a good deal of memory. */
-  jpeg_destroy_compress(&cinfo);
-
-  /* And we're done! */
 
+    jpeg_writer_dest( &cinfo, &writer );
+    cinfo.image_width = this->width;
+    cinfo.image_height = this->height;
+    cinfo.input_components = fmt == PIXEL_FORMAT_GRAY8 ? 1 : 3;
+    cinfo.in_color_space = fmt == PIXEL_FORMAT_GRAY8 ? JCS_GRAYSCALE : JCS_RGB;
+    jpeg_set_defaults( &cinfo );
+    jpeg_set_quality( &cinfo, params.quality, TRUE /* limit to baseline-JPEG values */ );
+    cinfo.dct_method = params.fastDct ? JDCT_IFAST : JDCT_ISLOW;
+    jpeg_start_compress( &cinfo, TRUE );
+
+    /* the rows of the same pixel format are passed directly */
+    auto cvt = get_convert_row_func( this->fmt, fmt );
+    int jpegStride = cinfo.input_components * this->width;
+    if( fmt != this->fmt ) {
+        buffer.resize( jpegStride * JPEG_ROWS_NUMBER );
+    }
+    JSAMPROW rows[JPEG_ROWS_NUMBER];
+    while( cinfo.next_scanline < cinfo.image_height ) {
+        int first = cinfo.next_scanline;
+        int count = std::min( JPEG_ROWS_NUMBER, this->height - first );
+        for( int i = 0; i < count; i++ ) {
+            if( fmt != this->fmt ) {
+                rows[i] = buffer.data() + jpegStride * i;
+                cvt( get_line_ptr( first + i ), rows[i], this->width );
+            } else {
+                rows[i] = get_line_ptr( first + i );
+            }
+        }
+        jpeg_write_scanlines( &cinfo, rows, count );
+    }
+
+    jpeg_finish_compress( &cinfo );
+    if( os.fail() ) {
+        common::error() << "image::save_jpg() error: writing error (data)" << std::endl;
+        return false;
+    }
     return true;
 }
 
+/* image::load_jpg_from_file */
+bool image::load_jpg_from_file( const string &name, const jpeg_params &params, const pixel_format fmt ) {
+    assert( is_empty() );
+    mapped_file file( filesystem::open_mapped(name) );
+    if( !file.is_open() ) {
+        return false;
+    }
+    memory_istream is( file.data(), file.size() );
+    return load_jpg( is, fmt, params );
+}
+
+/* image::save_jpg_to_file */
+bool image::save_jpg_to_file( const string &name, const jpeg_params &params, const pixel_format fmt ) {
+    assert( !is_empty() );
+    ofstream file( filesystem::open_write(name) );
+    if( !file.is_open() ) {
+        return false;
+    }
+    return save_jpg( file, fmt, params );
+}
+
+/* jpeg_count_succeeded */
+static int jpeg_count_succeeded( const jpeg_batch_item *items, int count ) {
+    int succeeded = 0;
+    for( int i = 0; i < count; i++ ) {
+        succeeded += items[i].succeeded ? 1 : 0;
+    }
+    return succeeded;
+}
+
+/* image::load_jpg_files */
+int image::load_jpg_files( jpeg_batch_item *items, int count, const jpeg_params &params, const pixel_format fmt ) {
+    jobs::parallel_for( 0, count, 1, [items, &params, fmt]( int first, int last ) {
+        for( int i = first; i < last; i++ ) {
+            assert( items[i].img != nullptr );
+            items[i].succeeded = items[i].img->load_jpg_from_file( items[i].name, params, fmt );
+        }
+    } );
+    return jpeg_count_succeeded( items, count );
+}
+
+/* image::save_jpg_files */
+int image::save_jpg_files( jpeg_batch_item *items, int count, const jpeg_params &params, const pixel_format fmt ) {
+    jobs::parallel_for( 0, count, 1, [items, &params, fmt]( int first, int last ) {
+        for( int i = first; i < last; i++ ) {
+            assert( items[i].img != nullptr );
+            items[i].succeeded = items[i].img->save_jpg_to_file( items[i].name, params, fmt );
+        }
+    } );
+    return jpeg_count_succeeded( items, count );
+}
+
 
 
 /*
@@ -1394,55 +1552,72 @@ static void png_warning_callback( png_structp png, png_const_charp cstr ) {
     (void)cstr;
 }
 
-static void png_progressive_info_callback( png_structp png, png_infop info ) {
-    common::log() << "call: png_progressive_info_callback()" << std::endl;
-    (void)png;
-    (void)info;
-}
-
-static void png_progressive_row_callback( png_structp png, png_bytep data, png_uint_32 row, int size ) {
-    common::log() << "call: png_progressive_row_callback()" << std::endl;
-    (void)png;
-    (void)data;
-    (void)row;
-    (void)size;
-}
-
-static void png_progressive_end_callback( png_structp png, png_infop info ) {
-    (void)png;
-    (void)info;
-    common::log() << "call: png_progressive_end_callback()" << std::endl;
-}
-
 static void png_read_data_callback( png_structp png, png_bytep data, size_t length ) {
    /* fread() returns 0 on error, so it is OK to store this in a size_t
     * instead of an int, which is what fread() actually returns.
     */
-    istream *is( reinterpret_cast<istream*>(png_get_io_ptr(png)) );
+    memory_istream *is( reinterpret_cast<memory_istream*>(png_get_io_ptr(png)) );
     assert( is != nullptr );
 
-    is->read( reinterpret_cast<char*>(data), length );
-
-    size_t nbytes = static_cast<size_t>( is->gcount() );
-
-    if( nbytes != length ) {
+    if( !is->read( data, length ) ) {
         png_error( png, "PNG Reading Error. nbytes != length" );
     }
 }
 
-static bool png_check_signature( istream &is ) {
-    char buf[4];
-    auto pos = is.tellg();
-    if( !is.read( buf, sizeof(buf) ) ) {
-        is.seekg( pos );
-        return false;
+static bool png_check_signature( memory_istream &is ) {
+    return is.remaining() >= 8 && !png_sig_cmp( is.data() + is.tell(), 0, 8 );
+}
+
+/* png_set_transforms
+* sets the transforms from the PNG pixels to fmt: the palette, the low
+* bit depths and tRNS are expanded to 8 bits, the gray of the color image
+* is the luminance, the added alpha is opaque. Returns the pixel format of
+* the file which is loaded by PIXEL_FORMAT_AUTO */
+static pixel_format png_set_transforms( png_structp png, png_infop info, pixel_format fmt ) {
+    const int colorType = png_get_color_type( png, info );
+    const int bitDepth = png_get_bit_depth( png, info );
+    const bool color = colorType & PNG_COLOR_MASK_COLOR;
+    bool alpha = colorType & PNG_COLOR_MASK_ALPHA;
+    if( colorType == PNG_COLOR_TYPE_PALETTE ) {
+        png_set_palette_to_rgb( png );
+    }
+    if( colorType == PNG_COLOR_TYPE_GRAY && bitDepth < 8 ) {
+        png_set_expand_gray_1_2_4_to_8( png );
+    }
+    if( png_get_valid( png, info, PNG_INFO_tRNS ) ) {
+        png_set_tRNS_to_alpha( png );
+        alpha = true;
+    }
+    if( bitDepth == 16 ) {
+        png_set_strip_16( png );
     }
-    is.seekg( pos );
-    return( !png_sig_cmp( reinterpret_cast<png_const_bytep>(buf), 0, 4 ) );
+
+    pixel_format pngFmt = alpha ? PIXEL_FORMAT_RGBA8 : (color ? PIXEL_FORMAT_RGB8 : PIXEL_FORMAT_GRAY8);
+    if( fmt == PIXEL_FORMAT_AUTO ) {
+        fmt = pngFmt;
+    }
+    const bool toColor = fmt != PIXEL_FORMAT_GRAY8;
+    const bool toAlpha = fmt == PIXEL_FORMAT_RGBA8 || fmt == PIXEL_FORMAT_BGRA8;
+    if( toColor && !color ) {
+        png_set_gray_to_rgb( png );
+    }
+    if( !toColor && color ) {
+        png_set_rgb_to_gray_fixed( png, 1, -1, -1 );
+    }
+    if( toAlpha && !alpha ) {
+        png_set_add_alpha( png, 0xff, PNG_FILLER_AFTER );
+    }
+    if( !toAlpha && alpha ) {
+        png_set_strip_alpha( png );
+    }
+    if( fmt == PIXEL_FORMAT_BGR8 || fmt == PIXEL_FORMAT_BGRA8 ) {
+        png_set_bgr( png );
+    }
+    return pngFmt;
 }
 
-/* image::load_png */
-bool image::load_png( istream &is, pixel_format fmt ) {
+/* png_decode */
+static bool png_decode( memory_istream &is, image_output &out ) {
     if( !png_check_signature(is) ) {
         return false;
     }
@@ -1470,23 +1645,6 @@ bool image::load_png( istream &is, pixel_format fmt ) {
         return false;
     }
 
-   /* You will need to provide all three function callbacks,
-    * even if you aren't using all of them.
-    * If you aren't using all functions, you can specify NULL
-    * parameters.  Even when all three functions are NULL,
-    * you need to call png_set_progressive_read_fn().
-    * These functions shouldn't be dependent on global or
-    * static variables if you are decoding several images
-    * simultaneously.  You should store stream specific data
-    * in a separate struct, given as the second parameter,
-    * and retrieve the pointer from inside the callbacks using
-    * the function png_get_progressive_ptr(png_ptr).
-    */
-    //png_set_read_fn( png, reinterpret_cast<png_voidp>(&is), png_read_data_callback );
-
-    png_set_progressive_read_fn( png, reinterpret_cast<png_voidp>(&is),
-        png_progressive_info_callback, png_progressive_row_callback, 
-        png_progressive_end_callback );
     png_set_read_fn( png, reinterpret_cast<png_voidp>(&is), png_read_data_callback );
    // png_set_sig_bytes( png, 6 );
    /* The call to png_read_info() gives us all of the information from the
@@ -1518,48 +1676,1080 @@ bool image::load_png( istream &is, pixel_format fmt ) {
     * are mutually exclusive.
     */
 
-    pixel_format pngFmt = PIXEL_FORMAT_AUTO;
-    switch( colorType ) {
-        case PNG_COLOR_TYPE_GRAY:
-            pngFmt = PIXEL_FORMAT_GRAY8;
+    /* libpng converts the rows to the requested format itself */
+    pixel_format pngFmt = png_set_transforms( png, info, out.get_pixel_format() );
+    if( !out.open( width, height, pngFmt ) ) {
+        png_destroy_read_struct( &png, &info, NULL );
+        return false;
+    }
+    int passes = png_set_interlace_handling( png );
+    png_read_update_info( png, info );
+    assert( png_get_rowbytes( png, info ) == 
+            width * (image::pixel_format_to_bpp( out.get_pixel_format() ) >> 3) );
+
+    /* the rows are decoded to the output, the passes of
+    * the interlaced image are combined in the rows */
+    for( int pass = 0; pass < passes; pass++ ) {
+        for( png_uint_32 y = 0; y < height; y++ ) {
+            png_read_row( png, out.get_line_ptr( y ), NULL );
+        }
+    }
+   
+    png_destroy_read_struct( &png, &info, NULL );
+    return true;
+}
+
+/* image::load_png */
+bool image::load_png( memory_istream &is, pixel_format fmt ) {
+    image_output out( this, fmt );
+    if( !png_decode( is, out ) ) {
+        release();
+        return false;
+    }
+    return true;
+}
+
+/* png_get_best_save_format */
+static pixel_format png_get_best_save_format( pixel_format fmt ) {
+    switch( fmt ) {
+        case PIXEL_FORMAT_GRAY8:
+            return PIXEL_FORMAT_GRAY8;
+        case PIXEL_FORMAT_RGB8:
+        case PIXEL_FORMAT_BGR8:
+            return PIXEL_FORMAT_RGB8;
+        case PIXEL_FORMAT_RGBA8:
+        case PIXEL_FORMAT_BGRA8:
+            return PIXEL_FORMAT_RGBA8;
+        case PIXEL_FORMAT_AUTO:
             break;
-        case PNG_COLOR_TYPE_RGB:
-            pngFmt = PIXEL_FORMAT_RGB8;
+    }
+    assert(0);
+    return PIXEL_FORMAT_AUTO;
+}
+
+/* png_get_color_type */
+static int png_get_color_type( pixel_format fmt ) {
+    switch( fmt ) {
+        case PIXEL_FORMAT_GRAY8:
+            return PNG_COLOR_TYPE_GRAY;
+        case PIXEL_FORMAT_RGB8:
+            return PNG_COLOR_TYPE_RGB;
+        case PIXEL_FORMAT_RGBA8:
+            return PNG_COLOR_TYPE_RGB_ALPHA;
+        default:
             break;
-        case PNG_COLOR_TYPE_RGB_ALPHA:
-            pngFmt = PIXEL_FORMAT_RGBA8;
+    }
+    assert(0);
+    return PNG_COLOR_TYPE_RGB;
+}
+
+/* png_get_filter_flags
+* libpng filters for the row filter */
+static int png_get_filter_flags( png_row_filter filter ) {
+    switch( filter ) {
+        case PNG_ROW_FILTER_ADAPTIVE:
+            return PNG_ALL_FILTERS;
+        case PNG_ROW_FILTER_ADAPTIVE_FAST:
+            return PNG_FAST_FILTERS;
+        case PNG_ROW_FILTER_NONE:
+            return PNG_FILTER_NONE;
+        case PNG_ROW_FILTER_SUB:
+            return PNG_FILTER_SUB;
+        case PNG_ROW_FILTER_UP:
+            return PNG_FILTER_UP;
+        case PNG_ROW_FILTER_AVERAGE:
+            return PNG_FILTER_AVG;
+        case PNG_ROW_FILTER_PAETH:
+            return PNG_FILTER_PAETH;
+    }
+    assert(0);
+    return PNG_ALL_FILTERS;
+}
+
+static void png_write_error_callback( png_structp png, png_const_charp cstr ) {
+    common::error() << "image::save_png() error: png_error_callback(): " << cstr << std::endl;
+    longjmp( png_jmpbuf(png), 1 );
+}
+
+static void png_write_data_callback( png_structp png, png_bytep data, size_t length ) {
+    ostream *os( reinterpret_cast<ostream*>(png_get_io_ptr(png)) );
+    assert( os != nullptr );
+
+    if( !os->write( reinterpret_cast<const char*>(data), length ) ) {
+        png_error( png, "PNG Writing Error" );
+    }
+}
+
+static void png_flush_data_callback( png_structp png ) {
+    (void)png;
+}
+
+/* image::save_png */
+bool image::save_png( ostream &os, pixel_format fmt, const png_save_params &params ) {
+    /* PNG keeps RGB order only */
+    fmt = png_get_best_save_format( fmt == PIXEL_FORMAT_AUTO ? this->fmt : fmt );
+    if( params.parallel ) {
+        return save_png_strips( os, fmt, params );
+    }
+
+    png_structp png = png_create_write_struct( PNG_LIBPNG_VER_STRING,
+        nullptr, png_write_error_callback, png_warning_callback );
+    if( png == nullptr ) {
+        common::error() << "image::save_png() error: png_create_write_struct() returns nullptr" << std::endl;
+        return false;
+    }
+    png_infop info = png_create_info_struct( png );
+    if( info == nullptr ) {
+        png_destroy_write_struct( &png, NULL );
+        common::error() << "image::save_png() error: png_create_info_struct() returns nullptr" << std::endl;
+        return false;
+    }
+
+    int pngPxSize = pixel_format_to_bpp( fmt ) >> 3;
+    core::vector<byte> tempData( pngPxSize * this->width );
+    if( setjmp( png_jmpbuf( png ) ) ) {
+        png_destroy_write_struct( &png, &info );
+        return false;
+    }
+
+    png_set_write_fn( png, reinterpret_cast<png_voidp>(&os), png_write_data_callback, png_flush_data_callback );
+    png_set_IHDR( png, info, this->width, this->height, 8, png_get_color_type( fmt ),
+        PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT );
+    png_set_compression_level( png, std::max( 0, std::min( params.level, 9 ) ) );
+    png_set_filter( png, PNG_FILTER_TYPE_BASE, png_get_filter_flags( params.filter ) );
+    png_write_info( png, info );
+
+    byte *pngDataPtr = tempData.data();
+    auto cvt = get_convert_row_func( this->fmt, fmt );
+    for( int y = 0; y < this->height; y++ ) {
+        cvt( get_line_ptr( y ), pngDataPtr, this->width );
+        png_write_row( png, pngDataPtr );
+    }
+    png_write_end( png, NULL );
+
+    png_destroy_write_struct( &png, &info );
+    return true;
+}
+
+/* size of the filtered data compressed by one job */
+static const int PNG_STRIP_SIZE = 256 * 1024;
+/* deflate window, the strip starts with the previous data as dictionary */
+static const int PNG_WINDOW_SIZE = 32 * 1024;
+
+/* png_paeth_predictor */
+inline static int png_paeth_predictor( int a, int b, int c ) {
+    int pa = std::abs( b - c );
+    int pb = std::abs( a - c );
+    int pc = std::abs( a + b - c - c );
+    if( pa <= pb && pa <= pc ) {
+        return a;
+    }
+    return pb <= pc ? b : c;
+}
+
+#if SIMD_SSE4_1_ENABLED
+/* png_paeth_predictor_epi16
+* the predictors of 8 bytes widened to 16 bits, the ties favor a over b over c */
+inline static __m128i png_paeth_predictor_epi16( __m128i a, __m128i b, __m128i c ) {
+    __m128i pa = _mm_sub_epi16( b, c );
+    __m128i pb = _mm_sub_epi16( a, c );
+    __m128i pc = _mm_abs_epi16( _mm_add_epi16( pa, pb ) );
+    pa = _mm_abs_epi16( pa );
+    pb = _mm_abs_epi16( pb );
+    __m128i smallest = _mm_min_epi16( pc, _mm_min_epi16( pa, pb ) );
+    __m128i pred = _mm_blendv_epi8( c, b, _mm_cmpeq_epi16( smallest, pb ) );
+    return _mm_blendv_epi8( pred, a, _mm_cmpeq_epi16( smallest, pa ) );
+}
+#endif /* SIMD_SSE4_1_ENABLED */
+
+/* png_filter_simd
+* filters the bytes of the row from first by 16, returns the first byte left
+* for the scalar code. The filtered bytes depend on the source bytes only,
+* unlike the unfiltering there is no dependency on the previous output */
+static int png_filter_simd( int type, const byte *row, const byte *prev, byte *out, int first, int rowBytes, int pxSize ) {
+    int i = first;
+#if SIMD_SSE4_1_ENABLED
+    auto load = []( const byte *p ) {
+        return _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+    };
+    auto store = []( byte *p, __m128i v ) {
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( p ), v );
+    };
+    const __m128i zero = _mm_setzero_si128();
+    switch( type ) {
+        case PNG_FILTER_VALUE_SUB:
+            for( ; rowBytes - i >= 16; i += 16 ) {
+                store( out + i, _mm_sub_epi8( load( row + i ), load( row + i - pxSize ) ) );
+            }
+            break;
+        case PNG_FILTER_VALUE_UP:
+            for( ; rowBytes - i >= 16; i += 16 ) {
+                store( out + i, _mm_sub_epi8( load( row + i ), load( prev + i ) ) );
+            }
+            break;
+        case PNG_FILTER_VALUE_AVG: {
+            /* the average rounds up, the odd sums are corrected */
+            const __m128i one = _mm_set1_epi8( 1 );
+            for( ; rowBytes - i >= 16; i += 16 ) {
+                __m128i a = load( row + i - pxSize );
+                __m128i b = load( prev + i );
+                __m128i avg = _mm_sub_epi8( _mm_avg_epu8( a, b ), _mm_and_si128( _mm_xor_si128( a, b ), one ) );
+                store( out + i, _mm_sub_epi8( load( row + i ), avg ) );
+            }
+            break;
+        }
+        case PNG_FILTER_VALUE_PAETH:
+            for( ; rowBytes - i >= 16; i += 16 ) {
+                __m128i a = load( row + i - pxSize );
+                __m128i b = load( prev + i );
+                __m128i c = load( prev + i - pxSize );
+                __m128i lo = png_paeth_predictor_epi16( _mm_unpacklo_epi8( a, zero ),
+                        _mm_unpacklo_epi8( b, zero ), _mm_unpacklo_epi8( c, zero ) );
+                __m128i hi = png_paeth_predictor_epi16( _mm_unpackhi_epi8( a, zero ),
+                        _mm_unpackhi_epi8( b, zero ), _mm_unpackhi_epi8( c, zero ) );
+                store( out + i, _mm_sub_epi8( load( row + i ), _mm_packus_epi16( lo, hi ) ) );
+            }
+            break;
+    }
+#else
+    (void)type;
+    (void)row;
+    (void)prev;
+    (void)out;
+    (void)rowBytes;
+    (void)pxSize;
+#endif /* SIMD_SSE4_1_ENABLED */
+    return i;
+}
+
+/* png_filter_row
+* writes the filter type and the filtered row, prev is the row above */
+static void png_filter_row( int type, const byte *row, const byte *prev, byte *out, int rowBytes, int pxSize ) {
+    *out++ = static_cast<byte>(type);
+    switch( type ) {
+        case PNG_FILTER_VALUE_NONE:
+            memcpy( out, row, rowBytes );
+            break;
+        case PNG_FILTER_VALUE_SUB:
+            memcpy( out, row, pxSize );
+            for( int i = png_filter_simd( type, row, prev, out, pxSize, rowBytes, pxSize ); i < rowBytes; i++ ) {
+                out[i] = static_cast<byte>(row[i] - row[i - pxSize]);
+            }
+            break;
+        case PNG_FILTER_VALUE_UP:
+            for( int i = png_filter_simd( type, row, prev, out, 0, rowBytes, pxSize ); i < rowBytes; i++ ) {
+                out[i] = static_cast<byte>(row[i] - prev[i]);
+            }
+            break;
+        case PNG_FILTER_VALUE_AVG:
+            for( int i = 0; i < pxSize; i++ ) {
+                out[i] = static_cast<byte>(row[i] - (prev[i] >> 1));
+            }
+            for( int i = png_filter_simd( type, row, prev, out, pxSize, rowBytes, pxSize ); i < rowBytes; i++ ) {
+                out[i] = static_cast<byte>(row[i] - ((row[i - pxSize] + prev[i]) >> 1));
+            }
+            break;
+        case PNG_FILTER_VALUE_PAETH:
+            for( int i = 0; i < pxSize; i++ ) {
+                out[i] = static_cast<byte>(row[i] - prev[i]);
+            }
+            for( int i = png_filter_simd( type, row, prev, out, pxSize, rowBytes, pxSize ); i < rowBytes; i++ ) {
+                out[i] = static_cast<byte>(row[i] - png_paeth_predictor( row[i - pxSize], prev[i], prev[i - pxSize] ));
+            }
             break;
         default:
-            common::error() << "image::load_png() error: unsupported PNG pixel format" << std::endl;
-            png_destroy_read_struct( &png, &info, NULL );
+            assert(0);
+    }
+}
+
+/* png_filter_cost
+* sum of the absolute values of the filtered bytes as signed,
+* stops counting as soon as the sum exceeds the limit */
+static unsigned int png_filter_cost( const byte *out, int rowBytes, unsigned int limit ) {
+    unsigned int sum = 0;
+    for( int i = 0; i < rowBytes; i += 64 ) {
+        int end = std::min( i + 64, rowBytes );
+        int j = i;
+#if SIMD_SSE4_1_ENABLED
+        /* min( v, 256 - v ) of the bytes, summed by the SAD with zero */
+        if( end - i == 64 ) {
+            const __m128i zero = _mm_setzero_si128();
+            __m128i acc = zero;
+            for( ; j < end; j += 16 ) {
+                __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( out + j ) );
+                acc = _mm_add_epi64( acc, _mm_sad_epu8( _mm_min_epu8( v, _mm_sub_epi8( zero, v ) ), zero ) );
+            }
+            sum += _mm_cvtsi128_si32( acc ) + _mm_extract_epi32( acc, 2 );
+        }
+#endif /* SIMD_SSE4_1_ENABLED */
+        for( ; j < end; j++ ) {
+            sum += out[j] < 128 ? out[j] : 256 - out[j];
+        }
+        if( sum > limit ) {
+            break;
+        }
+    }
+    return sum;
+}
+
+/* png_filter_adaptive
+* the filter of the minimum cost, scratch holds two filtered rows */
+static void png_filter_adaptive( png_row_filter filter, const byte *row, const byte *prev, byte *out, byte *scratch, int rowBytes, int pxSize ) {
+    static const int types[] = { PNG_FILTER_VALUE_NONE, PNG_FILTER_VALUE_SUB, PNG_FILTER_VALUE_UP,
+        PNG_FILTER_VALUE_AVG, PNG_FILTER_VALUE_PAETH };
+    int typesNumber = filter == PNG_ROW_FILTER_ADAPTIVE_FAST ? 3 : 5;
+    byte *best = scratch;
+    byte *test = scratch + rowBytes + 1;
+    unsigned int bestCost = UINT_MAX;
+    for( int i = 0; i < typesNumber; i++ ) {
+        png_filter_row( types[i], row, prev, test, rowBytes, pxSize );
+        unsigned int cost = png_filter_cost( test + 1, rowBytes, bestCost );
+        if( cost < bestCost ) {
+            bestCost = cost;
+            std::swap( best, test );
+        }
+    }
+    memcpy( out, best, rowBytes + 1 );
+}
+
+/* png_strip
+* deflate blocks of the strip, place is left for the zlib header and checksum */
+struct png_strip {
+    static const int    HEADER_SIZE = 2;
+    static const int    CHECKSUM_SIZE = 4;
+
+    core::vector<byte>  data;
+    size_t              size{0};            /* size of the deflate blocks */
+    uLong               adler{0};           /* adler32 of the strip */
+    bool                failed{false};
+};
+
+/* png_deflate_strip
+* compresses [begin..end) of the filtered stream. The strip is ended by
+* the sync flush, so the next strip starts at the byte boundary */
+static void png_deflate_strip( png_strip &strip, const byte *stream, size_t begin, size_t end, int level, int strategy, bool last ) {
+    z_stream zs;
+    memset( &zs, 0, sizeof(zs) );
+    if( deflateInit2( &zs, level, Z_DEFLATED, -MAX_WBITS, 8, strategy ) != Z_OK ) {
+        strip.failed = true;
+        return;
+    }
+    if( begin > 0 ) {
+        size_t dictSize = std::min( begin, static_cast<size_t>(PNG_WINDOW_SIZE) );
+        deflateSetDictionary( &zs, stream + begin - dictSize, static_cast<uInt>(dictSize) );
+    }
+
+    size_t size = end - begin;
+    strip.data.resize( png_strip::HEADER_SIZE + deflateBound( &zs, static_cast<uLong>(size) ) + 16 + png_strip::CHECKSUM_SIZE );
+    zs.next_in = const_cast<Bytef*>(stream + begin);
+    zs.avail_in = static_cast<uInt>(size);
+    int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+    for( ;; ) {
+        size_t capacity = strip.data.size() - png_strip::HEADER_SIZE - png_strip::CHECKSUM_SIZE;
+        zs.next_out = strip.data.data() + png_strip::HEADER_SIZE + zs.total_out;
+        zs.avail_out = static_cast<uInt>(capacity - zs.total_out);
+        int ret = deflate( &zs, flush );
+        if( ret == Z_STREAM_ERROR ) {
+            strip.failed = true;
+            break;
+        }
+        if( last ? ret == Z_STREAM_END : zs.avail_out != 0 ) {
+            break;
+        }
+        strip.data.resize( strip.data.size() * 2 );
+    }
+    strip.size = zs.total_out;
+    strip.adler = adler32( adler32( 0, Z_NULL, 0 ), stream + begin, static_cast<uInt>(size) );
+    deflateEnd( &zs );
+}
+
+/* png_put_dword
+* big endian */
+inline static void png_put_dword( byte *ptr, uLong value ) {
+    ptr[0] = static_cast<byte>(value >> 24);
+    ptr[1] = static_cast<byte>(value >> 16);
+    ptr[2] = static_cast<byte>(value >> 8);
+    ptr[3] = static_cast<byte>(value);
+}
+
+/* png_write_chunk */
+static bool png_write_chunk( ostream &os, const char *type, const byte *data, size_t size ) {
+    byte header[8];
+    byte crc[4];
+    png_put_dword( header, static_cast<uLong>(size) );
+    memcpy( header + 4, type, 4 );
+    uLong value = crc32( crc32( 0, Z_NULL, 0 ), header + 4, 4 );
+    if( size > 0 ) {
+        value = crc32( value, data, static_cast<uInt>(size) );
+    }
+    png_put_dword( crc, value );
+    os.write( reinterpret_cast<const char*>(header), sizeof(header) );
+    os.write( reinterpret_cast<const char*>(data), size );
+    os.write( reinterpret_cast<const char*>(crc), sizeof(crc) );
+    return !os.fail();
+}
+
+/* image::save_png_strips
+* pigz like: the filtered rows are split to strips, every strip is compressed by
+* its own job to the deflate blocks with the end of the previous strip as the
+* dictionary. The blocks are concatenated to one zlib stream, a strip is an IDAT */
+bool image::save_png_strips( ostream &os, pixel_format fmt, const png_save_params &params ) {
+    const int pxSize = pixel_format_to_bpp( fmt ) >> 3;
+    const int rowBytes = pxSize * this->width;
+    const size_t lineSize = rowBytes + 1;
+    const int level = std::max( 0, std::min( params.level, 9 ) );
+    const int stripRows = std::max( 1, PNG_STRIP_SIZE / static_cast<int>(lineSize) );
+    const int stripsNumber = (this->height + stripRows - 1) / stripRows;
+    auto cvt = get_convert_row_func( this->fmt, fmt );
+
+    /* filter the rows, every strip converts the row above it again */
+    core::vector<byte> stream( lineSize * this->height );
+    jobs::parallel_for( 0, stripsNumber, 1, [&]( int first, int last ) {
+        core::vector<byte> rows( rowBytes * 2 );
+        core::vector<byte> scratch( lineSize * 2 );
+        for( int i = first; i < last; i++ ) {
+            int y = i * stripRows;
+            int end = std::min( y + stripRows, this->height );
+            byte *prev = rows.data();
+            byte *row = rows.data() + rowBytes;
+            if( y > 0 ) {
+                cvt( get_line_ptr( y - 1 ), prev, this->width );
+            } else {
+                memset( prev, 0, rowBytes );
+            }
+            for( ; y < end; y++ ) {
+                byte *out = stream.data() + lineSize * y;
+                cvt( get_line_ptr( y ), row, this->width );
+                switch( params.filter ) {
+                    case PNG_ROW_FILTER_ADAPTIVE:
+                    case PNG_ROW_FILTER_ADAPTIVE_FAST:
+                        png_filter_adaptive( params.filter, row, prev, out, scratch.data(), rowBytes, pxSize );
+                        break;
+                    case PNG_ROW_FILTER_NONE:
+                        png_filter_row( PNG_FILTER_VALUE_NONE, row, prev, out, rowBytes, pxSize );
+                        break;
+                    case PNG_ROW_FILTER_SUB:
+                        png_filter_row( PNG_FILTER_VALUE_SUB, row, prev, out, rowBytes, pxSize );
+                        break;
+                    case PNG_ROW_FILTER_UP:
+                        png_filter_row( PNG_FILTER_VALUE_UP, row, prev, out, rowBytes, pxSize );
+                        break;
+                    case PNG_ROW_FILTER_AVERAGE:
+                        png_filter_row( PNG_FILTER_VALUE_AVG, row, prev, out, rowBytes, pxSize );
+                        break;
+                    case PNG_ROW_FILTER_PAETH:
+                        png_filter_row( PNG_FILTER_VALUE_PAETH, row, prev, out, rowBytes, pxSize );
+                        break;
+                }
+                std::swap( prev, row );
+            }
+        }
+    } );
+
+    /* the same strategy as libpng */
+    int strategy = params.filter == PNG_ROW_FILTER_NONE ? Z_DEFAULT_STRATEGY : Z_FILTERED;
+    core::vector<png_strip> strips( stripsNumber );
+    jobs::parallel_for( 0, stripsNumber, 1, [&]( int first, int last ) {
+        for( int i = first; i < last; i++ ) {
+            size_t begin = lineSize * i * stripRows;
+            size_t end = std::min( begin + lineSize * stripRows, stream.size() );
+            png_deflate_strip( strips[i], stream.data(), begin, end, level, strategy, i == stripsNumber - 1 );
+        }
+    } );
+
+    /* zlib header and checksum of the whole stream */
+    uLong adler = adler32( 0, Z_NULL, 0 );
+    for( int i = 0; i < stripsNumber; i++ ) {
+        if( strips[i].failed ) {
+            common::error() << "image::save_png() error: deflate() failure" << std::endl;
             return false;
+        }
+        size_t begin = lineSize * i * stripRows;
+        size_t size = std::min( lineSize * stripRows, stream.size() - begin );
+        adler = adler32_combine( adler, strips[i].adler, static_cast<z_off_t>(size) );
     }
-    if( fmt == PIXEL_FORMAT_AUTO ) {
-        fmt = pngFmt;
+    int levelFlags = level < 2 ? 0 : (level < 6 ? 1 : (level == 6 ? 2 : 3));
+    uInt zlibHeader = (0x78 << 8) | (levelFlags << 6);
+    zlibHeader += 31 - zlibHeader % 31;
+    png_strip &firstStrip = strips[0];
+    firstStrip.data[0] = static_cast<byte>(zlibHeader >> 8);
+    firstStrip.data[1] = static_cast<byte>(zlibHeader);
+    png_strip &lastStrip = strips[stripsNumber - 1];
+    png_put_dword( lastStrip.data.data() + png_strip::HEADER_SIZE + lastStrip.size, adler );
+
+    byte ihdr[13];
+    png_put_dword( ihdr, static_cast<uLong>(this->width) );
+    png_put_dword( ihdr + 4, static_cast<uLong>(this->height) );
+    ihdr[8] = 8;
+    ihdr[9] = static_cast<byte>(png_get_color_type( fmt ));
+    ihdr[10] = PNG_COMPRESSION_TYPE_BASE;
+    ihdr[11] = PNG_FILTER_TYPE_BASE;
+    ihdr[12] = PNG_INTERLACE_NONE;
+
+    static const byte signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+    os.write( reinterpret_cast<const char*>(signature), sizeof(signature) );
+    bool ok = png_write_chunk( os, "IHDR", ihdr, sizeof(ihdr) );
+    for( int i = 0; ok && i < stripsNumber; i++ ) {
+        const png_strip &strip = strips[i];
+        const byte *data = strip.data.data() + png_strip::HEADER_SIZE;
+        size_t size = strip.size;
+        if( i == 0 ) {
+            data -= png_strip::HEADER_SIZE;
+            size += png_strip::HEADER_SIZE;
+        }
+        if( i == stripsNumber - 1 ) {
+            size += png_strip::CHECKSUM_SIZE;
+        }
+        ok = png_write_chunk( os, "IDAT", data, size );
+    }
+    ok = ok && png_write_chunk( os, "IEND", nullptr, 0 );
+    if( !ok ) {
+        common::error() << "image::save_png() error: writing error (data)" << std::endl;
+        return false;
     }
+    return true;
+}
 
-    reserve( width, height, fmt );
-    
-    int pngPxSize = pixel_format_to_bpp( pngFmt ) >> 3;
-    int pxSize = get_bpp() >> 3;
-    core::vector<byte> tempData;
-    tempData.reserve( pngPxSize * width );
-    byte *pngDataPtr = tempData.data();
-    auto cvt = get_pxcvt_func( pngFmt, fmt );
-    for( int y = 0; y < this->height; y++ ) {
-        png_read_rows( png, reinterpret_cast<png_bytepp>(&pngDataPtr), NULL, 1 );
-        byte *from = pngDataPtr;
-        byte *to = get_line_ptr( y );
-        for( int i = 0; i < this->width; i++ ) {
-            cvt( from, to );
-            from += pngPxSize;
-            to += pxSize;
+/*
+================================================
+            TEX
+================================================
+*/
+
+/* tex_decode
+* the pixels of the same format are copied by one memcpy
+* if the rows of the output are packed and not flipped */
+static bool tex_decode( memory_istream &is, image_output &out ) {
+    const texture_file_header *header = texture_file::get_header( is.data(), is.size() );
+    if( !header ) {
+        common::error() << "image::load_tex() error: wrong texture file" << std::endl;
+        return false;
+    }
+    if( header->flags & TEXTURE_FILE_FLAG_COMPRESSED ) {
+        common::error() << "image::load_tex() error: the texture is block compressed, see texture_file" << std::endl;
+        return false;
+    }
+    const pixel_format texFmt = static_cast<pixel_format>(header->format);
+    const texture_file_level &level = header->levels[0];
+    const byte *pixels = is.data() + level.offset;
+    if( !out.open( level.width, level.height, texFmt ) ) {
+        return false;
+    }
+    const pixel_format fmt = out.get_pixel_format();
+    const int texStride = level.width * (image::pixel_format_to_bpp( texFmt ) >> 3);
+    const int height = level.height;
+    const bool packed = height == 1 || out.get_line_ptr( 1 ) == out.get_line_ptr( 0 ) + texStride;
+    if( fmt == texFmt && packed ) {
+        memcpy( out.get_line_ptr( 0 ), pixels, level.size );
+        return true;
+    }
+    fnRowcvtFunc cvt = get_convert_row_func( texFmt, fmt );
+    for( int y = 0; y < height; y++ ) {
+        cvt( pixels + static_cast<size_t>(texStride) * y, out.get_line_ptr( y ), level.width );
+    }
+    return true;
+}
+
+/* image::load_tex */
+bool image::load_tex( memory_istream &is, pixel_format fmt ) {
+    image_output out( this, fmt );
+    if( !tex_decode( is, out ) ) {
+        release();
+        return false;
+    }
+    return true;
+}
+
+/*
+================================================
+            Decoding to the memory of the caller
+================================================
+*/
+
+/* decode_from_memory */
+static bool decode_from_memory( const byte *data, size_t size, image_output &out, const jpeg_params &params ) {
+    memory_istream is( data, size );
+    switch( image::get_image_format( data, size ) ) {
+        case IMAGE_FORMAT_BMP:
+            return bmp_decode( is, out );
+        case IMAGE_FORMAT_TGA:
+            return tga_decode( is, out );
+        case IMAGE_FORMAT_JPG:
+            return jpeg_decode( is, out, params );
+        case IMAGE_FORMAT_PNG:
+            return png_decode( is, out );
+        case IMAGE_FORMAT_TEX:
+            return tex_decode( is, out );
+        case IMAGE_FORMAT_AUTO:
+            break;
+    }
+    return false;
+}
+
+/* image::get_image_info
+* the decoders stop when the output is opened */
+bool image::get_image_info( const byte *data, size_t size, image_info &info, const pixel_format fmt, const jpeg_params &params ) {
+    image_output out( fmt );
+    decode_from_memory( data, size, out, params );
+    info = out.get_info();
+    return info.width > 0 && info.height > 0;
+}
+
+/* image::decode */
+bool image::decode( const byte *data, size_t size, const image_decode_target &target, const jpeg_params &params ) {
+    image_output out( target );
+    return decode_from_memory( data, size, out, params );
+}
+
+/*
+================================================
+            Progressive decoding
+================================================
+*/
+
+/* the input is passed to libpng/libjpeg by slices, the
+* budget of image_decoder::decode() is checked between them */
+static const size_t DECODER_SLICE_SIZE = 4 * 1024;
+
+enum jpeg_stage {
+    JPEG_STAGE_HEADER,
+    JPEG_STAGE_START,
+    JPEG_STAGE_ROWS,
+    JPEG_STAGE_FINISH
+};
+
+/* jpeg_stream_source
+* suspending data source of libjpeg, the buffer is one slice of the pushed
+* bytes. fill_input_buffer() always returns FALSE: libjpeg resumes from
+* next_input_byte of its last complete unit (marker, MCU), so the buffer
+* is reloaded between the calls of libjpeg only */
+struct jpeg_stream_source {
+    jpeg_source_mgr         pub;
+    const byte *            end{nullptr};   /* end of the pushed bytes */
+    size_t                  skip{0};        /* skipped beyond the pushed bytes */
+    bool                    eof{false};
+    bool                    eoiInserted{false};
+};
+
+/* image_decoder_state */
+struct image_decoder_state {
+                            image_decoder_state( image *img, pixel_format fmt );
+                            ~image_decoder_state();
+
+    bool                    start_png();
+    void                    start_jpeg();
+    void                    destroy_codec();
+    bool                    is_budget_spent() const;
+
+    image_output            out;
+    image_format            format{IMAGE_FORMAT_AUTO};
+    bool                    hasInfo{false};
+    bool                    done{false};
+    int                     rowsCompleted{0};
+
+    /* budget of the decode() call */
+    timer::ticks            deadline{0};    /* 0 - no limit */
+    int                     rowsLimit{0};
+    int                     rowsDecoded{0};
+
+    png_structp             png{nullptr};
+    png_infop               info{nullptr};
+    int                     lastPass{0};
+
+    jpeg_decompress_struct  cinfo;
+    my_error_mgr            jerr;
+    jpeg_stream_source      src;
+    bool                    jpegCreated{false};
+    jpeg_stage              stage{JPEG_STAGE_HEADER};
+    pixel_format            jpegFmt{PIXEL_FORMAT_AUTO};
+    core::vector<byte>      buffer;         /* rows of CMYK and of the gray RGB files */
+};
+
+/* png_progressive_info_callback
+* the transforms are set when the header is read */
+static void png_progressive_info_callback( png_structp png, png_infop info ) {
+    auto state = reinterpret_cast<image_decoder_state*>(png_get_progressive_ptr( png ));
+    pixel_format pngFmt = png_set_transforms( png, info, state->out.get_pixel_format() );
+    if( !state->out.open( png_get_image_width( png, info ), png_get_image_height( png, info ), pngFmt ) ) {
+        png_error( png, "the output is not opened" );
+    }
+    state->lastPass = png_set_interlace_handling( png ) - 1;
+    png_start_read_image( png );
+    state->hasInfo = true;
+}
+
+/* png_progressive_row_callback
+* the passes of the interlaced image are combined in the rows,
+* the rows are final in the last pass */
+static void png_progressive_row_callback( png_structp png, png_bytep row, png_uint_32 y, int pass ) {
+    auto state = reinterpret_cast<image_decoder_state*>(png_get_progressive_ptr( png ));
+    if( row == nullptr ) {
+        return;
+    }
+    png_progressive_combine_row( png, state->out.get_line_ptr( y ), row );
+    state->rowsDecoded++;
+    if( pass == state->lastPass ) {
+        state->rowsCompleted = y + 1;
+    }
+}
+
+/* png_progressive_end_callback */
+static void png_progressive_end_callback( png_structp png, png_infop info ) {
+    auto state = reinterpret_cast<image_decoder_state*>(png_get_progressive_ptr( png ));
+    state->rowsCompleted = png_get_image_height( png, info );
+    state->done = true;
+}
+
+/* png_process_slice */
+static bool png_process_slice( image_decoder_state &state, const byte *data, size_t size ) {
+    if( setjmp( png_jmpbuf( state.png ) ) ) {
+        return false;
+    }
+    png_process_data( state.png, state.info, const_cast<png_bytep>(data), size );
+    return true;
+}
+
+/* jpeg_stream_init_source */
+static void jpeg_stream_init_source( j_decompress_ptr cinfo ) {
+    (void)cinfo;
+}
+
+/* jpeg_stream_fill_input_buffer
+* the truncated file is completed by the fake EOI marker */
+static boolean jpeg_stream_fill_input_buffer( j_decompress_ptr cinfo ) {
+    static const JOCTET eoi[2] = { 0xff, JPEG_EOI };
+    auto src = reinterpret_cast<jpeg_stream_source*>(cinfo->src);
+    if( !src->eof ) {
+        return FALSE;
+    }
+    src->pub.next_input_byte = eoi;
+    src->pub.bytes_in_buffer = 2;
+    src->eoiInserted = true;
+    return TRUE;
+}
+
+/* jpeg_stream_skip_input_data
+* the markers are skipped beyond the slice, the
+* rest of the skip is applied to the next pushed bytes */
+static void jpeg_stream_skip_input_data( j_decompress_ptr cinfo, long count ) {
+    auto src = reinterpret_cast<jpeg_stream_source*>(cinfo->src);
+    if( count <= 0 ) {
+        return;
+    }
+    size_t skip = count;
+    if( skip <= src->pub.bytes_in_buffer ) {
+        src->pub.next_input_byte += skip;
+        src->pub.bytes_in_buffer -= skip;
+        return;
+    }
+    skip -= src->pub.bytes_in_buffer;
+    src->pub.next_input_byte += src->pub.bytes_in_buffer;
+    src->pub.bytes_in_buffer = 0;
+    if( src->eoiInserted ) {
+        return;
+    }
+    const size_t available = std::min( skip, static_cast<size_t>(src->end - src->pub.next_input_byte) );
+    src->pub.next_input_byte += available;
+    src->skip += skip - available;
+}
+
+/* jpeg_stream_term_source */
+static void jpeg_stream_term_source( j_decompress_ptr cinfo ) {
+    (void)cinfo;
+}
+
+/* jpeg_process
+* decodes until libjpeg is suspended or the budget is spent,
+* the stage is advanced when its libjpeg call is completed */
+static bool jpeg_process( image_decoder_state &state, const jpeg_params &params ) {
+    jpeg_decompress_struct &cinfo = state.cinfo;
+    if( setjmp( state.jerr.setjmp_buffer ) ) {
+        common::error() << "image_decoder::decode() error: decoding jpeg file" << std::endl;
+        return false;
+    }
+    if( state.stage == JPEG_STAGE_HEADER ) {
+        if( jpeg_read_header( &cinfo, TRUE ) == JPEG_SUSPENDED ) {
+            return true;
+        }
+        cinfo.dct_method = params.fastDct ? JDCT_IFAST : JDCT_ISLOW;
+        cinfo.scale_num = 1;
+        cinfo.scale_denom = std::max( 1, params.scale );
+        cinfo.out_color_space = jpeg_color_space( cinfo, state.out.get_pixel_format() );
+        jpeg_calc_output_dimensions( &cinfo );
+
+        state.jpegFmt = jpeg_pixel_format( cinfo.out_color_space, cinfo.output_components );
+        if( state.jpegFmt == PIXEL_FORMAT_AUTO ) {
+            common::error() << "image_decoder::decode() error: unsupported JPEG components '" 
+                    << cinfo.output_components << "'" << std::endl;
+            return false;
+        }
+        if( !state.out.open( cinfo.output_width, cinfo.output_height, state.jpegFmt ) ) {
+            return false;
         }
+        if( state.out.get_pixel_format() != state.jpegFmt ) {
+            state.buffer.resize( cinfo.output_width * cinfo.output_components * JPEG_ROWS_NUMBER );
+        }
+        state.hasInfo = true;
+        state.stage = JPEG_STAGE_START;
     }
-   
-    png_destroy_read_struct( &png, &info, NULL );
+    if( state.stage == JPEG_STAGE_START ) {
+        /* the scans of the progressive file are consumed here */
+        if( !jpeg_start_decompress( &cinfo ) ) {
+            return true;
+        }
+        state.stage = JPEG_STAGE_ROWS;
+    }
+    if( state.stage == JPEG_STAGE_ROWS ) {
+        const pixel_format fmt = state.out.get_pixel_format();
+        const bool convert = fmt != state.jpegFmt;
+        const int height = cinfo.output_height;
+        const int jpegStride = cinfo.output_width * cinfo.output_components;
+        auto cvt = get_convert_row_func( state.jpegFmt, fmt );
+        JSAMPROW rows[JPEG_ROWS_NUMBER];
+        while( cinfo.output_scanline < cinfo.output_height ) {
+            int first = cinfo.output_scanline;
+            int count = std::min( JPEG_ROWS_NUMBER, height - first );
+            for( int i = 0; i < count; i++ ) {
+                rows[i] = convert ? state.buffer.data() + jpegStride * i : state.out.get_line_ptr( first + i );
+            }
+            int read = jpeg_read_scanlines( &cinfo, rows, count );
+            if( read == 0 ) {
+                return true;
+            }
+            if( convert ) {
+                for( int i = 0; i < read; i++ ) {
+                    cvt( rows[i], state.out.get_line_ptr( first + i ), cinfo.output_width );
+                }
+            }
+            state.rowsDecoded += read;
+            state.rowsCompleted = cinfo.output_scanline;
+            if( state.is_budget_spent() ) {
+                return true;
+            }
+        }
+        state.stage = JPEG_STAGE_FINISH;
+    }
+    if( !jpeg_finish_decompress( &cinfo ) ) {
+        return true;
+    }
+    state.done = true;
     return true;
 }
 
+/* image_decoder_state::image_decoder_state */
+image_decoder_state::image_decoder_state( image *img, pixel_format fmt ) : out( img, fmt ) {
+}
+
+/* image_decoder_state::~image_decoder_state */
+image_decoder_state::~image_decoder_state() {
+    destroy_codec();
+}
+
+/* image_decoder_state::start_png */
+bool image_decoder_state::start_png() {
+    png = png_create_read_struct( PNG_LIBPNG_VER_STRING, nullptr, png_error_callback, png_warning_callback );
+    if( png == nullptr ) {
+        common::error() << "image_decoder::decode() error: png_create_read_struct() returns nullptr" << std::endl;
+        return false;
+    }
+    info = png_create_info_struct( png );
+    if( info == nullptr ) {
+        common::error() << "image_decoder::decode() error: png_create_info_struct() returns nullptr" << std::endl;
+        return false;
+    }
+    png_set_progressive_read_fn( png, reinterpret_cast<png_voidp>(this),
+        png_progressive_info_callback, png_progressive_row_callback, 
+        png_progressive_end_callback );
+    return true;
+}
+
+/* image_decoder_state::start_jpeg */
+void image_decoder_state::start_jpeg() {
+    /* the standard error_exit() until the object is created */
+    cinfo.err = jpeg_std_error( &jerr.pub );
+    jpeg_create_decompress( &cinfo );
+    jerr.pub.error_exit = my_error_exit;
+    jpegCreated = true;
+
+    src.pub.init_source = jpeg_stream_init_source;
+    src.pub.fill_input_buffer = jpeg_stream_fill_input_buffer;
+    src.pub.skip_input_data = jpeg_stream_skip_input_data;
+    src.pub.resync_to_restart = jpeg_resync_to_restart;
+    src.pub.term_source = jpeg_stream_term_source;
+    src.pub.next_input_byte = nullptr;
+    src.pub.bytes_in_buffer = 0;
+    cinfo.src = &src.pub;
+}
+
+/* image_decoder_state::destroy_codec
+* libpng/libjpeg memory is released when the image is decoded */
+void image_decoder_state::destroy_codec() {
+    if( png != nullptr ) {
+        png_destroy_read_struct( &png, &info, NULL );
+    }
+    if( jpegCreated ) {
+        jpeg_destroy_decompress( &cinfo );
+        jpegCreated = false;
+    }
+    buffer = core::vector<byte>();
+}
+
+/* image_decoder_state::is_budget_spent */
+bool image_decoder_state::is_budget_spent() const {
+    if( rowsLimit > 0 && rowsDecoded >= rowsLimit ) {
+        return true;
+    }
+    return deadline != 0 && timer::get_ticks() >= deadline;
+}
+
+/* image_decoder::image_decoder */
+image_decoder::image_decoder( const pixel_format fmt, const jpeg_params &params ) : fmt( fmt ), params( params ) {
+}
+
+/* image_decoder::~image_decoder */
+image_decoder::~image_decoder() {
+    delete state;
+}
+
+/* image_decoder::push
+* the consumed bytes are dropped when they are the most of the buffer */
+void image_decoder::push( const byte *data, size_t size ) {
+    assert( !finished );
+    if( status == IMAGE_DECODER_DONE || status == IMAGE_DECODER_FAILED ) {
+        return;
+    }
+    if( inputOffset > 0 && inputOffset >= input.size() / 2 ) {
+        input.erase( input.begin(), input.begin() + inputOffset );
+        inputOffset = 0;
+    }
+    input.insert( input.end(), data, data + size );
+}
+
+/* image_decoder::finish */
+void image_decoder::finish() {
+    finished = true;
+}
+
+/* image_decoder::start
+* creates libpng/libjpeg objects by the signature */
+bool image_decoder::start() {
+    const image_format format = image::get_image_format( input.data() + inputOffset, input.size() - inputOffset );
+    if( format != IMAGE_FORMAT_PNG && format != IMAGE_FORMAT_JPG ) {
+        common::error() << "image_decoder::decode() error: only PNG and JPEG are decoded progressively" << std::endl;
+        return false;
+    }
+    state = new image_decoder_state( &img, fmt );
+    state->format = format;
+    if( format == IMAGE_FORMAT_JPG ) {
+        state->start_jpeg();
+        return true;
+    }
+    return state->start_png();
+}
+
+/* image_decoder::decode */
+image_decoder_status image_decoder::decode( float budgetMsec, int maxRows ) {
+    if( status == IMAGE_DECODER_DONE || status == IMAGE_DECODER_FAILED ) {
+        return status;
+    }
+    if( state == nullptr ) {
+        /* the longest signature is of PNG */
+        if( input.size() - inputOffset < 8 && !finished ) {
+            return status;
+        }
+        if( !start() ) {
+            img.release();
+            status = IMAGE_DECODER_FAILED;
+            return status;
+        }
+    }
+
+    state->deadline = budgetMsec > 0.0f ? timer::get_ticks() + 
+            static_cast<timer::ticks>(budgetMsec * 0.001f * timer::get_ticks_per_sec()) : 0;
+    state->rowsLimit = maxRows;
+    state->rowsDecoded = 0;
+
+    bool succeeded = true;
+    if( state->format == IMAGE_FORMAT_PNG ) {
+        /* libpng keeps the incomplete chunks itself */
+        while( inputOffset < input.size() ) {
+            size_t size = std::min( input.size() - inputOffset, DECODER_SLICE_SIZE );
+            succeeded = png_process_slice( *state, input.data() + inputOffset, size );
+            inputOffset += size;
+            if( !succeeded || state->done || state->is_budget_spent() ) {
+                break;
+            }
+        }
+    } else {
+        /* libjpeg is suspended at the end of every slice. The pointers of the
+        * source are set again, the buffer may be moved by push() */
+        jpeg_stream_source &src = state->src;
+        size_t sliceSize = DECODER_SLICE_SIZE;
+        while( true ) {
+            const size_t skip = std::min( src.skip, input.size() - inputOffset );
+            inputOffset += skip;
+            src.skip -= skip;
+            const size_t remaining = input.size() - inputOffset;
+            const size_t size = std::min( remaining, sliceSize );
+            src.end = input.data() + input.size();
+            src.eof = finished && size == remaining;
+            if( !src.eoiInserted ) {
+                src.pub.next_input_byte = input.data() + inputOffset;
+                src.pub.bytes_in_buffer = size;
+            }
+            succeeded = jpeg_process( *state, params );
+            const size_t offset = src.eoiInserted ? input.size() : src.pub.next_input_byte - input.data();
+            const bool consumed = offset != inputOffset;
+            inputOffset = offset;
+            if( !succeeded || state->done || state->is_budget_spent() ) {
+                break;
+            }
+            if( !consumed && size == remaining ) {
+                break;
+            }
+            /* the unit of libjpeg is longer than the slice */
+            sliceSize = consumed ? DECODER_SLICE_SIZE : sliceSize * 2;
+        }
+    }
+
+    /* libpng and libjpeg stop early by the budget only */
+    const bool suspended = state->is_budget_spent();
+    if( succeeded && !state->done && !suspended && finished ) {
+        common::error() << "image_decoder::decode() error: unexpected end of the file" << std::endl;
+        succeeded = false;
+    }
+    if( !succeeded ) {
+        state->destroy_codec();
+        img.release();
+        status = IMAGE_DECODER_FAILED;
+    } else if( state->done ) {
+        state->destroy_codec();
+        input = core::vector<byte>();
+        inputOffset = 0;
+        status = IMAGE_DECODER_DONE;
+    } else {
+        status = suspended ? IMAGE_DECODER_SUSPENDED : IMAGE_DECODER_NEED_DATA;
+    }
+    return status;
+}
+
+/* image_decoder::has_info */
+bool image_decoder::has_info() const {
+    return state != nullptr && state->hasInfo;
+}
+
+/* image_decoder::get_info */
+image_info image_decoder::get_info() const {
+    if( !has_info() ) {
+        return image_info();
+    }
+    return state->out.get_info();
+}
+
+/* image_decoder::get_rows_completed */
+int image_decoder::get_rows_completed() const {
+    return state != nullptr && status != IMAGE_DECODER_FAILED ? state->rowsCompleted : 0;
+}
+
 } /* namespace renderer */
 } /* namespace engine */
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <core/vector.hpp>
 #include <core/assert.hpp>
 #include <core/string.hpp>
+#include <core/memory_istream.hpp>
 
 using namespace engine::core;
 
@@ -14,7 +15,8 @@ enum image_format {
     IMAGE_FORMAT_BMP,
     IMAGE_FORMAT_TGA,
     IMAGE_FORMAT_JPG,
-    IMAGE_FORMAT_PNG
+    IMAGE_FORMAT_PNG,
+    IMAGE_FORMAT_TEX                /* cooked texture, see texture_file */
 };
 
 enum pixel_format {
@@ -26,6 +28,68 @@ enum pixel_format {
     PIXEL_FORMAT_RGBA8
 };
 
+/* PNG row filters, the adaptive filters select one of
+* the filters per row by the minimum sum of absolute differences */
+enum png_row_filter {
+    PNG_ROW_FILTER_ADAPTIVE,        /* none, sub, up, average, paeth */
+    PNG_ROW_FILTER_ADAPTIVE_FAST,   /* none, sub, up */
+    PNG_ROW_FILTER_NONE,
+    PNG_ROW_FILTER_SUB,
+    PNG_ROW_FILTER_UP,
+    PNG_ROW_FILTER_AVERAGE,
+    PNG_ROW_FILTER_PAETH
+};
+
+/* quality/speed knobs of JPEG */
+struct jpeg_params {
+    int             quality{95};    /* encoding 1 - minimum quality, 100 - maximum */
+    bool            fastDct{false}; /* JDCT_IFAST instead of JDCT_ISLOW, faster but less accurate */
+    int             scale{1};       /* decoding 1, 2, 4, 8 - the image is 1/scale of the size */
+};
+
+/* destination of image::decode(), e.g. the mapped buffer of the texture
+* upload. The decoders write the rows to it, there is no temporary image */
+struct image_decode_target {
+    byte *          pixels{nullptr};
+    int             width{0};       /* must be the size of the decoded image */
+    int             height{0};
+    int             stride{0};      /* 0 - the rows are packed */
+    pixel_format    fmt{PIXEL_FORMAT_AUTO};     /* AUTO - the format of the file */
+    bool            flipVertical{false};        /* the first row is the last one, origin of GL */
+};
+
+/* result of image_decoder::decode() */
+enum image_decoder_status {
+    IMAGE_DECODER_NEED_DATA,        /* the pushed bytes are decoded, push() more */
+    IMAGE_DECODER_SUSPENDED,        /* the budget is spent, decode() again */
+    IMAGE_DECODER_DONE,
+    IMAGE_DECODER_FAILED
+};
+
+/* size and pixel format of the decoded image, see image::get_image_info() */
+struct image_info {
+    int             width{0};
+    int             height{0};
+    pixel_format    fmt{PIXEL_FORMAT_AUTO};
+};
+
+class image;
+
+/* item of the batch of images */
+struct jpeg_batch_item {
+    string          name;
+    image *         img{nullptr};
+    bool            succeeded{false};
+};
+
+struct png_save_params {
+    int             level{6};       /* deflate level 0 - no compression, 9 - maximum */
+    png_row_filter  filter{PNG_ROW_FILTER_ADAPTIVE};
+                    /* compress strips of rows by the job system, the strips are
+                    * concatenated deflate blocks, the file is a bit larger */
+    bool            parallel{false};
+};
+
 class image {
 public:
                     image() {}
@@ -34,13 +98,20 @@ public:
                     
                     /* read/write */
     bool            load_from_file( const string &name, const pixel_format fmt = PIXEL_FORMAT_AUTO );
+                    /* the format is detected by the signature */
+    bool            load_from_memory( const byte *data, size_t size, const pixel_format fmt = PIXEL_FORMAT_AUTO );
                     /* quality min 1 - minimum quality (maximum compression)
                     * max 100 - minimum compression */
     bool            save_to_file( const string &name, int quality = 95, const pixel_format fmt = PIXEL_FORMAT_AUTO, image_format imfmt = IMAGE_FORMAT_AUTO );
+                    /* save_to_file() maps quality to the level of PNG */
+    bool            save_png_to_file( const string &name, const png_save_params &params, const pixel_format fmt = PIXEL_FORMAT_AUTO );
+    bool            load_jpg_from_file( const string &name, const jpeg_params &params, const pixel_format fmt = PIXEL_FORMAT_AUTO );
+    bool            save_jpg_to_file( const string &name, const jpeg_params &params, const pixel_format fmt = PIXEL_FORMAT_AUTO );
 
                     /* returns pointer to pixel */
     byte *          get_pixel_ptr( int x, int y );
     byte *          get_line_ptr( int y );
+    const byte *    get_line_ptr( int y ) const;
     
                     /* horizontal / vertical flip processing */
     void            horizontal_flip();
@@ -65,20 +136,38 @@ public:
 
     /* satatic methods */
     static int      pixel_format_to_bpp( const pixel_format fmt );
+                    /* IMAGE_FORMAT_AUTO if the data is not an image,
+                    * data without a signature is expected to be TGA */
+    static image_format get_image_format( const byte *data, size_t size );
+                    /* load/save the JPEG files by the job system, one job per image.
+                    * Every thread keeps its libjpeg objects for the next images.
+                    * Returns the number of succeeded items */
+    static int      load_jpg_files( jpeg_batch_item *items, int count, const jpeg_params &params, const pixel_format fmt = PIXEL_FORMAT_AUTO );
+    static int      save_jpg_files( jpeg_batch_item *items, int count, const jpeg_params &params, const pixel_format fmt = PIXEL_FORMAT_AUTO );
+                    /* reads the headers only, the info is of the image decoded to fmt */
+    static bool     get_image_info( const byte *data, size_t size, image_info &info, const pixel_format fmt = PIXEL_FORMAT_AUTO, const jpeg_params &params = jpeg_params() );
+                    /* decodes the image straight to the memory of the caller. PNG and JPEG
+                    * are converted to the target format by libpng/libjpeg */
+    static bool     decode( const byte *data, size_t size, const image_decode_target &target, const jpeg_params &params = jpeg_params() );
 protected:
-    bool            load_bmp( istream &is, pixel_format fmt );
+    bool            load_bmp( memory_istream &is, pixel_format fmt );
     bool            save_bmp( ostream &os, pixel_format fmt );
 
-    bool            load_tga( istream &is, pixel_format fmt );
+    bool            load_tga( memory_istream &is, pixel_format fmt );
                     /* if rle is ture then: 
                     * compress min 0 - maximum quality
                     * max 255 - maximum compression */
     bool            save_tga( ostream &os, pixel_format fmt, bool rle, byte compress );
 
-    bool            load_jpg( istream &is, pixel_format fmt );
-    bool            save_jpg( ostream &os, pixel_format fmt, int quality );
+    bool            load_jpg( memory_istream &is, pixel_format fmt, const jpeg_params &params = jpeg_params() );
+    bool            save_jpg( ostream &os, pixel_format fmt, const jpeg_params &params );
 
-    bool            load_png( istream &is, pixel_format fmt );
+    bool            load_png( memory_istream &is, pixel_format fmt );
+
+                    /* the first level of the uncompressed texture file */
+    bool            load_tex( memory_istream &is, pixel_format fmt );
+    bool            save_png( ostream &os, pixel_format fmt, const png_save_params &params );
+    bool            save_png_strips( ostream &os, pixel_format fmt, const png_save_params &params );
 
     core::vector<byte>    data;           /* pixels data */
     int             width{0};
@@ -88,6 +177,54 @@ protected:
     pixel_format    fmt{PIXEL_FORMAT_AUTO};
 };
 
+/* libpng/libjpeg objects of image_decoder, see image.cpp */
+struct image_decoder_state;
+
+/* image_decoder
+* decodes PNG and JPEG incrementally, a large texture is loaded across the
+* frames. The file arrives by chunks of any size, decode() works until the
+* budget of the call is spent. PNG is decoded by the progressive reader of
+* libpng, JPEG by the suspending data source of libjpeg. The rows
+* [0, get_rows_completed()) of the image are final and may be uploaded
+* before the rest is decoded, the interlaced PNG and the progressive JPEG
+* complete the rows in the last pass only */
+class image_decoder {
+public:
+                    image_decoder( const pixel_format fmt = PIXEL_FORMAT_AUTO, const jpeg_params &params = jpeg_params() );
+                    image_decoder( const image_decoder& ) = delete;
+    image_decoder & operator=( const image_decoder& ) = delete;
+                    ~image_decoder();
+
+                    /* the bytes are copied */
+    void            push( const byte *data, size_t size );
+                    /* no more data, the truncated PNG fails, the truncated JPEG
+                    * is completed by libjpeg */
+    void            finish();
+                    /* decodes the pushed bytes until budgetMsec is spent or maxRows
+                    * rows are decoded, 0 - no limit. The budget is checked between
+                    * the slices of the input, so one slice is decoded at least */
+    image_decoder_status    decode( float budgetMsec, int maxRows = 0 );
+
+    image_decoder_status    get_status() const;
+                    /* the header is read, the image is reserved */
+    bool            has_info() const;
+    image_info      get_info() const;
+    int             get_rows_completed() const;
+    image &         get_image();
+
+private:
+    bool            start();
+
+    image_decoder_state *   state{nullptr};
+    core::vector<byte>      input;          /* the pushed bytes */
+    size_t          inputOffset{0};         /* the bytes before are consumed */
+    bool            finished{false};
+    image           img;
+    pixel_format    fmt;
+    jpeg_params     params;
+    image_decoder_status    status{IMAGE_DECODER_NEED_DATA};
+};
+
 
 
 /* image::is_empty */
@@ -112,6 +249,14 @@ inline byte *image::get_line_ptr( int y ) {
     return reinterpret_cast<byte*>(data.data() + offset);
 }
 
+/* image::get_line_ptr */
+inline const byte *image::get_line_ptr( int y ) const {
+    assert( y >= 0 && y < height );
+    assert( !is_empty() );
+    size_t offset = y * stride;
+    return data.data() + offset;
+}
+
 /* image::get_width */
 inline int image::get_width() const {
     return width;
@@ -155,5 +300,15 @@ inline int image::pixel_format_to_bpp( const pixel_format fmt ) {
     return 0;
 }
 
+/* image_decoder::get_status */
+inline image_decoder_status image_decoder::get_status() const {
+    return status;
+}
+
+/* image_decoder::get_image */
+inline image &image_decoder::get_image() {
+    return img;
+}
+
 } /* namespace renderer */
 } /* namespace engine */
\ No newline at end of file
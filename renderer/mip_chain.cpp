@@ -0,0 +1,356 @@
+#include "mip_chain.h"
+#include <core/common.hpp>
+#include <core/jobs.hpp>
+#include <core/simd.hpp>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace engine {
+namespace renderer {
+
+/* number of the pixels filtered by one job */
+static const int MIP_JOB_PIXELS = 16 * 1024;
+
+/* taps of the Kaiser filter, the destination pixel x
+* is made from the source pixels 2x - 3 .. 2x + 4 */
+static const int KAISER_TAPS = 8;
+static const int KAISER_FIRST_TAP = -3;
+static const float KAISER_ALPHA = 4.0f;
+
+/* srgb_tables
+* decoding of sRGB values to linear and encoding
+* of linear values quantized to 16 bits */
+struct srgb_tables {
+                srgb_tables();
+
+    float       toLinear[256];
+    byte        fromLinear[65536];
+};
+
+/* srgb_tables::srgb_tables */
+srgb_tables::srgb_tables() {
+    for( int i = 0; i < 256; i++ ) {
+        double c = i / 255.0;
+        toLinear[i] = static_cast<float>(c <= 0.04045 ? c / 12.92 : std::pow( (c + 0.055) / 1.055, 2.4 ));
+    }
+    for( int i = 0; i < 65536; i++ ) {
+        double l = i / 65535.0;
+        double c = l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow( l, 1.0 / 2.4 ) - 0.055;
+        fromLinear[i] = static_cast<byte>(c * 255.0 + 0.5);
+    }
+}
+
+/* get_srgb_tables */
+static const srgb_tables &get_srgb_tables() {
+    static const srgb_tables tables;
+    return tables;
+}
+
+/* srgb_encode */
+inline static byte srgb_encode( const srgb_tables &tables, float value ) {
+    int i = static_cast<int>(value * 65535.0f + 0.5f);
+    return tables.fromLinear[std::max( 0, std::min( i, 65535 ) )];
+}
+
+/* clamp_to_byte */
+inline static byte clamp_to_byte( float value ) {
+    return static_cast<byte>(std::max( 0.0f, std::min( value + 0.5f, 255.0f ) ));
+}
+
+/* bessel_i0
+* modified Bessel function of the first kind */
+static double bessel_i0( double x ) {
+    double sum = 1.0;
+    double term = 1.0;
+    for( int k = 1; k < 32; k++ ) {
+        term *= (x * 0.5 / k) * (x * 0.5 / k);
+        sum += term;
+    }
+    return sum;
+}
+
+/* kaiser_weights
+* normalized weights of the taps */
+struct kaiser_weights {
+                kaiser_weights();
+
+    float       weights[KAISER_TAPS];
+};
+
+/* kaiser_weights::kaiser_weights */
+kaiser_weights::kaiser_weights() {
+    const double pi = 3.14159265358979323846;
+    const double radius = KAISER_TAPS / 2;
+    double sum = 0.0;
+    double w[KAISER_TAPS];
+    for( int k = 0; k < KAISER_TAPS; k++ ) {
+        /* distance from the center of the destination pixel in source pixels */
+        double t = k + KAISER_FIRST_TAP - 0.5;
+        double x = pi * t * 0.5;
+        double sinc = std::sin( x ) / x;
+        double u = t / radius;
+        w[k] = sinc * bessel_i0( KAISER_ALPHA * std::sqrt( 1.0 - u * u ) ) / bessel_i0( KAISER_ALPHA );
+        sum += w[k];
+    }
+    for( int k = 0; k < KAISER_TAPS; k++ ) {
+        weights[k] = static_cast<float>(w[k] / sum);
+    }
+}
+
+/* get_kaiser_weights */
+static const float *get_kaiser_weights() {
+    static const kaiser_weights kaiser;
+    return kaiser.weights;
+}
+
+/* get_alpha_channel
+* index of the alpha channel or -1 */
+static int get_alpha_channel( pixel_format fmt ) {
+    return fmt == PIXEL_FORMAT_BGRA8 || fmt == PIXEL_FORMAT_RGBA8 ? 3 : -1;
+}
+
+/* box_row
+* averages 2x2 pixels of the rows a and b */
+static void box_row( const byte *a, const byte *b, byte *out, int srcWidth, int dstWidth, int pxSize ) {
+    int x = 0;
+#if SIMD_SSE4_1_ENABLED
+    /* the pixels which have the right neighbour */
+    int pairs = std::min( dstWidth, srcWidth >> 1 );
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16( 2 );
+    if( pxSize == 4 ) {
+        for( ; x + 4 <= pairs; x += 4 ) {
+            __m128i d[2];
+            for( int i = 0; i < 2; i++ ) {
+                __m128i pa = _mm_loadu_si128( reinterpret_cast<const __m128i*>( a + x * 8 + i * 16 ) );
+                __m128i pb = _mm_loadu_si128( reinterpret_cast<const __m128i*>( b + x * 8 + i * 16 ) );
+                /* vertical sums of 2 + 2 pixels, then the sums of the neighbours */
+                __m128i lo = _mm_add_epi16( _mm_unpacklo_epi8( pa, zero ), _mm_unpacklo_epi8( pb, zero ) );
+                __m128i hi = _mm_add_epi16( _mm_unpackhi_epi8( pa, zero ), _mm_unpackhi_epi8( pb, zero ) );
+                __m128i sum = _mm_add_epi16( _mm_unpacklo_epi64( lo, hi ), _mm_unpackhi_epi64( lo, hi ) );
+                d[i] = _mm_srli_epi16( _mm_add_epi16( sum, two ), 2 );
+            }
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( out + x * 4 ), _mm_packus_epi16( d[0], d[1] ) );
+        }
+    } else if( pxSize == 1 ) {
+        const __m128i ones = _mm_set1_epi8( 1 );
+        for( ; x + 16 <= pairs; x += 16 ) {
+            __m128i d[2];
+            for( int i = 0; i < 2; i++ ) {
+                __m128i pa = _mm_loadu_si128( reinterpret_cast<const __m128i*>( a + x * 2 + i * 16 ) );
+                __m128i pb = _mm_loadu_si128( reinterpret_cast<const __m128i*>( b + x * 2 + i * 16 ) );
+                /* sums of the neighbours */
+                __m128i sum = _mm_add_epi16( _mm_maddubs_epi16( pa, ones ), _mm_maddubs_epi16( pb, ones ) );
+                d[i] = _mm_srli_epi16( _mm_add_epi16( sum, two ), 2 );
+            }
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( out + x ), _mm_packus_epi16( d[0], d[1] ) );
+        }
+    }
+#endif /* SIMD_SSE4_1_ENABLED */
+    for( ; x < dstWidth; x++ ) {
+        int x0 = 2 * x * pxSize;
+        int x1 = std::min( 2 * x + 1, srcWidth - 1 ) * pxSize;
+        for( int c = 0; c < pxSize; c++ ) {
+            out[x * pxSize + c] = static_cast<byte>((a[x0 + c] + a[x1 + c] + b[x0 + c] + b[x1 + c] + 2) >> 2);
+        }
+    }
+}
+
+/* box_row_srgb
+* averages 2x2 pixels of the rows a and b in linear space */
+static void box_row_srgb( const byte *a, const byte *b, byte *out, int srcWidth, int dstWidth, int pxSize, int alpha ) {
+    const srgb_tables &tables = get_srgb_tables();
+    for( int x = 0; x < dstWidth; x++ ) {
+        int x0 = 2 * x * pxSize;
+        int x1 = std::min( 2 * x + 1, srcWidth - 1 ) * pxSize;
+        for( int c = 0; c < pxSize; c++ ) {
+            if( c == alpha ) {
+                out[x * pxSize + c] = static_cast<byte>((a[x0 + c] + a[x1 + c] + b[x0 + c] + b[x1 + c] + 2) >> 2);
+            } else {
+                float sum = tables.toLinear[a[x0 + c]] + tables.toLinear[a[x1 + c]] +
+                        tables.toLinear[b[x0 + c]] + tables.toLinear[b[x1 + c]];
+                out[x * pxSize + c] = srgb_encode( tables, sum * 0.25f );
+            }
+        }
+    }
+}
+
+/* kaiser_accumulate_row
+* acc += weight * row, the row is decoded to linear space if srgb */
+static void kaiser_accumulate_row( const byte *row, float *acc, int count, float weight, int pxSize, int alpha, bool srgb ) {
+    int i = 0;
+    if( srgb ) {
+        const srgb_tables &tables = get_srgb_tables();
+        for( ; i < count; i += pxSize ) {
+            for( int c = 0; c < pxSize; c++ ) {
+                float value = c == alpha ? row[i + c] * (1.0f / 255.0f) : tables.toLinear[row[i + c]];
+                acc[i + c] += weight * value;
+            }
+        }
+        return;
+    }
+#if SIMD_SSE4_1_ENABLED
+    const __m128 w = _mm_set1_ps( weight );
+    for( ; i + 4 <= count; i += 4 ) {
+        int v;
+        memcpy( &v, row + i, 4 );
+        __m128 value = _mm_cvtepi32_ps( _mm_cvtepu8_epi32( _mm_cvtsi32_si128( v ) ) );
+        __m128 sum = _mm_add_ps( _mm_loadu_ps( acc + i ), _mm_mul_ps( w, value ) );
+        _mm_storeu_ps( acc + i, sum );
+    }
+#endif /* SIMD_SSE4_1_ENABLED */
+    for( ; i < count; i++ ) {
+        acc[i] += weight * row[i];
+    }
+}
+
+/* kaiser_filter_row
+* horizontal pass of the vertically filtered row */
+static void kaiser_filter_row( const float *acc, float *out, int srcWidth, int dstWidth, int pxSize ) {
+    const float *weights = get_kaiser_weights();
+    for( int x = 0; x < dstWidth; x++ ) {
+        int first = 2 * x + KAISER_FIRST_TAP;
+        bool inside = first >= 0 && first + KAISER_TAPS <= srcWidth;
+#if SIMD_SSE4_1_ENABLED
+        if( pxSize == 4 && inside ) {
+            __m128 sum = _mm_setzero_ps();
+            for( int k = 0; k < KAISER_TAPS; k++ ) {
+                __m128 value = _mm_loadu_ps( acc + (first + k) * 4 );
+                sum = _mm_add_ps( sum, _mm_mul_ps( _mm_set1_ps( weights[k] ), value ) );
+            }
+            _mm_storeu_ps( out + x * 4, sum );
+            continue;
+        }
+#endif /* SIMD_SSE4_1_ENABLED */
+        for( int c = 0; c < pxSize; c++ ) {
+            float sum = 0.0f;
+            for( int k = 0; k < KAISER_TAPS; k++ ) {
+                int sx = inside ? first + k : std::max( 0, std::min( first + k, srcWidth - 1 ) );
+                sum += weights[k] * acc[sx * pxSize + c];
+            }
+            out[x * pxSize + c] = sum;
+        }
+    }
+}
+
+/* mip_chain::get_levels_number */
+int mip_chain::get_levels_number( int width, int height ) {
+    int size = std::max( width, height );
+    int number = 1;
+    while( size > 1 ) {
+        size >>= 1;
+        number++;
+    }
+    return number;
+}
+
+/* mip_chain::generate */
+bool mip_chain::generate( const image &img, mip_filter filter, bool srgb ) {
+    release();
+    if( img.is_empty() ) {
+        common::error() << "mip_chain::generate() error: the image is empty" << std::endl;
+        return false;
+    }
+    fmt = img.get_pixel_format();
+    pxSize = img.get_bpp() >> 3;
+
+    int width = img.get_width();
+    int height = img.get_height();
+    size_t size = 0;
+    levels.resize( get_levels_number( width, height ) );
+    for( auto &lvl : levels ) {
+        lvl.width = width;
+        lvl.height = height;
+        lvl.offset = size;
+        size += static_cast<size_t>(width) * height * pxSize;
+        width = std::max( 1, width >> 1 );
+        height = std::max( 1, height >> 1 );
+    }
+    data.resize( size );
+
+    /* the first level is the image without the row padding */
+    size_t rowSize = static_cast<size_t>(levels[0].width) * pxSize;
+    for( int y = 0; y < levels[0].height; y++ ) {
+        memcpy( data.data() + rowSize * y, img.get_line_ptr( y ), rowSize );
+    }
+    for( size_t i = 1; i < levels.size(); i++ ) {
+        if( filter == MIP_FILTER_KAISER ) {
+            downsample_kaiser( levels[i - 1], levels[i], srgb );
+        } else {
+            downsample_box( levels[i - 1], levels[i], srgb );
+        }
+    }
+    return true;
+}
+
+/* mip_chain::release */
+void mip_chain::release() {
+    data.clear();
+    data.shrink_to_fit();
+    levels.clear();
+    pxSize = 0;
+    fmt = PIXEL_FORMAT_AUTO;
+}
+
+/* mip_chain::downsample_box */
+void mip_chain::downsample_box( const level &src, const level &dst, bool srgb ) {
+    const byte *srcData = data.data() + src.offset;
+    byte *dstData = data.data() + dst.offset;
+    const size_t srcRow = static_cast<size_t>(src.width) * pxSize;
+    const size_t dstRow = static_cast<size_t>(dst.width) * pxSize;
+    const int alpha = get_alpha_channel( fmt );
+    const int grain = std::max( 1, MIP_JOB_PIXELS / dst.width );
+    jobs::parallel_for( 0, dst.height, grain, [&]( int first, int last ) {
+        for( int y = first; y < last; y++ ) {
+            const byte *a = srcData + srcRow * (2 * y);
+            const byte *b = srcData + srcRow * std::min( 2 * y + 1, src.height - 1 );
+            if( srgb ) {
+                box_row_srgb( a, b, dstData + dstRow * y, src.width, dst.width, pxSize, alpha );
+            } else {
+                box_row( a, b, dstData + dstRow * y, src.width, dst.width, pxSize );
+            }
+        }
+    } );
+}
+
+/* mip_chain::downsample_kaiser */
+void mip_chain::downsample_kaiser( const level &src, const level &dst, bool srgb ) {
+    const byte *srcData = data.data() + src.offset;
+    byte *dstData = data.data() + dst.offset;
+    const int srcRow = src.width * pxSize;
+    const int dstRow = dst.width * pxSize;
+    const int alpha = get_alpha_channel( fmt );
+    const float *weights = get_kaiser_weights();
+    const int grain = std::max( 1, MIP_JOB_PIXELS / dst.width );
+    jobs::parallel_for( 0, dst.height, grain, [&]( int first, int last ) {
+        const srgb_tables &tables = get_srgb_tables();
+        core::vector<float> acc( srcRow );
+        core::vector<float> filtered( dstRow );
+        for( int y = first; y < last; y++ ) {
+            /* vertical pass to acc, then horizontal */
+            std::fill( acc.begin(), acc.end(), 0.0f );
+            for( int k = 0; k < KAISER_TAPS; k++ ) {
+                int sy = std::max( 0, std::min( 2 * y + KAISER_FIRST_TAP + k, src.height - 1 ) );
+                kaiser_accumulate_row( srcData + static_cast<size_t>(srcRow) * sy, acc.data(), srcRow, weights[k], pxSize, alpha, srgb );
+            }
+            kaiser_filter_row( acc.data(), filtered.data(), src.width, dst.width, pxSize );
+
+            byte *out = dstData + static_cast<size_t>(dstRow) * y;
+            if( !srgb ) {
+                for( int i = 0; i < dstRow; i++ ) {
+                    out[i] = clamp_to_byte( filtered[i] );
+                }
+                continue;
+            }
+            for( int i = 0; i < dstRow; i += pxSize ) {
+                for( int c = 0; c < pxSize; c++ ) {
+                    out[i + c] = c == alpha ? clamp_to_byte( filtered[i + c] * 255.0f ) : srgb_encode( tables, filtered[i + c] );
+                }
+            }
+        }
+    } );
+}
+
+} /* namespace renderer */
+} /* namespace engine */
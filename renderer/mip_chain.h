@@ -0,0 +1,113 @@
+#pragma once
+#include <core/types.hpp>
+#include <core/vector.hpp>
+#include <core/assert.hpp>
+#include "image.h"
+
+using namespace engine::core;
+
+namespace engine {
+namespace renderer {
+
+enum mip_filter {
+    MIP_FILTER_BOX,         /* average of 2x2 pixels */
+    MIP_FILTER_KAISER       /* Kaiser windowed sinc of 8x8 pixels, sharper */
+};
+
+/* mip_chain
+* all levels of the image from the full size down to 1x1. The levels are
+* stored one after another in one buffer, the rows are not padded */
+class mip_chain {
+public:
+                    mip_chain() {}
+
+                    /* every level is made from the previous one, the rows of
+                    * the level are filtered by the job system. If srgb is true
+                    * then the color channels are filtered in linear space */
+    bool            generate( const image &img, mip_filter filter = MIP_FILTER_BOX, bool srgb = false );
+    void            release();
+
+    bool            is_empty() const;
+    int             get_levels_number() const;
+    int             get_width( int level ) const;
+    int             get_height( int level ) const;
+    const byte *    get_level_ptr( int level ) const;
+    size_t          get_level_size( int level ) const;
+    pixel_format    get_pixel_format() const;
+
+                    /* all levels */
+    const byte *    get_data() const;
+    size_t          get_size() const;
+
+                    /* number of levels of the size */
+    static int      get_levels_number( int width, int height );
+
+private:
+    struct level {
+        int         width;
+        int         height;
+        size_t      offset;
+    };
+
+    void            downsample_box( const level &src, const level &dst, bool srgb );
+    void            downsample_kaiser( const level &src, const level &dst, bool srgb );
+
+    core::vector<byte>  data;
+    core::vector<level> levels;
+    int             pxSize{0};
+    pixel_format    fmt{PIXEL_FORMAT_AUTO};
+};
+
+
+
+/* mip_chain::is_empty */
+inline bool mip_chain::is_empty() const {
+    return levels.empty();
+}
+
+/* mip_chain::get_levels_number */
+inline int mip_chain::get_levels_number() const {
+    return static_cast<int>(levels.size());
+}
+
+/* mip_chain::get_width */
+inline int mip_chain::get_width( int level ) const {
+    assert( level >= 0 && level < get_levels_number() );
+    return levels[level].width;
+}
+
+/* mip_chain::get_height */
+inline int mip_chain::get_height( int level ) const {
+    assert( level >= 0 && level < get_levels_number() );
+    return levels[level].height;
+}
+
+/* mip_chain::get_level_ptr */
+inline const byte *mip_chain::get_level_ptr( int level ) const {
+    assert( level >= 0 && level < get_levels_number() );
+    return data.data() + levels[level].offset;
+}
+
+/* mip_chain::get_level_size */
+inline size_t mip_chain::get_level_size( int level ) const {
+    assert( level >= 0 && level < get_levels_number() );
+    return static_cast<size_t>(levels[level].width) * levels[level].height * pxSize;
+}
+
+/* mip_chain::get_pixel_format */
+inline pixel_format mip_chain::get_pixel_format() const {
+    return fmt;
+}
+
+/* mip_chain::get_data */
+inline const byte *mip_chain::get_data() const {
+    return data.data();
+}
+
+/* mip_chain::get_size */
+inline size_t mip_chain::get_size() const {
+    return data.size();
+}
+
+} /* namespace renderer */
+} /* namespace engine */
@@ -0,0 +1,94 @@
+#include "gl_render_backend.h"
+#include "gl_state_cache.h"
+namespace engine {
+
+/* gl_render_backend::create_vertex_array */
+GLuint gl_render_backend::create_vertex_array() {
+    GLuint vao = 0;
+    glGenVertexArrays( 1, &vao );
+    return vao;
+}
+
+/* gl_render_backend::create_buffer */
+GLuint gl_render_backend::create_buffer() {
+    GLuint buffer = 0;
+    glGenBuffers( 1, &buffer );
+    return buffer;
+}
+
+/* gl_render_backend::bind_vertex_array */
+void gl_render_backend::bind_vertex_array( GLuint vao ) {
+    gl_state_cache::bind_vertex_array( vao );
+}
+
+/* gl_render_backend::bind_buffer */
+void gl_render_backend::bind_buffer( GLenum target, GLuint buffer ) {
+    glBindBuffer( target, buffer );
+}
+
+/* gl_render_backend::buffer_data */
+void gl_render_backend::buffer_data( GLenum target, GLsizeiptr size, const void *data, GLenum usage ) {
+    glBufferData( target, size, data, usage );
+}
+
+/* gl_render_backend::buffer_sub_data */
+void gl_render_backend::buffer_sub_data( GLenum target, GLintptr offset, GLsizeiptr size, const void *data ) {
+    glBufferSubData( target, offset, size, data );
+}
+
+/* gl_render_backend::vertex_attrib_pointer */
+void gl_render_backend::vertex_attrib_pointer( GLuint index, GLint size, GLenum type, GLsizei stride, GLintptr offset ) {
+    glVertexAttribPointer( index, size, type, GL_FALSE, stride, reinterpret_cast<void*>(offset) );
+}
+
+/* gl_render_backend::vertex_attrib_divisor */
+void gl_render_backend::vertex_attrib_divisor( GLuint index, GLuint divisor ) {
+    glVertexAttribDivisor( index, divisor );
+}
+
+/* gl_render_backend::enable_vertex_attrib */
+void gl_render_backend::enable_vertex_attrib( GLuint index ) {
+    gl_state_cache::enable_vertex_attrib( index );
+}
+
+/* gl_render_backend::use_program */
+void gl_render_backend::use_program( GLuint program ) {
+    gl_state_cache::use_program( program );
+}
+
+/* gl_render_backend::bind_texture */
+void gl_render_backend::bind_texture( GLenum target, GLuint texture ) {
+    gl_state_cache::bind_texture( target, texture );
+}
+
+/* gl_render_backend::uniform_matrix */
+void gl_render_backend::uniform_matrix( GLint location, const float *m ) {
+    gl_state_cache::uniform_matrix( location, m );
+}
+
+/* gl_render_backend::primitive_restart_index */
+void gl_render_backend::primitive_restart_index( GLuint index ) {
+    gl_state_cache::primitive_restart_index( index );
+}
+
+/* gl_render_backend::draw_arrays */
+void gl_render_backend::draw_arrays( GLenum mode, GLint first, GLsizei count ) {
+    glDrawArrays( mode, first, count );
+}
+
+/* gl_render_backend::draw_arrays_instanced */
+void gl_render_backend::draw_arrays_instanced( GLenum mode, GLint first, GLsizei count, GLsizei instances ) {
+    glDrawArraysInstanced( mode, first, count, instances );
+}
+
+/* gl_render_backend::draw_elements */
+void gl_render_backend::draw_elements( GLenum mode, GLsizei count, GLenum type, GLintptr offset ) {
+    glDrawElements( mode, count, type, reinterpret_cast<void*>(offset) );
+}
+
+/* gl_render_backend::draw_elements_instanced */
+void gl_render_backend::draw_elements_instanced( GLenum mode, GLsizei count, GLenum type, GLintptr offset, GLsizei instances ) {
+    glDrawElementsInstanced( mode, count, type, reinterpret_cast<void*>(offset), instances );
+}
+
+} /* namespace engine */
@@ -0,0 +1,32 @@
+#pragma once
+#include <renderer/render_backend.h>
+namespace engine {
+
+/* gl_render_backend
+* render_backend which forwards the calls to the OpenGL context current
+* for the thread, state changes go through gl_state_cache */
+class gl_render_backend : public render_backend {
+public:
+    GLuint              create_vertex_array() override;
+    GLuint              create_buffer() override;
+    void                bind_vertex_array( GLuint vao ) override;
+    void                bind_buffer( GLenum target, GLuint buffer ) override;
+    void                buffer_data( GLenum target, GLsizeiptr size, const void *data, GLenum usage ) override;
+    void                buffer_sub_data( GLenum target, GLintptr offset, GLsizeiptr size, const void *data ) override;
+
+    void                vertex_attrib_pointer( GLuint index, GLint size, GLenum type, GLsizei stride, GLintptr offset ) override;
+    void                vertex_attrib_divisor( GLuint index, GLuint divisor ) override;
+    void                enable_vertex_attrib( GLuint index ) override;
+
+    void                use_program( GLuint program ) override;
+    void                bind_texture( GLenum target, GLuint texture ) override;
+    void                uniform_matrix( GLint location, const float *m ) override;
+
+    void                primitive_restart_index( GLuint index ) override;
+    void                draw_arrays( GLenum mode, GLint first, GLsizei count ) override;
+    void                draw_arrays_instanced( GLenum mode, GLint first, GLsizei count, GLsizei instances ) override;
+    void                draw_elements( GLenum mode, GLsizei count, GLenum type, GLintptr offset ) override;
+    void                draw_elements_instanced( GLenum mode, GLsizei count, GLenum type, GLintptr offset, GLsizei instances ) override;
+};
+
+} /* namespace engine */
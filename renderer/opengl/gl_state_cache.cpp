@@ -0,0 +1,304 @@
+#include "gl_state_cache.h"
+#include <cstring>
+#include <core/assert.hpp>
+namespace engine {
+
+gl_state_cache::value<GLuint>   gl_state_cache::program;
+gl_state_cache::value<GLuint>   gl_state_cache::vertexArray;
+gl_state_cache::value<GLenum>   gl_state_cache::activeUnit;
+gl_state_cache::value<GLuint>   gl_state_cache::textures[MAX_TEXTURE_UNITS][TARGET_NUMBER];
+gl_state_cache::value<GLuint>   gl_state_cache::restartIndex;
+gl_state_cache::value<bool>     gl_state_cache::caps[CAP_NUMBER];
+gl_state_cache::value<GLenum>   gl_state_cache::cullFace;
+gl_state_cache::value<GLenum>   gl_state_cache::depthFunc;
+gl_state_cache::value<GLenum>   gl_state_cache::polygonMode;
+std::unordered_map<GLuint, gl_state_cache::attribs>                     gl_state_cache::vertexAttribs;
+std::unordered_map<GLuint, core::vector<gl_state_cache::uniform_value>> gl_state_cache::uniforms;
+gl_state_cache::statistics      gl_state_cache::frame;
+gl_state_cache::statistics      gl_state_cache::lastFrame;
+
+/* gl_state_cache::reset */
+void gl_state_cache::reset() {
+    program = value<GLuint>();
+    vertexArray = value<GLuint>();
+    activeUnit = value<GLenum>();
+    for( auto &unit : textures ) {
+        for( auto &texture : unit ) {
+            texture = value<GLuint>();
+        }
+    }
+    restartIndex = value<GLuint>();
+    for( auto &cap : caps ) {
+        cap = value<bool>();
+    }
+    cullFace = value<GLenum>();
+    depthFunc = value<GLenum>();
+    polygonMode = value<GLenum>();
+    vertexAttribs.clear();
+    uniforms.clear();
+}
+
+/* gl_state_cache::begin_frame */
+void gl_state_cache::begin_frame() {
+    lastFrame = frame;
+    frame = statistics();
+}
+
+/* gl_state_cache::use_program */
+void gl_state_cache::use_program( GLuint prog ) {
+    if( skip( program.equal( prog ) ) ) {
+        return;
+    }
+    glUseProgram( prog );
+    program.set( prog );
+}
+
+/* gl_state_cache::bind_vertex_array */
+void gl_state_cache::bind_vertex_array( GLuint vao ) {
+    if( skip( vertexArray.equal( vao ) ) ) {
+        return;
+    }
+    glBindVertexArray( vao );
+    vertexArray.set( vao );
+}
+
+/* gl_state_cache::active_texture */
+void gl_state_cache::active_texture( GLenum unit ) {
+    assert( unit >= GL_TEXTURE0 );
+    if( skip( activeUnit.equal( unit ) ) ) {
+        return;
+    }
+    glActiveTexture( unit );
+    activeUnit.set( unit );
+}
+
+/* gl_state_cache::bind_texture */
+void gl_state_cache::bind_texture( GLenum target, GLuint texture ) {
+    int unit = activeUnit.known ? static_cast<int>( activeUnit.v - GL_TEXTURE0 ) : -1;
+    int targetIndex = texture_target_index( target );
+    if( unit < 0 || unit >= MAX_TEXTURE_UNITS || targetIndex < 0 ) {
+        /* not shadowed */
+        skip( false );
+        glBindTexture( target, texture );
+        return;
+    }
+    auto &bound = textures[unit][targetIndex];
+    if( skip( bound.equal( texture ) ) ) {
+        return;
+    }
+    glBindTexture( target, texture );
+    bound.set( texture );
+}
+
+/* gl_state_cache::enable_vertex_attrib */
+void gl_state_cache::enable_vertex_attrib( GLuint index ) {
+    assert( index < MAX_VERTEX_ATTRIBS );
+    if( !vertexArray.known ) {
+        skip( false );
+        glEnableVertexAttribArray( index );
+        return;
+    }
+    auto &a = vertexAttribs[vertexArray.v];
+    std::uint32_t bit = std::uint32_t(1) << index;
+    if( skip( (a.known & bit) && (a.enabled & bit) ) ) {
+        return;
+    }
+    glEnableVertexAttribArray( index );
+    a.known |= bit;
+    a.enabled |= bit;
+}
+
+/* gl_state_cache::disable_vertex_attrib */
+void gl_state_cache::disable_vertex_attrib( GLuint index ) {
+    assert( index < MAX_VERTEX_ATTRIBS );
+    if( !vertexArray.known ) {
+        skip( false );
+        glDisableVertexAttribArray( index );
+        return;
+    }
+    auto &a = vertexAttribs[vertexArray.v];
+    std::uint32_t bit = std::uint32_t(1) << index;
+    if( skip( (a.known & bit) && !(a.enabled & bit) ) ) {
+        return;
+    }
+    glDisableVertexAttribArray( index );
+    a.known |= bit;
+    a.enabled &= ~bit;
+}
+
+/* gl_state_cache::primitive_restart_index */
+void gl_state_cache::primitive_restart_index( GLuint index ) {
+    if( skip( restartIndex.equal( index ) ) ) {
+        return;
+    }
+    glPrimitiveRestartIndex( index );
+    restartIndex.set( index );
+}
+
+/* gl_state_cache::enable */
+void gl_state_cache::enable( GLenum cap ) {
+    int i = cap_index( cap );
+    if( skip( i >= 0 && caps[i].equal( true ) ) ) {
+        return;
+    }
+    glEnable( cap );
+    if( i >= 0 ) {
+        caps[i].set( true );
+    }
+}
+
+/* gl_state_cache::disable */
+void gl_state_cache::disable( GLenum cap ) {
+    int i = cap_index( cap );
+    if( skip( i >= 0 && caps[i].equal( false ) ) ) {
+        return;
+    }
+    glDisable( cap );
+    if( i >= 0 ) {
+        caps[i].set( false );
+    }
+}
+
+/* gl_state_cache::cull_face */
+void gl_state_cache::cull_face( GLenum face ) {
+    if( skip( cullFace.equal( face ) ) ) {
+        return;
+    }
+    glCullFace( face );
+    cullFace.set( face );
+}
+
+/* gl_state_cache::depth_func */
+void gl_state_cache::depth_func( GLenum func ) {
+    if( skip( depthFunc.equal( func ) ) ) {
+        return;
+    }
+    glDepthFunc( func );
+    depthFunc.set( func );
+}
+
+/* gl_state_cache::polygon_mode
+* core profile has only GL_FRONT_AND_BACK face */
+void gl_state_cache::polygon_mode( GLenum mode ) {
+    if( skip( polygonMode.equal( mode ) ) ) {
+        return;
+    }
+    glPolygonMode( GL_FRONT_AND_BACK, mode );
+    polygonMode.set( mode );
+}
+
+/* gl_state_cache::uniform_matrix */
+void gl_state_cache::uniform_matrix( GLint location, const float *m ) {
+    if( location < 0 || !program.known ) {
+        skip( false );
+        glUniformMatrix4fv( location, 1, GL_TRUE, m );
+        return;
+    }
+    auto &values = uniforms[program.v];
+    if( values.size() <= static_cast<size_t>( location ) ) {
+        values.resize( location + 1 );
+    }
+    auto &u = values[location];
+    if( skip( u.known && u.isMatrix && std::memcmp( u.m, m, sizeof(u.m) ) == 0 ) ) {
+        return;
+    }
+    glUniformMatrix4fv( location, 1, GL_TRUE, m );
+    std::memcpy( u.m, m, sizeof(u.m) );
+    u.isMatrix = true;
+    u.known = true;
+}
+
+/* gl_state_cache::uniform_int */
+void gl_state_cache::uniform_int( GLint location, GLint value ) {
+    if( location < 0 || !program.known ) {
+        skip( false );
+        glUniform1i( location, value );
+        return;
+    }
+    auto &values = uniforms[program.v];
+    if( values.size() <= static_cast<size_t>( location ) ) {
+        values.resize( location + 1 );
+    }
+    auto &u = values[location];
+    if( skip( u.known && !u.isMatrix && u.i == value ) ) {
+        return;
+    }
+    glUniform1i( location, value );
+    u.i = value;
+    u.isMatrix = false;
+    u.known = true;
+}
+
+/* gl_state_cache::delete_texture
+* GL unbinds the texture from every unit of the context */
+void gl_state_cache::delete_texture( GLuint texture ) {
+    if( texture == 0 ) {
+        return;
+    }
+    glDeleteTextures( 1, &texture );
+    for( auto &unit : textures ) {
+        for( auto &bound : unit ) {
+            if( bound.equal( texture ) ) {
+                bound = value<GLuint>();
+            }
+        }
+    }
+}
+
+/* gl_state_cache::delete_program
+* the current program is only flagged for deletion by GL, it is
+* forgotten as well */
+void gl_state_cache::delete_program( GLuint prog ) {
+    if( prog == 0 ) {
+        return;
+    }
+    glDeleteProgram( prog );
+    if( program.equal( prog ) ) {
+        program = value<GLuint>();
+    }
+    uniforms.erase( prog );
+}
+
+/* gl_state_cache::delete_vertex_array */
+void gl_state_cache::delete_vertex_array( GLuint vao ) {
+    if( vao == 0 ) {
+        return;
+    }
+    glDeleteVertexArrays( 1, &vao );
+    if( vertexArray.equal( vao ) ) {
+        vertexArray = value<GLuint>();
+    }
+    vertexAttribs.erase( vao );
+}
+
+/* gl_state_cache::cap_index */
+int gl_state_cache::cap_index( GLenum cap ) {
+    switch( cap ) {
+        case GL_CULL_FACE:
+            return CAP_CULL_FACE;
+        case GL_DEPTH_TEST:
+            return CAP_DEPTH_TEST;
+        case GL_PRIMITIVE_RESTART:
+            return CAP_PRIMITIVE_RESTART;
+        case GL_BLEND:
+            return CAP_BLEND;
+    }
+    return -1;
+}
+
+/* gl_state_cache::texture_target_index */
+int gl_state_cache::texture_target_index( GLenum target ) {
+    switch( target ) {
+        case GL_TEXTURE_2D:
+            return TARGET_2D;
+        case GL_TEXTURE_CUBE_MAP:
+            return TARGET_CUBE_MAP;
+        case GL_TEXTURE_3D:
+            return TARGET_3D;
+        case GL_TEXTURE_2D_ARRAY:
+            return TARGET_2D_ARRAY;
+    }
+    return -1;
+}
+
+} /* namespace engine */
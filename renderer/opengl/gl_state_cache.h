@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <core/vector.hpp>
+#include "gl.h"
+namespace engine {
+
+/* gl_state_cache
+* shadow copy of the OpenGL state of the current context. Calls which
+* do not change the state are not forwarded to GL. All state changes of
+* the context must go through the cache or be followed by reset() */
+class gl_state_cache {
+public:
+    struct statistics {
+        int         forwarded{0};       /* calls passed to GL */
+        int         skipped{0};         /* redundant calls */
+    };
+
+    static const int    MAX_TEXTURE_UNITS = 16;
+    static const int    MAX_VERTEX_ATTRIBS = 32;
+
+public:
+                        /* forget everything, next calls are forwarded */
+    static void         reset();
+                        /* statistics of the finished frame are kept for get_frame_statistics() */
+    static void         begin_frame();
+    static const statistics &get_frame_statistics();
+
+    static void         use_program( GLuint program );
+    static void         bind_vertex_array( GLuint vao );
+    static void         active_texture( GLenum unit );
+    static void         bind_texture( GLenum target, GLuint texture );
+                        /* enabled attributes are stored per vertex array */
+    static void         enable_vertex_attrib( GLuint index );
+    static void         disable_vertex_attrib( GLuint index );
+    static void         primitive_restart_index( GLuint index );
+    static void         enable( GLenum cap );
+    static void         disable( GLenum cap );
+    static void         cull_face( GLenum face );
+    static void         depth_func( GLenum func );
+    static void         polygon_mode( GLenum mode );
+
+                        /* uniforms of the bound program, m - row-major 4x4 matrix */
+    static void         uniform_matrix( GLint location, const float *m );
+    static void         uniform_int( GLint location, GLint value );
+
+                        /* deletes the GL object and forgets its bindings, its
+                        * attributes and uniforms, GL may return the name again */
+    static void         delete_texture( GLuint texture );
+    static void         delete_program( GLuint prog );
+    static void         delete_vertex_array( GLuint vao );
+
+private:
+    static bool         skip( bool same );
+    static int          cap_index( GLenum cap );
+    static int          texture_target_index( GLenum target );
+
+private:
+    /* shadowed value, unknown values are never equal */
+    template <typename T>
+    struct value {
+        T           v{};
+        bool        known{false};
+
+        bool        equal( const T &x ) const { return known && v == x; }
+        void        set( const T &x ) { v = x; known = true; }
+    };
+    struct attribs {
+        std::uint32_t   enabled{0};
+        std::uint32_t   known{0};
+    };
+    struct uniform_value {
+        float       m[16];
+        GLint       i{0};
+        bool        isMatrix{false};
+        bool        known{false};
+    };
+
+    enum { CAP_CULL_FACE, CAP_DEPTH_TEST, CAP_PRIMITIVE_RESTART, CAP_BLEND, CAP_NUMBER };
+    enum { TARGET_2D, TARGET_CUBE_MAP, TARGET_3D, TARGET_2D_ARRAY, TARGET_NUMBER };
+
+    static value<GLuint>    program;
+    static value<GLuint>    vertexArray;
+    static value<GLenum>    activeUnit;
+    static value<GLuint>    textures[MAX_TEXTURE_UNITS][TARGET_NUMBER];
+    static value<GLuint>    restartIndex;
+    static value<bool>      caps[CAP_NUMBER];
+    static value<GLenum>    cullFace;
+    static value<GLenum>    depthFunc;
+    static value<GLenum>    polygonMode;
+    static std::unordered_map<GLuint, attribs>                      vertexAttribs;
+    static std::unordered_map<GLuint, core::vector<uniform_value>>  uniforms;
+    static statistics       frame;
+    static statistics       lastFrame;
+};
+
+
+
+/* gl_state_cache::get_frame_statistics */
+inline const gl_state_cache::statistics &gl_state_cache::get_frame_statistics() {
+    return lastFrame;
+}
+
+/* gl_state_cache::skip
+* counts the call, returns true if it must not be forwarded */
+inline bool gl_state_cache::skip( bool same ) {
+    if( same ) {
+        frame.skipped++;
+    } else {
+        frame.forwarded++;
+    }
+    return same;
+}
+
+} /* namespace engine */
@@ -0,0 +1,273 @@
+#include "pixel_convert.h"
+#include <core/simd.hpp>
+#include <core/assert.hpp>
+#include <cstring>
+
+namespace engine {
+namespace renderer {
+
+typedef void(*fnPxcvtFunc)(const byte*,byte*);
+
+/* pixel covert functions */
+static void pxcvt_bgr8_rgb8( const byte *from, byte *to ) {
+    to[0] = from[2];
+    to[1] = from[1];
+    to[2] = from[0];
+}
+
+static void pxcvt_bgr8_rgba8( const byte *from, byte *to ) {
+    to[0] = from[2];
+    to[1] = from[1];
+    to[2] = from[0];
+    to[3] = 0;
+}
+
+static void pxcvt_bgr8_gray8( const byte *from, byte *to ) {
+    to[0] = (from[2] + from[1] + from[0]) / 3;
+}
+
+static void pxcvt_gray8_bgr8( const byte *from, byte *to ) {
+    to[0] = from[0];
+    to[1] = from[0];
+    to[2] = from[0];
+}
+
+static void pxcvt_gray8_bgra8( const byte *from, byte *to ) {
+    to[0] = from[0];
+    to[1] = from[0];
+    to[2] = from[0];
+    to[3] = 0;
+}
+
+static void pxcvt_bgra8_rgba8( const byte *from, byte *to ) {
+    to[0] = from[2];
+    to[1] = from[1];
+    to[2] = from[0];
+    to[3] = from[3];
+}
+
+static void pxcpy3( const byte *from, byte *to ) {
+    to[0] = from[0];
+    to[1] = from[1];
+    to[2] = from[2];
+}
+
+static void pxcpy3_expand1( const byte *from, byte *to ) {
+    to[0] = from[0];
+    to[1] = from[1];
+    to[2] = from[2];
+    to[3] = 0;
+}
+
+/* byte shuffles of 16 bytes, Z clears the byte */
+#define Z 0x80
+/* 5 pixels of 3 bytes, swap of the first and the third byte */
+alignas(16) static const byte MASK_SWAP3[16] = {
+    2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, Z
+};
+/* 4 pixels of 3 bytes to 4 bytes */
+alignas(16) static const byte MASK_EXPAND[16] = {
+    0, 1, 2, Z, 3, 4, 5, Z, 6, 7, 8, Z, 9, 10, 11, Z
+};
+alignas(16) static const byte MASK_SWAP_EXPAND[16] = {
+    2, 1, 0, Z, 5, 4, 3, Z, 8, 7, 6, Z, 11, 10, 9, Z
+};
+/* 4 pixels of 4 bytes to 3 bytes */
+alignas(16) static const byte MASK_SHRINK[16] = {
+    0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, Z, Z, Z, Z
+};
+alignas(16) static const byte MASK_SWAP_SHRINK[16] = {
+    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, Z, Z, Z, Z
+};
+/* 4 pixels of 4 bytes */
+alignas(16) static const byte MASK_SWAP4[16] = {
+    2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15
+};
+/* 16 gray pixels to 3 and 4 bytes */
+alignas(16) static const byte MASK_GRAY3[3][16] = {
+    { 0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5 },
+    { 5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10 },
+    { 10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15 }
+};
+alignas(16) static const byte MASK_GRAY4[4][16] = {
+    { 0, 0, 0, Z, 1, 1, 1, Z, 2, 2, 2, Z, 3, 3, 3, Z },
+    { 4, 4, 4, Z, 5, 5, 5, Z, 6, 6, 6, Z, 7, 7, 7, Z },
+    { 8, 8, 8, Z, 9, 9, 9, Z, 10, 10, 10, Z, 11, 11, 11, Z },
+    { 12, 12, 12, Z, 13, 13, 13, Z, 14, 14, 14, Z, 15, 15, 15, Z }
+};
+#undef Z
+
+/* pixels needed to read or write 16 bytes */
+constexpr int get_min_pixels( int group, int fromSize, int toSize ) {
+    int from = (16 + fromSize - 1) / fromSize;
+    int to = (16 + toSize - 1) / toSize;
+    int n = from > to ? from : to;
+    return n > group ? n : group;
+}
+
+/* convert_row_pixels */
+template<fnPxcvtFunc cvt, int fromSize, int toSize>
+static void convert_row_pixels( const byte *from, byte *to, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        cvt( from, to );
+        from += fromSize;
+        to += toSize;
+    }
+}
+
+/* copy_row */
+template<int pxSize>
+static void copy_row( const byte *from, byte *to, int count ) {
+    memcpy( to, from, static_cast<size_t>( count ) * pxSize );
+}
+
+/* convert_row_shuffle
+* reorders the channels of the groups of pixels, every group is
+* loaded and stored by 16 bytes, AVX2 shuffles two groups at once */
+template<int fromSize, int toSize, const byte *mask, fnPxcvtFunc cvt>
+static void convert_row_shuffle( const byte *from, byte *to, int count ) {
+    int i = 0;
+#if SIMD_SSE4_1_ENABLED
+    const int group = fromSize == 3 && toSize == 3 ? 5 : 4;
+    const int minPixels = get_min_pixels( group, fromSize, toSize );
+    const __m128i shuffle = _mm_load_si128( reinterpret_cast<const __m128i*>( mask ) );
+#if SIMD_AVX2_ENABLED
+    const __m256i shuffle2 = _mm256_broadcastsi128_si256( shuffle );
+    for( ; count - i >= group + minPixels; i += group * 2 ) {
+        const byte *src = from + i * fromSize;
+        byte *dst = to + i * toSize;
+        __m256i px = _mm256_castsi128_si256( _mm_loadu_si128( reinterpret_cast<const __m128i*>( src ) ) );
+        px = _mm256_inserti128_si256( px, _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + group * fromSize ) ), 1 );
+        px = _mm256_shuffle_epi8( px, shuffle2 );
+        /* the tail of the first group is overwritten by the second one */
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( dst ), _mm256_castsi256_si128( px ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( dst + group * toSize ), _mm256_extracti128_si256( px, 1 ) );
+    }
+#endif /* SIMD_AVX2_ENABLED */
+    for( ; count - i >= minPixels; i += group ) {
+        __m128i px = _mm_loadu_si128( reinterpret_cast<const __m128i*>( from + i * fromSize ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( to + i * toSize ), _mm_shuffle_epi8( px, shuffle ) );
+    }
+#endif /* SIMD_SSE4_1_ENABLED */
+    convert_row_pixels<cvt, fromSize, toSize>( from + i * fromSize, to + i * toSize, count - i );
+}
+
+/* convert_row_from_gray
+* 16 gray pixels are spread to 3 or 4 stores of 16 bytes */
+template<int toSize, fnPxcvtFunc cvt>
+static void convert_row_from_gray( const byte *from, byte *to, int count ) {
+    int i = 0;
+#if SIMD_SSE4_1_ENABLED
+    const byte (*masks)[16] = toSize == 3 ? MASK_GRAY3 : MASK_GRAY4;
+    __m128i shuffle[toSize];
+    for( int k = 0; k < toSize; k++ ) {
+        shuffle[k] = _mm_load_si128( reinterpret_cast<const __m128i*>( masks[k] ) );
+    }
+    for( ; count - i >= 16; i += 16 ) {
+        __m128i px = _mm_loadu_si128( reinterpret_cast<const __m128i*>( from + i ) );
+        byte *dst = to + i * toSize;
+        for( int k = 0; k < toSize; k++ ) {
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( dst + k * 16 ), _mm_shuffle_epi8( px, shuffle[k] ) );
+        }
+    }
+#endif /* SIMD_SSE4_1_ENABLED */
+    convert_row_pixels<cvt, 1, toSize>( from + i, to + i * toSize, count - i );
+}
+
+/* convert_row_to_gray
+* the channels of 16 pixels are summed up by the multiply-add of bytes,
+* sum / 3 is (sum * 21846) >> 16, which is exact for sums up to 765 */
+template<int fromSize, fnPxcvtFunc cvt>
+static void convert_row_to_gray( const byte *from, byte *to, int count ) {
+    int i = 0;
+#if SIMD_SSE4_1_ENABLED
+    const int minPixels = fromSize == 3 ? 18 : 16;     /* the last load reads 4 bytes more */
+    const __m128i expand = _mm_load_si128( reinterpret_cast<const __m128i*>( MASK_EXPAND ) );
+    const __m128i weights = _mm_set1_epi32( 0x00010101 );
+    const __m128i third = _mm_set1_epi16( 21846 );
+    for( ; count - i >= minPixels; i += 16 ) {
+        const byte *src = from + i * fromSize;
+        __m128i sums[4];
+        for( int k = 0; k < 4; k++ ) {
+            __m128i px = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + k * 4 * fromSize ) );
+            if( fromSize == 3 ) {
+                px = _mm_shuffle_epi8( px, expand );
+            }
+            sums[k] = _mm_maddubs_epi16( px, weights );
+        }
+        __m128i lo = _mm_mulhi_epu16( _mm_hadd_epi16( sums[0], sums[1] ), third );
+        __m128i hi = _mm_mulhi_epu16( _mm_hadd_epi16( sums[2], sums[3] ), third );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( to + i ), _mm_packus_epi16( lo, hi ) );
+    }
+#endif /* SIMD_SSE4_1_ENABLED */
+    convert_row_pixels<cvt, fromSize, 1>( from + i * fromSize, to + i, count - i );
+}
+
+/* get_convert_row_func */
+fnRowcvtFunc get_convert_row_func( pixel_format from, pixel_format to ) {
+    assert( from != PIXEL_FORMAT_AUTO );
+    assert( to != PIXEL_FORMAT_AUTO );
+    switch(from) {
+        case PIXEL_FORMAT_GRAY8:
+            switch(to) {
+                case PIXEL_FORMAT_GRAY8:    return copy_row<1>;
+                case PIXEL_FORMAT_BGR8:     return convert_row_from_gray<3, pxcvt_gray8_bgr8>;
+                case PIXEL_FORMAT_BGRA8:    return convert_row_from_gray<4, pxcvt_gray8_bgra8>;
+                case PIXEL_FORMAT_RGB8:     return convert_row_from_gray<3, pxcvt_gray8_bgr8>;
+                case PIXEL_FORMAT_RGBA8:    return convert_row_from_gray<4, pxcvt_gray8_bgra8>;
+                case PIXEL_FORMAT_AUTO:     break;
+            }
+            break;
+        case PIXEL_FORMAT_BGR8:
+            switch(to) {
+                case PIXEL_FORMAT_GRAY8:    return convert_row_to_gray<3, pxcvt_bgr8_gray8>;
+                case PIXEL_FORMAT_BGR8:     return copy_row<3>;
+                case PIXEL_FORMAT_BGRA8:    return convert_row_shuffle<3, 4, MASK_EXPAND, pxcpy3_expand1>;
+                case PIXEL_FORMAT_RGB8:     return convert_row_shuffle<3, 3, MASK_SWAP3, pxcvt_bgr8_rgb8>;
+                case PIXEL_FORMAT_RGBA8:    return convert_row_shuffle<3, 4, MASK_SWAP_EXPAND, pxcvt_bgr8_rgba8>;
+                case PIXEL_FORMAT_AUTO:     break;
+            }
+            break;
+        case PIXEL_FORMAT_BGRA8:
+            switch(to) {
+                case PIXEL_FORMAT_GRAY8:    return convert_row_to_gray<4, pxcvt_bgr8_gray8>;
+                case PIXEL_FORMAT_BGR8:     return convert_row_shuffle<4, 3, MASK_SHRINK, pxcpy3>;
+                case PIXEL_FORMAT_BGRA8:    return copy_row<4>;
+                case PIXEL_FORMAT_RGB8:     return convert_row_shuffle<4, 3, MASK_SWAP_SHRINK, pxcvt_bgr8_rgb8>;
+                case PIXEL_FORMAT_RGBA8:    return convert_row_shuffle<4, 4, MASK_SWAP4, pxcvt_bgra8_rgba8>;
+                case PIXEL_FORMAT_AUTO:     break;
+            }
+            break;
+        case PIXEL_FORMAT_RGB8:
+            switch(to) {
+                case PIXEL_FORMAT_GRAY8:    return convert_row_to_gray<3, pxcvt_bgr8_gray8>;
+                case PIXEL_FORMAT_BGR8:     return convert_row_shuffle<3, 3, MASK_SWAP3, pxcvt_bgr8_rgb8>;
+                case PIXEL_FORMAT_BGRA8:    return convert_row_shuffle<3, 4, MASK_SWAP_EXPAND, pxcvt_bgr8_rgba8>;
+                case PIXEL_FORMAT_RGB8:     return copy_row<3>;
+                case PIXEL_FORMAT_RGBA8:    return convert_row_shuffle<3, 4, MASK_EXPAND, pxcpy3_expand1>;
+                case PIXEL_FORMAT_AUTO:     break;
+            }
+            break;
+        case PIXEL_FORMAT_RGBA8:
+            switch(to) {
+                case PIXEL_FORMAT_GRAY8:    return convert_row_to_gray<4, pxcvt_bgr8_gray8>;
+                case PIXEL_FORMAT_BGR8:     return convert_row_shuffle<4, 3, MASK_SWAP_SHRINK, pxcvt_bgr8_rgb8>;
+                case PIXEL_FORMAT_BGRA8:    return convert_row_shuffle<4, 4, MASK_SWAP4, pxcvt_bgra8_rgba8>;
+                case PIXEL_FORMAT_RGB8:     return convert_row_shuffle<4, 3, MASK_SHRINK, pxcpy3>;
+                case PIXEL_FORMAT_RGBA8:    return copy_row<4>;
+                case PIXEL_FORMAT_AUTO:     break;
+            }
+            break;
+        case PIXEL_FORMAT_AUTO: break;
+    }
+    assert(0);
+    return nullptr;
+}
+
+/* convert_row */
+void convert_row( pixel_format from, pixel_format to, const byte *src, byte *dst, int count ) {
+    get_convert_row_func( from, to )( src, dst, count );
+}
+
+} /* namespace renderer */
+} /* namespace engine */
@@ -0,0 +1,18 @@
+#pragma once
+#include <core/types.hpp>
+#include "image.h"
+
+namespace engine {
+namespace renderer {
+
+/* converts count pixels of the row from one pixel format to another.
+* Alpha of the formats without it is 0, gray is (r + g + b) / 3.
+* The rows must not overlap */
+typedef void(*fnRowcvtFunc)(const byte *from, byte *to, int count);
+
+/* returns the conversion of the pixel formats, selected once per image */
+fnRowcvtFunc    get_convert_row_func( pixel_format from, pixel_format to );
+void            convert_row( pixel_format from, pixel_format to, const byte *src, byte *dst, int count );
+
+} /* namespace renderer */
+} /* namespace engine */
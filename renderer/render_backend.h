@@ -0,0 +1,40 @@
+#pragma once
+#include <renderer/opengl/gl.h>
+namespace engine {
+
+/* render_backend
+* low-level calls used to submit meshes to the graphics API.
+* The submission logic talks only to this interface, so it can be
+* checked by a backend which records the calls instead of drawing */
+class render_backend {
+public:
+    virtual             ~render_backend() {}
+
+                        /* objects */
+    virtual GLuint      create_vertex_array() = 0;
+    virtual GLuint      create_buffer() = 0;
+    virtual void        bind_vertex_array( GLuint vao ) = 0;
+    virtual void        bind_buffer( GLenum target, GLuint buffer ) = 0;
+    virtual void        buffer_data( GLenum target, GLsizeiptr size, const void *data, GLenum usage ) = 0;
+    virtual void        buffer_sub_data( GLenum target, GLintptr offset, GLsizeiptr size, const void *data ) = 0;
+
+                        /* vertex attributes, offset in bytes in the bound buffer */
+    virtual void        vertex_attrib_pointer( GLuint index, GLint size, GLenum type, GLsizei stride, GLintptr offset ) = 0;
+    virtual void        vertex_attrib_divisor( GLuint index, GLuint divisor ) = 0;
+    virtual void        enable_vertex_attrib( GLuint index ) = 0;
+
+                        /* program state */
+    virtual void        use_program( GLuint program ) = 0;
+    virtual void        bind_texture( GLenum target, GLuint texture ) = 0;
+                        /* m - row-major 4x4 matrix */
+    virtual void        uniform_matrix( GLint location, const float *m ) = 0;
+
+                        /* drawing */
+    virtual void        primitive_restart_index( GLuint index ) = 0;
+    virtual void        draw_arrays( GLenum mode, GLint first, GLsizei count ) = 0;
+    virtual void        draw_arrays_instanced( GLenum mode, GLint first, GLsizei count, GLsizei instances ) = 0;
+    virtual void        draw_elements( GLenum mode, GLsizei count, GLenum type, GLintptr offset ) = 0;
+    virtual void        draw_elements_instanced( GLenum mode, GLsizei count, GLenum type, GLintptr offset, GLsizei instances ) = 0;
+};
+
+} /* namespace engine */
@@ -2,6 +2,7 @@
 #include <core/assert.hpp>
 #include <core/common.hpp>
 #include <core/filesystem.hpp>
+#include <renderer/opengl/gl_state_cache.h>
 namespace engine {
 
 core::vector<shader::shader_object> shader::shaderObjects;
@@ -14,6 +15,13 @@ shader::idprog shader::link_program( const idobj vsh, const idobj fsh ) {
     assert( vsh != fsh );
     assert( vsh != 0 || fsh != 0 );
 
+    /* the same objects are linked once */
+    for( size_t i = 0; i < shaderPrograms.size(); i++ ) {
+        if( shaderPrograms[i].vertexShaderId == vsh && shaderPrograms[i].fragmentShaderId == fsh ) {
+            return static_cast<idprog>( i + 1 + 65535 );
+        }
+    }
+
     auto fail = false;
     auto program = glCreateProgram();
     if( !program ) {
@@ -55,14 +63,14 @@ shader::idprog shader::link_program( const idobj vsh, const idobj fsh ) {
     }
     /* detach shader objects */
     if( vsh ) {
-        glDetachShader( program, vsh );
+        glDetachShader( program, shaderObjects[vsh - 1].obj );
     }
     if( fsh ) {
-        glDetachShader( program, fsh );
+        glDetachShader( program, shaderObjects[fsh - 1].obj );
     }
     if( fail ) {
         /* linking the program failed */
-        glDeleteProgram( program );
+        gl_state_cache::delete_program( program );
         return 0;
     }
     /* add program to list */
@@ -74,11 +82,20 @@ shader::idprog shader::link_program( const idobj vsh, const idobj fsh ) {
 void shader::use_program( const idprog prog ) {
     assert( ((prog > 65535) && (prog <= static_cast<idprog>(shaderPrograms.size()) + 65535)) || prog == 0 );
     if( prog == 0 ) {
-        glUseProgram( 0 );
+        gl_state_cache::use_program( 0 );
         return;
     }
     auto &program( shaderPrograms[prog - 65535 - 1] );
-    glUseProgram( program.prog );
+    gl_state_cache::use_program( program.prog );
+}
+
+/* shader::get_program_object */
+GLuint shader::get_program_object( const idprog prog ) {
+    assert( ((prog > 65535) && (prog <= static_cast<idprog>(shaderPrograms.size()) + 65535)) || prog == 0 );
+    if( prog == 0 ) {
+        return 0;
+    }
+    return shaderPrograms[prog - 65535 - 1].prog;
 }
 
 /* shader::load */
@@ -95,6 +112,18 @@ bool shader::load( const string &vshName, const string &fshName ) {
     return is_loaded();
 }
 
+/* shader::load */
+bool shader::load( const idobj vsh, const idobj fsh ) {
+    assert( !is_loaded() );
+    if( vsh == 0 && fsh == 0 ) {
+        return false;
+    }
+    vertexShader = vsh;
+    fragmentShader = fsh;
+    program = shader::link_program( vertexShader, fragmentShader );
+    return is_loaded();
+}
+
 /* shader::get_uniform */
 uniform shader::get_uniform( const string &uniformName ) {
     auto glprog = shaderPrograms[program - 65535 - 1].prog;
@@ -104,6 +133,12 @@ uniform shader::get_uniform( const string &uniformName ) {
 
 /* shader::load_shader_object */
 shader::idobj shader::load_shader_object( const string &name, GLenum type ) {
+    /* the file is compiled once */
+    for( size_t i = 0; i < shaderObjects.size(); i++ ) {
+        if( shaderObjects[i].type == type && shaderObjects[i].name == name ) {
+            return static_cast<idobj>( i + 1 );
+        }
+    }
     auto shader = load_shader( name, type );
     if( !shader ) {
         return 0;
@@ -112,6 +147,30 @@ shader::idobj shader::load_shader_object( const string &name, GLenum type ) {
     return static_cast<idobj>(shaderObjects.size());
 }
 
+/* shader::compile_shader_object */
+shader::idobj shader::compile_shader_object( const char *text, size_t length, GLenum type ) {
+    auto shader = compile_shader( text, length, type );
+    if( !shader ) {
+        return 0;
+    }
+    /* no name, the object is found by the caller */
+    shaderObjects.push_back( shader_object( "", type, shader ) );
+    return static_cast<idobj>(shaderObjects.size());
+}
+
+/* shader::delete_shader_object
+* the index stays taken, the name of the file is not found again */
+void shader::delete_shader_object( const idobj obj ) {
+    if( obj == 0 ) {
+        return;
+    }
+    assert( obj <= static_cast<idobj>(shaderObjects.size()) );
+    auto &object( shaderObjects[obj - 1] );
+    glDeleteShader( object.obj );
+    object.obj = 0;
+    object.name = "";
+}
+
 /* shader::load_shader */
 GLuint shader::load_shader( const string &name, GLenum type ) {
     /* load shader text */
@@ -120,16 +179,20 @@ GLuint shader::load_shader( const string &name, GLenum type ) {
         common::error() << "shader::load_shader() error: file '" << name << "' not found." << std::endl;
         return 0;
     }
+    return compile_shader( contents.c_str(), contents.length(), type );
+}
 
+/* shader::compile_shader */
+GLuint shader::compile_shader( const char *text, size_t length, GLenum type ) {
     /* create shader object */
     auto shader = glCreateShader( type );
     if( shader == 0 ) {
-        common::error() << "shader::load_shader() error: glCreateShader() returns 0" << std::endl;
+        common::error() << "shader::compile_shader() error: glCreateShader() returns 0" << std::endl;
         return 0;
     }
     /* compile shader */
-    auto *shaderText = contents.c_str();
-    auto shaderTextLength = static_cast<GLint>( contents.length() );
+    auto *shaderText = text;
+    auto shaderTextLength = static_cast<GLint>( length );
     glShaderSource( shader, 1, &shaderText, &shaderTextLength );
     glCompileShader( shader );
     /* check compile status */
@@ -139,7 +202,7 @@ GLuint shader::load_shader( const string &name, GLenum type ) {
         /* compilation failed */
         char buffer[4096];
         glGetShaderInfoLog( shader, sizeof(buffer), nullptr, buffer );   
-        common::error() << "shader::load_shader() error: glCompileShader()" << 
+        common::error() << "shader::compile_shader() error: glCompileShader()" << 
                 std::endl << buffer << std::endl;
         glDeleteShader( shader );
         return 0;
@@ -17,16 +17,26 @@ public:
 public:
     static idobj        load_vertex_shader( const string &name );
     static idobj        load_fragment_shader( const string &name );
+                        /* the text of the file read by the caller, see resource_cache */
+    static idobj        compile_shader_object( const char *text, size_t length, GLenum type );
+                        /* deletes the GL object, the linked programs keep working */
+    static void         delete_shader_object( const idobj obj );
     static idprog       link_program( const idobj vsh, const idobj fsh );
     static void         use_program( const idprog prog );
+                        /* returns GL program object, 0 for prog = 0 */
+    static GLuint       get_program_object( const idprog prog );
 
     bool                load( const string &vshName, const string &fshName );
+                        /* links the compiled objects, 0 - no shader of the type */
+    bool                load( const idobj vsh, const idobj fsh );
     bool                is_loaded();
     void                use();
+    idprog              get_program() const;
     uniform             get_uniform( const string &uniformName );
 private:
     static idobj        load_shader_object( const string &name, GLenum type );
     static GLuint       load_shader( const string &name, GLenum type );
+    static GLuint       compile_shader( const char *text, size_t length, GLenum type );
 
 private:
     idobj               vertexShader{0};
@@ -77,6 +87,11 @@ inline bool shader::is_loaded() {
     return program != 0;
 }
 
+/* shader::get_program */
+inline shader::idprog shader::get_program() const {
+    return program;
+}
+
 /* shader::is_loaded */
 inline void shader::use() {
     shader::use_program( program );
@@ -0,0 +1,162 @@
+#include "texture_file.h"
+#include <core/common.hpp>
+#include <core/filesystem.hpp>
+#include <cstring>
+
+namespace engine {
+namespace renderer {
+
+/* get_expected_size */
+static uint64_t get_expected_size( const texture_file_header &header, dword width, dword height ) {
+    if( header.flags & TEXTURE_FILE_FLAG_COMPRESSED ) {
+        return compressed_image::get_compressed_size( width, height, static_cast<block_format>(header.format) );
+    }
+    return static_cast<uint64_t>(width) * height * (image::pixel_format_to_bpp( static_cast<pixel_format>(header.format) ) >> 3);
+}
+
+/* texture_file::open */
+bool texture_file::open( const string &name ) {
+    mapped_file mapped( filesystem::open_mapped( name ) );
+    if( !mapped.is_open() ) {
+        close();
+        return false;
+    }
+    if( !open( std::move( mapped ) ) ) {
+        common::error() << "texture_file::open() error: wrong texture file " << name << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/* texture_file::open */
+bool texture_file::open( mapped_file &&mapped ) {
+    close();
+    file = std::move( mapped );
+    header = get_header( file.data(), file.size() );
+    if( !header ) {
+        file.close();
+        return false;
+    }
+    return true;
+}
+
+/* texture_file::close */
+void texture_file::close() {
+    header = nullptr;
+    file.close();
+}
+
+/* texture_file::get_header */
+const texture_file_header *texture_file::get_header( const byte *data, size_t size ) {
+    if( size < sizeof( texture_file_header ) ) {
+        return nullptr;
+    }
+    auto header = reinterpret_cast<const texture_file_header*>( data );
+    if( header->magic != TEXTURE_FILE_MAGIC || header->version != TEXTURE_FILE_VERSION ) {
+        return nullptr;
+    }
+    if( header->levelsNumber < 1 || header->levelsNumber > TEXTURE_FILE_MAX_LEVELS ) {
+        return nullptr;
+    }
+    if( header->flags & TEXTURE_FILE_FLAG_COMPRESSED ) {
+        if( header->format > BLOCK_FORMAT_BC7 ) {
+            return nullptr;
+        }
+    } else if( header->format < PIXEL_FORMAT_GRAY8 || header->format > PIXEL_FORMAT_RGBA8 ) {
+        return nullptr;
+    }
+    /* the levels must be inside of the file */
+    for( dword i = 0; i < header->levelsNumber; i++ ) {
+        const texture_file_level &level = header->levels[i];
+        if( level.width == 0 || level.height == 0 || level.size != get_expected_size( *header, level.width, level.height ) ) {
+            return nullptr;
+        }
+        if( level.offset < sizeof( texture_file_header ) || level.offset > size || level.size > size - level.offset ) {
+            return nullptr;
+        }
+    }
+    return header;
+}
+
+/* texture_file::save */
+bool texture_file::save( const string &name, const mip_chain &mips, bool srgb ) {
+    assert( !mips.is_empty() );
+    if( mips.get_levels_number() > TEXTURE_FILE_MAX_LEVELS ) {
+        common::error() << "texture_file::save() error: too many levels" << std::endl;
+        return false;
+    }
+    texture_file_header header;
+    memset( &header, 0, sizeof( header ) );
+    header.flags = srgb ? TEXTURE_FILE_FLAG_SRGB : 0;
+    header.format = mips.get_pixel_format();
+    header.levelsNumber = mips.get_levels_number();
+    const byte *levels[TEXTURE_FILE_MAX_LEVELS];
+    for( int i = 0; i < mips.get_levels_number(); i++ ) {
+        header.levels[i].width = mips.get_width( i );
+        header.levels[i].height = mips.get_height( i );
+        levels[i] = mips.get_level_ptr( i );
+    }
+    return write( name, header, levels );
+}
+
+/* texture_file::save */
+bool texture_file::save( const string &name, const compressed_image *levels, int levelsNumber, bool srgb ) {
+    assert( levels != nullptr && levelsNumber > 0 );
+    if( levelsNumber > TEXTURE_FILE_MAX_LEVELS ) {
+        common::error() << "texture_file::save() error: too many levels" << std::endl;
+        return false;
+    }
+    texture_file_header header;
+    memset( &header, 0, sizeof( header ) );
+    header.flags = TEXTURE_FILE_FLAG_COMPRESSED | (srgb ? TEXTURE_FILE_FLAG_SRGB : 0);
+    header.format = levels[0].get_format();
+    header.levelsNumber = levelsNumber;
+    const byte *data[TEXTURE_FILE_MAX_LEVELS];
+    for( int i = 0; i < levelsNumber; i++ ) {
+        assert( !levels[i].is_empty() && levels[i].get_format() == levels[0].get_format() );
+        header.levels[i].width = levels[i].get_width();
+        header.levels[i].height = levels[i].get_height();
+        data[i] = levels[i].get_data();
+    }
+    return write( name, header, data );
+}
+
+/* texture_file::write
+* places the levels at the page boundaries, the gaps are zeros */
+bool texture_file::write( const string &name, texture_file_header &header, const byte * const *levels ) {
+    header.magic = TEXTURE_FILE_MAGIC;
+    header.version = TEXTURE_FILE_VERSION;
+    header.width = header.levels[0].width;
+    header.height = header.levels[0].height;
+    uint64_t offset = sizeof( header );
+    for( dword i = 0; i < header.levelsNumber; i++ ) {
+        texture_file_level &level = header.levels[i];
+        offset = (offset + TEXTURE_FILE_ALIGNMENT - 1) & ~static_cast<uint64_t>(TEXTURE_FILE_ALIGNMENT - 1);
+        level.offset = offset;
+        level.size = get_expected_size( header, level.width, level.height );
+        offset += level.size;
+    }
+
+    ofstream file( filesystem::open_write( name ) );
+    if( !file.is_open() ) {
+        common::error() << "texture_file::save() error: can not open " << name << std::endl;
+        return false;
+    }
+    static const char zeros[TEXTURE_FILE_ALIGNMENT] = {};
+    file.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+    uint64_t position = sizeof( header );
+    for( dword i = 0; i < header.levelsNumber; i++ ) {
+        const texture_file_level &level = header.levels[i];
+        file.write( zeros, static_cast<std::streamsize>(level.offset - position) );
+        file.write( reinterpret_cast<const char*>( levels[i] ), static_cast<std::streamsize>(level.size) );
+        position = level.offset + level.size;
+    }
+    if( !file ) {
+        common::error() << "texture_file::save() error: can not write " << name << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} /* namespace renderer */
+} /* namespace engine */
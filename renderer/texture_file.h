@@ -0,0 +1,149 @@
+#pragma once
+#include <core/types.hpp>
+#include <core/assert.hpp>
+#include <core/string.hpp>
+#include <core/mapped_file.hpp>
+#include <cstdint>
+#include "image.h"
+#include "mip_chain.h"
+#include "compressed_image.h"
+
+using namespace engine::core;
+
+namespace engine {
+namespace renderer {
+
+/* "ETEX" */
+static const dword TEXTURE_FILE_MAGIC = 0x58455445;
+static const dword TEXTURE_FILE_VERSION = 1;
+static const int TEXTURE_FILE_MAX_LEVELS = 16;
+/* the levels start at the page boundaries */
+static const int TEXTURE_FILE_ALIGNMENT = 4096;
+
+enum texture_file_flags {
+    TEXTURE_FILE_FLAG_COMPRESSED = 1,   /* the format is block_format, otherwise pixel_format */
+    TEXTURE_FILE_FLAG_SRGB = 2          /* the mips are filtered in linear space */
+};
+
+struct texture_file_level {
+    dword           width;
+    dword           height;
+    uint64_t        offset;         /* from the beginning of the file */
+    uint64_t        size;
+};
+
+/* texture_file_header
+* the beginning of the file, little endian. Unused levels are zero */
+struct texture_file_header {
+    dword           magic;
+    dword           version;
+    dword           flags;
+    dword           format;
+    dword           width;
+    dword           height;
+    dword           levelsNumber;
+    dword           reserved;
+    texture_file_level  levels[TEXTURE_FILE_MAX_LEVELS];
+};
+
+/* texture_file
+* the texture cooked by _texture_cooker. The file is mapped and used as
+* is: the header is checked, the levels are pointers to the mapped pages,
+* the pixels or blocks are ready for the upload */
+class texture_file {
+public:
+                    texture_file() {}
+
+                    /* returns false if the file can not be mapped or the header is wrong */
+    bool            open( const string &name );
+                    /* takes the mapping, see async_loader */
+    bool            open( mapped_file &&mapped );
+    void            close();
+
+    bool            is_open() const;
+    bool            is_compressed() const;
+    bool            is_srgb() const;
+                    /* PIXEL_FORMAT_AUTO for the compressed texture */
+    pixel_format    get_pixel_format() const;
+    block_format    get_block_format() const;
+    int             get_levels_number() const;
+    int             get_width( int level ) const;
+    int             get_height( int level ) const;
+    const byte *    get_level_ptr( int level ) const;
+    size_t          get_level_size( int level ) const;
+
+                    /* nullptr if the data is not a valid texture file */
+    static const texture_file_header *get_header( const byte *data, size_t size );
+                    /* write the levels of the mips or the compressed levels */
+    static bool     save( const string &name, const mip_chain &mips, bool srgb );
+    static bool     save( const string &name, const compressed_image *levels, int levelsNumber, bool srgb );
+
+private:
+    static bool     write( const string &name, texture_file_header &header, const byte * const *levels );
+
+    mapped_file     file;
+    const texture_file_header *header{nullptr};
+};
+
+
+
+/* texture_file::is_open */
+inline bool texture_file::is_open() const {
+    return header != nullptr;
+}
+
+/* texture_file::is_compressed */
+inline bool texture_file::is_compressed() const {
+    assert( is_open() );
+    return (header->flags & TEXTURE_FILE_FLAG_COMPRESSED) != 0;
+}
+
+/* texture_file::is_srgb */
+inline bool texture_file::is_srgb() const {
+    assert( is_open() );
+    return (header->flags & TEXTURE_FILE_FLAG_SRGB) != 0;
+}
+
+/* texture_file::get_pixel_format */
+inline pixel_format texture_file::get_pixel_format() const {
+    return is_compressed() ? PIXEL_FORMAT_AUTO : static_cast<pixel_format>(header->format);
+}
+
+/* texture_file::get_block_format */
+inline block_format texture_file::get_block_format() const {
+    assert( is_compressed() );
+    return static_cast<block_format>(header->format);
+}
+
+/* texture_file::get_levels_number */
+inline int texture_file::get_levels_number() const {
+    assert( is_open() );
+    return static_cast<int>(header->levelsNumber);
+}
+
+/* texture_file::get_width */
+inline int texture_file::get_width( int level ) const {
+    assert( level >= 0 && level < get_levels_number() );
+    return static_cast<int>(header->levels[level].width);
+}
+
+/* texture_file::get_height */
+inline int texture_file::get_height( int level ) const {
+    assert( level >= 0 && level < get_levels_number() );
+    return static_cast<int>(header->levels[level].height);
+}
+
+/* texture_file::get_level_ptr */
+inline const byte *texture_file::get_level_ptr( int level ) const {
+    assert( level >= 0 && level < get_levels_number() );
+    return file.data() + header->levels[level].offset;
+}
+
+/* texture_file::get_level_size */
+inline size_t texture_file::get_level_size( int level ) const {
+    assert( level >= 0 && level < get_levels_number() );
+    return static_cast<size_t>(header->levels[level].size);
+}
+
+} /* namespace renderer */
+} /* namespace engine */
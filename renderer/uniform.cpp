@@ -1,17 +1,18 @@
 #include "uniform.h"
 #include <core/assert.hpp>
+#include <renderer/opengl/gl_state_cache.h>
 namespace engine {
 
 /* uniform::set */
 void uniform::set( const mat4 &m ) {
     assert( is_valid() );
-    glUniformMatrix4fv( var, 1, GL_TRUE, m.get_ptr() );
+    gl_state_cache::uniform_matrix( var, m.get_ptr() );
 }
 
 /* uniform::set */
 void uniform::set( int i ) {
     assert( is_valid() );
-    glUniform1i( var, i );
+    gl_state_cache::uniform_int( var, i );
 }
 
 } /* namespace engine */
\ No newline at end of file
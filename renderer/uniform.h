@@ -10,6 +10,7 @@ public:
     void                set( const mat4 &m );
     void                set( int i );
     bool                is_valid();
+    GLint               get_location() const;
 private:
     GLint               var{-1};
 };
@@ -19,4 +20,9 @@ inline bool uniform::is_valid() {
     return var != -1;
 }
 
+/* uniform::get_location */
+inline GLint uniform::get_location() const {
+    return var;
+}
+
 } /* namespace engine */
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "test.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <core/async_loader.hpp>
+#include <core/filesystem.hpp>
+
+using namespace engine;
+using namespace engine::core;
+
+namespace {
+
+const char * const TEMP_NAME = "_async_loader_test.bin";
+
+/* temp_file
+* the file of the requests in the current directory, the resources
+* directory is the current one while the file exists */
+class temp_file {
+public:
+                    temp_file() : resourcesDir( filesystem::get_resources_dir() ) {
+                        filesystem::set_resources_dir( "" );
+                        std::ofstream( TEMP_NAME, std::ios::binary ) << "0123456789";
+                    }
+                    ~temp_file() {
+                        std::remove( TEMP_NAME );
+                        filesystem::set_resources_dir( resourcesDir );
+                    }
+
+private:
+    string          resourcesDir;
+};
+
+} /* namespace */
+
+/* the opened and decoded file succeeds, the missing one and the false
+* decode fail, every finalize is called once */
+TEST( async_loader, statuses ) {
+    temp_file file;
+    async_loader loader;
+    loader.start( 2 );
+    int statuses[3] = {};
+    size_t size = 0;
+    loader.load( TEMP_NAME, LOAD_PRIORITY_NORMAL,
+        [&size]( mapped_file &f ) { size = f.size(); return true; },
+        [&statuses]( load_status status ) { statuses[status]++; } );
+    loader.load( "_async_loader_test.missing", LOAD_PRIORITY_NORMAL,
+        []( mapped_file & ) { return true; },
+        [&statuses]( load_status status ) { statuses[status]++; } );
+    loader.load( TEMP_NAME, LOAD_PRIORITY_NORMAL,
+        []( mapped_file & ) { return false; },
+        [&statuses]( load_status status ) { statuses[status]++; } );
+    loader.wait_all();
+    CHECK( size == 10 );
+    CHECK( statuses[LOAD_STATUS_SUCCEEDED] == 1 );
+    CHECK( statuses[LOAD_STATUS_FAILED] == 2 );
+    CHECK( statuses[LOAD_STATUS_CANCELED] == 0 );
+    loader.stop();
+    return true;
+}
+
+/* the loader which is not started finalizes the request at once */
+TEST( async_loader, load_when_stopped ) {
+    async_loader loader;
+    int canceled = 0;
+    auto id = loader.load( TEMP_NAME, LOAD_PRIORITY_NORMAL,
+        []( mapped_file & ) { return true; },
+        [&canceled]( load_status status ) { canceled += status == LOAD_STATUS_CANCELED; } );
+    CHECK( id == 0 );
+    CHECK( canceled == 1 );
+    CHECK( !loader.is_pending( id ) );
+    CHECK( loader.get_stats().canceled == 1 );
+    return true;
+}
+
+/* stop() cancels the queued requests, their finalize loads the next
+* file as the fallback of main.cpp does, the new requests are canceled
+* and stop() returns */
+TEST( async_loader, load_in_stop ) {
+    temp_file file;
+    const int requestsNumber = 20;
+    async_loader loader;
+    loader.start( 1 );
+    std::atomic<bool> release{false};
+    int statuses[3] = {};
+    int fallbacks[3] = {};
+    for( int i = 0; i < requestsNumber; i++ ) {
+        /* the first request holds the thread, the others stay queued */
+        loader.load( TEMP_NAME, LOAD_PRIORITY_NORMAL,
+            [&release]( mapped_file & ) {
+                while( !release.load() ) {
+                    std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+                }
+                return true;
+            },
+            [&]( load_status status ) {
+                statuses[status]++;
+                loader.load( TEMP_NAME, LOAD_PRIORITY_HIGH,
+                    []( mapped_file & ) { return true; },
+                    [&fallbacks]( load_status status ) { fallbacks[status]++; } );
+            } );
+    }
+    std::thread releaser( [&release]() {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+        release.store( true );
+    } );
+    loader.stop();
+    releaser.join();
+    CHECK( statuses[LOAD_STATUS_SUCCEEDED] + statuses[LOAD_STATUS_CANCELED] == requestsNumber );
+    CHECK( statuses[LOAD_STATUS_CANCELED] >= requestsNumber - 1 );
+    CHECK( fallbacks[LOAD_STATUS_CANCELED] == requestsNumber );
+    CHECK( !loader.is_started() );
+    return true;
+}
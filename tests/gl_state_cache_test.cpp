@@ -0,0 +1,330 @@
+#include "test.h"
+#include <cstring>
+#include <core/vector.hpp>
+#include <core/math.hpp>
+#include <renderer/opengl/gl_state_cache.h>
+
+using namespace engine;
+using namespace engine::core::math;
+
+namespace {
+
+/* gl_call
+* one call which reached the stubbed GL */
+struct gl_call {
+    const char *    name;
+    long long       a0;
+    long long       a1;
+};
+
+core::vector<gl_call> glCalls;
+
+/* the stubs of the GL functions used by gl_state_cache */
+void GL_APIENTRY stub_use_program( GLuint program ) { glCalls.push_back( {"glUseProgram", program, 0} ); }
+void GL_APIENTRY stub_bind_vertex_array( GLuint vao ) { glCalls.push_back( {"glBindVertexArray", vao, 0} ); }
+void GL_APIENTRY stub_active_texture( GLenum unit ) { glCalls.push_back( {"glActiveTexture", unit, 0} ); }
+void GL_APIENTRY stub_bind_texture( GLenum target, GLuint texture ) { glCalls.push_back( {"glBindTexture", target, texture} ); }
+void GL_APIENTRY stub_enable_attrib( GLuint index ) { glCalls.push_back( {"glEnableVertexAttribArray", index, 0} ); }
+void GL_APIENTRY stub_disable_attrib( GLuint index ) { glCalls.push_back( {"glDisableVertexAttribArray", index, 0} ); }
+void GL_APIENTRY stub_restart_index( GLuint index ) { glCalls.push_back( {"glPrimitiveRestartIndex", index, 0} ); }
+void GL_APIENTRY stub_enable( GLenum cap ) { glCalls.push_back( {"glEnable", cap, 0} ); }
+void GL_APIENTRY stub_disable( GLenum cap ) { glCalls.push_back( {"glDisable", cap, 0} ); }
+void GL_APIENTRY stub_cull_face( GLenum face ) { glCalls.push_back( {"glCullFace", face, 0} ); }
+void GL_APIENTRY stub_depth_func( GLenum func ) { glCalls.push_back( {"glDepthFunc", func, 0} ); }
+void GL_APIENTRY stub_polygon_mode( GLenum face, GLenum mode ) { glCalls.push_back( {"glPolygonMode", face, mode} ); }
+void GL_APIENTRY stub_uniform_matrix( GLint location, GLsizei count, GLboolean transpose, const GLfloat *m ) {
+    glCalls.push_back( {"glUniformMatrix4fv", location, static_cast<long long>( m[0] )} );
+}
+void GL_APIENTRY stub_uniform_int( GLint location, GLint value ) { glCalls.push_back( {"glUniform1i", location, value} ); }
+void GL_APIENTRY stub_delete_textures( GLsizei n, const GLuint *textures ) { glCalls.push_back( {"glDeleteTextures", n, textures[0]} ); }
+void GL_APIENTRY stub_delete_program( GLuint program ) { glCalls.push_back( {"glDeleteProgram", program, 0} ); }
+void GL_APIENTRY stub_delete_vertex_arrays( GLsizei n, const GLuint *arrays ) { glCalls.push_back( {"glDeleteVertexArrays", n, arrays[0]} ); }
+
+/* stubbed_gl
+* replaces the GL function pointers of gl.cpp while it lives,
+* the cache starts with the unknown state */
+class stubbed_gl {
+public:
+                    stubbed_gl();
+                    ~stubbed_gl();
+
+private:
+    PFN_glUseProgram                useProgram{_glptr_glUseProgram};
+    PFN_glBindVertexArray           bindVertexArray{_glptr_glBindVertexArray};
+    PFN_glActiveTexture             activeTexture{_glptr_glActiveTexture};
+    PFN_glBindTexture               bindTexture{_glptr_glBindTexture};
+    PFN_glEnableVertexAttribArray   enableAttrib{_glptr_glEnableVertexAttribArray};
+    PFN_glDisableVertexAttribArray  disableAttrib{_glptr_glDisableVertexAttribArray};
+    PFN_glPrimitiveRestartIndex     restartIndex{_glptr_glPrimitiveRestartIndex};
+    PFN_glEnable                    enable{_glptr_glEnable};
+    PFN_glDisable                   disable{_glptr_glDisable};
+    PFN_glCullFace                  cullFace{_glptr_glCullFace};
+    PFN_glDepthFunc                 depthFunc{_glptr_glDepthFunc};
+    PFN_glPolygonMode               polygonMode{_glptr_glPolygonMode};
+    PFN_glUniformMatrix4fv          uniformMatrix{_glptr_glUniformMatrix4fv};
+    PFN_glUniform1i                 uniformInt{_glptr_glUniform1i};
+    PFN_glDeleteTextures            deleteTextures{_glptr_glDeleteTextures};
+    PFN_glDeleteProgram             deleteProgram{_glptr_glDeleteProgram};
+    PFN_glDeleteVertexArrays        deleteVertexArrays{_glptr_glDeleteVertexArrays};
+};
+
+/* stubbed_gl::stubbed_gl */
+stubbed_gl::stubbed_gl() {
+    _glptr_glUseProgram = stub_use_program;
+    _glptr_glBindVertexArray = stub_bind_vertex_array;
+    _glptr_glActiveTexture = stub_active_texture;
+    _glptr_glBindTexture = stub_bind_texture;
+    _glptr_glEnableVertexAttribArray = stub_enable_attrib;
+    _glptr_glDisableVertexAttribArray = stub_disable_attrib;
+    _glptr_glPrimitiveRestartIndex = stub_restart_index;
+    _glptr_glEnable = stub_enable;
+    _glptr_glDisable = stub_disable;
+    _glptr_glCullFace = stub_cull_face;
+    _glptr_glDepthFunc = stub_depth_func;
+    _glptr_glPolygonMode = stub_polygon_mode;
+    _glptr_glUniformMatrix4fv = stub_uniform_matrix;
+    _glptr_glUniform1i = stub_uniform_int;
+    _glptr_glDeleteTextures = stub_delete_textures;
+    _glptr_glDeleteProgram = stub_delete_program;
+    _glptr_glDeleteVertexArrays = stub_delete_vertex_arrays;
+    glCalls.clear();
+    gl_state_cache::reset();
+    gl_state_cache::begin_frame();
+}
+
+/* stubbed_gl::~stubbed_gl */
+stubbed_gl::~stubbed_gl() {
+    _glptr_glUseProgram = useProgram;
+    _glptr_glBindVertexArray = bindVertexArray;
+    _glptr_glActiveTexture = activeTexture;
+    _glptr_glBindTexture = bindTexture;
+    _glptr_glEnableVertexAttribArray = enableAttrib;
+    _glptr_glDisableVertexAttribArray = disableAttrib;
+    _glptr_glPrimitiveRestartIndex = restartIndex;
+    _glptr_glEnable = enable;
+    _glptr_glDisable = disable;
+    _glptr_glCullFace = cullFace;
+    _glptr_glDepthFunc = depthFunc;
+    _glptr_glPolygonMode = polygonMode;
+    _glptr_glUniformMatrix4fv = uniformMatrix;
+    _glptr_glUniform1i = uniformInt;
+    _glptr_glDeleteTextures = deleteTextures;
+    _glptr_glDeleteProgram = deleteProgram;
+    _glptr_glDeleteVertexArrays = deleteVertexArrays;
+}
+
+/* count_calls */
+int count_calls( const char *name ) {
+    int count = 0;
+    for( const auto &c : glCalls ) {
+        count += std::strcmp( c.name, name ) == 0 ? 1 : 0;
+    }
+    return count;
+}
+
+/* is_last_call */
+bool is_last_call( const char *name, long long a0, long long a1 = 0 ) {
+    return !glCalls.empty() && std::strcmp( glCalls.back().name, name ) == 0 &&
+            glCalls.back().a0 == a0 && glCalls.back().a1 == a1;
+}
+
+} /* namespace */
+
+/* the repeated values are not forwarded, the changed ones are,
+* the statistics of the frame count both */
+TEST( gl_state_cache, redundant_calls ) {
+    stubbed_gl gl;
+    for( int i = 0; i < 3; i++ ) {
+        gl_state_cache::use_program( 7 );
+        gl_state_cache::bind_vertex_array( 3 );
+        gl_state_cache::primitive_restart_index( 0xffff );
+        gl_state_cache::enable( GL_DEPTH_TEST );
+        gl_state_cache::cull_face( GL_BACK );
+        gl_state_cache::depth_func( GL_LESS );
+        gl_state_cache::polygon_mode( GL_FILL );
+    }
+    CHECK( glCalls.size() == 7 );
+    CHECK( count_calls( "glUseProgram" ) == 1 );
+    CHECK( count_calls( "glBindVertexArray" ) == 1 );
+    CHECK( count_calls( "glPrimitiveRestartIndex" ) == 1 );
+    CHECK( count_calls( "glEnable" ) == 1 );
+    CHECK( count_calls( "glCullFace" ) == 1 );
+    CHECK( count_calls( "glDepthFunc" ) == 1 );
+    CHECK( is_last_call( "glPolygonMode", GL_FRONT_AND_BACK, GL_FILL ) );
+
+    gl_state_cache::use_program( 8 );
+    CHECK( is_last_call( "glUseProgram", 8 ) );
+    gl_state_cache::disable( GL_DEPTH_TEST );
+    CHECK( is_last_call( "glDisable", GL_DEPTH_TEST ) );
+    gl_state_cache::enable( GL_DEPTH_TEST );
+    CHECK( is_last_call( "glEnable", GL_DEPTH_TEST ) );
+    /* the capabilities which are not shadowed are always forwarded */
+    gl_state_cache::enable( GL_SCISSOR_TEST );
+    gl_state_cache::enable( GL_SCISSOR_TEST );
+    CHECK( count_calls( "glEnable" ) == 4 );
+
+    gl_state_cache::begin_frame();
+    const auto &stats = gl_state_cache::get_frame_statistics();
+    CHECK( stats.forwarded == static_cast<int>( glCalls.size() ) );
+    CHECK( stats.skipped == 14 );
+    return true;
+}
+
+/* the textures are shadowed per unit and target, before the active
+* unit is known every bind is forwarded */
+TEST( gl_state_cache, textures ) {
+    stubbed_gl gl;
+    gl_state_cache::bind_texture( GL_TEXTURE_2D, 5 );
+    gl_state_cache::bind_texture( GL_TEXTURE_2D, 5 );
+    CHECK( count_calls( "glBindTexture" ) == 2 );
+
+    gl_state_cache::active_texture( GL_TEXTURE0 );
+    gl_state_cache::bind_texture( GL_TEXTURE_2D, 5 );
+    gl_state_cache::bind_texture( GL_TEXTURE_2D, 5 );
+    CHECK( count_calls( "glBindTexture" ) == 3 );
+    gl_state_cache::active_texture( GL_TEXTURE1 );
+    gl_state_cache::bind_texture( GL_TEXTURE_2D, 5 );
+    CHECK( is_last_call( "glBindTexture", GL_TEXTURE_2D, 5 ) );
+    gl_state_cache::bind_texture( GL_TEXTURE_CUBE_MAP, 5 );
+    CHECK( is_last_call( "glBindTexture", GL_TEXTURE_CUBE_MAP, 5 ) );
+    gl_state_cache::active_texture( GL_TEXTURE0 );
+    gl_state_cache::active_texture( GL_TEXTURE0 );
+    CHECK( count_calls( "glActiveTexture" ) == 3 );
+    gl_state_cache::bind_texture( GL_TEXTURE_2D, 5 );
+    CHECK( count_calls( "glBindTexture" ) == 5 );
+    gl_state_cache::bind_texture( GL_TEXTURE_2D, 6 );
+    CHECK( is_last_call( "glBindTexture", GL_TEXTURE_2D, 6 ) );
+    return true;
+}
+
+/* the enabled attributes belong to the bound vertex array */
+TEST( gl_state_cache, vertex_attribs ) {
+    stubbed_gl gl;
+    /* the vertex array is unknown */
+    gl_state_cache::enable_vertex_attrib( 0 );
+    gl_state_cache::enable_vertex_attrib( 0 );
+    CHECK( count_calls( "glEnableVertexAttribArray" ) == 2 );
+
+    gl_state_cache::bind_vertex_array( 1 );
+    gl_state_cache::enable_vertex_attrib( 0 );
+    gl_state_cache::enable_vertex_attrib( 0 );
+    gl_state_cache::enable_vertex_attrib( 4 );
+    CHECK( count_calls( "glEnableVertexAttribArray" ) == 4 );
+    gl_state_cache::bind_vertex_array( 2 );
+    gl_state_cache::enable_vertex_attrib( 0 );
+    CHECK( count_calls( "glEnableVertexAttribArray" ) == 5 );
+    gl_state_cache::bind_vertex_array( 1 );
+    gl_state_cache::enable_vertex_attrib( 0 );
+    gl_state_cache::enable_vertex_attrib( 4 );
+    CHECK( count_calls( "glEnableVertexAttribArray" ) == 5 );
+    gl_state_cache::disable_vertex_attrib( 4 );
+    gl_state_cache::disable_vertex_attrib( 4 );
+    CHECK( count_calls( "glDisableVertexAttribArray" ) == 1 );
+    gl_state_cache::enable_vertex_attrib( 4 );
+    CHECK( is_last_call( "glEnableVertexAttribArray", 4 ) );
+    return true;
+}
+
+/* the uniform values are shadowed per program and location */
+TEST( gl_state_cache, uniforms ) {
+    stubbed_gl gl;
+    mat4 a( MAT4_IDENTITY );
+    mat4 b( MAT4_IDENTITY );
+    b.x.x = 2.0f;
+    /* the program is unknown */
+    gl_state_cache::uniform_matrix( 0, a.get_ptr() );
+    gl_state_cache::uniform_matrix( 0, a.get_ptr() );
+    CHECK( count_calls( "glUniformMatrix4fv" ) == 2 );
+
+    gl_state_cache::use_program( 1 );
+    gl_state_cache::uniform_matrix( 0, a.get_ptr() );
+    gl_state_cache::uniform_matrix( 0, a.get_ptr() );
+    CHECK( count_calls( "glUniformMatrix4fv" ) == 3 );
+    gl_state_cache::uniform_matrix( 0, b.get_ptr() );
+    CHECK( is_last_call( "glUniformMatrix4fv", 0, 2 ) );
+    gl_state_cache::uniform_int( 2, 3 );
+    gl_state_cache::uniform_int( 2, 3 );
+    CHECK( count_calls( "glUniform1i" ) == 1 );
+
+    gl_state_cache::use_program( 2 );
+    gl_state_cache::uniform_matrix( 0, b.get_ptr() );
+    gl_state_cache::uniform_int( 2, 3 );
+    CHECK( count_calls( "glUniformMatrix4fv" ) == 5 );
+    CHECK( count_calls( "glUniform1i" ) == 2 );
+
+    gl_state_cache::use_program( 1 );
+    gl_state_cache::uniform_matrix( 0, b.get_ptr() );
+    gl_state_cache::uniform_int( 2, 3 );
+    CHECK( count_calls( "glUniformMatrix4fv" ) == 5 );
+    CHECK( count_calls( "glUniform1i" ) == 2 );
+    /* a matrix location set as int, the location -1 is always forwarded */
+    gl_state_cache::uniform_int( 0, 1 );
+    CHECK( is_last_call( "glUniform1i", 0, 1 ) );
+    gl_state_cache::uniform_int( -1, 1 );
+    gl_state_cache::uniform_int( -1, 1 );
+    CHECK( count_calls( "glUniform1i" ) == 5 );
+    return true;
+}
+
+/* reset() forgets the state, for example after a new context */
+TEST( gl_state_cache, reset ) {
+    stubbed_gl gl;
+    gl_state_cache::use_program( 1 );
+    gl_state_cache::active_texture( GL_TEXTURE0 );
+    gl_state_cache::bind_texture( GL_TEXTURE_2D, 1 );
+    gl_state_cache::reset();
+    gl_state_cache::use_program( 1 );
+    gl_state_cache::active_texture( GL_TEXTURE0 );
+    gl_state_cache::bind_texture( GL_TEXTURE_2D, 1 );
+    CHECK( glCalls.size() == 6 );
+    return true;
+}
+
+/* the deleted objects are forgotten, GL may return their names to the
+* next glGen*() and the binds of the new objects must be forwarded */
+TEST( gl_state_cache, deleted_objects ) {
+    stubbed_gl gl;
+    gl_state_cache::active_texture( GL_TEXTURE1 );
+    gl_state_cache::bind_texture( GL_TEXTURE_2D, 5 );
+    gl_state_cache::active_texture( GL_TEXTURE0 );
+    gl_state_cache::bind_texture( GL_TEXTURE_2D, 5 );
+    gl_state_cache::bind_texture( GL_TEXTURE_CUBE_MAP, 6 );
+    gl_state_cache::delete_texture( 5 );
+    CHECK( is_last_call( "glDeleteTextures", 1, 5 ) );
+    gl_state_cache::bind_texture( GL_TEXTURE_2D, 5 );
+    CHECK( is_last_call( "glBindTexture", GL_TEXTURE_2D, 5 ) );
+    gl_state_cache::active_texture( GL_TEXTURE1 );
+    gl_state_cache::bind_texture( GL_TEXTURE_2D, 5 );
+    CHECK( is_last_call( "glBindTexture", GL_TEXTURE_2D, 5 ) );
+    CHECK( count_calls( "glBindTexture" ) == 5 );
+    /* the other textures are kept */
+    gl_state_cache::active_texture( GL_TEXTURE0 );
+    gl_state_cache::bind_texture( GL_TEXTURE_CUBE_MAP, 6 );
+    CHECK( count_calls( "glBindTexture" ) == 5 );
+
+    gl_state_cache::use_program( 3 );
+    gl_state_cache::uniform_int( 1, 4 );
+    gl_state_cache::delete_program( 3 );
+    CHECK( is_last_call( "glDeleteProgram", 3 ) );
+    gl_state_cache::use_program( 3 );
+    gl_state_cache::uniform_int( 1, 4 );
+    CHECK( count_calls( "glUseProgram" ) == 2 );
+    CHECK( count_calls( "glUniform1i" ) == 2 );
+
+    gl_state_cache::bind_vertex_array( 2 );
+    gl_state_cache::enable_vertex_attrib( 0 );
+    gl_state_cache::delete_vertex_array( 2 );
+    CHECK( is_last_call( "glDeleteVertexArrays", 1, 2 ) );
+    gl_state_cache::bind_vertex_array( 2 );
+    gl_state_cache::enable_vertex_attrib( 0 );
+    CHECK( count_calls( "glBindVertexArray" ) == 2 );
+    CHECK( count_calls( "glEnableVertexAttribArray" ) == 2 );
+
+    /* the name 0 is not deleted */
+    auto calls = glCalls.size();
+    gl_state_cache::delete_texture( 0 );
+    gl_state_cache::delete_program( 0 );
+    gl_state_cache::delete_vertex_array( 0 );
+    CHECK( glCalls.size() == calls );
+    return true;
+}
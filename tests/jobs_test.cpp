@@ -0,0 +1,157 @@
+#include "test.h"
+#include <atomic>
+#include <thread>
+#include <core/vector.hpp>
+#include <core/unique_ptr.hpp>
+#include <core/jobs.hpp>
+#include <core/jobs/work_stealing_deque.hpp>
+
+using namespace engine;
+using namespace engine::core;
+
+namespace {
+
+const int THIEVES_NUMBER = 3;
+
+} /* namespace */
+
+/* the owner pushes and pops while the thieves steal, every item is
+* taken exactly once, also when the owner and a thief race for the last one */
+TEST( jobs, deque_push_pop_steal ) {
+    const int itemsNumber = 200000;
+    core::vector<int> items( itemsNumber );
+    core::vector<std::atomic<int>> taken( itemsNumber );
+    for( int i = 0; i < itemsNumber; i++ ) {
+        items[i] = i;
+        taken[i].store( 0 );
+    }
+    core::unique_ptr<jobs::work_stealing_deque<int, 256>> deque( new jobs::work_stealing_deque<int, 256> );
+    std::atomic<bool> done{false};
+    std::atomic<int> takenNumber{0};
+    core::vector<std::thread> thieves;
+    for( int t = 0; t < THIEVES_NUMBER; t++ ) {
+        thieves.emplace_back( [&]() {
+            while( !done.load() ) {
+                if( int *item = deque->steal() ) {
+                    taken[*item].fetch_add( 1 );
+                    takenNumber.fetch_add( 1 );
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        } );
+    }
+    test::random rnd( 1 );
+    int pushed = 0;
+    while( pushed < itemsNumber ) {
+        /* bursts of pushes and pops keep the deque short, so the
+        * last item is raced for often */
+        int burst = rnd.range( 1, 8 );
+        for( int i = 0; i < burst && pushed < itemsNumber; i++ ) {
+            if( deque->push( &items[pushed] ) ) {
+                pushed++;
+            }
+        }
+        int pops = rnd.range( 0, 8 );
+        for( int i = 0; i < pops; i++ ) {
+            if( int *item = deque->pop() ) {
+                taken[*item].fetch_add( 1 );
+                takenNumber.fetch_add( 1 );
+            }
+        }
+    }
+    for( int *item = deque->pop(); item; item = deque->pop() ) {
+        taken[*item].fetch_add( 1 );
+        takenNumber.fetch_add( 1 );
+    }
+    /* the thieves may still hold a stolen item */
+    while( takenNumber.load() < itemsNumber ) {
+        std::this_thread::yield();
+    }
+    done = true;
+    for( auto &t : thieves ) {
+        t.join();
+    }
+    CHECK( deque->is_empty() );
+    CHECK( takenNumber.load() == itemsNumber );
+    for( int i = 0; i < itemsNumber; i++ ) {
+        CHECK( taken[i].load() == 1 );
+    }
+    return true;
+}
+
+/* the jobs are started by the threads which are not workers (the shared
+* queue), by the workers (their deques, stolen by the others) and after
+* dependency counters, every job is executed exactly once */
+TEST( jobs, job_system_stress ) {
+    const int rounds = 100;
+    const int producersNumber = 2;
+    const int jobsNumber = 500;
+    const int childrenNumber = 4;
+    jobs::job_system::initialize( 4 );
+    bool passed = true;
+    for( int round = 0; round < rounds && passed; round++ ) {
+        std::atomic<int> executed{0};
+        std::atomic<int> afterDependency{0};
+        std::atomic<int> earlyDependent{0};
+        jobs::counter done;
+        jobs::counter dependents;
+        core::vector<std::thread> producers;
+        for( int p = 0; p < producersNumber; p++ ) {
+            producers.emplace_back( [&]() {
+                for( int i = 0; i < jobsNumber; i++ ) {
+                    jobs::job_system::run( [&]() {
+                        /* nested jobs go to the deque of the worker */
+                        for( int c = 0; c < childrenNumber; c++ ) {
+                            jobs::job_system::run( [&]() { executed.fetch_add( 1 ); }, &done );
+                        }
+                        executed.fetch_add( 1 );
+                    }, &done );
+                }
+            } );
+        }
+        for( auto &p : producers ) {
+            p.join();
+        }
+        for( int i = 0; i < jobsNumber; i++ ) {
+            jobs::job_system::run( [&]() {
+                if( executed.load() != producersNumber * jobsNumber * (childrenNumber + 1) ) {
+                    earlyDependent.fetch_add( 1 );
+                }
+                afterDependency.fetch_add( 1 );
+            }, &dependents, &done );
+        }
+        jobs::job_system::wait( done );
+        jobs::job_system::wait( dependents );
+        passed = executed.load() == producersNumber * jobsNumber * (childrenNumber + 1)
+                && afterDependency.load() == jobsNumber
+                && earlyDependent.load() == 0;
+    }
+    jobs::job_system::shutdown();
+    CHECK( passed );
+    return true;
+}
+
+/* parallel_for covers the range exactly once with any grain */
+TEST( jobs, parallel_for_ranges ) {
+    const int size = 100000;
+    jobs::job_system::initialize( 4 );
+    core::vector<std::atomic<int>> visits( size );
+    bool passed = true;
+    for( int grain : { 1, 7, 64, 1000, size, size * 2 } ) {
+        for( auto &v : visits ) {
+            v.store( 0 );
+        }
+        jobs::parallel_for( 0, size, grain, [&]( int begin, int end ) {
+            for( int i = begin; i < end; i++ ) {
+                visits[i].fetch_add( 1 );
+            }
+        } );
+        for( auto &v : visits ) {
+            passed = passed && v.load() == 1;
+        }
+    }
+    jobs::job_system::shutdown();
+    CHECK( passed );
+    return true;
+}
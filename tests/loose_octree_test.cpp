@@ -0,0 +1,185 @@
+#include "test.h"
+#include <algorithm>
+#include <cmath>
+#include <core/vector.hpp>
+#include <engine/camera.h>
+#include <engine/loose_octree.h>
+
+using namespace engine;
+using namespace engine::core::math;
+
+namespace {
+
+typedef loose_octree::handle handle;
+
+/* brute_ray
+* the same ray-sphere test as the octree on every object */
+bool brute_ray( const vec3 &origin, const vec3 &dir, const sphere &s, float maxDistance, float &distance ) {
+    auto m = origin - s.center;
+    auto b = m * dir;
+    auto c = m * m - s.radius * s.radius;
+    if( c > 0.0f && b > 0.0f ) {
+        return false;
+    }
+    auto discr = b * b - c;
+    if( discr < 0.0f ) {
+        return false;
+    }
+    auto t = -b - std::sqrt( discr );
+    t = t < 0.0f ? 0.0f : t;
+    if( t > maxDistance ) {
+        return false;
+    }
+    distance = t;
+    return true;
+}
+
+/* is_same_set */
+bool is_same_set( core::vector<handle> a, core::vector<handle> b ) {
+    std::sort( a.begin(), a.end() );
+    std::sort( b.begin(), b.end() );
+    return a == b;
+}
+
+/* random_sphere */
+sphere random_sphere( test::random &rnd, float extent ) {
+    /* mostly small objects, some as large as the cells of the top levels */
+    float radius = (rnd.next() & 7) ? rnd.range( 0.1f, 3.0f ) : rnd.range( 3.0f, 60.0f );
+    return sphere( vec3( rnd.range( -extent, extent ), rnd.range( -extent, extent ),
+            rnd.range( -extent, extent ) ), radius );
+}
+
+/* random_dir */
+vec3 random_dir( test::random &rnd ) {
+    vec3 dir( rnd.range( -1.0f, 1.0f ), rnd.range( -1.0f, 1.0f ), rnd.range( -1.0f, 1.0f ) );
+    if( dir * dir < 1.0e-4f ) {
+        dir = vec3( 0.0f, 0.0f, 1.0f );
+    }
+    return dir * (1.0f / std::sqrt( dir * dir ));
+}
+
+} /* namespace */
+
+/* an object moved inside the loose bounds of its node keeps the node,
+* the split of the node must not push it to a child which does not
+* hold it, or the queries stop at the loose bounds of the child */
+TEST( loose_octree, split_keeps_moved_objects ) {
+    loose_octree tree( vec3( 0.0f, 0.0f, 0.0f ), 100.0f );
+    core::vector<handle> handles;
+    for( int i = 0; i < 8; i++ ) {
+        handles.push_back( tree.insert( sphere( vec3( 60.0f + i, 60.0f, 60.0f ), 1.0f ) ) );
+    }
+    for( int i = 0; i < 9; i++ ) {
+        handles.push_back( tree.insert( sphere( vec3( -60.0f - i, -60.0f, -60.0f ), 1.0f ) ) );
+    }
+    tree.move( handles[0], sphere( vec3( 140.0f, 140.0f, 140.0f ), 1.0f ) );
+    for( int i = 0; i < 10; i++ ) {
+        tree.insert( sphere( vec3( 55.0f + i * 0.5f, 55.0f, 55.0f ), 1.0f ) );
+    }
+    core::vector<handle> found;
+    tree.query_sphere( sphere( vec3( 140.0f, 140.0f, 140.0f ), 0.5f ), found );
+    CHECK( found.size() == 1 && found[0] == handles[0] );
+    handle hit = -1;
+    float distance = 0.0f;
+    CHECK( tree.raycast( vec3( 140.0f, 140.0f, 0.0f ), vec3( 0.0f, 0.0f, 1.0f ), 1000.0f, hit, distance ) );
+    CHECK( hit == handles[0] );
+    found.clear();
+    tree.query_ray( vec3( 140.0f, 140.0f, 0.0f ), vec3( 0.0f, 0.0f, 1.0f ), 1000.0f, found );
+    CHECK( std::find( found.begin(), found.end(), handles[0] ) != found.end() );
+    return true;
+}
+
+/* random inserts, small and large moves and removes, after every batch
+* the sphere, ray and frustum queries and the raycast give the same
+* objects as the test of every object */
+TEST( loose_octree, brute_force ) {
+    const float extent = 120.0f;    /* some objects are out of the root cell */
+    loose_octree tree( vec3( 0.0f, 0.0f, 0.0f ), 100.0f, 6 );
+    core::vector<handle> live;
+    test::random rnd( 1 );
+    for( int batch = 0; batch < 40; batch++ ) {
+        for( int i = 0; i < 100; i++ ) {
+            int action = rnd.range( 0, 10 );
+            if( action < 4 || live.empty() ) {
+                live.push_back( tree.insert( random_sphere( rnd, extent ) ) );
+            } else if( action < 7 ) {
+                /* short moves often stay in the loose bounds */
+                auto h = live[rnd.range( 0, static_cast<int>( live.size() ) )];
+                auto s = tree.get_bounds( h );
+                s.center = s.center + vec3( rnd.range( -20.0f, 20.0f ), rnd.range( -20.0f, 20.0f ), rnd.range( -20.0f, 20.0f ) );
+                tree.move( h, s );
+            } else if( action < 9 ) {
+                auto h = live[rnd.range( 0, static_cast<int>( live.size() ) )];
+                tree.move( h, random_sphere( rnd, extent ) );
+            } else {
+                int i = rnd.range( 0, static_cast<int>( live.size() ) );
+                tree.remove( live[i] );
+                live[i] = live.back();
+                live.pop_back();
+            }
+        }
+        CHECK( tree.size() == static_cast<int>( live.size() ) );
+        /* every object is found at its own center */
+        for( auto h : live ) {
+            core::vector<handle> found;
+            tree.query_sphere( sphere( tree.get_bounds( h ).center, 0.0f ), found );
+            CHECK( std::find( found.begin(), found.end(), h ) != found.end() );
+        }
+
+        for( int q = 0; q < 20; q++ ) {
+            /* sphere */
+            auto s = random_sphere( rnd, extent );
+            s.radius *= 4.0f;
+            core::vector<handle> found;
+            core::vector<handle> expected;
+            tree.query_sphere( s, found );
+            for( auto h : live ) {
+                const auto &b = tree.get_bounds( h );
+                auto d = b.center - s.center;
+                auto r = b.radius + s.radius;
+                if( d * d <= r * r ) {
+                    expected.push_back( h );
+                }
+            }
+            CHECK( is_same_set( found, expected ) );
+
+            /* ray and raycast */
+            vec3 origin( rnd.range( -extent, extent ), rnd.range( -extent, extent ), rnd.range( -extent, extent ) );
+            auto dir = random_dir( rnd );
+            float maxDistance = rnd.range( 10.0f, 300.0f );
+            found.clear();
+            expected.clear();
+            tree.query_ray( origin, dir, maxDistance, found );
+            float nearest = maxDistance;
+            bool anyHit = false;
+            for( auto h : live ) {
+                float t;
+                if( brute_ray( origin, dir, tree.get_bounds( h ), maxDistance, t ) ) {
+                    expected.push_back( h );
+                    nearest = !anyHit || t < nearest ? t : nearest;
+                    anyHit = true;
+                }
+            }
+            CHECK( is_same_set( found, expected ) );
+            handle hit = -1;
+            float distance = 0.0f;
+            CHECK( tree.raycast( origin, dir, maxDistance, hit, distance ) == anyHit );
+            CHECK( !anyHit || distance == nearest );
+
+            /* frustum */
+            camera cam( origin, dir, std::fabs( dir.z ) < 0.9f ? vec3( 0.0f, 0.0f, 1.0f ) : vec3( 1.0f, 0.0f, 0.0f ) );
+            cam.set_perspective_projection( pi / 3.0, 1.5, 0.1, rnd.range( 20.0f, 300.0f ) );
+            frustum view( cam() );
+            found.clear();
+            expected.clear();
+            tree.query_frustum( view, found );
+            for( auto h : live ) {
+                if( view.test_sphere( tree.get_bounds( h ) ) ) {
+                    expected.push_back( h );
+                }
+            }
+            CHECK( is_same_set( found, expected ) );
+        }
+    }
+    return true;
+}
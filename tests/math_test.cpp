@@ -0,0 +1,152 @@
+#include "test.h"
+#include <cstring>
+#include <core/math.hpp>
+
+using namespace engine::core::math;
+
+/* the scalar code of mat4.cpp and quat.cpp built without ENGINE_SIMD,
+* the SIMD paths add the products in the same order and are bit-exact */
+namespace {
+
+/* scalar_mul */
+vec4 scalar_mul( const mat4 &m, const vec4 &a ) {
+    return vec4(
+        m.x.x * a.x + m.x.y * a.y + m.x.z * a.z + m.x.w * a.w,
+        m.y.x * a.x + m.y.y * a.y + m.y.z * a.z + m.y.w * a.w,
+        m.z.x * a.x + m.z.y * a.y + m.z.z * a.z + m.z.w * a.w,
+        m.w.x * a.x + m.w.y * a.y + m.w.z * a.z + m.w.w * a.w);
+}
+
+/* scalar_mul */
+vec3 scalar_mul( const mat4 &m, const vec3 &a ) {
+    auto scale = m.w.x * a.x + m.w.y * a.y + m.w.z * a.z + m.w.w;
+    if (scale == 1.0) {
+        return vec3(
+            m.x.x * a.x + m.x.y * a.y + m.x.z * a.z + m.x.w,
+            m.y.x * a.x + m.y.y * a.y + m.y.z * a.z + m.y.w,
+            m.z.x * a.x + m.z.y * a.y + m.z.z * a.z + m.z.w);
+    } else if (scale == 0.0) {
+        return vec3( 0.0, 0.0, 0.0 );
+    } else {
+        auto invScale = 1.0 / scale;
+        return vec3(
+            (m.x.x * a.x + m.x.y * a.y + m.x.z * a.z + m.x.w) * invScale,
+            (m.y.x * a.x + m.y.y * a.y + m.y.z * a.z + m.y.w) * invScale,
+            (m.z.x * a.x + m.z.y * a.y + m.z.z * a.z + m.z.w) * invScale);
+    }
+}
+
+/* scalar_mul */
+mat4 scalar_mul( const mat4 &lm, const mat4 &rm ) {
+    mat4 mat;
+    auto l = lm.get_ptr();
+    auto r = rm.get_ptr();
+    auto m = mat.get_ptr();
+    for (auto i = 0; i < 4; i++) {
+        for (auto j = 0; j < 4; j++) {
+            *m =  l[0] * r[0 * 4 + j]
+                + l[1] * r[1 * 4 + j]
+                + l[2] * r[2 * 4 + j]
+                + l[3] * r[3 * 4 + j];
+            m++;
+        }
+        l += 4;
+    }
+    return mat;
+}
+
+/* scalar_to_mat4 */
+mat4 scalar_to_mat4( const quat &q ) {
+    auto x2 = q.x + q.x;
+    auto y2 = q.y + q.y;
+    auto z2 = q.z + q.z;
+    auto xx = q.x * x2;
+    auto xy = q.x * y2;
+    auto xz = q.x * z2;
+    auto yy = q.y * y2;
+    auto yz = q.y * z2;
+    auto zz = q.z * z2;
+    auto wx = q.w * x2;
+    auto wy = q.w * y2;
+    auto wz = q.w * z2;
+    return mat4(
+        1.0 - (yy + zz), xy - wz, xz + wy, 0.0,
+        xy + wz, 1.0 - ( xx + zz ), yz - wx, 0.0,
+        xz - wy, yz + wx, 1.0f - ( xx + yy ), 0.0,
+        0.0, 0.0, 0.0, 1.0
+    );
+}
+
+/* random_mat4
+* the last row is projective for a part of the matrices */
+mat4 random_mat4( engine::test::random &rnd ) {
+    mat4 m;
+    float *p = m.get_ptr();
+    for( int i = 0; i < 16; i++ ) {
+        p[i] = rnd.range( -100.0f, 100.0f );
+    }
+    if( rnd.next() & 1 ) {
+        m.w = vec4( 0.0f, 0.0f, 0.0f, 1.0f );
+    }
+    return m;
+}
+
+/* is_same_bits */
+bool is_same_bits( const float *a, const float *b, int count ) {
+    return std::memcmp( a, b, sizeof( float ) * count ) == 0;
+}
+
+const int PRODUCTS_NUMBER = 100000;
+
+} /* namespace */
+
+TEST( math, mat4_mul_mat4 ) {
+    engine::test::random rnd( 1 );
+    for( int i = 0; i < PRODUCTS_NUMBER; i++ ) {
+        mat4 a = random_mat4( rnd );
+        mat4 b = random_mat4( rnd );
+        mat4 simd = a * b;
+        mat4 scalar = scalar_mul( a, b );
+        CHECK( is_same_bits( simd.get_ptr(), scalar.get_ptr(), 16 ) );
+    }
+    return true;
+}
+
+TEST( math, mat4_mul_vec4 ) {
+    engine::test::random rnd( 2 );
+    for( int i = 0; i < PRODUCTS_NUMBER; i++ ) {
+        mat4 m = random_mat4( rnd );
+        vec4 v( rnd.range( -100.0f, 100.0f ), rnd.range( -100.0f, 100.0f ),
+                rnd.range( -100.0f, 100.0f ), rnd.range( -100.0f, 100.0f ) );
+        vec4 simd = m * v;
+        vec4 scalar = scalar_mul( m, v );
+        CHECK( is_same_bits( simd.get_ptr(), scalar.get_ptr(), 4 ) );
+    }
+    return true;
+}
+
+TEST( math, mat4_mul_vec3 ) {
+    engine::test::random rnd( 3 );
+    for( int i = 0; i < PRODUCTS_NUMBER; i++ ) {
+        mat4 m = random_mat4( rnd );
+        vec3 v( rnd.range( -100.0f, 100.0f ), rnd.range( -100.0f, 100.0f ), rnd.range( -100.0f, 100.0f ) );
+        vec3 simd = m * v;
+        vec3 scalar = scalar_mul( m, v );
+        const float a[3] = { simd.x, simd.y, simd.z };
+        const float b[3] = { scalar.x, scalar.y, scalar.z };
+        CHECK( is_same_bits( a, b, 3 ) );
+    }
+    return true;
+}
+
+TEST( math, quat_to_mat4 ) {
+    engine::test::random rnd( 4 );
+    for( int i = 0; i < PRODUCTS_NUMBER; i++ ) {
+        vec3 axis( rnd.range( -1.0f, 1.0f ), rnd.range( -1.0f, 1.0f ), rnd.range( -1.0f, 1.0f ) );
+        quat q( axis, rnd.range( -pi, pi ) );
+        mat4 simd = q.to_mat4();
+        mat4 scalar = scalar_to_mat4( q );
+        CHECK( is_same_bits( simd.get_ptr(), scalar.get_ptr(), 16 ) );
+    }
+    return true;
+}
@@ -0,0 +1,161 @@
+#include "test.h"
+#include "recording_backend.h"
+#include <core/common.hpp>
+#include <engine/mesh.h>
+#include <engine/mesh_renderer.h>
+
+using namespace engine;
+
+namespace {
+
+/* make_strip_mesh
+* the cube of main.cpp: 8 vertices, one strip of 17 8-bit indices */
+void make_strip_mesh( mesh &m ) {
+    for( int i = 0; i < 8; i++ ) {
+        m.add_vertex( draw_vertex( vec3( i & 1, (i >> 1) & 1, (i >> 2) & 1 ), vec2( 0.0, 0.0 ) ) );
+    }
+    const unsigned int indices[] = { 0,1,2,3,4,5,6,7,0xff,2,4,0,6,1,7,3,5 };
+    for( auto i : indices ) {
+        m.add_index( i );
+    }
+    m.add_present_drawing( PRIMITIVE_TYPE_TRIANGLE_STRIP, m.get_indices_number(), 0 );
+}
+
+/* make_triangles_mesh
+* two triangles without indices */
+void make_triangles_mesh( mesh &m ) {
+    for( int i = 0; i < 6; i++ ) {
+        m.add_vertex( draw_vertex( vec3( i, 0.0, 0.0 ), vec2( 0.0, 0.0 ) ) );
+    }
+    m.add_present_drawing( PRIMITIVE_TYPE_TRIANGLES, 6, 0 );
+}
+
+/* is_same_calls
+* compares the names and the arguments, logs the first difference */
+bool is_same_calls( const core::vector<test::backend_call> &calls, int first,
+        std::initializer_list<test::backend_call> expected ) {
+    int i = first;
+    for( const auto &e : expected ) {
+        if( i >= static_cast<int>( calls.size() ) ) {
+            common::error() << "call " << i << ": expected " << e.name << ", no more calls" << std::endl;
+            return false;
+        }
+        const auto &c = calls[i];
+        if( std::strcmp( c.name, e.name ) != 0 || std::memcmp( c.args, e.args, sizeof(c.args) ) != 0 ) {
+            common::error() << "call " << i << ": " << c.name << "(" << c.args[0] << ", " << c.args[1] << ", "
+                    << c.args[2] << ", " << c.args[3] << ", " << c.args[4] << "), expected " << e.name << "("
+                    << e.args[0] << ", " << e.args[1] << ", " << e.args[2] << ", " << e.args[3] << ", "
+                    << e.args[4] << ")" << std::endl;
+            return false;
+        }
+        i++;
+    }
+    if( i != static_cast<int>( calls.size() ) ) {
+        common::error() << "call " << i << ": unexpected " << calls[i].name << std::endl;
+        return false;
+    }
+    return true;
+}
+
+const long long VERTEX_SIZE = sizeof(draw_vertex);
+const long long MATRIX_SIZE = sizeof(mat4);
+
+} /* namespace */
+
+/* the first draw creates the vertex array, the buffers and the instance
+* layout (four vec4 rows from location 4, divisor 1), the next ones only
+* bind them and orphan the instance buffer growing by doubling */
+TEST( mesh_renderer, instanced_indexed ) {
+    test::recording_backend backend;
+    mesh_renderer renderer( backend );
+    mesh cube( PRESENT_INDEX_8BITS );
+    make_strip_mesh( cube );
+    mat4 transforms[20];
+
+    renderer.draw_mesh_instanced( cube, transforms, 3 );
+    CHECK( is_same_calls( backend.calls, 0, {
+        { "create_vertex_array" },
+        { "bind_vertex_array", {1} },
+        { "create_buffer" },
+        { "bind_buffer", {GL_ARRAY_BUFFER, 2} },
+        { "buffer_data", {GL_ARRAY_BUFFER, VERTEX_SIZE * 8, GL_STATIC_DRAW} },
+        { "vertex_attrib_pointer", {0, 3, GL_FLOAT, VERTEX_SIZE, 0} },
+        { "vertex_attrib_pointer", {1, 2, GL_FLOAT, VERTEX_SIZE, sizeof(vec3)} },
+        { "create_buffer" },
+        { "bind_buffer", {GL_ELEMENT_ARRAY_BUFFER, 3} },
+        { "buffer_data", {GL_ELEMENT_ARRAY_BUFFER, 17, GL_STATIC_DRAW} },
+        { "bind_vertex_array", {0} },
+        { "bind_vertex_array", {1} },
+        { "create_buffer" },
+        { "bind_buffer", {GL_ARRAY_BUFFER, 4} },
+        { "vertex_attrib_pointer", {4, 4, GL_FLOAT, MATRIX_SIZE, 0} },
+        { "vertex_attrib_divisor", {4, 1} },
+        { "enable_vertex_attrib", {4} },
+        { "vertex_attrib_pointer", {5, 4, GL_FLOAT, MATRIX_SIZE, 16} },
+        { "vertex_attrib_divisor", {5, 1} },
+        { "enable_vertex_attrib", {5} },
+        { "vertex_attrib_pointer", {6, 4, GL_FLOAT, MATRIX_SIZE, 32} },
+        { "vertex_attrib_divisor", {6, 1} },
+        { "enable_vertex_attrib", {6} },
+        { "vertex_attrib_pointer", {7, 4, GL_FLOAT, MATRIX_SIZE, 48} },
+        { "vertex_attrib_divisor", {7, 1} },
+        { "enable_vertex_attrib", {7} },
+        { "buffer_data", {GL_ARRAY_BUFFER, 3 * MATRIX_SIZE, GL_STREAM_DRAW} },
+        { "buffer_sub_data", {GL_ARRAY_BUFFER, 0, 3 * MATRIX_SIZE} },
+        { "enable_vertex_attrib", {0} },
+        { "enable_vertex_attrib", {1} },
+        { "primitive_restart_index", {0xff} },
+        { "draw_elements_instanced", {GL_TRIANGLE_STRIP, 17, GL_UNSIGNED_BYTE, 0, 3} }
+    } ) );
+    CHECK( backend.find( "buffer_sub_data" )[0].data == transforms );
+
+    /* 5 instances double the capacity, 20 are above the double, 4 fit */
+    for( int count : { 5, 20, 4 } ) {
+        int capacity = count == 5 ? 6 : 20;
+        int first = static_cast<int>( backend.calls.size() );
+        renderer.draw_mesh_instanced( cube, transforms, count );
+        CHECK( is_same_calls( backend.calls, first, {
+            { "bind_vertex_array", {1} },
+            { "bind_buffer", {GL_ARRAY_BUFFER, 4} },
+            { "buffer_data", {GL_ARRAY_BUFFER, capacity * MATRIX_SIZE, GL_STREAM_DRAW} },
+            { "buffer_sub_data", {GL_ARRAY_BUFFER, 0, count * MATRIX_SIZE} },
+            { "enable_vertex_attrib", {0} },
+            { "enable_vertex_attrib", {1} },
+            { "primitive_restart_index", {0xff} },
+            { "draw_elements_instanced", {GL_TRIANGLE_STRIP, 17, GL_UNSIGNED_BYTE, 0, count} }
+        } ) );
+    }
+
+    /* no instances, no calls */
+    auto callsNumber = backend.calls.size();
+    renderer.draw_mesh_instanced( cube, transforms, 0 );
+    CHECK( backend.calls.size() == callsNumber );
+    return true;
+}
+
+/* the meshes without indices are drawn by draw_arrays and do not
+* set the restart index */
+TEST( mesh_renderer, not_indexed ) {
+    test::recording_backend backend;
+    mesh_renderer renderer( backend );
+    mesh triangles( PRESENT_INDEX_NO_INDEX );
+    make_triangles_mesh( triangles );
+    mat4 transforms[2];
+
+    renderer.draw_mesh( triangles );
+    CHECK( backend.find( "create_buffer" ).size() == 1 );
+    CHECK( backend.find( "primitive_restart_index" ).empty() );
+    auto draws = backend.find( "draw_arrays" );
+    CHECK( draws.size() == 1 );
+    CHECK( draws[0].args[0] == GL_TRIANGLES && draws[0].args[1] == 0 && draws[0].args[2] == 6 );
+
+    int first = static_cast<int>( backend.calls.size() );
+    renderer.draw_mesh_instanced( triangles, transforms, 2 );
+    CHECK( is_same_calls( backend.calls, static_cast<int>( backend.calls.size() ) - 1, {
+        { "draw_arrays_instanced", {GL_TRIANGLES, 0, 6, 2} }
+    } ) );
+    CHECK( backend.find( "create_vertex_array" ).size() == 1 );
+    CHECK( backend.find( "vertex_attrib_divisor" ).size() == 4 );
+    CHECK( std::strcmp( backend.calls[first].name, "bind_vertex_array" ) == 0 );
+    return true;
+}
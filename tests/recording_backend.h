@@ -0,0 +1,86 @@
+#pragma once
+#include <cstring>
+#include <core/vector.hpp>
+#include <renderer/render_backend.h>
+
+namespace engine::test {
+
+/* backend_call
+* one call of render_backend, the arguments in the order of the method */
+struct backend_call {
+    const char *    name;
+    long long       args[5];
+    const void *    data;       /* pointer argument */
+};
+
+/* recording_backend
+* records the calls instead of drawing, the objects are numbered from 1 */
+class recording_backend : public render_backend {
+public:
+    GLuint          create_vertex_array() override { record( "create_vertex_array" ); return ++objects; }
+    GLuint          create_buffer() override { record( "create_buffer" ); return ++objects; }
+    void            bind_vertex_array( GLuint vao ) override { record( "bind_vertex_array", vao ); }
+    void            bind_buffer( GLenum target, GLuint buffer ) override { record( "bind_buffer", target, buffer ); }
+    void            buffer_data( GLenum target, GLsizeiptr size, const void *data, GLenum usage ) override {
+                        record( "buffer_data", target, size, usage, 0, 0, data );
+                    }
+    void            buffer_sub_data( GLenum target, GLintptr offset, GLsizeiptr size, const void *data ) override {
+                        record( "buffer_sub_data", target, offset, size, 0, 0, data );
+                    }
+    void            vertex_attrib_pointer( GLuint index, GLint size, GLenum type, GLsizei stride, GLintptr offset ) override {
+                        record( "vertex_attrib_pointer", index, size, type, stride, offset );
+                    }
+    void            vertex_attrib_divisor( GLuint index, GLuint divisor ) override { record( "vertex_attrib_divisor", index, divisor ); }
+    void            enable_vertex_attrib( GLuint index ) override { record( "enable_vertex_attrib", index ); }
+    void            use_program( GLuint program ) override { record( "use_program", program ); }
+    void            bind_texture( GLenum target, GLuint texture ) override { record( "bind_texture", target, texture ); }
+    void            uniform_matrix( GLint location, const float *m ) override {
+                        /* the first element tells the matrices apart */
+                        record( "uniform_matrix", location, static_cast<long long>( m[0] ), 0, 0, 0, m );
+                    }
+    void            primitive_restart_index( GLuint index ) override { record( "primitive_restart_index", index ); }
+    void            draw_arrays( GLenum mode, GLint first, GLsizei count ) override { record( "draw_arrays", mode, first, count ); }
+    void            draw_arrays_instanced( GLenum mode, GLint first, GLsizei count, GLsizei instances ) override {
+                        record( "draw_arrays_instanced", mode, first, count, instances );
+                    }
+    void            draw_elements( GLenum mode, GLsizei count, GLenum type, GLintptr offset ) override {
+                        record( "draw_elements", mode, count, type, offset );
+                    }
+    void            draw_elements_instanced( GLenum mode, GLsizei count, GLenum type, GLintptr offset, GLsizei instances ) override {
+                        record( "draw_elements_instanced", mode, count, type, offset, instances );
+                    }
+
+                    /* returns the recorded calls with the name */
+    core::vector<backend_call> find( const char *name ) const;
+
+public:
+    core::vector<backend_call>  calls;
+
+private:
+    void            record( const char *name, long long a0 = 0, long long a1 = 0, long long a2 = 0,
+                            long long a3 = 0, long long a4 = 0, const void *data = nullptr );
+
+private:
+    GLuint          objects{0};
+};
+
+
+
+/* recording_backend::find */
+inline core::vector<backend_call> recording_backend::find( const char *name ) const {
+    core::vector<backend_call> found;
+    for( const auto &c : calls ) {
+        if( std::strcmp( c.name, name ) == 0 ) {
+            found.push_back( c );
+        }
+    }
+    return found;
+}
+
+/* recording_backend::record */
+inline void recording_backend::record( const char *name, long long a0, long long a1, long long a2,
+        long long a3, long long a4, const void *data ) {
+    calls.push_back( backend_call{ name, {a0, a1, a2, a3, a4}, data } );
+}
+
+} /* namespace engine::test */
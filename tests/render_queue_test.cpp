@@ -0,0 +1,139 @@
+#include "test.h"
+#include "recording_backend.h"
+#include <algorithm>
+#include <engine/mesh.h>
+#include <engine/render_queue.h>
+
+using namespace engine;
+
+namespace {
+
+/* make_mesh
+* one triangle, only the vertex array of the mesh matters */
+void make_mesh( mesh &m ) {
+    for( int i = 0; i < 3; i++ ) {
+        m.add_vertex( draw_vertex( vec3( i, 0.0, 0.0 ), vec2( 0.0, 0.0 ) ) );
+        m.add_index( i );
+    }
+    m.add_present_drawing( PRIMITIVE_TYPE_TRIANGLES, 3, 0 );
+}
+
+} /* namespace */
+
+/* the program is the most significant part of the key, then the
+* texture, the vertex array and the depth */
+TEST( render_queue, key_order ) {
+    const shader::idprog first = 65536;
+    CHECK( render_queue::make_key( 0, 0, 0, 0.0f ) == 0 );
+    CHECK( render_queue::make_key( first, 0, 0, 0.0f ) < render_queue::make_key( first + 1, 0, 0, 0.0f ) );
+    CHECK( render_queue::make_key( first, 65535, 1048575, 1.0f ) < render_queue::make_key( first + 1, 0, 0, 0.0f ) );
+    CHECK( render_queue::make_key( first, 1, 1048575, 1.0f ) < render_queue::make_key( first, 2, 0, 0.0f ) );
+    CHECK( render_queue::make_key( first, 1, 1, 1.0f ) < render_queue::make_key( first, 1, 2, 0.0f ) );
+    CHECK( render_queue::make_key( first, 1, 1, 0.25f ) < render_queue::make_key( first, 1, 1, 0.5f ) );
+    /* the depth is clamped to [0..1] */
+    CHECK( render_queue::make_key( first, 1, 1, -1.0f ) == render_queue::make_key( first, 1, 1, 0.0f ) );
+    CHECK( render_queue::make_key( first, 1, 1, 2.0f ) == render_queue::make_key( first, 1, 1, 1.0f ) );
+    return true;
+}
+
+/* the items are submitted in the stable order of their keys, the texture
+* and the vertex array are bound only when they change, every item sets
+* its own transform before its draw call */
+TEST( render_queue, submission_order ) {
+    const int itemsNumber = 300;
+    const int meshesNumber = 3;
+    const GLint worldLocation = 3;
+    test::recording_backend backend;
+    mesh_renderer meshes( backend );
+    render_queue queue( meshes, backend );
+    mesh models[meshesNumber];
+    for( auto &m : models ) {
+        make_mesh( m );
+    }
+    struct expected_item {
+        render_queue::sort_key  key;
+        int                     index;
+        GLuint                  texture;
+        GLuint                  vao;
+    };
+    core::vector<expected_item> expected;
+    uniform world( worldLocation );
+    test::random rnd( 1 );
+    for( int i = 0; i < itemsNumber; i++ ) {
+        GLuint texture = rnd.range( 1, 5 );
+        auto &m = models[rnd.range( 0, meshesNumber )];
+        /* few depths, so the equal keys are tested */
+        float depth = rnd.range( 0, 4 ) * 0.25f;
+        mat4 transform( MAT4_IDENTITY );
+        transform.x.x = static_cast<float>( i );
+        queue.add( 0, texture, m, world, transform, depth );
+        GLuint vao = meshes.get_vertex_array( m );
+        expected.push_back( {render_queue::make_key( 0, texture, vao, depth ), i, texture, vao} );
+    }
+    std::stable_sort( expected.begin(), expected.end(), []( const expected_item &a, const expected_item &b ) {
+        return a.key < b.key;
+    } );
+    CHECK( queue.size() == itemsNumber );
+
+    auto first = backend.calls.size();
+    queue.submit();
+    CHECK( queue.size() == 0 );
+
+    /* replay the calls against the expected order */
+    int item = 0;
+    GLuint texture = 0;
+    GLuint vao = 0;
+    int textureBinds = 0;
+    int vaoBinds = 0;
+    int programBinds = 0;
+    int draws = 0;
+    for( auto i = first; i < backend.calls.size(); i++ ) {
+        const auto &c = backend.calls[i];
+        if( std::strcmp( c.name, "use_program" ) == 0 ) {
+            CHECK( c.args[0] == 0 );
+            programBinds++;
+        } else if( std::strcmp( c.name, "bind_texture" ) == 0 ) {
+            CHECK( c.args[0] == GL_TEXTURE_2D );
+            CHECK( textureBinds == 0 || c.args[1] != texture );
+            texture = c.args[1];
+            textureBinds++;
+        } else if( std::strcmp( c.name, "bind_vertex_array" ) == 0 ) {
+            CHECK( vaoBinds == 0 || c.args[0] != vao );
+            vao = c.args[0];
+            vaoBinds++;
+        } else if( std::strcmp( c.name, "uniform_matrix" ) == 0 ) {
+            CHECK( item < itemsNumber );
+            CHECK( c.args[0] == worldLocation );
+            CHECK( c.args[1] == expected[item].index );
+            CHECK( texture == expected[item].texture );
+            CHECK( vao == expected[item].vao );
+        } else if( std::strcmp( c.name, "draw_elements" ) == 0 ) {
+            /* the draw of the item whose transform was set last */
+            CHECK( draws == item );
+            draws++;
+            item++;
+        }
+    }
+    CHECK( item == itemsNumber );
+    CHECK( programBinds == 1 );
+
+    const auto &stats = queue.get_statistics();
+    CHECK( stats.items == itemsNumber );
+    CHECK( stats.programBinds == 1 && stats.programBindsAvoided == itemsNumber - 1 );
+    CHECK( stats.textureBinds == textureBinds && stats.textureBinds + stats.textureBindsAvoided == itemsNumber );
+    CHECK( stats.meshBinds == vaoBinds && stats.meshBinds + stats.meshBindsAvoided == itemsNumber );
+    /* sorted by texture first: one bind per texture */
+    CHECK( textureBinds == 4 );
+    return true;
+}
+
+/* an empty queue submits nothing */
+TEST( render_queue, empty ) {
+    test::recording_backend backend;
+    mesh_renderer meshes( backend );
+    render_queue queue( meshes, backend );
+    queue.submit();
+    CHECK( backend.calls.empty() );
+    CHECK( queue.get_statistics().items == 0 );
+    return true;
+}
@@ -0,0 +1,141 @@
+#include "test.h"
+#include <cstdio>
+#include <fstream>
+#include <core/resource_cache.hpp>
+
+using namespace engine;
+using namespace engine::core;
+
+namespace {
+
+/* text
+* the resource of the tests, the contents of the file */
+struct text {
+    string          contents;
+};
+
+/* temp_files
+* the files of the test in the current directory, the resources
+* directory is the current one while the files exist */
+class temp_files {
+public:
+                    temp_files() : resourcesDir( filesystem::get_resources_dir() ) {
+                        filesystem::set_resources_dir( "" );
+                    }
+                    ~temp_files() {
+                        for( const auto &name : names ) {
+                            std::remove( name.c_str() );
+                        }
+                        filesystem::set_resources_dir( resourcesDir );
+                    }
+
+    void            write( const string &name, const char *contents ) {
+                        std::ofstream( name, std::ios::binary ) << contents;
+                        names.push_back( name );
+                    }
+
+private:
+    string                  resourcesDir;
+    core::vector<string>    names;
+};
+
+/* text_cache
+* counts the loads, the contents "bad" are not loaded */
+class text_cache : public resource_cache<text> {
+public:
+                    text_cache( size_t budget = SIZE_MAX ) :
+                        resource_cache<text>( [this]( mapped_file &file, text &t, resource_size &size ) {
+                            loads++;
+                            t.contents.assign( reinterpret_cast<const char*>( file.data() ), file.size() );
+                            size.cpuBytes = file.size();
+                            return t.contents != "bad";
+                        }, budget ) {}
+
+    int             loads{0};
+};
+
+} /* namespace */
+
+/* the path is loaded once, the same contents under another path are
+* shared, the other contents are loaded */
+TEST( resource_cache, paths_and_contents ) {
+    temp_files files;
+    files.write( "_resource_cache_a.txt", "alpha" );
+    files.write( "_resource_cache_b.txt", "alpha" );
+    files.write( "_resource_cache_c.txt", "gamma" );
+    text_cache cache;
+    auto a = cache.get( "_resource_cache_a.txt" );
+    CHECK( a && a->contents == "alpha" );
+    CHECK( cache.get( "_resource_cache_a.txt" ) == a );
+    CHECK( cache.get( "_resource_cache_b.txt" ) == a );
+    auto c = cache.get( "_resource_cache_c.txt" );
+    CHECK( c && c != a && c->contents == "gamma" );
+    CHECK( cache.loads == 2 );
+    const auto &stats = cache.get_stats();
+    CHECK( stats.hits == 1 && stats.deduplicated == 1 && stats.misses == 2 );
+    CHECK( stats.entries == 2 && stats.cpuBytes == 10 );
+    return true;
+}
+
+/* the equal hash is not enough, the contents are compared with the file
+* of the entry. The file changed since its load has other contents */
+TEST( resource_cache, compares_contents ) {
+    temp_files files;
+    files.write( "_resource_cache_a.txt", "alpha" );
+    text_cache cache;
+    auto a = cache.get( "_resource_cache_a.txt" );
+    CHECK( a );
+    files.write( "_resource_cache_a.txt", "omega" );
+    files.write( "_resource_cache_b.txt", "alpha" );
+    auto b = cache.get( "_resource_cache_b.txt" );
+    CHECK( b && b != a && b->contents == "alpha" );
+    CHECK( cache.loads == 2 );
+    CHECK( cache.get_stats().deduplicated == 0 );
+    /* the path of the first entry is still found */
+    CHECK( cache.get( "_resource_cache_a.txt" ) == a );
+    return true;
+}
+
+/* the least recently used entries which are not referenced go first */
+TEST( resource_cache, eviction ) {
+    temp_files files;
+    files.write( "_resource_cache_a.txt", "aaaa" );
+    files.write( "_resource_cache_b.txt", "bbbb" );
+    files.write( "_resource_cache_c.txt", "cccc" );
+    text_cache cache( 8 );
+    auto a = cache.get( "_resource_cache_a.txt" );
+    cache.get( "_resource_cache_b.txt" );
+    cache.get( "_resource_cache_c.txt" );
+    CHECK( cache.contains( "_resource_cache_a.txt" ) );
+    CHECK( !cache.contains( "_resource_cache_b.txt" ) );
+    CHECK( cache.contains( "_resource_cache_c.txt" ) );
+    CHECK( cache.get_stats().evictions == 1 && cache.get_stats().cpuBytes == 8 );
+
+    /* the size of the upload */
+    cache.set_size( a, resource_size{ 4, 4 } );
+    CHECK( !cache.contains( "_resource_cache_c.txt" ) );
+    CHECK( cache.get_stats().gpuBytes == 4 && cache.get_stats().entries == 1 );
+
+    cache.set_budget( 0 );
+    CHECK( cache.contains( "_resource_cache_a.txt" ) );
+    a = nullptr;
+    cache.clear();
+    CHECK( !cache.contains( "_resource_cache_a.txt" ) );
+    CHECK( cache.get_stats().entries == 0 && cache.get_stats().cpuBytes == 0 && cache.get_stats().gpuBytes == 0 );
+    return true;
+}
+
+/* the missing file and the failed load are not cached */
+TEST( resource_cache, failures ) {
+    temp_files files;
+    files.write( "_resource_cache_bad.txt", "bad" );
+    text_cache cache;
+    CHECK( !cache.get( "_resource_cache_missing.txt" ) );
+    CHECK( cache.loads == 0 );
+    CHECK( !cache.get( "_resource_cache_bad.txt" ) );
+    CHECK( !cache.get( "_resource_cache_bad.txt" ) );
+    CHECK( cache.loads == 2 );
+    CHECK( !cache.contains( "_resource_cache_bad.txt" ) );
+    CHECK( cache.get_stats().entries == 0 && cache.get_stats().misses == 0 );
+    return true;
+}
@@ -0,0 +1,62 @@
+#include "test.h"
+#include <cstring>
+#include <core/vector.hpp>
+
+namespace engine::test {
+
+struct test_case {
+    const char *    group;
+    const char *    name;
+    test_fn         fn;
+};
+
+/* get_tests
+* the registrars are static objects of the other files */
+static core::vector<test_case> &get_tests() {
+    static core::vector<test_case> tests;
+    return tests;
+}
+
+/* registrar::registrar */
+registrar::registrar( const char *group, const char *name, test_fn fn ) {
+    get_tests().push_back( test_case{ group, name, fn } );
+}
+
+/* check_failed */
+bool check_failed( const char *file, int line, const char *expr ) {
+    common::error() << file << ":" << line << ": check failed: " << expr << std::endl;
+    return false;
+}
+
+/* is_selected */
+static bool is_selected( const test_case &t, int argc, char **argv ) {
+    if( argc < 2 ) {
+        return true;
+    }
+    for( int i = 1; i < argc; i++ ) {
+        if( std::strcmp( argv[i], t.group ) == 0 ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} /* namespace engine::test */
+
+/* usage: _tests [GROUP...], all groups without the arguments */
+int main( int argc, char **argv ) {
+    using namespace engine;
+    int run = 0;
+    int failed = 0;
+    for( const auto &t : test::get_tests() ) {
+        if( !test::is_selected( t, argc, argv ) ) {
+            continue;
+        }
+        bool passed = t.fn();
+        common::log() << t.group << "." << t.name << ": " << (passed ? "ok" : "FAILED") << std::endl;
+        run++;
+        failed += passed ? 0 : 1;
+    }
+    common::log() << run << " tests, " << failed << " failed" << std::endl;
+    return run > 0 && failed == 0 ? 0 : 1;
+}
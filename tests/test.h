@@ -0,0 +1,61 @@
+#pragma once
+#include <core/common.hpp>
+
+namespace engine::test {
+
+typedef bool (*test_fn)();
+
+/* registrar
+* adds the test to the list of _tests, see TEST() */
+struct registrar {
+                    registrar( const char *group, const char *name, test_fn fn );
+};
+
+/* logs the failed check, returns false for CHECK() */
+bool                check_failed( const char *file, int line, const char *expr );
+
+/* deterministic random numbers, the failures are reproduced by the same seed */
+class random {
+public:
+    explicit        random( unsigned seed = 1 ) : state( seed ) {}
+    unsigned        next();
+                    /* [min, max) */
+    float           range( float min, float max );
+    int             range( int min, int max );
+
+private:
+    unsigned        state;
+};
+
+/* random::next */
+inline unsigned random::next() {
+    state = state * 1103515245u + 12345u;
+    return state >> 8;
+}
+
+/* random::range */
+inline float random::range( float min, float max ) {
+    return min + (max - min) * static_cast<float>( next() & 0xffff ) / 65536.0f;
+}
+
+/* random::range */
+inline int random::range( int min, int max ) {
+    return min + static_cast<int>( next() % static_cast<unsigned>( max - min ) );
+}
+
+} /* namespace engine::test */
+
+/* the test is a function of the group returning true if it is passed,
+* the groups are the arguments of _tests and the tests of ctest */
+#define TEST( group, name ) \
+    static bool test_##group##_##name(); \
+    static engine::test::registrar registrar_##group##_##name( #group, #name, test_##group##_##name ); \
+    static bool test_##group##_##name()
+
+/* returns false from the test if expr is false */
+#define CHECK( expr ) \
+    do { \
+        if( !(expr) ) { \
+            return engine::test::check_failed( __FILE__, __LINE__, #expr ); \
+        } \
+    } while( 0 )
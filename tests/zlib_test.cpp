@@ -0,0 +1,199 @@
+#include "test.h"
+#include <cstdlib>
+#include <cstring>
+#include <zlib.h>
+#include <core/vector.hpp>
+
+using namespace engine;
+using namespace engine::core;
+
+#if !defined(NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+/* the flags of 3rd_party/zlib-1.2.11/simd.h */
+extern "C" int x86_simd_support();
+#define X86_SIMD_AVX2 4
+#endif
+
+/* the SIMD paths of 3rd_party/zlib-1.2.11 against the bytewise references,
+* ctest runs the group again with ZSIMD_FORCESSSE3=1 and ZSIMD_FORCENONE=1 */
+namespace {
+
+const int MAX_LENGTH = 300;
+const int MAX_MISALIGNMENT = 15;
+/* the lengths of several adler32 reductions and crc32 folds */
+const int LONG_LENGTHS[] = { 1000, 5552 * 3 + 13, 70001 };
+
+/* reference_crc32 */
+uLong reference_crc32( uLong crc, const byte *buf, size_t len ) {
+    crc ^= 0xffffffffUL;
+    for( size_t i = 0; i < len; i++ ) {
+        crc ^= buf[i];
+        for( int k = 0; k < 8; k++ ) {
+            crc = (crc >> 1) ^ (0xedb88320UL & (0 - (crc & 1)));
+        }
+    }
+    return crc ^ 0xffffffffUL;
+}
+
+/* reference_adler32 */
+uLong reference_adler32( uLong adler, const byte *buf, size_t len ) {
+    uLong s1 = adler & 0xffff;
+    uLong s2 = adler >> 16;
+    for( size_t i = 0; i < len; i++ ) {
+        s1 = (s1 + buf[i]) % 65521;
+        s2 = (s2 + s1) % 65521;
+    }
+    return s1 | (s2 << 16);
+}
+
+/* random_bytes */
+vector<byte> random_bytes( test::random &rnd, size_t size ) {
+    vector<byte> bytes( size );
+    for( auto &b : bytes ) {
+        b = static_cast<byte>( rnd.next() );
+    }
+    return bytes;
+}
+
+typedef uLong (*checksum_fn)( uLong, const Bytef*, z_size_t );
+typedef uLong (*reference_fn)( uLong, const byte*, size_t );
+
+/* check_checksum
+* every length and misalignment from the initial value and from a random
+* one, the checksum of the buffer split in two calls is the same */
+bool check_checksum( checksum_fn checksum, reference_fn reference, uLong initial ) {
+    test::random rnd;
+    const auto bytes = random_bytes( rnd, LONG_LENGTHS[2] + MAX_MISALIGNMENT );
+    for( int misalignment = 0; misalignment <= MAX_MISALIGNMENT; misalignment++ ) {
+        const byte *buf = bytes.data() + misalignment;
+        for( int len = 0; len <= MAX_LENGTH; len++ ) {
+            const uLong start = rnd.next() & 0xffff;
+            CHECK( checksum( initial, buf, len ) == reference( initial, buf, len ) );
+            CHECK( checksum( start, buf, len ) == reference( start, buf, len ) );
+            const int split = len > 0 ? rnd.range( 0, len ) : 0;
+            CHECK( checksum( checksum( initial, buf, split ), buf + split, len - split ) == reference( initial, buf, len ) );
+        }
+        for( int len : LONG_LENGTHS ) {
+            CHECK( checksum( initial, buf, len ) == reference( initial, buf, len ) );
+        }
+    }
+    /* all ones, the sums of adler32 are the largest before the reductions */
+    const vector<byte> ones( LONG_LENGTHS[2], 0xff );
+    for( int len : LONG_LENGTHS ) {
+        CHECK( checksum( initial, ones.data(), len ) == reference( initial, ones.data(), len ) );
+    }
+    return true;
+}
+
+/* make_matches
+* random literals and matches of the distance, the pattern of
+* a distance shorter than the match is repeated */
+vector<byte> make_matches( test::random &rnd, int distance, size_t size ) {
+    vector<byte> data = random_bytes( rnd, distance );
+    while( data.size() < size ) {
+        const int literals = rnd.range( 0, 8 );
+        for( int i = 0; i < literals; i++ ) {
+            data.push_back( static_cast<byte>( rnd.next() ) );
+        }
+        const int len = (rnd.next() & 1) ? rnd.range( 3, 20 ) : rnd.range( 3, 259 );
+        for( int i = 0; i < len; i++ ) {
+            data.push_back( data[data.size() - distance] );
+        }
+    }
+    return data;
+}
+
+/* deflate_data */
+bool deflate_data( const vector<byte> &data, int windowBits, vector<byte> &compressed ) {
+    z_stream strm;
+    std::memset( &strm, 0, sizeof( strm ) );
+    if( deflateInit2( &strm, 9, Z_DEFLATED, windowBits, 9, Z_DEFAULT_STRATEGY ) != Z_OK ) {
+        return false;
+    }
+    compressed.resize( deflateBound( &strm, data.size() ) );
+    strm.next_in = const_cast<Bytef*>( data.data() );
+    strm.avail_in = static_cast<uInt>( data.size() );
+    strm.next_out = compressed.data();
+    strm.avail_out = static_cast<uInt>( compressed.size() );
+    const int result = deflate( &strm, Z_FINISH );
+    compressed.resize( strm.total_out );
+    deflateEnd( &strm );
+    return result == Z_STREAM_END;
+}
+
+/* inflate_by
+* the output buffer of outSize bytes is followed by guard bytes, inflate
+* writes only inside avail_out */
+bool inflate_by( const vector<byte> &compressed, int windowBits, size_t outSize, vector<byte> &data ) {
+    const size_t GUARD_SIZE = 32;
+    z_stream strm;
+    std::memset( &strm, 0, sizeof( strm ) );
+    if( inflateInit2( &strm, windowBits ) != Z_OK ) {
+        return false;
+    }
+    vector<byte> out( outSize + GUARD_SIZE, 0xa5 );
+    strm.next_in = const_cast<Bytef*>( compressed.data() );
+    strm.avail_in = static_cast<uInt>( compressed.size() );
+    data.clear();
+    int result = Z_OK;
+    while( result == Z_OK ) {
+        strm.next_out = out.data();
+        strm.avail_out = static_cast<uInt>( outSize );
+        result = inflate( &strm, Z_NO_FLUSH );
+        data.insert( data.end(), out.data(), out.data() + outSize - strm.avail_out );
+        for( size_t i = outSize; i < out.size(); i++ ) {
+            if( out[i] != 0xa5 ) {
+                result = Z_BUF_ERROR;
+            }
+        }
+    }
+    inflateEnd( &strm );
+    return result == Z_STREAM_END;
+}
+
+} /* namespace */
+
+
+#ifdef X86_SIMD_AVX2
+/* the environment variables of ctest select the paths */
+TEST( zlib, simd_override ) {
+    const char *none = std::getenv( "ZSIMD_FORCENONE" );
+    const char *ssse3 = std::getenv( "ZSIMD_FORCESSSE3" );
+    if( none != nullptr && none[0] == '1' ) {
+        CHECK( x86_simd_support() == 0 );
+    }
+    if( ssse3 != nullptr && ssse3[0] == '1' ) {
+        CHECK( (x86_simd_support() & X86_SIMD_AVX2) == 0 );
+    }
+    return true;
+}
+#endif
+
+/* crc32_z of every length and misalignment against the bitwise CRC */
+TEST( zlib, crc32 ) {
+    return check_checksum( crc32_z, reference_crc32, crc32_z( 0, nullptr, 0 ) );
+}
+
+/* adler32_z of every length and misalignment against the sums modulo 65521 */
+TEST( zlib, adler32 ) {
+    return check_checksum( adler32_z, reference_adler32, adler32_z( 0, nullptr, 0 ) );
+}
+
+/* the matches of the distances 1..40 inflated to the output buffers of
+* 1..300 bytes. From 258 bytes inflate_fast runs with the end of the output
+* closer than a chunk, the short buffers copy the matches from the window */
+TEST( zlib, inflate_distances ) {
+    test::random rnd;
+    for( int windowBits : { 9, 15 } ) {
+        for( int distance = 1; distance <= 40; distance++ ) {
+            const auto data = make_matches( rnd, distance, 3000 );
+            vector<byte> compressed;
+            CHECK( deflate_data( data, windowBits, compressed ) );
+            for( size_t outSize = 1; outSize <= MAX_LENGTH; outSize++ ) {
+                vector<byte> inflated;
+                CHECK( inflate_by( compressed, windowBits, outSize, inflated ) );
+                CHECK( inflated == data );
+            }
+        }
+    }
+    return true;
+}